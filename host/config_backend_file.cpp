@@ -0,0 +1,54 @@
+#include "config_backend_file.h"
+
+#include <stdio.h>
+
+#include <map>
+#include <string>
+
+#include "config_backend.h"
+
+static std::string configPath;  // 空字串: 只存在記憶體
+static std::map<std::string, uint32_t> values;
+static uint32_t writes = 0;
+static uint32_t commits = 0;
+
+void cfgFileBackendBegin(const char* dir) {
+  values.clear();
+  writes = commits = 0;
+  configPath = dir ? std::string(dir) + "/config.txt" : "";
+  if (configPath.empty()) return;
+  FILE* f = fopen(configPath.c_str(), "r");
+  if (f == nullptr) return;
+  char key[16];
+  unsigned long value;
+  while (fscanf(f, "%15s %lu", key, &value) == 2) values[key] = (uint32_t)value;
+  fclose(f);
+}
+
+uint32_t cfgFileBackendWrites() { return writes; }
+
+uint32_t cfgFileBackendCommits() { return commits; }
+
+bool cfgBackendOpen() { return true; }
+
+bool cfgBackendRead(const char* key, uint32_t* value) {
+  auto it = values.find(key);
+  if (it == values.end()) return false;
+  *value = it->second;
+  return true;
+}
+
+bool cfgBackendWrite(const char* key, uint32_t value) {
+  values[key] = value;
+  writes++;
+  return true;
+}
+
+bool cfgBackendCommit() {
+  commits++;
+  if (configPath.empty()) return true;
+  FILE* f = fopen(configPath.c_str(), "w");
+  if (f == nullptr) return false;
+  for (const auto& kv : values) fprintf(f, "%s %lu\n", kv.first.c_str(), (unsigned long)kv.second);
+  return fclose(f) == 0;
+}
@@ -0,0 +1,11 @@
+#pragma once
+// config_backend.h 的主機端實作 (單元測試、模擬器): 以 <dir>/config.txt 模擬 NVS
+// 每行 "key value"; commit 時整個檔案重寫。dir 為 nullptr 時只存在記憶體 (測試)。
+
+#include <stdint.h>
+
+// 清除記憶體中的內容並從 <dir>/config.txt 載入 (模擬器每次開機呼叫)
+void cfgFileBackendBegin(const char* dir);
+// 測試用: 寫入的欄位數與 commit 次數 (對應 flash 寫入)
+uint32_t cfgFileBackendWrites();
+uint32_t cfgFileBackendCommits();
@@ -0,0 +1,13 @@
+#pragma once
+// WebSocket 交握與 HTTP Basic 驗證用的編碼工具 (SHA-1 只用於 Sec-WebSocket-Accept)
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+std::string base64Encode(const uint8_t* data, size_t len);
+// 無效輸入回傳 false
+bool base64Decode(const std::string& text, std::string* out);
+// RFC 6455: base64(SHA-1(key + GUID))
+std::string wsAcceptKey(const std::string& clientKey);
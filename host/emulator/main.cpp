@@ -0,0 +1,631 @@
+// 虛擬車 (Linux 模擬器)
+// 以韌體本身的控制核心 (car_control)、OTA 管線 (ota_stream / ota_update) 與 HTTP 處理器 (web_api) 提供與車上相同的
+// `/`、`/health`、`/latency`、`/events`、`/api/*` (含 `/api/config`)、`/ota/info`、`/update`、`/capture`、`/stream`、`/fleet` 與控制 WebSocket;
+// PWM 輸出寫入 CSV 而不是腳位。
+//
+//   emulator --port 8080 [--state DIR] [--image firmware.bin] [--pwm-log pwm.csv] [--ws-max 5]
+//            [--video clip.mjpg] [--video-fps 15] [--peers 127.0.0.1:8082,...] [--mac 0c4ea032ad7c]
+//
+// --mac 代替車上的 eFuse MAC 選擇內建 profile (car_profiles.cpp), 例如以藍色四驅車的差速混控執行。
+// --peers 取代車上的 mDNS 探索, 列在 /peers 供車隊儀表板 (/fleet) 使用。
+// WebSocket 在 --port + 1 (車上為 80/81)。每個實例使用自己的埠與狀態目錄, 可同時執行多個。
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "capture.h"
+#include "car_control.h"
+#include "car_profiles.h"
+#include "car_variant.h"
+#include "config_backend_file.h"
+#include "config_store.h"
+#include "control_api.h"
+#include "event_stream.h"
+#include "fleet_ui.h"
+#include "gpio_pins.h"
+#include "hal_native.h"
+#include "mjpeg_relay.h"
+#include "net_server.h"
+#include "ota_backend.h"
+#include "ota_backend_file.h"
+#include "ota_stream.h"
+#include "ota_update.h"
+#include "sha256.h"
+#include "web_api.h"
+#include "web_ui.h"
+
+static const char* OTA_HTTP_USER = "ota";
+static const char* OTA_PASSWORD = "mysecurepassword";
+static const uint32_t OTA_STALL_TIMEOUT = 10000;
+static const int RST_POWERON = 1; // esp_reset_reason_t
+static const int RST_SW = 3;
+static const size_t SSE_BACKLOG = 5744; // 與車上 lwIP 的 TCP_SND_BUF 相同: 慢的 SSE 連線在這之後開始 drop-oldest
+
+static NetServer net;
+static uint8_t emulatedMac[6];
+static bool haveMac = false;
+static FILE* pwmLog = nullptr;
+static volatile sig_atomic_t stopRequested = 0;
+
+// 影像來源 (--video): 串接的 JPEG 檔 (例如 ffmpeg -i clip.mp4 -vf scale=320:-2 -q:v 8 clip.mjpg),
+// 依 --video-fps 逐框以 TCP 區段大小送進轉送器, 放完從頭開始; 代替車上連到相機節點的上游連線
+struct VideoFile {
+  std::string path;
+  std::string data;
+  std::vector<size_t> ends; // 每個框 EOI 之後的位置
+  size_t next = 0;
+  uint32_t intervalMs = 66;
+  uint32_t dueMs = 0;
+};
+static VideoFile videoFile;
+
+// 一次「開機」的所有狀態; OTA 完成後整個重建以模擬重新啟動
+struct VirtualCar {
+  CarControl car;
+  ConfigStore config;  // 保存在 <state>/config.txt (車上為 NVS)
+  CaptureLog capture;
+  MjpegRelay video;
+  EventStream events;
+  OtaUpdater httpOta;
+  OtaStream otaStream{httpOta};
+  ApiQueue api = {NO_LOCK, {}};        // 與車上相同, REST 命令在 loopOnce() 中套用
+  StatusBoard status{NO_LOCK};
+  uint8_t captureRequest = CAPTURE_REQ_NONE;
+  OtaProgressFeed otaProgress;
+  uint32_t bootMs = 0;
+  int resetReason = RST_POWERON;
+  int otaOwner = 0;          // 正在上傳的 HTTP 連線編號
+  uint32_t otaLastChunkAt = 0;
+  uint32_t otaRebootAt = 0;
+  uint32_t lastHeartbeat = 0;
+};
+static std::unique_ptr<VirtualCar> vc;
+
+// 與裝置上的 sendLogMessage() 相同: Serial (stdout) + WebSocket 廣播
+static void sendLogMessage(const std::string& message) {
+  halLog(message.c_str());
+}
+
+// --- HAL 掛勾 ---
+
+static void onPwm(void*, uint8_t channel, uint32_t duty) {
+  static const char* const NAMES[] = {"a_fwd", "a_rev", "b_left", "b_right", "servo"};
+  if (pwmLog && channel <= CH_SERVO) fprintf(pwmLog, "%u,%s,%u\n", halMillis(), NAMES[channel], duty);
+}
+
+static void onPin(void*, uint8_t pin, bool high) {
+  if (pwmLog && vc && pin == vc->config.active().pinStby) fprintf(pwmLog, "%u,stby,%d\n", halMillis(), high ? 1 : 0);
+}
+
+// 對應 main.cpp 的 motorsOff(): 急停與 OTA 開始時立即拉低 STBY, car 的狀態由 loopOnce() 接手
+static void motorsOff() { halPinWrite(vc->config.active().pinStby, false); }
+
+static bool onBroadcast(void*, const char* data, size_t len) {
+  if (vc) vc->events.publish(SSE_STATUS, data, len, halMillis());
+  return net.broadcastTXT(data, len);
+}
+
+static bool onSend(void*, int client, const char* data, size_t len) { return net.sendTXT(client, data, len); }
+
+static void onLog(void*, const char* message) {
+  printf("%s\n", message);
+  fflush(stdout);
+  if (vc) vc->events.publishLog(message);
+  net.broadcastTXT(message, strlen(message));
+}
+
+// --- 影像資訊 (esp_app_desc_t 位於影像第一個 segment 開頭, offset 32) ---
+
+struct ImageInfo {
+  std::string version = "emulator";
+  std::string built = __DATE__ " " __TIME__;
+  std::string shaHex;
+};
+
+static std::string descField(const uint8_t* image, size_t offset, size_t len) {
+  const char* s = (const char*)image + offset;
+  return std::string(s, strnlen(s, len));
+}
+
+static ImageInfo runningImageInfo() {
+  ImageInfo info;
+  size_t size;
+  const uint8_t* image = otaFileBackendImage(&size);
+  char hex[Sha256::DIGEST_LEN * 2 + 1];
+  if (runningShaHex(hex, nullptr)) info.shaHex = hex;
+  static const uint8_t APP_DESC_MAGIC[] = {0x32, 0x54, 0xCD, 0xAB};
+  if (size >= 144 && memcmp(image + 32, APP_DESC_MAGIC, 4) == 0) {
+    info.version = descField(image, 48, 32);
+    info.built = descField(image, 128, 16) + " " + descField(image, 112, 16);
+  }
+  return info;
+}
+
+// --- 網路事件 (對應 main.cpp 的 webSocketEvent) ---
+
+static void webSocketEvent(int num, WsEvent type, const uint8_t* payload, size_t length) {
+  switch (type) {
+    case WS_CONNECTED:
+      vc->capture.record(CAPTURE_CONNECT, (uint8_t)num, nullptr, 0, halMillis());
+      sendLogMessage("--- WS Client Connected from " + net.remoteIP(num) + " ---");
+      break;
+    case WS_DISCONNECTED:
+      vc->capture.record(CAPTURE_DISCONNECT, (uint8_t)num, nullptr, 0, halMillis());
+      sendLogMessage("--- WS Client Disconnected ---");
+      // 斷線時立即停止馬達
+      vc->car.onClientDisconnected(num);
+      break;
+    case WS_TEXT:
+      vc->capture.record(CAPTURE_TEXT, (uint8_t)num, payload, length, halMillis());
+      vc->car.handleText((const char*)payload, length, num);
+      break;
+  }
+}
+
+// --- HTTP (對應 main.cpp 的 handleHealth / setupApi / setupCapture / setupHttpOTA; 共用部分在 web_api.h) ---
+
+static void sendJson(HttpResponse& res, int code, const char* body) { res.send(code, "application/json", body); }
+
+static void handleHealth(const HttpRequest&, HttpResponse& res) {
+  ImageInfo image = runningImageInfo();
+  HealthInfo info = {};
+  info.uptimeMs = halMillis() - vc->bootMs;
+  info.version = image.version.c_str();
+  info.otaState = OtaUpdater::stateName(vc->httpOta.state());
+  info.selftest = "n/a";
+  info.resetReason = vc->resetReason;
+  info.wsClients = (unsigned)net.wsClientCount();
+  info.wsDropped = (int64_t)net.wsDropped();
+  info.sse = vc->events.stats();
+  char body[600];
+  healthJson(info, vc->status, body, sizeof(body));
+  sendJson(res, 200, body);
+}
+
+static void handleLatency(const HttpRequest&, HttpResponse& res) {
+  char body[1024];
+  sendJson(res, vc->status.latencyReply(body, sizeof(body)), body);
+}
+
+// 模擬器為單執行緒 (NO_LOCK); 命令與車上一樣排入, 在 loopOnce() 中套用
+static bool apiBody(const HttpRequest& req, HttpResponse& res) {
+  if (req.contentLength <= MAX_API_BODY) return true;
+  char reply[64];
+  sendJson(res, apiError(413, "body too large", reply, sizeof(reply)), reply);
+  return false;
+}
+
+static void handleApiDrive(const HttpRequest& req, HttpResponse& res) {
+  if (!apiBody(req, res)) return;
+  char reply[128];
+  sendJson(res, apiDrive(&vc->api, vc->status.mode(), req.body.data(), req.body.size(), reply, sizeof(reply)), reply);
+}
+
+static void handleApiMode(const HttpRequest& req, HttpResponse& res) {
+  if (!apiBody(req, res)) return;
+  char reply[128];
+  sendJson(res, apiMode(&vc->api, req.body.data(), req.body.size(), reply, sizeof(reply)), reply);
+}
+
+static void handleApiStop(const HttpRequest&, HttpResponse& res) {
+  motorsOff();
+  char reply[32];
+  sendJson(res, apiStop(&vc->api, reply, sizeof(reply)), reply);
+}
+
+static void handleApiMission(const HttpRequest& req, HttpResponse& res) {
+  if (!apiBody(req, res)) return;
+  char reply[128];
+  sendJson(res, apiMission(&vc->api, vc->otaStream.active(), req.body.data(), req.body.size(), reply, sizeof(reply)),
+           reply);
+}
+
+static void handleApiMissionGet(const HttpRequest&, HttpResponse& res) {
+  char body[128];
+  sendJson(res, vc->status.missionReply(body, sizeof(body)), body);
+}
+
+// 暫存, 在 loopOnce() 的 tick 邊界套用
+static size_t onWsConfig(void*, const char* json, size_t len, char* reply, size_t maxLen) {
+  return configWsReply(&vc->config, NO_LOCK, json, len, reply, maxLen);
+}
+
+static void handleApiConfig(const HttpRequest& req, HttpResponse& res) {
+  if (!apiBody(req, res)) return;
+  char reply[768];
+  sendJson(res, apiConfigPost(&vc->config, NO_LOCK, req.body.data(), req.body.size(), reply, sizeof(reply)), reply);
+}
+
+static void handleApiConfigGet(const HttpRequest&, HttpResponse& res) {
+  char body[768];
+  sendJson(res, apiConfigGet(vc->config, NO_LOCK, body, sizeof(body)), body);
+}
+
+// 與車上相同, 開始/停止在 loopOnce() 中套用
+static void handleCaptureStart(const HttpRequest&, HttpResponse& res) {
+  vc->captureRequest = CAPTURE_REQ_START;
+  char body[128];
+  sendJson(res, captureStatusReply(vc->capture, "starting", body, sizeof(body)), body);
+}
+
+static void handleCaptureStop(const HttpRequest&, HttpResponse& res) {
+  vc->captureRequest = CAPTURE_REQ_STOP;
+  char body[128];
+  sendJson(res, captureStatusReply(vc->capture, "stopping", body, sizeof(body)), body);
+}
+
+static void handleCaptureGet(const HttpRequest&, HttpResponse& res) {
+  char body[96];
+  int code = captureDownloadCheck(vc->capture, vc->captureRequest, body, sizeof(body));
+  if (code != 200) return sendJson(res, code, body);
+  std::string text;
+  char chunk[1024];
+  size_t n;
+  while ((n = vc->capture.exportText(chunk, sizeof(chunk), text.size())) > 0) text.append(chunk, n);
+  res.send(200, "text/plain", text);
+}
+
+static void handleOtaInfo(const HttpRequest&, HttpResponse& res) {
+  ImageInfo info = runningImageInfo();
+  char body[320];
+  otaInfoJson(otaBackendTargetLabel(), info.version.c_str(), info.built.c_str(), body, sizeof(body));
+  sendJson(res, 200, body);
+}
+
+static void handleOtaChunk(const HttpRequest& req, size_t index, const uint8_t* data, size_t len, size_t total) {
+  if (index == 0) {
+    if (!req.authenticate(OTA_HTTP_USER, OTA_PASSWORD)) return; // 完成時回覆 401
+    if (vc->otaStream.active()) return;                         // 完成時回覆 409
+
+    // 更新期間馬達保持停止: 與車上相同, motorsOff() 只拉低 STBY, 鎖定與 holdSafe() 在 loopOnce()
+    vc->otaLastChunkAt = halMillis();
+    const std::string* shaHeader = req.header("X-Image-SHA256");
+    if (!otaUploadBegin(vc->otaStream, vc->httpOta, shaHeader ? shaHeader->c_str() : nullptr, total, halMillis(),
+                        motorsOff)) {
+      return;
+    }
+    vc->otaOwner = req.id;
+  }
+  if (vc->otaOwner == req.id) {
+    vc->otaLastChunkAt = halMillis();
+    vc->otaStream.write(data, len, halMillis());
+  }
+}
+
+static void handleUpdate(const HttpRequest& req, HttpResponse& res) {
+  if (!req.authenticate(OTA_HTTP_USER, OTA_PASSWORD)) return res.requestAuthentication();
+  bool owner = vc->otaOwner == req.id;
+  if (owner) vc->otaOwner = 0;
+  bool ok;
+  char body[300];
+  sendJson(res, otaUpdateReply(vc->otaStream, vc->httpOta, owner, halMillis(), &ok, body, sizeof(body)), body);
+  if (ok) vc->otaRebootAt = halMillis() + 1500; // 等回應送出後再重新啟動
+}
+
+static void onHttpClose(int id) {
+  if (vc->otaOwner == id) {
+    vc->otaStream.abort("client disconnected");
+    vc->otaOwner = 0;
+  }
+}
+
+// --- loop() ---
+
+static void publishOtaProgress() {
+  char buffer[240];
+  char log[96];
+  size_t len = vc->otaProgress.next(vc->otaStream, vc->httpOta, halMillis(), buffer, sizeof(buffer), log, sizeof(log));
+  if (len == 0) return;
+  net.broadcastTXT(buffer, len);
+  if (log[0]) sendLogMessage(log);
+}
+
+// --- 影像轉送 (對應 main.cpp 的 setupVideo) ---
+
+static bool loadVideoFile(const char* path, uint32_t fps) {
+  FILE* f = fopen(path, "rb");
+  if (f == nullptr) return false;
+  char buf[65536];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) videoFile.data.append(buf, n);
+  fclose(f);
+  const std::string& d = videoFile.data;
+  bool inFrame = false;
+  for (size_t i = 1; i < d.size(); i++) {
+    if ((uint8_t)d[i - 1] != 0xFF) continue;
+    if (!inFrame && (uint8_t)d[i] == 0xD8) inFrame = true;
+    else if (inFrame && (uint8_t)d[i] == 0xD9) {
+      inFrame = false;
+      videoFile.ends.push_back(i + 1);
+    }
+  }
+  videoFile.path = path;
+  videoFile.intervalMs = 1000 / (fps ? fps : 1);
+  return !videoFile.ends.empty();
+}
+
+static void feedVideo() {
+  if (videoFile.ends.empty() || !vc->video.ready()) return;
+  uint32_t now = halMillis();
+  if ((int32_t)(now - videoFile.dueMs) < 0) return;
+  // 落後太多 (例如被除錯器暫停) 時不補送
+  videoFile.dueMs = now - videoFile.dueMs > 1000 ? now + videoFile.intervalMs : videoFile.dueMs + videoFile.intervalMs;
+  size_t start = videoFile.next == 0 ? 0 : videoFile.ends[videoFile.next - 1];
+  size_t end = videoFile.ends[videoFile.next];
+  videoFile.next = (videoFile.next + 1) % videoFile.ends.size();
+  const size_t SEGMENT = 1460;
+  for (size_t pos = start; pos < end; pos += SEGMENT) {
+    vc->video.feed((const uint8_t*)videoFile.data.data() + pos, std::min(SEGMENT, end - pos), now);
+  }
+}
+
+static void handleStream(const HttpRequest&, HttpResponse& res) {
+  if (!vc->video.ready()) return res.send(503, "application/json", "{\"error\":\"no video source (--video FILE)\"}");
+  int viewer = vc->video.addViewer();
+  if (viewer < 0) return res.send(503, "application/json", "{\"error\":\"too many viewers\"}");
+  res.contentType = MjpegRelay::CONTENT_TYPE;
+  res.headers.emplace_back("Cache-Control", "no-store");
+  res.stream = [viewer](uint8_t* buf, size_t maxLen, size_t) -> size_t {
+    size_t n = vc->video.read(viewer, buf, maxLen, halMillis());
+    return n == MjpegRelay::AGAIN ? HttpResponse::TRY_AGAIN : n;
+  };
+  res.onDisconnect = [viewer]() { vc->video.removeViewer(viewer); };
+}
+
+// 對應 main.cpp 的 handleEvents(): GET /events?rate=N
+static void handleEvents(const HttpRequest& req, HttpResponse& res) {
+  int sub = vc->events.addSubscriber(eventsRate(req.arg("rate").c_str()), halMillis());
+  if (sub < 0) return res.send(503, "application/json", "{\"error\":\"too many event streams\"}");
+  res.contentType = EventStream::CONTENT_TYPE;
+  res.headers.emplace_back("Cache-Control", "no-store");
+  res.streamBacklog = SSE_BACKLOG;
+  res.stream = [sub](uint8_t* buf, size_t maxLen, size_t) -> size_t {
+    size_t n = vc->events.next(sub, (char*)buf, maxLen, halMillis());
+    return n ? n : HttpResponse::TRY_AGAIN;
+  };
+  res.onDisconnect = [sub]() { vc->events.removeSubscriber(sub); };
+}
+
+static void handleFrame(const HttpRequest&, HttpResponse& res) {
+  int viewer = vc->video.ready() ? vc->video.addViewer(true) : -1;
+  if (viewer < 0) return res.send(503, "application/json", "{\"error\":\"no frame\"}");
+  res.headers.emplace_back("Cache-Control", "no-store");
+  res.headers.emplace_back("X-Frame-Seq", std::to_string(vc->video.seq()));
+  res.headers.emplace_back("X-Frame-Age", std::to_string(vc->video.publishedAgeMs(halMillis())));
+  std::string jpeg;
+  uint8_t buf[4096];
+  size_t n;
+  while ((n = vc->video.read(viewer, buf, sizeof(buf), halMillis())) > 0) jpeg.append((const char*)buf, n);
+  vc->video.removeViewer(viewer);
+  res.send(200, "image/jpeg", jpeg);
+}
+
+static void handleVideoInfo(const HttpRequest&, HttpResponse& res) {
+  char body[320];
+  videoInfoJson(vc->video, videoFile.path.c_str(), videoFile.ends.empty() ? "none" : "connected", halMillis(), body,
+                sizeof(body));
+  sendJson(res, 200, body);
+}
+
+// 車上由 mDNS 找到的其他車; 模擬器以 --peers 指定 (名稱即位址)
+static const int MAX_PEERS = 16;
+static Peer peers[MAX_PEERS];
+static int peerCount = 0;
+static int listenPort = 0;
+
+static void handlePeers(const HttpRequest& req, HttpResponse& res) {
+  const std::string* host = req.header("Host");
+  std::string self = "emulator-" + std::to_string(listenPort);
+  char body[(MAX_PEERS + 1) * 80 + 64];
+  peersJson(self.c_str(), host ? host->c_str() : "", peers, peerCount, body, sizeof(body));
+  sendJson(res, 200, body);
+}
+
+static bool boot(const char* stateDir, const char* image, int resetReason) {
+  vc.reset(new VirtualCar());
+  if (!videoFile.ends.empty()) vc->video.begin();
+  if (!otaFileBackendBoot(stateDir, image)) return false;
+  vc->bootMs = halMillis();
+  vc->resetReason = resetReason;
+  cfgFileBackendBegin(stateDir);
+  vc->config.begin(haveMac ? emulatedMac : nullptr);
+  vc->car.configure(vc->config.active());
+  vc->car.onConfig(onWsConfig, nullptr);
+  vc->car.begin();
+  vc->status.publish(vc->car, halMillis(), true);
+  ImageInfo info = runningImageInfo();
+  sendLogMessage("Emulator booted " + std::string(otaBackendRunningLabel()) + " version " + info.version +
+                 (info.shaHex.empty() ? "" : " build " + info.shaHex.substr(0, 16)) + ", profile " +
+                 CAR_PROFILES[vc->config.profileIndex()].name);
+  return true;
+}
+
+static void loopOnce(const char* stateDir) {
+  net.poll(1);
+  // 對應 main.cpp 的 handleCaptureRequest() / handleApiRequests(): 處理器排入的請求在這裡套用
+  if (vc->captureRequest != CAPTURE_REQ_NONE) {
+    uint8_t request = vc->captureRequest;
+    vc->captureRequest = CAPTURE_REQ_NONE;
+    captureApply(vc->capture, request, halMillis());
+  }
+  if (apiApply(&vc->api, vc->car)) vc->status.publish(vc->car, halMillis(), true);
+  // OTA 更新期間鎖定遙控命令; 馬達命令超時邏輯
+  vc->car.setDriveLocked(vc->otaStream.active());
+  // 對應 main.cpp 的 handleConfig(): 在 tick 邊界套用暫存的設定, 合併寫入
+  if (vc->config.applyPending(halMillis())) {
+    vc->car.configure(vc->config.active());
+    sendLogMessage("Config applied");
+  }
+  vc->config.tick(halMillis());
+  vc->car.tick();
+  vc->status.publish(vc->car, halMillis(), false);
+  feedVideo();
+  // SSE 遙測: 有連線到期才組一次, 各連線共用
+  if (vc->events.teleDue(halMillis())) {
+    size_t len;
+    const char* tele = vc->car.telemetry(&len);
+    vc->events.publish(SSE_TELE, tele, len, halMillis());
+  }
+
+  if (vc->otaStream.active()) {
+    CarControl& car = vc->car;
+    if (car.outputs().standby || car.missionActive() || car.calibrating()) car.holdSafe();
+    if (halMillis() - vc->otaLastChunkAt > OTA_STALL_TIMEOUT) {
+      vc->otaOwner = 0;
+      vc->otaStream.abort("upload stalled");
+    }
+  }
+  publishOtaProgress();
+  if (vc->otaRebootAt != 0 && (int32_t)(halMillis() - vc->otaRebootAt) >= 0) {
+    sendLogMessage("HTTP OTA: Update Finished. Rebooting...");
+    vc->config.flush();
+    net.closeAll();
+    boot(stateDir, nullptr, RST_SW);
+  }
+
+  // 心跳日誌
+  if (halMillis() - vc->lastHeartbeat > 5000) {
+    sendLogMessage(std::string("Heartbeat: Car system active, Mode=") + driveModeName(vc->car.mode()));
+    vc->lastHeartbeat = halMillis();
+  }
+}
+
+static void usage() {
+  fprintf(stderr,
+          "usage: emulator [--port 8080] [--state DIR] [--image firmware.bin] [--pwm-log FILE|-] [--ws-max N]\n"
+          "                [--video FILE.mjpg] [--video-fps N] [--peers HOST:PORT,...] [--mac 12HEXDIGITS]\n");
+  exit(2);
+}
+
+static void onSignal(int) { stopRequested = 1; }
+
+int main(int argc, char** argv) {
+  int port = 8080;
+  int wsMax = 5;
+  std::string stateDir;
+  const char* image = nullptr;
+  const char* pwmLogPath = nullptr;
+  const char* videoPath = nullptr;
+  int videoFps = 15;
+  for (int i = 1; i < argc; i++) {
+    if (i + 1 >= argc) usage();
+    if (strcmp(argv[i], "--port") == 0) port = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--state") == 0) stateDir = argv[++i];
+    else if (strcmp(argv[i], "--image") == 0) image = argv[++i];
+    else if (strcmp(argv[i], "--pwm-log") == 0) pwmLogPath = argv[++i];
+    else if (strcmp(argv[i], "--ws-max") == 0) wsMax = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--video") == 0) videoPath = argv[++i];
+    else if (strcmp(argv[i], "--video-fps") == 0) videoFps = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--mac") == 0) {
+      const char* hex = argv[++i];
+      for (int b = 0; b < 6; b++) {
+        unsigned v;
+        if (strlen(hex) != 12 || sscanf(hex + b * 2, "%2x", &v) != 1) usage();
+        emulatedMac[b] = (uint8_t)v;
+      }
+      haveMac = true;
+    }
+    else if (strcmp(argv[i], "--peers") == 0) {
+      std::string list = argv[++i];
+      for (size_t start = 0; start <= list.size();) {
+        size_t end = list.find(',', start);
+        if (end == std::string::npos) end = list.size();
+        if (end > start && peerCount < MAX_PEERS) {
+          std::string host = list.substr(start, end - start);
+          snprintf(peers[peerCount].name, sizeof(peers[peerCount].name), "%s", host.c_str());
+          snprintf(peers[peerCount].host, sizeof(peers[peerCount].host), "%s", host.c_str());
+          peerCount++;
+        }
+        start = end + 1;
+      }
+    }
+    else usage();
+  }
+  if (port <= 0 || port >= 65535 || videoFps <= 0) usage();
+  if (videoPath && !loadVideoFile(videoPath, (uint32_t)videoFps)) {
+    fprintf(stderr, "cannot read JPEG frames from %s\n", videoPath);
+    return 1;
+  }
+  if (stateDir.empty()) {
+    mkdir("emu-state", 0755);
+    stateDir = "emu-state/" + std::to_string(port);
+  }
+  if (mkdir(stateDir.c_str(), 0755) != 0 && errno != EEXIST) {
+    perror(stateDir.c_str());
+    return 1;
+  }
+  if (pwmLogPath) {
+    pwmLog = strcmp(pwmLogPath, "-") == 0 ? stdout : fopen(pwmLogPath, "w");
+    if (pwmLog == nullptr) {
+      perror(pwmLogPath);
+      return 1;
+    }
+    setvbuf(pwmLog, nullptr, _IOLBF, 0); // 讓其他程式可即時 tail
+    fprintf(pwmLog, "ms,output,value\n");
+  }
+
+  halNativeReset();
+  halNative.useRealClock = true;
+  halNative.onPwm = onPwm;
+  halNative.onPin = onPin;
+  halNative.onBroadcast = onBroadcast;
+  halNative.onSend = onSend;
+  halNative.onLog = onLog;
+
+  if (!net.begin((uint16_t)port, (uint16_t)(port + 1))) {
+    fprintf(stderr, "cannot listen on ports %d/%d\n", port, port + 1);
+    return 1;
+  }
+  listenPort = port;
+  net.setWsMaxClients(wsMax);
+  net.onWsEvent(webSocketEvent);
+  net.onHttpClose(onHttpClose);
+  net.on("GET", "/favicon.ico", [](const HttpRequest&, HttpResponse& res) { res.send(204, "text/plain", ""); });
+  net.on("GET", "/", [](const HttpRequest&, HttpResponse& res) { res.send(200, "text/html", index_html); });
+  net.on("GET", "/fleet", [](const HttpRequest&, HttpResponse& res) { res.send(200, "text/html", fleet_html); });
+  net.on("GET", "/peers", handlePeers);
+  net.on("GET", "/health", handleHealth);
+  net.on("GET", "/latency", handleLatency);
+  net.on("GET", "/events", handleEvents);
+  net.on("POST", "/api/drive", handleApiDrive);
+  net.on("POST", "/api/mode", handleApiMode);
+  net.on("POST", "/api/estop", handleApiStop);
+  net.on("POST", "/api/mission", handleApiMission);
+  net.on("GET", "/api/mission", handleApiMissionGet);
+  net.on("POST", "/api/config", handleApiConfig);
+  net.on("GET", "/api/config", handleApiConfigGet);
+  net.on("GET", "/ota/info", handleOtaInfo);
+  net.on("POST", "/update", handleUpdate, handleOtaChunk);
+  net.on("POST", "/capture/start", handleCaptureStart);
+  net.on("POST", "/capture/stop", handleCaptureStop);
+  net.on("GET", "/capture", handleCaptureGet);
+  net.on("GET", "/stream", handleStream);
+  net.on("GET", "/frame.jpg", handleFrame);
+  net.on("GET", "/video", handleVideoInfo);
+
+  if (!boot(stateDir.c_str(), image, RST_POWERON)) {
+    fprintf(stderr, "cannot load image %s into %s\n", image, stateDir.c_str());
+    return 1;
+  }
+  sendLogMessage("Web UI Ready on port " + std::to_string(port) + ", control WebSocket on port " +
+                 std::to_string(port + 1) + ", state in " + stateDir);
+
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+  while (!stopRequested) loopOnce(stateDir.c_str());
+
+  vc->config.flush();
+  net.closeAll();
+  if (pwmLog && pwmLog != stdout) fclose(pwmLog);
+  return 0;
+}
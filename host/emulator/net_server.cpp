@@ -0,0 +1,543 @@
+#include "net_server.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "handshake.h"
+
+struct NetServer::Conn {
+  int id;
+  int fd;
+  bool ws;             // 在 WebSocket 埠上接受的連線
+  bool upgraded = false;
+  bool closeAfterFlush = false;
+  std::string ip;
+  std::string in;
+  std::string out;
+  // HTTP 狀態
+  bool inBody = false;
+  size_t bodyRead = 0;
+  const Route* route = nullptr;
+  HttpRequest req;
+  // WebSocket 分段訊息
+  std::string message;
+  bool messageText = false;
+  // 串流回應
+  HttpResponse::Filler stream;
+  size_t streamIndex = 0;
+  size_t streamBacklog = 0;
+  std::function<void()> streamClosed;
+};
+
+const std::string* HttpRequest::header(const char* name) const {
+  for (const auto& h : headers) {
+    if (strcasecmp(h.first.c_str(), name) == 0) return &h.second;
+  }
+  return nullptr;
+}
+
+std::string HttpRequest::arg(const char* name, const char* fallback) const {
+  size_t n = strlen(name);
+  size_t pos = 0;
+  while (pos <= query.size()) {
+    size_t amp = query.find('&', pos);
+    if (amp == std::string::npos) amp = query.size();
+    if (amp - pos > n && query.compare(pos, n, name) == 0 && query[pos + n] == '=') {
+      return query.substr(pos + n + 1, amp - pos - n - 1);
+    }
+    pos = amp + 1;
+  }
+  return fallback;
+}
+
+bool HttpRequest::authenticate(const char* user, const char* password) const {
+  const std::string* auth = header("Authorization");
+  if (auth == nullptr || strncasecmp(auth->c_str(), "Basic ", 6) != 0) return false;
+  std::string decoded;
+  if (!base64Decode(auth->substr(6), &decoded)) return false;
+  return decoded == std::string(user) + ":" + password;
+}
+
+void HttpResponse::requestAuthentication() {
+  code = 401;
+  contentType = "text/plain";
+  body = "Unauthorized";
+  headers.emplace_back("WWW-Authenticate", "Basic realm=\"Login Required\"");
+}
+
+static const char* reasonPhrase(int code) {
+  switch (code) {
+    case 101: return "Switching Protocols";
+    case 200: return "OK";
+    case 204: return "No Content";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 404: return "Not Found";
+    case 409: return "Conflict";
+    case 411: return "Length Required";
+    case 413: return "Payload Too Large";
+    case 431: return "Request Header Fields Too Large";
+    case 503: return "Service Unavailable";
+  }
+  return "Unknown";
+}
+
+static int listenOn(uint16_t port) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) return -1;
+  int one = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(port);
+  if (bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 64) != 0) {
+    ::close(fd);
+    return -1;
+  }
+  fcntl(fd, F_SETFL, O_NONBLOCK);
+  return fd;
+}
+
+NetServer::NetServer() {}
+
+NetServer::~NetServer() {
+  for (auto& c : _conns) ::close(c->fd);
+  if (_httpFd >= 0) ::close(_httpFd);
+  if (_wsFd >= 0) ::close(_wsFd);
+}
+
+bool NetServer::begin(uint16_t httpPort, uint16_t wsPort) {
+  _httpFd = listenOn(httpPort);
+  if (_httpFd < 0) return false;
+  if (wsPort != 0) {
+    _wsFd = listenOn(wsPort);
+    if (_wsFd < 0) return false;
+  }
+  return true;
+}
+
+void NetServer::on(const char* method, const char* path, Handler handler, BodyHandler body) {
+  _routes.push_back(Route{method, path, handler, body});
+}
+
+NetServer::Conn* NetServer::find(int id) const {
+  for (const auto& c : _conns) {
+    if (c->id == id) return c.get();
+  }
+  return nullptr;
+}
+
+void NetServer::accept(int listenFd, bool ws) {
+  for (;;) {
+    sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    int fd = ::accept(listenFd, (sockaddr*)&addr, &len);
+    if (fd < 0) return;
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    std::unique_ptr<Conn> c(new Conn());
+    c->id = _nextId++;
+    c->fd = fd;
+    c->ws = ws;
+    char ip[INET_ADDRSTRLEN];
+    c->ip = inet_ntop(AF_INET, &addr.sin_addr, ip, sizeof(ip)) ? ip : "?";
+    _conns.push_back(std::move(c));
+  }
+}
+
+void NetServer::poll(int timeoutMs) {
+  // 串流回應先向 filler 要資料; pump 可能關閉連線, 先取得 id 清單
+  std::vector<int> streaming;
+  for (const auto& c : _conns) {
+    if (c->stream) streaming.push_back(c->id);
+  }
+  for (int id : streaming) {
+    Conn* c = find(id);
+    if (c != nullptr) pump(*c);
+  }
+
+  std::vector<pollfd> fds;
+  fds.push_back({_httpFd, POLLIN, 0});
+  if (_wsFd >= 0) fds.push_back({_wsFd, POLLIN, 0});
+  size_t first = fds.size();
+  for (const auto& c : _conns) {
+    fds.push_back({c->fd, (short)(POLLIN | (c->out.empty() ? 0 : POLLOUT)), 0});
+  }
+  if (::poll(fds.data(), fds.size(), timeoutMs) <= 0) return;
+
+  // 以 id 處理, 回呼中可能新增或關閉連線
+  std::vector<std::pair<int, short>> ready;
+  for (size_t i = first; i < fds.size(); i++) {
+    if (fds[i].revents) ready.emplace_back(_conns[i - first]->id, fds[i].revents);
+  }
+  for (const auto& r : ready) {
+    Conn* c = find(r.first);
+    if (c == nullptr) continue;
+    if (r.second & POLLOUT) flush(*c);
+    if ((c = find(r.first)) == nullptr) continue;
+    if (r.second & (POLLIN | POLLHUP | POLLERR)) {
+      char buf[16384];
+      ssize_t n = recv(c->fd, buf, sizeof(buf), 0);
+      if (n > 0) {
+        c->in.append(buf, (size_t)n);
+        handleInput(*c);
+      } else if (n == 0 || (errno != EAGAIN && errno != EINTR)) {
+        close(*c);
+      }
+    }
+  }
+  if (fds[0].revents & POLLIN) accept(_httpFd, false);
+  if (_wsFd >= 0 && fds[1].revents & POLLIN) accept(_wsFd, true);
+}
+
+void NetServer::handleInput(Conn& c) {
+  int id = c.id;
+  bool ok = c.upgraded ? handleWsFrames(c) : (c.ws ? handleWsHandshake(c) : handleHttp(c));
+  if (!ok && find(id) != nullptr) close(c);
+}
+
+bool NetServer::parseHeaders(Conn& c, size_t headerEnd) {
+  HttpRequest& r = c.req;
+  r = HttpRequest();
+  r.id = c.id;
+  r.remoteIp = c.ip;
+  size_t lineEnd = c.in.find("\r\n");
+  std::string line = c.in.substr(0, lineEnd);
+  size_t sp1 = line.find(' ');
+  size_t sp2 = line.find(' ', sp1 + 1);
+  if (sp1 == std::string::npos || sp2 == std::string::npos) return false;
+  r.method = line.substr(0, sp1);
+  std::string target = line.substr(sp1 + 1, sp2 - sp1 - 1);
+  size_t q = target.find('?');
+  r.path = target.substr(0, q);
+  if (q != std::string::npos) r.query = target.substr(q + 1);
+  bool http10 = line.compare(sp2 + 1, std::string::npos, "HTTP/1.0") == 0;
+
+  size_t pos = lineEnd + 2;
+  while (pos < headerEnd) {
+    size_t end = c.in.find("\r\n", pos);
+    size_t colon = c.in.find(':', pos);
+    if (colon == std::string::npos || colon > end) return false;
+    size_t v = colon + 1;
+    while (v < end && c.in[v] == ' ') v++;
+    r.headers.emplace_back(c.in.substr(pos, colon - pos), c.in.substr(v, end - v));
+    pos = end + 2;
+  }
+  c.in.erase(0, headerEnd + 4);
+
+  const std::string* conn = r.header("Connection");
+  c.closeAfterFlush = http10 || (conn && strcasecmp(conn->c_str(), "close") == 0);
+  const std::string* len = r.header("Content-Length");
+  r.contentLength = len ? strtoul(len->c_str(), nullptr, 10) : 0;
+  return true;
+}
+
+bool NetServer::handleHttp(Conn& c) {
+  for (;;) {
+    if (c.stream) {
+      c.in.clear(); // 串流中的連線不再處理請求
+      return true;
+    }
+    if (!c.inBody) {
+      size_t headerEnd = c.in.find("\r\n\r\n");
+      if (headerEnd == std::string::npos) {
+        if (c.in.size() > MAX_HEADER) {
+          HttpResponse res;
+          res.send(431, "text/plain", "header too large");
+          c.closeAfterFlush = true;
+          respond(c, res);
+        }
+        return true;
+      }
+      if (!parseHeaders(c, headerEnd)) return false;
+      if (c.req.header("Transfer-Encoding") != nullptr) {
+        HttpResponse res;
+        res.send(411, "text/plain", "chunked bodies are not supported");
+        c.closeAfterFlush = true;
+        respond(c, res);
+        return true;
+      }
+      c.route = nullptr;
+      for (const auto& route : _routes) {
+        if (route.method == c.req.method && route.path == c.req.path) c.route = &route;
+      }
+      if (c.req.contentLength > MAX_BUFFERED_BODY && (c.route == nullptr || !c.route->body)) {
+        HttpResponse res;
+        res.send(413, "text/plain", "body too large");
+        c.closeAfterFlush = true;
+        respond(c, res);
+        return true;
+      }
+      c.inBody = true;
+      c.bodyRead = 0;
+    }
+
+    size_t take = std::min(c.in.size(), c.req.contentLength - c.bodyRead);
+    if (take > 0) {
+      if (c.route && c.route->body) {
+        int id = c.id;
+        c.route->body(c.req, c.bodyRead, (const uint8_t*)c.in.data(), take, c.req.contentLength);
+        if (find(id) == nullptr) return true;
+      } else {
+        c.req.body.append(c.in, 0, take);
+      }
+      c.in.erase(0, take);
+      c.bodyRead += take;
+    }
+    if (c.bodyRead < c.req.contentLength) return true;
+    c.inBody = false;
+    int id = c.id;
+    finishRequest(c);
+    if (find(id) == nullptr || c.closeAfterFlush || c.in.empty()) return true;
+  }
+}
+
+void NetServer::finishRequest(Conn& c) {
+  HttpResponse res;
+  if (c.route) {
+    c.route->handler(c.req, res);
+  } else {
+    res.send(404, "text/plain", "Not found");
+  }
+  respond(c, res);
+}
+
+void NetServer::respond(Conn& c, const HttpResponse& res) {
+  char head[256];
+  if (res.stream) {
+    snprintf(head, sizeof(head), "HTTP/1.1 %d %s\r\nContent-Type: %s\r\nConnection: close\r\n", res.code,
+             reasonPhrase(res.code), res.contentType.c_str());
+    c.out += head;
+    for (const auto& h : res.headers) c.out += h.first + ": " + h.second + "\r\n";
+    c.out += "\r\n";
+    c.stream = res.stream;
+    c.streamIndex = 0;
+    c.streamClosed = res.onDisconnect;
+    c.streamBacklog = res.streamBacklog ? res.streamBacklog : MAX_STREAM_BACKLOG;
+    if (res.streamBacklog) {
+      int size = (int)res.streamBacklog;
+      setsockopt(c.fd, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+    }
+    pump(c);
+    return;
+  }
+  snprintf(head, sizeof(head), "HTTP/1.1 %d %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\n", res.code,
+           reasonPhrase(res.code), res.contentType.c_str(), res.body.size());
+  c.out += head;
+  for (const auto& h : res.headers) c.out += h.first + ": " + h.second + "\r\n";
+  c.out += c.closeAfterFlush ? "Connection: close\r\n\r\n" : "\r\n";
+  c.out += res.body;
+  flush(c);
+}
+
+bool NetServer::handleWsHandshake(Conn& c) {
+  size_t headerEnd = c.in.find("\r\n\r\n");
+  if (headerEnd == std::string::npos) return c.in.size() <= MAX_HEADER;
+  if (!parseHeaders(c, headerEnd)) return false;
+  const std::string* key = c.req.header("Sec-WebSocket-Key");
+  const std::string* upgrade = c.req.header("Upgrade");
+  c.closeAfterFlush = true;
+  if (key == nullptr || upgrade == nullptr || strcasecmp(upgrade->c_str(), "websocket") != 0) {
+    HttpResponse res;
+    res.send(400, "text/plain", "expected a WebSocket upgrade");
+    respond(c, res);
+    return true;
+  }
+  if (wsClientCount() >= _wsMax) {
+    HttpResponse res;
+    res.send(503, "text/plain", "too many clients");
+    respond(c, res);
+    return true;
+  }
+  c.closeAfterFlush = false;
+  c.upgraded = true;
+  c.out += "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Accept: " +
+           wsAcceptKey(*key) + "\r\n\r\n";
+  flush(c);
+  int id = c.id;
+  if (_wsHandler) _wsHandler(id, WS_CONNECTED, nullptr, 0);
+  Conn* still = find(id);
+  return still == nullptr || c.in.empty() || handleWsFrames(*still);
+}
+
+bool NetServer::handleWsFrames(Conn& c) {
+  int id = c.id;
+  for (;;) {
+    if (c.in.size() < 2) return true;
+    const uint8_t* p = (const uint8_t*)c.in.data();
+    bool fin = p[0] & 0x80;
+    uint8_t opcode = p[0] & 0x0F;
+    bool masked = p[1] & 0x80;
+    uint64_t len = p[1] & 0x7F;
+    size_t pos = 2;
+    if (len == 126) {
+      if (c.in.size() < 4) return true;
+      len = (uint64_t)p[2] << 8 | p[3];
+      pos = 4;
+    } else if (len == 127) {
+      if (c.in.size() < 10) return true;
+      len = 0;
+      for (int i = 0; i < 8; i++) len = len << 8 | p[2 + i];
+      pos = 10;
+    }
+    if (!masked || len > MAX_WS_MESSAGE) return false; // 客戶端訊框必須遮罩
+    if (c.in.size() < pos + 4 + len) return true;
+    const uint8_t* mask = p + pos;
+    std::string payload(c.in, pos + 4, (size_t)len);
+    for (size_t i = 0; i < payload.size(); i++) payload[i] ^= mask[i & 3];
+    c.in.erase(0, pos + 4 + (size_t)len);
+
+    switch (opcode) {
+      case 0x0: // continuation
+      case 0x1: // text
+      case 0x2: // binary
+        if (opcode != 0) {
+          c.message.clear();
+          c.messageText = opcode == 0x1;
+        }
+        c.message += payload;
+        if (c.message.size() > MAX_WS_MESSAGE) return false;
+        if (fin && c.messageText && _wsHandler) {
+          std::string msg;
+          msg.swap(c.message);
+          // 與 WebSocketsServer 相同, payload 以 '\0' 結尾
+          _wsHandler(id, WS_TEXT, (const uint8_t*)msg.c_str(), msg.size());
+          if (find(id) == nullptr) return true;
+        }
+        break;
+      case 0x8: // close
+        queueFrame(c, 0x8, payload.data(), std::min<size_t>(payload.size(), 2), true);
+        c.closeAfterFlush = true;
+        flush(c);
+        return true;
+      case 0x9: // ping
+        queueFrame(c, 0xA, payload.data(), payload.size(), true);
+        flush(c);
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+bool NetServer::queueFrame(Conn& c, uint8_t opcode, const char* data, size_t len, bool force) {
+  if (!force && c.out.size() > MAX_WS_BACKLOG) {
+    _wsDropped++;
+    return false;
+  }
+  char head[10];
+  size_t n = 2;
+  head[0] = (char)(0x80 | opcode);
+  if (len < 126) {
+    head[1] = (char)len;
+  } else if (len <= 0xFFFF) {
+    head[1] = 126;
+    head[2] = (char)(len >> 8);
+    head[3] = (char)len;
+    n = 4;
+  } else {
+    head[1] = 127;
+    for (int i = 0; i < 8; i++) head[2 + i] = (char)((uint64_t)len >> (56 - i * 8));
+    n = 10;
+  }
+  c.out.append(head, n);
+  c.out.append(data, len);
+  return true;
+}
+
+void NetServer::closeAll() {
+  while (!_conns.empty()) close(*_conns.front());
+}
+
+bool NetServer::broadcastTXT(const char* data, size_t len) {
+  // flush 失敗時連線會被移除, 先取得 id 清單
+  std::vector<int> ids;
+  for (const auto& c : _conns) {
+    if (c->upgraded && !c->closeAfterFlush) ids.push_back(c->id);
+  }
+  bool ok = true;
+  for (int id : ids) {
+    Conn* c = find(id);
+    if (c == nullptr) continue;
+    ok = queueFrame(*c, 0x1, data, len, false) && ok;
+    flush(*c);
+  }
+  return ok;
+}
+
+bool NetServer::sendTXT(int client, const char* data, size_t len) {
+  Conn* c = find(client);
+  if (c == nullptr || !c->upgraded) return false;
+  bool ok = queueFrame(*c, 0x1, data, len, false);
+  flush(*c);
+  return ok;
+}
+
+std::string NetServer::remoteIP(int client) const {
+  Conn* c = find(client);
+  return c ? c->ip : "";
+}
+
+int NetServer::wsClientCount() const {
+  int n = 0;
+  for (const auto& c : _conns) n += c->upgraded ? 1 : 0;
+  return n;
+}
+
+void NetServer::pump(Conn& c) {
+  uint8_t buf[16384];
+  while (c.stream && c.out.size() < c.streamBacklog) {
+    size_t n = c.stream(buf, std::min(sizeof(buf), c.streamBacklog - c.out.size()), c.streamIndex);
+    if (n == HttpResponse::TRY_AGAIN) break;
+    if (n == 0) {
+      c.stream = nullptr;
+      c.closeAfterFlush = true;
+      break;
+    }
+    c.out.append((const char*)buf, n);
+    c.streamIndex += n;
+  }
+  flush(c);
+}
+
+void NetServer::flush(Conn& c) {
+  while (!c.out.empty()) {
+    ssize_t n = send(c.fd, c.out.data(), c.out.size(), MSG_NOSIGNAL);
+    if (n > 0) {
+      c.out.erase(0, (size_t)n);
+    } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+      return;
+    } else {
+      close(c);
+      return;
+    }
+  }
+  if (c.closeAfterFlush) close(c);
+}
+
+void NetServer::close(Conn& c) {
+  int id = c.id;
+  bool ws = c.upgraded;
+  std::function<void()> streamClosed = std::move(c.streamClosed);
+  ::close(c.fd);
+  _conns.erase(std::remove_if(_conns.begin(), _conns.end(),
+                              [id](const std::unique_ptr<Conn>& p) { return p->id == id; }),
+               _conns.end());
+  if (ws && _wsHandler) _wsHandler(id, WS_DISCONNECTED, nullptr, 0);
+  if (!ws && _httpClose) _httpClose(id);
+  if (streamClosed) streamClosed();
+}
@@ -0,0 +1,129 @@
+#pragma once
+// 模擬器的網路層: 單執行緒 poll() 迴圈上的 HTTP/1.1 伺服器與 WebSocket 伺服器
+// 介面仿照裝置上的 ESPAsyncWebServer (路由 + body 串流回呼) 與 WebSocketsServer (broadcastTXT / sendTXT)。
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+class HttpRequest {
+public:
+  int id = 0;              // 連線編號 (同一條 keep-alive 連線上的請求相同)
+  std::string method;
+  std::string path;
+  std::string query;       // '?' 之後, 未解碼
+  std::string remoteIp;
+  size_t contentLength = 0;
+  std::string body;        // 沒有 body 回呼的路由才會緩衝 (上限 MAX_BUFFERED_BODY)
+  std::vector<std::pair<std::string, std::string>> headers;
+
+  // 不分大小寫; 找不到回傳 nullptr
+  const std::string* header(const char* name) const;
+  // 查詢參數 (?rate=10); 找不到回傳 fallback
+  std::string arg(const char* name, const char* fallback = "") const;
+  bool authenticate(const char* user, const char* password) const;
+};
+
+struct HttpResponse {
+  // 串流回應 (同 AsyncWebServerRequest::beginChunkedResponse 的 filler): 回傳寫入 buf 的位元組數,
+  // TRY_AGAIN 表示目前沒有資料 (下一次 poll 再呼叫), 0 表示結束。沒有 Content-Length, 結束後關閉連線。
+  typedef std::function<size_t(uint8_t* buf, size_t maxLen, size_t index)> Filler;
+  static const size_t TRY_AGAIN = (size_t)-1;
+
+  int code = 200;
+  std::string contentType = "text/plain";
+  std::string body;
+  std::vector<std::pair<std::string, std::string>> headers;
+  Filler stream;
+  std::function<void()> onDisconnect; // 串流連線關閉時 (同 request->onDisconnect)
+  // 送出緩衝的上限 (0 = MAX_STREAM_BACKLOG); 指定時也限制核心的 SO_SNDBUF (如車上的 TCP_SND_BUF),
+  // 慢連線及早回到 filler, 不在核心裡累積數秒的舊資料
+  size_t streamBacklog = 0;
+
+  void send(int status, const char* type, const std::string& content) {
+    code = status;
+    contentType = type;
+    body = content;
+  }
+  // 與 AsyncWebServerRequest::requestAuthentication() 相同的 401 回應
+  void requestAuthentication();
+};
+
+enum WsEvent { WS_CONNECTED, WS_DISCONNECTED, WS_TEXT };
+
+class NetServer {
+public:
+  static const size_t MAX_HEADER = 8192;
+  static const size_t MAX_BUFFERED_BODY = 64 * 1024;
+  static const size_t MAX_WS_MESSAGE = 16 * 1024;
+  static const size_t MAX_WS_BACKLOG = 256 * 1024; // 超過則丟棄送往該客戶端的訊息並計數
+  static const size_t MAX_STREAM_BACKLOG = 64 * 1024; // 串流回應: 送出緩衝低於此值才向 filler 要資料
+
+  typedef std::function<void(const HttpRequest&, HttpResponse&)> Handler;
+  // index: 本區塊在 body 中的位移, total: Content-Length
+  typedef std::function<void(const HttpRequest&, size_t index, const uint8_t* data, size_t len, size_t total)> BodyHandler;
+  typedef std::function<void(int client, WsEvent type, const uint8_t* payload, size_t len)> WsHandler;
+
+  NetServer();
+  ~NetServer();
+
+  // wsPort 為 0 時不啟動 WebSocket
+  bool begin(uint16_t httpPort, uint16_t wsPort);
+  void on(const char* method, const char* path, Handler handler, BodyHandler body = nullptr);
+  void onWsEvent(WsHandler handler) { _wsHandler = handler; }
+  // HTTP 連線關閉時呼叫 (例如上傳中途斷線)
+  void onHttpClose(std::function<void(int id)> hook) { _httpClose = hook; }
+  // 裝置上 WebSocketsServer 預設最多 5 個客戶端
+  void setWsMaxClients(int n) { _wsMax = n; }
+
+  // 等待最多 timeoutMs 並處理所有就緒的連線
+  void poll(int timeoutMs);
+
+  // 中斷所有連線 (模擬重新開機)
+  void closeAll();
+
+  // 回傳 false 表示至少一個客戶端因積壓而丟棄
+  bool broadcastTXT(const char* data, size_t len);
+  bool sendTXT(int client, const char* data, size_t len);
+  std::string remoteIP(int client) const;
+  int wsClientCount() const;
+  uint64_t wsDropped() const { return _wsDropped; }
+
+private:
+  struct Conn;
+  struct Route {
+    std::string method;
+    std::string path;
+    Handler handler;
+    BodyHandler body;
+  };
+
+  void accept(int listenFd, bool ws);
+  void handleInput(Conn& c);
+  bool handleHttp(Conn& c);
+  bool handleWsHandshake(Conn& c);
+  bool handleWsFrames(Conn& c);
+  bool parseHeaders(Conn& c, size_t headerEnd);
+  void finishRequest(Conn& c);
+  void respond(Conn& c, const HttpResponse& res);
+  void pump(Conn& c);
+  bool queueFrame(Conn& c, uint8_t opcode, const char* data, size_t len, bool force);
+  void flush(Conn& c);
+  void close(Conn& c);
+  Conn* find(int id) const;
+
+  int _httpFd = -1;
+  int _wsFd = -1;
+  int _nextId = 1;
+  int _wsMax = 5;
+  uint64_t _wsDropped = 0;
+  std::vector<Route> _routes;
+  std::vector<std::unique_ptr<Conn>> _conns;
+  WsHandler _wsHandler;
+  std::function<void(int)> _httpClose;
+};
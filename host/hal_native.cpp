@@ -0,0 +1,60 @@
+#include "hal_native.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+
+HalNative halNative;
+
+void halNativeReset() {
+  memset(&halNative, 0, sizeof(halNative));
+}
+
+static void copyText(char* dst, size_t cap, const char* src, size_t len) {
+  if (len >= cap) len = cap - 1;
+  memcpy(dst, src, len);
+  dst[len] = '\0';
+}
+
+void halPwmWrite(uint8_t channel, uint32_t duty) {
+  if (channel < HalNative::PWM_CHANNELS) halNative.pwm[channel] = duty;
+  halNative.pwmWrites++;
+  if (halNative.onPwm) halNative.onPwm(halNative.hookCtx, channel, duty);
+}
+
+void halPinWrite(uint8_t pin, bool high) {
+  if (pin < HalNative::PINS) halNative.pins[pin] = high;
+  if (halNative.onPin) halNative.onPin(halNative.hookCtx, pin, high);
+}
+
+uint32_t halMillis() {
+  if (!halNative.useRealClock) return halNative.nowMs;
+  static const auto start = std::chrono::steady_clock::now();
+  return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now() - start).count();
+}
+
+bool halBroadcast(const char* data, size_t len) {
+  halNative.broadcasts++;
+  copyText(halNative.lastBroadcast, sizeof(halNative.lastBroadcast), data, len);
+  if (halNative.echo) printf("[ws] %.*s\n", (int)len, data);
+  return halNative.onBroadcast ? halNative.onBroadcast(halNative.hookCtx, data, len) : true;
+}
+
+bool halSend(int client, const char* data, size_t len) {
+  halNative.sends++;
+  halNative.lastSendClient = client;
+  copyText(halNative.lastSend, sizeof(halNative.lastSend), data, len);
+  if (halNative.echo) printf("[ws #%d] %.*s\n", client, (int)len, data);
+  return halNative.onSend ? halNative.onSend(halNative.hookCtx, client, data, len) : true;
+}
+
+int halRssi() { return halNative.rssi; }
+
+void halLog(const char* message) {
+  halNative.logs++;
+  copyText(halNative.lastLog, sizeof(halNative.lastLog), message, strlen(message));
+  if (halNative.echo) printf("%s\n", message);
+  if (halNative.onLog) halNative.onLog(halNative.hookCtx, message);
+}
@@ -0,0 +1,42 @@
+#pragma once
+// 主機端 HAL (pio test -e native / 模擬器)
+// 記錄每個 LEDC 通道與腳位的最後輸出, 時間預設由測試手動推進。
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "hal.h"
+
+struct HalNative {
+  static const int PWM_CHANNELS = 8;
+  static const int PINS = 32;
+
+  uint32_t pwm[PWM_CHANNELS];
+  bool pins[PINS];
+  uint32_t nowMs;        // useRealClock = false 時 halMillis() 的回傳值
+  bool useRealClock;     // true: halMillis() 使用 steady_clock
+  uint32_t pwmWrites;    // 計數, 用來驗證只寫入有變化的通道
+  uint32_t broadcasts;
+  uint32_t sends;
+  uint32_t logs;
+  int rssi;              // halRssi() 的回傳值
+  bool echo;             // 將日誌與廣播印到 stdout
+
+  // 選用掛勾 (模擬器將 PWM 與廣播接到自己的輸出)
+  void (*onPwm)(void* ctx, uint8_t channel, uint32_t duty);
+  void (*onPin)(void* ctx, uint8_t pin, bool high);
+  bool (*onBroadcast)(void* ctx, const char* data, size_t len);
+  bool (*onSend)(void* ctx, int client, const char* data, size_t len);
+  void (*onLog)(void* ctx, const char* message);
+  void* hookCtx;
+
+  char lastBroadcast[256];
+  char lastSend[256];
+  int lastSendClient;
+  char lastLog[128];
+};
+
+extern HalNative halNative;
+
+// 清除所有紀錄與掛勾 (每個測試開始時呼叫)
+void halNativeReset();
@@ -0,0 +1,470 @@
+// WebSocket 負載產生器與延遲量測
+// 開啟 N 條控制連線 (每條以固定頻率送出命令) 與 M 條旁觀連線 (只接收), 量測:
+//   - 命令確認延遲: 搖桿命令帶唯一的 "t", 車端狀態廣播以 "ack" 回傳, 只在送出的連線上計算 RTT
+//   - 吞吐量: 送出/收到的訊息數與位元組
+//   - 伺服器端遺失: 測試前後 GET /health 的 "ws" 計數差值 (frames 與送出數比較, tx_fail, dropped)
+//
+//   loadgen --host 192.168.1.50 --control 5 --spectators 2 --rate 20 --duration 10
+//   loadgen --host 127.0.0.1 --http-port 8080 --control 10 --payload large --json report.json
+//
+// 以 --seed 決定各連線的相位與搖桿軌跡, 同樣的參數產生同樣的流量; 報告欄位順序固定。
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "handshake.h"
+
+static const char* const TOOL_VERSION = "loadgen/1";
+static const size_t MAX_BACKLOG = 64 * 1024; // 客戶端送不出去的積壓上限, 超過則跳過本次送出
+
+enum class Payload { JOYSTICK, LARGE, MODE, INVALID, MIX };
+
+struct Options {
+  std::string host = "127.0.0.1";
+  int httpPort = 80;
+  int wsPort = 0;            // 0 = httpPort + 1 (車上 80/81)
+  int control = 5;
+  int spectators = 0;
+  double rate = 20;          // 每條控制連線每秒送出數
+  double duration = 10;      // 秒
+  Payload payload = Payload::JOYSTICK;
+  uint32_t seed = 1;
+  const char* jsonPath = nullptr;
+};
+
+struct Conn {
+  int index;
+  bool control;
+  int fd = -1;
+  bool open = false;         // 完成 WebSocket 交握
+  bool failed = false;
+  std::string error;
+  std::string in;
+  std::string out;
+  double phase;              // 第一次送出的延遲 (秒)
+  uint64_t sentIndex = 0;
+  // 計數
+  uint64_t sent = 0, sentBytes = 0, skipped = 0;
+  uint64_t received = 0, receivedBytes = 0, acks = 0, foreignAcks = 0;
+};
+
+struct ServerCounters {
+  bool ok = false;
+  long long frames = 0, applied = 0, ignored = 0, errors = 0, txFail = 0, dropped = 0, clients = 0;
+};
+
+typedef std::chrono::steady_clock Clock;
+
+static uint32_t lcg(uint32_t& s) {
+  s = s * 1103515245u + 12345u;
+  return (s >> 16) & 0x7FFF;
+}
+
+static int connectTo(const std::string& host, int port, bool blocking) {
+  addrinfo hints = {};
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* res = nullptr;
+  if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &res) != 0) return -1;
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (!blocking) fcntl(fd, F_SETFL, O_NONBLOCK);
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  int rc = connect(fd, res->ai_addr, res->ai_addrlen);
+  freeaddrinfo(res);
+  if (rc != 0 && errno != EINPROGRESS) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// --- GET /health ---
+
+static long long jsonInt(const std::string& body, const char* key) {
+  std::string k = std::string("\"") + key + "\":";
+  size_t p = body.find(k);
+  return p == std::string::npos ? -1 : strtoll(body.c_str() + p + k.size(), nullptr, 10);
+}
+
+static ServerCounters fetchCounters(const Options& o) {
+  ServerCounters c;
+  int fd = connectTo(o.host, o.httpPort, true);
+  if (fd < 0) return c;
+  timeval tv = {3, 0};
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  std::string req = "GET /health HTTP/1.1\r\nHost: " + o.host + "\r\nConnection: close\r\n\r\n";
+  send(fd, req.data(), req.size(), MSG_NOSIGNAL);
+  std::string resp;
+  char buf[2048];
+  ssize_t n;
+  while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) resp.append(buf, (size_t)n);
+  close(fd);
+  size_t ws = resp.find("\"ws\":{");
+  if (ws == std::string::npos) return c;
+  std::string body = resp.substr(ws);
+  c.ok = true;
+  c.clients = jsonInt(body, "clients");
+  c.frames = jsonInt(body, "frames");
+  c.applied = jsonInt(body, "applied");
+  c.ignored = jsonInt(body, "ignored");
+  c.errors = jsonInt(body, "errors");
+  c.txFail = jsonInt(body, "tx_fail");
+  c.dropped = std::max(0LL, jsonInt(body, "dropped")); // 只有模擬器回報
+  return c;
+}
+
+// --- WebSocket 客戶端 ---
+
+static void queueFrame(Conn& c, const std::string& payload, uint32_t& rng) {
+  uint8_t mask[4];
+  for (int i = 0; i < 4; i++) mask[i] = (uint8_t)lcg(rng);
+  std::string f;
+  f += (char)0x81;
+  if (payload.size() < 126) {
+    f += (char)(0x80 | payload.size());
+  } else {
+    f += (char)(0x80 | 126);
+    f += (char)(payload.size() >> 8);
+    f += (char)(payload.size() & 0xFF);
+  }
+  f.append((const char*)mask, 4);
+  for (size_t i = 0; i < payload.size(); i++) f += (char)(payload[i] ^ mask[i & 3]);
+  c.out += f;
+}
+
+static void flush(Conn& c) {
+  while (!c.out.empty()) {
+    ssize_t n = send(c.fd, c.out.data(), c.out.size(), MSG_NOSIGNAL);
+    if (n > 0) {
+      c.out.erase(0, (size_t)n);
+    } else {
+      if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+      c.failed = true;
+      c.error = "send failed";
+      return;
+    }
+  }
+}
+
+static std::string makePayload(const Options& o, Conn& c, uint64_t id, uint32_t& rng) {
+  Payload kind = o.payload;
+  if (kind == Payload::MIX) {
+    uint32_t r = lcg(rng) % 100;
+    kind = r < 85 ? Payload::JOYSTICK : (r < 95 ? Payload::LARGE : (r < 98 ? Payload::MODE : Payload::INVALID));
+  }
+  // 搖桿軌跡: 各連線相位不同的三角波
+  int k = (int)((c.sentIndex * 7 + (uint64_t)c.index * 13) % 200);
+  int throttle = k < 100 ? k : 200 - k;
+  int steer = (int)(lcg(rng) % 201) - 100;
+  char buf[96];
+  switch (kind) {
+    case Payload::MODE:
+      return "M";
+    case Payload::INVALID:
+      return "{\"steer\":";
+    case Payload::LARGE: {
+      snprintf(buf, sizeof(buf), "{\"t\":%llu,\"steer\":%d,\"throttle\":%d,\"pad\":\"", (unsigned long long)id, steer,
+               throttle);
+      std::string s = buf;
+      s.append(900, 'x');
+      return s + "\"}";
+    }
+    default:
+      snprintf(buf, sizeof(buf), "{\"t\":%llu,\"steer\":%d,\"throttle\":%d}", (unsigned long long)id, steer, throttle);
+      return buf;
+  }
+}
+
+// 解析伺服器送來的訊框; 文字訊框交給 onText
+template <typename F>
+static bool readFrames(Conn& c, F onText) {
+  for (;;) {
+    if (c.in.size() < 2) return true;
+    const uint8_t* p = (const uint8_t*)c.in.data();
+    uint8_t opcode = p[0] & 0x0F;
+    uint64_t len = p[1] & 0x7F;
+    size_t pos = 2;
+    if (len == 126) {
+      if (c.in.size() < 4) return true;
+      len = (uint64_t)p[2] << 8 | p[3];
+      pos = 4;
+    } else if (len == 127) {
+      if (c.in.size() < 10) return true;
+      len = 0;
+      for (int i = 0; i < 8; i++) len = len << 8 | p[2 + i];
+      pos = 10;
+    }
+    if (c.in.size() < pos + len) return true;
+    std::string payload = c.in.substr(pos, (size_t)len);
+    c.in.erase(0, pos + (size_t)len);
+    if (opcode == 0x8) {
+      c.error = "closed by server";
+      return false;
+    }
+    c.received++;
+    c.receivedBytes += payload.size();
+    if (opcode == 0x1) onText(payload);
+  }
+}
+
+// --- 統計 ---
+
+static double percentile(std::vector<double>& v, double q) {
+  if (v.empty()) return 0;
+  size_t i = (size_t)(q * (v.size() - 1) + 0.5);
+  std::nth_element(v.begin(), v.begin() + i, v.end());
+  return v[i];
+}
+
+static const char* payloadName(Payload p) {
+  switch (p) {
+    case Payload::JOYSTICK: return "joystick";
+    case Payload::LARGE: return "large";
+    case Payload::MODE: return "mode";
+    case Payload::INVALID: return "invalid";
+    case Payload::MIX: return "mix";
+  }
+  return "?";
+}
+
+static void usage() {
+  fprintf(stderr,
+          "usage: loadgen [--host H] [--http-port 80] [--ws-port PORT] [--control N] [--spectators M]\n"
+          "               [--rate HZ] [--duration S] [--payload joystick|large|mode|invalid|mix] [--seed N]\n"
+          "               [--json FILE]\n");
+  exit(2);
+}
+
+int main(int argc, char** argv) {
+  Options o;
+  for (int i = 1; i < argc; i++) {
+    if (i + 1 >= argc) usage();
+    const char* a = argv[i];
+    const char* v = argv[++i];
+    if (strcmp(a, "--host") == 0) o.host = v;
+    else if (strcmp(a, "--http-port") == 0) o.httpPort = atoi(v);
+    else if (strcmp(a, "--ws-port") == 0) o.wsPort = atoi(v);
+    else if (strcmp(a, "--control") == 0) o.control = atoi(v);
+    else if (strcmp(a, "--spectators") == 0) o.spectators = atoi(v);
+    else if (strcmp(a, "--rate") == 0) o.rate = atof(v);
+    else if (strcmp(a, "--duration") == 0) o.duration = atof(v);
+    else if (strcmp(a, "--seed") == 0) o.seed = (uint32_t)strtoul(v, nullptr, 10);
+    else if (strcmp(a, "--json") == 0) o.jsonPath = v;
+    else if (strcmp(a, "--payload") == 0) {
+      if (strcmp(v, "joystick") == 0) o.payload = Payload::JOYSTICK;
+      else if (strcmp(v, "large") == 0) o.payload = Payload::LARGE;
+      else if (strcmp(v, "mode") == 0) o.payload = Payload::MODE;
+      else if (strcmp(v, "invalid") == 0) o.payload = Payload::INVALID;
+      else if (strcmp(v, "mix") == 0) o.payload = Payload::MIX;
+      else usage();
+    } else usage();
+  }
+  if (o.wsPort == 0) o.wsPort = o.httpPort + 1;
+  if (o.control < 0 || o.spectators < 0 || o.control + o.spectators == 0 || o.rate <= 0 || o.duration <= 0) usage();
+
+  uint32_t rng = o.seed;
+  std::vector<Conn> conns(o.control + o.spectators);
+  for (size_t i = 0; i < conns.size(); i++) {
+    conns[i].index = (int)i;
+    conns[i].control = (int)i < o.control;
+    conns[i].phase = (lcg(rng) % 1000) / 1000.0 / o.rate;
+  }
+
+  ServerCounters before = fetchCounters(o);
+
+  // 建立連線並交握
+  for (auto& c : conns) {
+    c.fd = connectTo(o.host, o.wsPort, false);
+    if (c.fd < 0) {
+      c.failed = true;
+      c.error = "connect failed";
+      continue;
+    }
+    uint8_t nonce[16];
+    for (auto& b : nonce) b = (uint8_t)lcg(rng);
+    std::string key = base64Encode(nonce, sizeof(nonce));
+    c.out = "GET / HTTP/1.1\r\nHost: " + o.host + "\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+            "Sec-WebSocket-Key: " + key + "\r\nSec-WebSocket-Version: 13\r\n\r\n";
+  }
+
+  // 送出時間 (以 t 為鍵) → 計算 RTT
+  std::map<uint64_t, std::pair<int, Clock::time_point>> inflight;
+  std::vector<double> rtts;
+  uint64_t nextId = (uint64_t)o.seed << 32;
+
+  Clock::time_point start = Clock::now();
+  Clock::time_point end = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(o.duration));
+  Clock::time_point drainEnd = end + std::chrono::seconds(1); // 等待最後的 ack
+  double period = 1.0 / o.rate;
+
+  while (Clock::now() < drainEnd) {
+    Clock::time_point now = Clock::now();
+    double elapsed = std::chrono::duration<double>(now - start).count();
+
+    // 依排程送出
+    if (now < end) {
+      for (auto& c : conns) {
+        if (!c.control || !c.open || c.failed) continue;
+        while (c.phase + c.sentIndex * period <= elapsed) {
+          if (c.out.size() > MAX_BACKLOG) {
+            c.skipped++;
+          } else {
+            uint64_t id = nextId++;
+            std::string payload = makePayload(o, c, id, rng);
+            if (payload[0] == '{' && payload.find("\"t\":") != std::string::npos) inflight[id] = {c.index, now};
+            queueFrame(c, payload, rng);
+            c.sent++;
+            c.sentBytes += payload.size();
+          }
+          c.sentIndex++;
+        }
+        flush(c);
+      }
+    }
+
+    std::vector<pollfd> fds;
+    std::vector<Conn*> owners;
+    for (auto& c : conns) {
+      if (c.failed || c.fd < 0) continue;
+      fds.push_back({c.fd, (short)(POLLIN | (c.out.empty() ? 0 : POLLOUT)), 0});
+      owners.push_back(&c);
+    }
+    if (fds.empty()) break;
+    poll(fds.data(), fds.size(), 1);
+
+    for (size_t i = 0; i < fds.size(); i++) {
+      Conn& c = *owners[i];
+      if (fds[i].revents & POLLOUT) flush(c);
+      if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+      char buf[16384];
+      ssize_t n = recv(c.fd, buf, sizeof(buf), 0);
+      if (n <= 0) {
+        if (n < 0 && errno == EAGAIN) continue;
+        c.failed = true;
+        if (c.error.empty()) c.error = c.open ? "connection closed" : "handshake failed";
+        continue;
+      }
+      c.in.append(buf, (size_t)n);
+      if (!c.open) {
+        size_t hdr = c.in.find("\r\n\r\n");
+        if (hdr == std::string::npos) continue;
+        if (c.in.compare(0, 12, "HTTP/1.1 101") != 0) {
+          c.failed = true;
+          c.error = "rejected: " + c.in.substr(0, c.in.find("\r\n"));
+          continue;
+        }
+        c.in.erase(0, hdr + 4);
+        c.open = true;
+        // 相位以交握完成的時間為準
+        c.phase += std::chrono::duration<double>(Clock::now() - start).count();
+      }
+      Clock::time_point rx = Clock::now();
+      bool ok = readFrames(c, [&](const std::string& text) {
+        size_t p = text.find("\"ack\":");
+        if (p == std::string::npos) return;
+        uint64_t id = strtoull(text.c_str() + p + 6, nullptr, 10);
+        auto it = inflight.find(id);
+        if (it == inflight.end() || it->second.first != c.index) {
+          c.foreignAcks++; // 廣播給其他連線的確認
+          return;
+        }
+        c.acks++;
+        rtts.push_back(std::chrono::duration<double, std::milli>(rx - it->second.second).count());
+        inflight.erase(it);
+      });
+      if (!ok) c.failed = true;
+    }
+  }
+  double wall = std::chrono::duration<double>(Clock::now() - start).count();
+  for (auto& c : conns) {
+    if (c.fd >= 0) close(c.fd);
+  }
+  usleep(200000); // 讓車端處理斷線後再讀計數
+  ServerCounters after = fetchCounters(o);
+
+  // --- 報告 ---
+  uint64_t sent = 0, sentBytes = 0, skipped = 0, recv = 0, recvBytes = 0, acks = 0, foreign = 0;
+  int opened = 0, failedConns = 0;
+  for (const auto& c : conns) {
+    sent += c.sent;
+    sentBytes += c.sentBytes;
+    skipped += c.skipped;
+    recv += c.received;
+    recvBytes += c.receivedBytes;
+    acks += c.acks;
+    foreign += c.foreignAcks;
+    opened += c.open ? 1 : 0;
+    failedConns += (c.failed && !c.open) ? 1 : 0;
+  }
+  uint64_t expectAcks = acks + inflight.size();
+  double p50 = percentile(rtts, 0.50), p90 = percentile(rtts, 0.90), p99 = percentile(rtts, 0.99);
+  double maxRtt = rtts.empty() ? 0 : *std::max_element(rtts.begin(), rtts.end());
+  long long srvFrames = before.ok && after.ok ? after.frames - before.frames : -1;
+  long long lost = srvFrames >= 0 ? (long long)sent - srvFrames : -1;
+
+  printf("%s  target %s http:%d ws:%d  seed %u\n", TOOL_VERSION, o.host.c_str(), o.httpPort, o.wsPort, o.seed);
+  printf("config       control=%d spectators=%d rate=%.1fHz payload=%s duration=%.1fs\n", o.control, o.spectators,
+         o.rate, payloadName(o.payload), o.duration);
+  printf("connections  opened=%d failed=%d\n", opened, failedConns);
+  for (const auto& c : conns) {
+    if (!c.error.empty()) printf("  #%d %s: %s\n", c.index, c.control ? "control" : "spectator", c.error.c_str());
+  }
+  printf("client tx    %llu msgs  %.1f msg/s  %.1f KiB/s  skipped(backlog)=%llu\n", (unsigned long long)sent,
+         sent / o.duration, sentBytes / 1024.0 / o.duration, (unsigned long long)skipped);
+  printf("client rx    %llu msgs  %.1f msg/s  %.1f KiB/s  foreign-acks=%llu\n", (unsigned long long)recv, recv / wall,
+         recvBytes / 1024.0 / wall, (unsigned long long)foreign);
+  printf("ack rtt ms   n=%llu/%llu  p50=%.2f p90=%.2f p99=%.2f max=%.2f\n", (unsigned long long)acks,
+         (unsigned long long)expectAcks, p50, p90, p99, maxRtt);
+  if (before.ok && after.ok) {
+    printf("server       frames=%lld applied=%lld ignored=%lld errors=%lld tx_fail=%lld dropped=%lld lost=%lld\n",
+           srvFrames, after.applied - before.applied, after.ignored - before.ignored, after.errors - before.errors,
+           after.txFail - before.txFail, after.dropped - before.dropped, lost);
+  } else {
+    printf("server       /health counters unavailable\n");
+  }
+
+  if (o.jsonPath) {
+    FILE* f = fopen(o.jsonPath, "w");
+    if (f == nullptr) {
+      perror(o.jsonPath);
+      return 1;
+    }
+    fprintf(f,
+            "{\n  \"tool\": \"%s\",\n  \"target\": {\"host\": \"%s\", \"http_port\": %d, \"ws_port\": %d},\n"
+            "  \"config\": {\"control\": %d, \"spectators\": %d, \"rate_hz\": %.3f, \"payload\": \"%s\", "
+            "\"duration_s\": %.3f, \"seed\": %u},\n"
+            "  \"connections\": {\"opened\": %d, \"failed\": %d},\n"
+            "  \"client\": {\"sent\": %llu, \"sent_bytes\": %llu, \"skipped\": %llu, \"received\": %llu, "
+            "\"received_bytes\": %llu, \"foreign_acks\": %llu},\n"
+            "  \"ack_rtt_ms\": {\"n\": %llu, \"expected\": %llu, \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, "
+            "\"max\": %.3f},\n"
+            "  \"server\": {\"available\": %s, \"frames\": %lld, \"applied\": %lld, \"ignored\": %lld, \"errors\": %lld, "
+            "\"tx_fail\": %lld, \"dropped\": %lld, \"lost\": %lld}\n}\n",
+            TOOL_VERSION, o.host.c_str(), o.httpPort, o.wsPort, o.control, o.spectators, o.rate,
+            payloadName(o.payload), o.duration, o.seed, opened, failedConns, (unsigned long long)sent,
+            (unsigned long long)sentBytes, (unsigned long long)skipped, (unsigned long long)recv,
+            (unsigned long long)recvBytes, (unsigned long long)foreign, (unsigned long long)acks,
+            (unsigned long long)expectAcks, p50, p90, p99, maxRtt, before.ok && after.ok ? "true" : "false", srvFrames,
+            after.applied - before.applied, after.ignored - before.ignored, after.errors - before.errors,
+            after.txFail - before.txFail, after.dropped - before.dropped, lost);
+    fclose(f);
+  }
+  return failedConns > 0 ? 1 : 0;
+}
@@ -0,0 +1,165 @@
+#include "ota_backend_file.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "ota_backend.h"
+#include "sha256.h"
+
+static const uint32_t PARTITION_SIZE = 0x170000; // partitions-4M.csv 的 ota_0 / ota_1 大小
+
+static std::string stateDir;
+static std::string runningLabel = "ota_0";
+static std::vector<uint8_t> runningImage;
+static bool runningValid = false;  // otaBackendScanRunning() 的結果
+static FILE* target = nullptr;
+static uint32_t targetWritten = 0;
+static const char* lastError = "ESP_OK";
+
+static std::string slotPath(const std::string& label, const char* suffix = "") {
+  return stateDir + "/" + label + ".bin" + suffix;
+}
+
+static const char* nextLabel() {
+  return runningLabel == "ota_0" ? "ota_1" : "ota_0";
+}
+
+static bool readFile(const std::string& path, std::vector<uint8_t>* out) {
+  FILE* f = fopen(path.c_str(), "rb");
+  if (f == nullptr) return false;
+  out->clear();
+  uint8_t buf[65536];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out->insert(out->end(), buf, buf + n);
+  fclose(f);
+  return true;
+}
+
+static bool copyFile(const char* from, const std::string& to) {
+  std::vector<uint8_t> data;
+  if (!readFile(from, &data)) return false;
+  FILE* f = fopen(to.c_str(), "wb");
+  if (f == nullptr) return false;
+  bool ok = fwrite(data.data(), 1, data.size(), f) == data.size();
+  return fclose(f) == 0 && ok;
+}
+
+// 與 esp_ota_end 相同的基本檢查: 影像開頭 magic 與附加的 SHA-256
+static bool verifyImage(const std::vector<uint8_t>& image) {
+  if (image.size() <= Sha256::DIGEST_LEN || image[0] != 0xE9) return false;
+  Sha256 sha;
+  sha.update(image.data(), image.size() - Sha256::DIGEST_LEN);
+  uint8_t digest[Sha256::DIGEST_LEN];
+  sha.finish(digest);
+  return memcmp(digest, image.data() + image.size() - Sha256::DIGEST_LEN, Sha256::DIGEST_LEN) == 0;
+}
+
+bool otaFileBackendBoot(const char* dir, const char* initialImage) {
+  stateDir = dir;
+  runningLabel = "ota_0";
+  char label[16] = "";
+  FILE* f = fopen((stateDir + "/boot").c_str(), "r");
+  if (f != nullptr) {
+    if (fscanf(f, "%15s", label) == 1 && (strcmp(label, "ota_0") == 0 || strcmp(label, "ota_1") == 0)) {
+      runningLabel = label;
+    }
+    fclose(f);
+  } else if (initialImage != nullptr && !copyFile(initialImage, slotPath(runningLabel))) {
+    return false;
+  }
+  if (!readFile(slotPath(runningLabel), &runningImage)) runningImage.clear();
+  otaBackendScanRunning();
+  return true;
+}
+
+const uint8_t* otaFileBackendImage(size_t* size) {
+  *size = runningImage.size();
+  return runningImage.data();
+}
+
+bool otaBackendBegin(uint32_t imageSize) {
+  if (imageSize > PARTITION_SIZE) {
+    lastError = "ESP_ERR_INVALID_SIZE";
+    return false;
+  }
+  target = fopen(slotPath(nextLabel(), ".part").c_str(), "wb");
+  if (target == nullptr) {
+    lastError = "ESP_ERR_NOT_FOUND";
+    return false;
+  }
+  targetWritten = 0;
+  lastError = "ESP_OK";
+  return true;
+}
+
+bool otaBackendWrite(const uint8_t* data, size_t len) {
+  if (target == nullptr || targetWritten + len > PARTITION_SIZE) {
+    lastError = "ESP_ERR_INVALID_SIZE";
+    return false;
+  }
+  if (fwrite(data, 1, len, target) != len) {
+    lastError = "ESP_FAIL";
+    return false;
+  }
+  targetWritten += len;
+  return true;
+}
+
+bool otaBackendEnd(bool commit) {
+  if (target == nullptr) return !commit;
+  fclose(target);
+  target = nullptr;
+  std::string part = slotPath(nextLabel(), ".part");
+  if (!commit) {
+    remove(part.c_str());
+    return true;
+  }
+  std::vector<uint8_t> image;
+  if (!readFile(part, &image) || !verifyImage(image)) {
+    lastError = "ESP_ERR_OTA_VALIDATE_FAILED";
+    remove(part.c_str());
+    return false;
+  }
+  FILE* boot = fopen((stateDir + "/boot").c_str(), "w");
+  if (rename(part.c_str(), slotPath(nextLabel()).c_str()) != 0 || boot == nullptr) {
+    if (boot) fclose(boot);
+    lastError = "ESP_FAIL";
+    return false;
+  }
+  fprintf(boot, "%s\n", nextLabel());
+  fclose(boot);
+  return true;
+}
+
+const char* otaBackendTargetLabel() { return nextLabel(); }
+
+const char* otaBackendError() { return lastError; }
+
+const char* otaBackendRunningLabel() { return runningLabel.c_str(); }
+
+bool otaBackendScanRunning() {
+  runningValid = verifyImage(runningImage);
+  return runningValid;
+}
+
+bool otaBackendRunningImage(uint8_t sha256Out[32], uint32_t* sizeOut) {
+  if (!runningValid) {
+    lastError = "ESP_ERR_IMAGE_INVALID";
+    return false;
+  }
+  memcpy(sha256Out, runningImage.data() + runningImage.size() - Sha256::DIGEST_LEN, Sha256::DIGEST_LEN);
+  if (sizeOut) *sizeOut = (uint32_t)runningImage.size();
+  return true;
+}
+
+bool otaBackendReadRunning(uint32_t offset, uint8_t* buf, size_t len) {
+  if ((size_t)offset + len > runningImage.size()) {
+    lastError = "ESP_ERR_INVALID_ARG";
+    return false;
+  }
+  memcpy(buf, runningImage.data() + offset, len);
+  return true;
+}
@@ -0,0 +1,13 @@
+#pragma once
+// ota_backend.h 的主機端實作 (模擬器): 以目錄中的檔案模擬 ota_0 / ota_1 分區
+//   <dir>/ota_0.bin, <dir>/ota_1.bin  分區內容
+//   <dir>/boot                         下次開機的分區名稱 (等同 esp_ota_set_boot_partition)
+
+#include <stddef.h>
+#include <stdint.h>
+
+// 開機: 讀取 <dir>/boot 決定執行中的分區; 目錄內尚無影像時以 initialImage (可為 nullptr) 作為 ota_0。
+// 同時掃描執行中的影像 (otaBackendScanRunning)
+bool otaFileBackendBoot(const char* dir, const char* initialImage);
+// 執行中影像的內容 (沒有影像時 size 為 0)
+const uint8_t* otaFileBackendImage(size_t* size);
@@ -0,0 +1,223 @@
+// 擷取重播: 把 /capture 下載的控制流量 (或任何駕駛腳本) 依原始時間送進韌體的 CarControl,
+// 與裝置上 webSocketEvent() 相同的處理路徑, 輸出 PWM/STBY/狀態廣播/ping 回覆的摘要與每框處理時間。
+//
+//   replay --script field.txt [--speed 1] [--jitter 0] [--seed 1] [--repeat 1] [--tail-ms 500] [--pwm-log out.csv]
+//
+// 控制時鐘一律是虛擬的 (每 1 ms 一次 tick, 同裝置 loop()), 所以輸出摘要與 --speed 無關:
+//   --speed 1  以原始時間送出 (即時), --speed 10 快十倍, --speed 0 不等待 (預設, 量測效能用)
+//   --jitter N 每個文字框延後 0~N ms (依 --seed, 保持順序), 重現網路抖動造成的問題
+// 同一份輸入在不同版本上重播, 摘要 (outputs sha256) 相同即代表控制行為相同。
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "car_control.h"
+#include "drive_script.h"
+#include "gpio_pins.h"
+#include "hal_native.h"
+#include "sha256.h"
+
+typedef std::chrono::steady_clock Clock;
+
+struct ReplayOutput {
+  Sha256 digest;
+  FILE* pwmLog = nullptr;
+  uint32_t pwmWrites = 0;
+  uint32_t stbyChanges = 0;
+  uint32_t broadcasts = 0;
+};
+
+// 摘要內容: 每次輸出的 (虛擬時間, 種類, 值), 與 --pwm-log 的每一行相同
+static void emit(ReplayOutput* out, const char* name, const char* value) {
+  char line[320];
+  int n = snprintf(line, sizeof(line), "%u,%s,%s\n", halMillis(), name, value);
+  if (n >= (int)sizeof(line)) n = sizeof(line) - 1;
+  out->digest.update((const uint8_t*)line, (size_t)n);
+  if (out->pwmLog) fwrite(line, 1, (size_t)n, out->pwmLog);
+}
+
+static void onPwm(void* ctx, uint8_t channel, uint32_t duty) {
+  static const char* const NAMES[] = {"a_fwd", "a_rev", "b_left", "b_right"};
+  ReplayOutput* out = (ReplayOutput*)ctx;
+  char value[16];
+  snprintf(value, sizeof(value), "%u", duty);
+  emit(out, channel < 4 ? NAMES[channel] : "pwm?", value);
+  out->pwmWrites++;
+}
+
+static void onPin(void* ctx, uint8_t pin, bool high) {
+  ReplayOutput* out = (ReplayOutput*)ctx;
+  if (pin != motor_stby) return;
+  emit(out, "stby", high ? "1" : "0");
+  out->stbyChanges++;
+}
+
+static bool onBroadcast(void* ctx, const char* data, size_t len) {
+  ReplayOutput* out = (ReplayOutput*)ctx;
+  std::string value(data, std::min(len, (size_t)256));
+  emit(out, "ws", value.c_str());
+  out->broadcasts++;
+  return true;
+}
+
+// ping 的回覆 (只送給發送者)
+static bool onSend(void* ctx, int client, const char* data, size_t len) {
+  char name[16];
+  snprintf(name, sizeof(name), "ws#%d", client);
+  std::string value(data, std::min(len, (size_t)256));
+  emit((ReplayOutput*)ctx, name, value.c_str());
+  return true;
+}
+
+static void onLog(void*, const char*) {}
+
+static void usage() {
+  fprintf(stderr,
+          "usage: replay --script FILE [--speed X] [--jitter MS] [--seed N] [--repeat N] [--tail-ms MS]"
+          " [--pwm-log FILE]\n");
+  exit(2);
+}
+
+static uint32_t lcg(uint32_t& s) {
+  s = s * 1103515245u + 12345u;
+  return (s >> 16) & 0x7FFF;
+}
+
+// 文字框延後 0~jitter ms; TCP 不會重排, 所以保持原本順序
+static void applyJitter(std::vector<ScriptEvent>* events, uint32_t jitter, uint32_t seed) {
+  uint32_t rng = seed;
+  uint32_t last = 0;
+  for (auto& ev : *events) {
+    if (ev.type == ScriptEventType::TEXT) ev.atMs += lcg(rng) % (jitter + 1);
+    ev.atMs = std::max(ev.atMs, last);
+    last = ev.atMs;
+  }
+}
+
+static double percentile(std::vector<double> v, double q) {
+  if (v.empty()) return 0;
+  std::sort(v.begin(), v.end());
+  return v[(size_t)(q * (v.size() - 1) + 0.5)];
+}
+
+int main(int argc, char** argv) {
+  const char* scriptPath = nullptr;
+  const char* pwmLogPath = nullptr;
+  double speed = 0;
+  uint32_t jitter = 0, seed = 1, tailMs = 500;
+  int repeat = 1;
+  for (int i = 1; i < argc; i++) {
+    if (i + 1 >= argc) usage();
+    if (strcmp(argv[i], "--script") == 0) scriptPath = argv[++i];
+    else if (strcmp(argv[i], "--speed") == 0) speed = atof(argv[++i]);
+    else if (strcmp(argv[i], "--jitter") == 0) jitter = (uint32_t)atoi(argv[++i]);
+    else if (strcmp(argv[i], "--seed") == 0) seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    else if (strcmp(argv[i], "--repeat") == 0) repeat = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--tail-ms") == 0) tailMs = (uint32_t)atoi(argv[++i]);
+    else if (strcmp(argv[i], "--pwm-log") == 0) pwmLogPath = argv[++i];
+    else usage();
+  }
+  if (scriptPath == nullptr || speed < 0 || repeat < 1) usage();
+
+  std::vector<ScriptEvent> events;
+  std::string error;
+  if (!loadDriveScript(scriptPath, &events, &error)) {
+    fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+  if (jitter > 0) applyJitter(&events, jitter, seed);
+
+  std::vector<double> frameNs;
+  double tickNs = 0;
+  uint64_t ticks = 0;
+  char firstHex[Sha256::DIGEST_LEN * 2 + 1] = "";
+  ControlStats stats = {};
+  ReplayOutput last;
+  bool deterministic = true;
+  uint32_t endMs = (events.empty() ? 0 : events.back().atMs) + tailMs;
+
+  for (int run = 0; run < repeat; run++) {
+    ReplayOutput out;
+    if (run == 0 && pwmLogPath) {
+      out.pwmLog = fopen(pwmLogPath, "w");
+      if (out.pwmLog == nullptr) {
+        perror(pwmLogPath);
+        return 1;
+      }
+      fprintf(out.pwmLog, "ms,output,value\n");
+    }
+    halNativeReset();
+    halNative.onPwm = onPwm;
+    halNative.onPin = onPin;
+    halNative.onBroadcast = onBroadcast;
+    halNative.onSend = onSend;
+    halNative.onLog = onLog;
+    halNative.hookCtx = &out;
+
+    CarControl car;
+    car.begin();
+    size_t next = 0;
+    Clock::time_point wallStart = Clock::now();
+    for (uint32_t ms = 0; ms <= endMs; ms++) {
+      if (speed > 0) {
+        std::this_thread::sleep_until(wallStart + std::chrono::duration_cast<Clock::duration>(
+                                                      std::chrono::duration<double, std::milli>(ms / speed)));
+      }
+      halNative.nowMs = ms;
+      while (next < events.size() && events[next].atMs <= ms) {
+        const ScriptEvent& ev = events[next++];
+        if (ev.type == ScriptEventType::TEXT) {
+          Clock::time_point t0 = Clock::now();
+          car.handleText(ev.payload.data(), ev.payload.size());
+          frameNs.push_back(std::chrono::duration<double, std::nano>(Clock::now() - t0).count());
+        } else if (ev.type == ScriptEventType::DISCONNECT) {
+          car.onClientDisconnected(ev.client);
+        }
+      }
+      Clock::time_point t0 = Clock::now();
+      car.tick();
+      tickNs += std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+      ticks++;
+    }
+    if (out.pwmLog) fclose(out.pwmLog);
+    out.pwmLog = nullptr;
+
+    uint8_t sha[Sha256::DIGEST_LEN];
+    char hex[Sha256::DIGEST_LEN * 2 + 1];
+    out.digest.finish(sha);
+    Sha256::toHex(sha, hex);
+    if (run == 0) strcpy(firstHex, hex);
+    else if (strcmp(hex, firstHex) != 0) deterministic = false;
+    stats = car.stats();
+    last.pwmWrites = out.pwmWrites;
+    last.stbyChanges = out.stbyChanges;
+    last.broadcasts = out.broadcasts;
+  }
+  halNativeReset();
+
+  size_t texts = 0;
+  for (const auto& ev : events) texts += ev.type == ScriptEventType::TEXT ? 1 : 0;
+  char speedText[16] = "max";
+  if (speed > 0) snprintf(speedText, sizeof(speedText), "%gx", speed);
+  printf("%s: %zu events (%zu frames), %.3f s, speed %s, jitter %u ms, %d run(s)\n", scriptPath, events.size(), texts,
+         endMs / 1000.0, speedText, jitter, repeat);
+  printf("control      frames=%u applied=%u ignored=%u errors=%u\n", stats.frames, stats.applied, stats.ignored,
+         stats.parseErrors);
+  printf("outputs      pwm_writes=%u stby_changes=%u broadcasts=%u sha256=%s\n", last.pwmWrites, last.stbyChanges,
+         last.broadcasts, firstHex);
+  printf("handleText   n=%zu p50=%.0f ns p99=%.0f ns max=%.0f ns\n", frameNs.size(), percentile(frameNs, 0.5),
+         percentile(frameNs, 0.99), frameNs.empty() ? 0 : *std::max_element(frameNs.begin(), frameNs.end()));
+  printf("tick         mean=%.1f ns\n", ticks ? tickNs / ticks : 0);
+  if (!deterministic) {
+    fprintf(stderr, "outputs differ between runs\n");
+    return 1;
+  }
+  return 0;
+}
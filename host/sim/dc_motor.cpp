@@ -0,0 +1,48 @@
+#include "dc_motor.h"
+
+#include <math.h>
+
+namespace {
+
+// 端電壓 v 固定時的精確解: i(t) = iss + (i0 - iss)·e^(-t/τ)
+// clampAtZero: fast decay 時二極體不允許電流反向, 過零後維持 0。回傳期間的電荷 (∫i dt)。
+double integrate(double& i, double v, double emf, const MotorParams& p, double t, bool clampAtZero) {
+  if (t <= 0) return 0;
+  double tau = p.inductance / p.resistance;
+  double iss = (v - emf) / p.resistance;
+  if (clampAtZero && i != 0 && iss * i < 0) {
+    // 過零時間 t0 = τ·ln((i0 - iss) / -iss)
+    double t0 = tau * log((i - iss) / -iss);
+    if (t0 < t) {
+      double q = iss * t0 + (i - iss) * tau * (1 - exp(-t0 / tau));
+      i = 0;
+      return q;
+    }
+  }
+  double decay = exp(-t / tau);
+  double q = iss * t + (i - iss) * tau * (1 - decay);
+  i = iss + (i - iss) * decay;
+  return q;
+}
+
+}  // namespace
+
+double stepMotorElectrical(DcMotor& m, const MotorParams& p, const BridgeParams& b, const BridgeInput& in,
+                           double omega, double dt) {
+  double emf = p.ke * omega;
+  double d1 = in.enabled ? in.in1 : 0;
+  double d2 = in.enabled ? in.in2 : 0;
+  // 兩輸入同時為 1 的部分是 brake (低側短路), 只有一邊為 1 的部分是驅動, 其餘為 fast decay
+  double brake = d1 < d2 ? d1 : d2;
+  double on = fabs(d1 - d2);
+  double off = 1 - brake - on;
+
+  double q = integrate(m.current, 0, emf, p, brake * dt, false);
+  q += integrate(m.current, d1 > d2 ? b.supply : -b.supply, emf, p, on * dt, false);
+  if (m.current != 0) {
+    // Hi-Z: 端電壓 = -sign(i)·(Vs + 2·Vf)
+    double v = b.supply + 2 * b.diodeDrop;
+    q += integrate(m.current, m.current > 0 ? -v : v, emf, p, off * dt, true);
+  }
+  return q / dt;
+}
@@ -0,0 +1,33 @@
+#pragma once
+// DRV8833 H 橋與有刷直流馬達的電氣模型
+// 模擬步長等於一個 PWM 週期 (20 kHz → 50 µs): 每步先導通 duty 比例的時間, 其餘時間為 DRV8833 的
+// fast decay (兩輸入皆 0 → Hi-Z, 電流經本體二極體回流到電源直到歸零), 因此可重現電流斷續的低 duty 區。
+
+struct MotorParams {
+  double resistance = 4.0;     // Ω, 端電阻 (含 DRV8833 HS+LS Rds(on) 0.36 Ω)
+  double inductance = 1.5e-3;  // H
+  double ke = 0.0055;          // V·s/rad = Kt (N·m/A)
+  double rotorInertia = 1e-7;  // kg·m²
+  double viscous = 2e-8;       // N·m·s/rad
+  double coulomb = 8e-4;       // N·m, 無載電流 ~0.15 A 對應的摩擦
+};
+
+struct BridgeParams {
+  double supply = 7.4;         // V, 2S 鋰電池
+  double diodeDrop = 0.7;      // V, fast decay 回流路徑上的兩個本體二極體各一
+};
+
+// 一個 H 橋通道的輸入 (duty 0..1)。car_control 只會讓其中一個非 0。
+struct BridgeInput {
+  double in1;
+  double in2;
+  bool enabled;                // STBY
+};
+
+struct DcMotor {
+  double current = 0;          // A (正值 = in1 方向)
+};
+
+// 推進一個 PWM 週期; omega 為馬達轉速 (rad/s, 視為此期間常數)。回傳期間內的平均電流。
+double stepMotorElectrical(DcMotor& m, const MotorParams& p, const BridgeParams& b, const BridgeInput& in,
+                           double omega, double dt);
@@ -0,0 +1,83 @@
+#include "drive_script.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+static int hexDigit(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+// 還原 \\ \n \r \xHH; 其他反斜線保持原樣
+static std::string unescape(const char* p) {
+  std::string out;
+  for (; *p; p++) {
+    if (*p != '\\' || p[1] == '\0') {
+      out += *p;
+    } else if (p[1] == '\\' || p[1] == 'n' || p[1] == 'r') {
+      out += p[1] == 'n' ? '\n' : (p[1] == 'r' ? '\r' : '\\');
+      p++;
+    } else if (p[1] == 'x' && hexDigit(p[2]) >= 0 && hexDigit(p[3]) >= 0) {
+      out += (char)(hexDigit(p[2]) << 4 | hexDigit(p[3]));
+      p += 3;
+    } else {
+      out += *p;
+    }
+  }
+  return out;
+}
+
+bool loadDriveScript(const char* path, std::vector<ScriptEvent>* events, std::string* error) {
+  FILE* f = fopen(path, "r");
+  if (f == nullptr) {
+    *error = std::string("cannot open ") + path;
+    return false;
+  }
+  events->clear();
+  char line[8192]; // 擷取檔的一個框跳脫後最長約 4 KB
+  int lineNo = 0;
+  bool ok = true;
+  while (ok && fgets(line, sizeof(line), f)) {
+    lineNo++;
+    line[strcspn(line, "\r\n")] = '\0';
+    char* p = line;
+    while (*p == ' ' || *p == '\t') p++;
+    if (*p == '\0' || *p == '#') continue;
+
+    char* end;
+    unsigned long start = strtoul(p, &end, 10);
+    unsigned long stop = start + 1, period = 1;
+    if (end != p && *end == '-') {
+      stop = strtoul(end + 1, &end, 10);
+      if (*end != '/') end = p; // 格式錯誤
+      else period = strtoul(end + 1, &end, 10);
+    }
+    if (end == p || (*end != ' ' && *end != '\t') || period == 0 || stop <= start) {
+      *error = std::string(path) + ":" + std::to_string(lineNo) + ": expected '<ms> <payload>' or '<start>-<end>/<period> <payload>'";
+      ok = false;
+      break;
+    }
+    while (*end == ' ' || *end == '\t') end++;
+    ScriptEvent ev;
+    if (strncmp(end, "@connect ", 9) == 0 || strncmp(end, "@disconnect ", 12) == 0) {
+      bool connect = end[1] == 'c';
+      ev.type = connect ? ScriptEventType::CONNECT : ScriptEventType::DISCONNECT;
+      ev.client = atoi(end + (connect ? 9 : 12));
+    } else {
+      ev.payload = unescape(end);
+    }
+    for (unsigned long t = start; t < stop; t += period) {
+      ev.atMs = (uint32_t)t;
+      events->push_back(ev);
+    }
+  }
+  fclose(f);
+  std::stable_sort(events->begin(), events->end(),
+                   [](const ScriptEvent& a, const ScriptEvent& b) { return a.atMs < b.atMs; });
+  return ok;
+}
@@ -0,0 +1,24 @@
+#pragma once
+// 駕駛腳本: 依時間送進 CarControl::handleText() 的 WebSocket 文字框
+// 每行一個事件, '#' 開頭的行為註解:
+//   <ms> <payload>                       在 ms 時送出一次, 例如  0 {"steer":0,"throttle":80}
+//   <start>-<end>/<period> <payload>     從 start 到 end (不含) 每 period ms 送出一次 (瀏覽器 50 ms 定時送出)
+//   <ms> @connect <n> / @disconnect <n>  控制端連線事件 (斷線時 CarControl 立即停車)
+// payload 中的 \\ \n \r \xHH 會還原成原始位元組 (src/capture.h 匯出的擷取檔即此格式)。
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+enum class ScriptEventType { TEXT, CONNECT, DISCONNECT };
+
+struct ScriptEvent {
+  uint32_t atMs;
+  std::string payload;
+  ScriptEventType type = ScriptEventType::TEXT;
+  int client = 0;
+};
+
+// 事件依時間排序 (同時間保留檔案順序); 失敗時 error 含行號
+bool loadDriveScript(const char* path, std::vector<ScriptEvent>* events, std::string* error);
@@ -0,0 +1,113 @@
+// 車體動態模擬器: 以駕駛腳本驅動韌體的 CarControl, 將實際寫入的 PWM 送進 VehicleSim, 輸出軌跡 CSV
+//
+//   sim --script drive.txt [--chassis ackermann|4wd] [--out trace.csv] [--trace-ms 10] [--tail-ms 1500]
+//       [--supply 7.4]
+//
+// 控制迴圈每 1 ms 執行一次 (等同裝置 loop() 的 delay(1)), 腳本結束後再模擬 --tail-ms 觀察停車過程。
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "car_control.h"
+#include "drive_script.h"
+#include "gpio_pins.h"
+#include "hal_native.h"
+#include "vehicle_sim.h"
+
+static void usage() {
+  fprintf(stderr,
+          "usage: sim --script FILE [--chassis ackermann|4wd] [--out trace.csv] [--trace-ms 10] [--tail-ms 1500]"
+          " [--supply V]\n");
+  exit(2);
+}
+
+// 實際寫到 LEDC / STBY 的值 (而不是 CarControl 的內部狀態)
+static MotorOutputs pinOutputs() {
+  MotorOutputs out;
+  out.aFwd = (uint16_t)halNative.pwm[CH_A_FWD];
+  out.aRev = (uint16_t)halNative.pwm[CH_A_REV];
+  out.bLeft = (uint16_t)halNative.pwm[CH_B_LEFT];
+  out.bRight = (uint16_t)halNative.pwm[CH_B_RIGHT];
+  out.standby = halNative.pins[motor_stby];
+  return out;
+}
+
+int main(int argc, char** argv) {
+  const char* scriptPath = nullptr;
+  const char* outPath = nullptr;
+  VehicleParams params = VehicleParams::ackermann();
+  uint32_t traceMs = 10, tailMs = 1500;
+  double supply = 0;
+  for (int i = 1; i < argc; i++) {
+    if (i + 1 >= argc) usage();
+    if (strcmp(argv[i], "--script") == 0) scriptPath = argv[++i];
+    else if (strcmp(argv[i], "--out") == 0) outPath = argv[++i];
+    else if (strcmp(argv[i], "--trace-ms") == 0) traceMs = (uint32_t)atoi(argv[++i]);
+    else if (strcmp(argv[i], "--tail-ms") == 0) tailMs = (uint32_t)atoi(argv[++i]);
+    else if (strcmp(argv[i], "--supply") == 0) supply = atof(argv[++i]);
+    else if (strcmp(argv[i], "--chassis") == 0) {
+      const char* c = argv[++i];
+      if (strcmp(c, "ackermann") == 0) params = VehicleParams::ackermann();
+      else if (strcmp(c, "4wd") == 0) params = VehicleParams::fourWheelDrive();
+      else usage();
+    } else usage();
+  }
+  if (scriptPath == nullptr || traceMs == 0) usage();
+  if (supply > 0) params.bridge.supply = supply;
+
+  std::vector<ScriptEvent> events;
+  std::string error;
+  if (!loadDriveScript(scriptPath, &events, &error)) {
+    fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+  FILE* out = stdout;
+  if (outPath && (out = fopen(outPath, "w")) == nullptr) {
+    perror(outPath);
+    return 1;
+  }
+
+  halNativeReset();
+  CarControl car;
+  car.begin();
+  VehicleSim sim(params);
+  fprintf(out, "ms,stby,a_fwd,a_rev,b_left,b_right,i_a,i_b,speed,left,right,steer_deg,yaw_rate,x,y,heading_deg\n");
+
+  uint32_t endMs = (events.empty() ? 0 : events.back().atMs) + tailMs;
+  size_t next = 0;
+  double maxSpeed = 0;
+  auto wallStart = std::chrono::steady_clock::now();
+  for (uint32_t ms = 0; ms <= endMs; ms++) {
+    halNative.nowMs = ms;
+    while (next < events.size() && events[next].atMs <= ms) {
+      const ScriptEvent& ev = events[next++];
+      if (ev.type == ScriptEventType::TEXT) car.handleText(ev.payload.data(), ev.payload.size());
+      else if (ev.type == ScriptEventType::DISCONNECT) car.onClientDisconnected(ev.client);
+    }
+    car.tick();
+    MotorOutputs pins = pinOutputs();
+    if (ms % traceMs == 0) {
+      const VehicleState& s = sim.state();
+      fprintf(out, "%u,%d,%u,%u,%u,%u,%.4f,%.4f,%.4f,%.4f,%.4f,%.2f,%.4f,%.4f,%.4f,%.2f\n", ms, pins.standby ? 1 : 0,
+              pins.aFwd, pins.aRev, pins.bLeft, pins.bRight, s.current[0], s.current[1], s.speed, s.sideSpeed[0],
+              s.sideSpeed[1], s.steerAngle * 180 / M_PI, s.yawRate, s.x, s.y, s.heading * 180 / M_PI);
+    }
+    sim.step(pins, 0.001);
+    if (fabs(sim.state().speed) > maxSpeed) maxSpeed = fabs(sim.state().speed);
+  }
+  double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+  if (out != stdout) fclose(out);
+
+  const VehicleState& s = sim.state();
+  fprintf(stderr, "%s: %zu frames, %.2f s simulated in %.3f s (%.0fx real time)\n", scriptPath, events.size(), s.t,
+          wall, s.t / (wall > 0 ? wall : 1e-9));
+  fprintf(stderr, "final pose x=%.3f m y=%.3f m heading=%.1f deg, speed %.3f m/s, max speed %.3f m/s\n", s.x, s.y,
+          s.heading * 180 / M_PI, s.speed, maxSpeed);
+  return 0;
+}
@@ -0,0 +1,96 @@
+#include "vehicle_sim.h"
+
+#include <math.h>
+
+static const double G = 9.81;
+static const double STICTION_SPEED = 1e-4; // m/s 以下視為靜止
+
+VehicleParams VehicleParams::ackermann() { return VehicleParams(); }
+
+VehicleParams VehicleParams::fourWheelDrive() {
+  VehicleParams p;
+  p.chassis = Chassis::SKID_4WD;
+  p.mass = 0.9;
+  p.motorsPerSide = 2;
+  p.rollingResistance = 0.05;
+  return p;
+}
+
+VehicleSim::VehicleSim(const VehicleParams& params) : _p(params) {}
+
+static BridgeInput bridge(uint16_t in1, uint16_t in2, bool enabled) {
+  return BridgeInput{(double)in1 / MAX_DUTY, (double)in2 / MAX_DUTY, enabled};
+}
+
+static double sign(double v) { return v > 0 ? 1 : (v < 0 ? -1 : 0); }
+
+double VehicleSim::stepDrive(DcMotor& m, const BridgeInput& in, double speed, int motors, double mass, double dt,
+                             double* current) {
+  const MotorParams& mp = _p.motor;
+  double omega = speed * _p.gearRatio / _p.wheelRadius;
+  double iAvg = stepMotorElectrical(m, mp, _p.bridge, in, omega, dt);
+  *current = iAvg * motors;
+
+  // 車輪上的力: 馬達轉矩經齒輪 (效率只折減驅動方向), 摩擦與滾動阻力
+  double k = _p.gearRatio / _p.wheelRadius;
+  double motorTorque = mp.ke * iAvg;
+  double drive = motors * motorTorque * k * (motorTorque * omega >= 0 ? _p.gearEfficiency : 1.0);
+  double viscous = motors * mp.viscous * omega * k;
+  double friction = motors * mp.coulomb * k + _p.rollingResistance * mass * G;
+  // 反射到車體的等效質量 (轉子慣量 × 齒比²)
+  double massEq = mass + motors * mp.rotorInertia * k * k;
+
+  if (fabs(speed) < STICTION_SPEED && fabs(drive) <= friction) return 0;
+  double net = drive - viscous - friction * sign(fabs(speed) < STICTION_SPEED ? drive : speed);
+  double next = speed + net / massEq * dt;
+  // 摩擦只能讓車停下, 不會反向推動
+  if (fabs(speed) >= STICTION_SPEED && sign(next) != sign(speed) && fabs(drive) <= friction) return 0;
+  return next;
+}
+
+void VehicleSim::stepSteering(const BridgeInput& in, double dt) {
+  const MotorParams& mp = _p.motor;
+  double iAvg = stepMotorElectrical(_motor[1], mp, _p.bridge, in, _s.steerOmega, dt);
+  _s.current[1] = iAvg;
+
+  // in1 = CH_B_LEFT (左轉為正角度), 彈簧與限位作用在轉向角上, 經齒輪反射到馬達
+  double torque = mp.ke * iAvg - mp.viscous * _s.steerOmega - _p.steerSpring * _s.steerAngle / _p.steerGear;
+  if (fabs(_s.steerOmega) < 1e-3 && fabs(torque) <= mp.coulomb) {
+    _s.steerOmega = 0;
+  } else {
+    torque -= mp.coulomb * sign(fabs(_s.steerOmega) < 1e-3 ? torque : _s.steerOmega);
+    _s.steerOmega += torque / (mp.rotorInertia * 4) * dt; // 轉向齒輪組慣量約為轉子的 3 倍
+  }
+  _s.steerAngle += _s.steerOmega / _p.steerGear * dt;
+  if (fabs(_s.steerAngle) >= _p.steerMax) {
+    _s.steerAngle = _p.steerMax * sign(_s.steerAngle);
+    if (_s.steerOmega * _s.steerAngle > 0) _s.steerOmega = 0;
+  }
+}
+
+void VehicleSim::step(const MotorOutputs& out, double dt) {
+  const double period = 1.0 / PWM_FREQ;
+  for (double left = dt; left > 1e-12; left -= period) {
+    double h = left < period ? left : period;
+    if (_p.chassis == Chassis::ACKERMANN) {
+      _s.speed = stepDrive(_motor[0], bridge(out.aFwd, out.aRev, out.standby), _s.speed, 1, _p.mass, h,
+                           &_s.current[0]);
+      _s.sideSpeed[0] = _s.speed;
+      stepSteering(bridge(out.bLeft, out.bRight, out.standby), h);
+      _s.yawRate = _s.speed * tan(_s.steerAngle) / _p.wheelbase;
+    } else {
+      // 左側: Motor A (fwd 為前進), 右側: Motor B (CH_B_RIGHT 在 ACKERMANN 為右轉, 這裡接成前進)
+      double half = _p.mass / 2;
+      _s.sideSpeed[0] = stepDrive(_motor[0], bridge(out.aFwd, out.aRev, out.standby), _s.sideSpeed[0],
+                                  _p.motorsPerSide, half, h, &_s.current[0]);
+      _s.sideSpeed[1] = stepDrive(_motor[1], bridge(out.bRight, out.bLeft, out.standby), _s.sideSpeed[1],
+                                  _p.motorsPerSide, half, h, &_s.current[1]);
+      _s.speed = (_s.sideSpeed[0] + _s.sideSpeed[1]) / 2;
+      _s.yawRate = (_s.sideSpeed[1] - _s.sideSpeed[0]) / (_p.track * _p.skidFactor);
+    }
+    _s.heading += _s.yawRate * h;
+    _s.x += _s.speed * cos(_s.heading) * h;
+    _s.y += _s.speed * sin(_s.heading) * h;
+    _s.t += h;
+  }
+}
@@ -0,0 +1,66 @@
+#pragma once
+// 車體動態模擬: car_control 的 PWM 決策 → DRV8833 → 直流馬達 → 車輛運動
+//   ACKERMANN: Motor A 驅動後輪, Motor B 為轉向馬達 (齒輪 + 回正彈簧 + 限位), 自行車模型
+//   SKID_4WD:  Motor A 為左側兩顆、Motor B 為右側兩顆馬達 (並聯於同一通道), 差速轉向
+// 以 PWM 週期為步長, 比即時快數百倍; 只模擬平面運動, 不含輪胎側滑。
+
+#include <stdint.h>
+
+#include "car_control.h"
+#include "dc_motor.h"
+
+enum class Chassis : uint8_t { ACKERMANN, SKID_4WD };
+
+struct VehicleParams {
+  Chassis chassis = Chassis::ACKERMANN;
+  MotorParams motor;
+  BridgeParams bridge;
+  double mass = 0.6;            // kg
+  double gearRatio = 48;        // 馬達:車輪
+  double gearEfficiency = 0.7;
+  double wheelRadius = 0.033;   // m
+  double rollingResistance = 0.03;
+  int motorsPerSide = 1;        // SKID_4WD: 每側並聯的馬達數
+  // ACKERMANN 轉向
+  double wheelbase = 0.14;      // m
+  double steerGear = 60;        // 馬達 rad / 轉向角 rad
+  double steerMax = 0.45;       // rad, 限位
+  double steerSpring = 0.6;     // N·m/rad (轉向角上的回正彈簧)
+  // SKID_4WD 差速
+  double track = 0.13;          // m
+  double skidFactor = 1.4;      // 有效輪距倍數 (打滑使實際轉向率較理論小)
+
+  static VehicleParams ackermann();
+  static VehicleParams fourWheelDrive();
+};
+
+struct VehicleState {
+  double t = 0;                 // s
+  double x = 0, y = 0;          // m
+  double heading = 0;           // rad, 逆時針為正
+  double speed = 0;             // m/s (前進為正, SKID_4WD 為左右平均)
+  double yawRate = 0;           // rad/s
+  double steerAngle = 0;        // rad, ACKERMANN 正值為左轉
+  double sideSpeed[2] = {0, 0}; // m/s, SKID_4WD 左/右 (ACKERMANN 只用 [0])
+  double current[2] = {0, 0};   // A, 通道 A / B 的平均電流
+  double steerOmega = 0;        // rad/s, 轉向馬達
+};
+
+class VehicleSim {
+public:
+  explicit VehicleSim(const VehicleParams& params);
+
+  // 以目前的 H 橋輸出 (duty 0..MAX_DUTY) 推進 dt 秒 (內部以 PWM 週期分割)
+  void step(const MotorOutputs& out, double dt);
+  const VehicleState& state() const { return _s; }
+  const VehicleParams& params() const { return _p; }
+
+private:
+  // 一側驅動輪: 回傳新速度 (m/s)
+  double stepDrive(DcMotor& m, const BridgeInput& in, double speed, int motors, double mass, double dt, double* current);
+  void stepSteering(const BridgeInput& in, double dt);
+
+  VehicleParams _p;
+  VehicleState _s;
+  DcMotor _motor[2];
+};
@@ -0,0 +1,38 @@
+#pragma once
+// 建置變體: platformio.ini 的每個 [env:car-*] 以 -D 旗標注入, 這裡轉成 constexpr 給程式碼使用。
+// 功能開關 (CAR_FEATURE_*) 為 0 時, 對應的路由、全域緩衝與程式碼不進入映像 (main.cpp 以 #if 包住);
+// CAR_MIX / CAR_CURVES 讓命令路徑在編譯時決定混控方式與是否查反應曲線 (car_control.cpp)。
+// 沒有旗標時 (esp32c3-car env、主機端測試與模擬器) 全部啟用, 混控由設定 (profile / NVS) 決定。
+// 各變體的映像大小與控制路徑效能: tools/variant_report.py
+
+#ifndef CAR_VARIANT
+#define CAR_VARIANT "generic"
+#endif
+#ifndef CAR_MIX
+#define CAR_MIX -1             // -1: 執行期依設定; 0 = MIX_STEER, 1 = MIX_DIFF
+#endif
+#ifndef CAR_CURVES
+#define CAR_CURVES 1           // 0: 不套用反應曲線 (expo_* 設定不生效)
+#endif
+#ifndef CAR_FEATURE_VIDEO
+#define CAR_FEATURE_VIDEO 1    // /stream、/frame.jpg、/video: 相機節點的 MJPEG 轉送
+#endif
+#ifndef CAR_FEATURE_FLEET
+#define CAR_FEATURE_FLEET 1    // /fleet 儀表板與 /peers (mDNS 查詢其他車)
+#endif
+#ifndef CAR_FEATURE_CAPTURE
+#define CAR_FEATURE_CAPTURE 1  // /capture: 控制流量擷取 (CAPTURE_BYTES 的 RAM)
+#endif
+#ifndef CAR_FEATURE_SERVO
+#define CAR_FEATURE_SERVO 1    // steer_mode 1: 以伺服取代 Motor B 轉向 (car_control.cpp)
+#endif
+
+namespace variant {
+constexpr const char* NAME = CAR_VARIANT;
+constexpr int MIX = CAR_MIX;
+constexpr bool CURVES = CAR_CURVES != 0;
+constexpr bool VIDEO = CAR_FEATURE_VIDEO != 0;
+constexpr bool FLEET = CAR_FEATURE_FLEET != 0;
+constexpr bool CAPTURE = CAR_FEATURE_CAPTURE != 0;
+constexpr bool SERVO = CAR_FEATURE_SERVO != 0;
+}  // namespace variant
@@ -1,11 +1,10 @@
+#pragma once
 // --- 馬達驅動晶片 GPIO 設定 (Motor H-Bridge DRV8833) ---
-//const int motorA_pwm_fwd = 6;
-//const int motorA_pwm_rev = 5;
-//const int motorB_pwm_left  = 20;
-//const int motorB_pwm_right = 21;
-//const int motor_stby = 7; // 設定 HIGH 啟用馬達
+// 預設腳位; 每台車的腳位在 src/car_profiles.cpp (另一組接線 6/5/20/21/7 為 "alt-pins")
 const int motorA_pwm_fwd = 3;
 const int motorA_pwm_rev = 2;
 const int motorB_pwm_left  = 10;
 const int motorB_pwm_right = 7;
 const int motor_stby = 4; // 設定 HIGH 啟用馬達
+// 轉向伺服的訊號腳位 (steer_mode 1 時使用, 取代 Motor B)
+const int servo_pwm = 1;
@@ -0,0 +1,144 @@
+#include "boot_selftest.h"
+
+#include <Arduino.h>
+#include <esp_ota_ops.h>
+#include <esp_partition.h>
+#include <esp_timer.h>
+
+void sendLogMessage(const String& message); // main.cpp
+
+// 整體時限: 涵蓋 connectToWiFi() 的 15 秒超時與控制迴圈量測
+static const uint32_t SELFTEST_BUDGET_MS = 30000;
+static const uint32_t NETWORK_BUDGET_MS = 20000;
+// 控制迴圈量測: 2 秒內至少 200 次, 且任兩次間隔不超過 50 ms (COMMAND_TIMEOUT 的 1/6)
+static const uint32_t TICK_WINDOW_MS = 2000;
+static const uint32_t MIN_TICK_RATE_HZ = 200;
+static const uint32_t MAX_TICK_GAP_MS = 50;
+
+static volatile SelfTestState state = SelfTestState::NOT_REQUIRED;
+static bool pwmOk = false;
+static bool networkOk = false;
+static uint32_t windowStartMs = 0;
+static uint32_t lastTickMs = 0;
+static uint32_t tickCount = 0;
+static uint32_t maxGapMs = 0;
+static esp_timer_handle_t deadlineTimer = nullptr;
+
+// Arduino core 的 initArduino() 預設在開機時直接標記影像有效; 改由自我測試決定
+extern "C" bool verifyRollbackLater() { return true; }
+
+// 標記目前影像無效並重新開機, 不阻塞也不使用 Serial: esp_timer 回呼中也可以呼叫
+static void rollbackAndReboot() {
+  esp_ota_mark_app_invalid_rollback_and_reboot();
+  // 沒有其他有效的 OTA 影像時退回 Factory (Launcher App)
+  const esp_partition_t* factory =
+      esp_partition_find_first(ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_FACTORY, NULL);
+  if (factory != NULL) esp_ota_set_boot_partition(factory);
+  esp_restart();
+}
+
+// setup()/loop() 中的失敗: 先留下序列埠訊息再回滾
+static void rollback(const char* reason) {
+  if (state == SelfTestState::FAILED) return;
+  state = SelfTestState::FAILED;
+  if (deadlineTimer) esp_timer_stop(deadlineTimer);
+  ESP_LOGE("selftest", "Self-test failed (%s), rolling back", reason);
+  Serial.printf("SELFTEST FAILED: %s. Rolling back to previous app...\n", reason);
+  delay(100);
+  rollbackAndReboot();
+}
+
+// esp_timer 任務中執行: 不能 delay 或寫 Serial (loop 可能正持有 UART), 直接回滾
+static void onDeadline(void*) {
+  if (state != SelfTestState::PENDING) return;
+  state = SelfTestState::FAILED;
+  ESP_DRAM_LOGE(DRAM_STR("selftest"), "self-test did not finish within budget, rolling back");
+  rollbackAndReboot();
+}
+
+void bootSelfTestBegin() {
+  esp_ota_img_states_t imgState;
+  const esp_partition_t* running = esp_ota_get_running_partition();
+  if (esp_ota_get_state_partition(running, &imgState) != ESP_OK) {
+    state = SelfTestState::NOT_REQUIRED;
+    return;
+  }
+  if (imgState == ESP_OTA_IMG_NEW) {
+    // OTA 後的第一次開機, 但 bootloader 沒有把影像改成 PENDING_VERIFY: 它是不支援回滾的舊版,
+    // 只有經序列埠燒錄一次新的 bootloader 才能啟用 (OTA 只更新 app)
+    state = SelfTestState::NO_ROLLBACK;
+    ESP_LOGW("selftest", "bootloader has no rollback support, flash it once over serial");
+    Serial.println("SELFTEST: new image was not set to PENDING_VERIFY; bootloader has no rollback support "
+                   "(flash the bootloader once over serial)");
+    return;
+  }
+  if (imgState != ESP_OTA_IMG_PENDING_VERIFY) {
+    state = SelfTestState::NOT_REQUIRED;
+    return;
+  }
+  state = SelfTestState::PENDING;
+  Serial.println("SELFTEST: new image pending verification");
+  // 以 esp_timer 執行, 即使 setup()/loop() 卡住也會觸發回滾
+  esp_timer_create_args_t args = {};
+  args.callback = onDeadline;
+  args.name = "selftest";
+  if (esp_timer_create(&args, &deadlineTimer) == ESP_OK) {
+    esp_timer_start_once(deadlineTimer, (uint64_t)SELFTEST_BUDGET_MS * 1000);
+  }
+}
+
+void bootSelfTestReportPwm(bool ok) {
+  pwmOk = ok;
+  if (state == SelfTestState::PENDING && !ok) rollback("PWM init failed");
+}
+
+void bootSelfTestReportNetwork(bool ok) {
+  networkOk = ok && millis() <= NETWORK_BUDGET_MS;
+  if (state == SelfTestState::PENDING && !networkOk) rollback("network not ready within budget");
+}
+
+void bootSelfTestControlTick(uint32_t nowMs) {
+  if (state != SelfTestState::PENDING || !networkOk) return;
+  if (tickCount == 0) {
+    windowStartMs = lastTickMs = nowMs;
+    tickCount = 1;
+    return;
+  }
+  uint32_t gap = nowMs - lastTickMs;
+  if (gap > maxGapMs) maxGapMs = gap;
+  lastTickMs = nowMs;
+  tickCount++;
+  if (nowMs - windowStartMs < TICK_WINDOW_MS) return;
+
+  uint32_t rateHz = (uint32_t)((uint64_t)tickCount * 1000 / (nowMs - windowStartMs));
+  if (rateHz < MIN_TICK_RATE_HZ || maxGapMs > MAX_TICK_GAP_MS) {
+    rollback("control loop too slow");
+    return;
+  }
+  if (!pwmOk) {
+    rollback("PWM init not reported");
+    return;
+  }
+  esp_err_t err = esp_ota_mark_app_valid_cancel_rollback();
+  if (err != ESP_OK) {
+    rollback("mark valid failed");
+    return;
+  }
+  if (deadlineTimer) esp_timer_stop(deadlineTimer);
+  state = SelfTestState::PASSED;
+  sendLogMessage("SELFTEST passed: control loop " + String(rateHz) + " Hz (max gap " + String(maxGapMs) +
+                 " ms), network up at boot+" + String(millis() / 1000) + "s. App marked valid.");
+}
+
+SelfTestState bootSelfTestState() { return state; }
+
+const char* bootSelfTestStateName() {
+  switch (state) {
+    case SelfTestState::NOT_REQUIRED: return "n/a";
+    case SelfTestState::PENDING: return "pending";
+    case SelfTestState::PASSED: return "passed";
+    case SelfTestState::FAILED: return "failed";
+    case SelfTestState::NO_ROLLBACK: return "no_rollback";
+  }
+  return "?";
+}
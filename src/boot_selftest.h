@@ -0,0 +1,21 @@
+#pragma once
+// 開機自我測試 (OTA 回滾保護)
+// OTA 更新後的第一次開機影像處於 PENDING_VERIFY 狀態: 只有 PWM 初始化成功、
+// 馬達超時檢查以預期頻率執行、且網路在時限內就緒, 才標記為有效;
+// 任何一項失敗或整體逾時 (含 setup() 卡住) 都會自動回滾到上一個影像。
+// PENDING_VERIFY 由 bootloader 設定: 以舊 bootloader (未啟用回滾) 開機的新影像停在 NEW,
+// 不做自我測試也不會回滾 (NO_ROLLBACK, /health 的 selftest 為 "no_rollback")。
+
+#include <stdint.h>
+
+enum class SelfTestState : uint8_t { NOT_REQUIRED, PENDING, PASSED, FAILED, NO_ROLLBACK };
+
+// setup() 最前面呼叫: 判斷是否需要自我測試並啟動整體逾時計時器
+void bootSelfTestBegin();
+void bootSelfTestReportPwm(bool ok);
+void bootSelfTestReportNetwork(bool ok);
+// 每次執行馬達超時檢查時呼叫, 用於量測控制迴圈頻率
+void bootSelfTestControlTick(uint32_t nowMs);
+
+SelfTestState bootSelfTestState();
+const char* bootSelfTestStateName();
@@ -0,0 +1,140 @@
+#include "capture.h"
+
+#include <stdio.h>
+#include <string.h>
+
+void CaptureLog::start(uint32_t nowMs) {
+  _active = false;
+  _head = 0;
+  _used = 0;
+  _records = 0;
+  _overwritten = 0;
+  _startMs = nowMs;
+  _generation++;
+  _active = true;
+}
+
+void CaptureLog::put(size_t pos, const uint8_t* data, size_t len) {
+  for (size_t i = 0; i < len; i++) _buf[(pos + i) % CAPACITY] = data[i];
+}
+
+size_t CaptureLog::recordSize(size_t pos) const {
+  size_t len = (size_t)at(pos + 6) | (size_t)at(pos + 7) << 8;
+  return HEADER + (at(pos + 4) == CAPTURE_TEXT ? len : 0);
+}
+
+void CaptureLog::dropOldest() {
+  size_t size = recordSize(_head);
+  _head = (_head + size) % CAPACITY;
+  _used -= size;
+  _records--;
+  _overwritten++;
+}
+
+void CaptureLog::record(CaptureKind kind, uint8_t client, const uint8_t* data, size_t len, uint32_t nowMs) {
+  if (!_active) return;
+  if (kind == CAPTURE_TEXT && len > MAX_FRAME) kind = CAPTURE_OVERSIZE;
+  size_t stored = kind == CAPTURE_TEXT ? len : 0;
+  while (CAPACITY - _used < HEADER + stored) dropOldest();
+
+  uint32_t ms = nowMs - _startMs;
+  uint16_t len16 = len > 0xFFFF ? 0xFFFF : (uint16_t)len;
+  uint8_t header[HEADER] = {(uint8_t)ms, (uint8_t)(ms >> 8), (uint8_t)(ms >> 16), (uint8_t)(ms >> 24),
+                            kind, client, (uint8_t)len16, (uint8_t)(len16 >> 8)};
+  size_t tail = (_head + _used) % CAPACITY;
+  put(tail, header, HEADER);
+  if (stored) put(tail + HEADER, data, stored);
+  _used += HEADER + stored;
+  _records++;
+}
+
+// 準備下一筆紀錄的輸出; 沒有更多紀錄時回傳 false
+bool CaptureLog::loadRecord() {
+  if (_expLeft == 0) return false;
+  size_t pos = _expPos;
+  uint32_t ms = (uint32_t)at(pos) | (uint32_t)at(pos + 1) << 8 | (uint32_t)at(pos + 2) << 16 | (uint32_t)at(pos + 3) << 24;
+  uint8_t kind = at(pos + 4);
+  unsigned client = at(pos + 5);
+  uint16_t len = (uint16_t)(at(pos + 6) | at(pos + 7) << 8);
+  int n;
+  switch (kind) {
+    case CAPTURE_CONNECT:
+      n = snprintf(_pre, sizeof(_pre), "%lu @connect %u\n", (unsigned long)ms, client);
+      break;
+    case CAPTURE_DISCONNECT:
+      n = snprintf(_pre, sizeof(_pre), "%lu @disconnect %u\n", (unsigned long)ms, client);
+      break;
+    case CAPTURE_OVERSIZE:
+      n = snprintf(_pre, sizeof(_pre), "# %lu client %u sent %u bytes (not captured)\n", (unsigned long)ms, client, len);
+      break;
+    default:
+      n = snprintf(_pre, sizeof(_pre), "%lu ", (unsigned long)ms);
+      _payPos = pos + HEADER;
+      _payLen = len;
+      _payIdx = 0;
+      _needNewline = true;
+      break;
+  }
+  _preLen = (uint8_t)(n < (int)sizeof(_pre) ? n : sizeof(_pre) - 1);
+  _preIdx = 0;
+  _expPos = (pos + recordSize(pos)) % CAPACITY;
+  _expLeft--;
+  return true;
+}
+
+int CaptureLog::nextChar() {
+  for (;;) {
+    if (_preIdx < _preLen) return (uint8_t)_pre[_preIdx++];
+    if (_escIdx < _escLen) return (uint8_t)_esc[_escIdx++];
+    if (_payIdx < _payLen) {
+      uint8_t b = at(_payPos + _payIdx);
+      // 行首的空白與 '@' 也跳脫, 讀回時才不會被當成分隔或事件
+      bool lead = _payIdx == 0 && (b == ' ' || b == '\t' || b == '@');
+      _payIdx++;
+      if (b == '\\' || b == '\n' || b == '\r') {
+        _esc[0] = '\\';
+        _esc[1] = b == '\\' ? '\\' : (b == '\n' ? 'n' : 'r');
+        _escLen = 2;
+      } else if (b < 0x20 || b == 0x7F || lead) {
+        static const char HEX[] = "0123456789abcdef";
+        _esc[0] = '\\';
+        _esc[1] = 'x';
+        _esc[2] = HEX[b >> 4];
+        _esc[3] = HEX[b & 15];
+        _escLen = 4;
+      } else {
+        return b;
+      }
+      _escIdx = 0;
+      continue;
+    }
+    if (_needNewline) {
+      _needNewline = false;
+      return '\n';
+    }
+    if (!loadRecord()) return -1;
+  }
+}
+
+size_t CaptureLog::exportText(char* buf, size_t maxLen, size_t index) {
+  if (index == 0) {
+    _expGeneration = _generation;
+    _expPos = _head;
+    _expLeft = _records;
+    _escLen = _escIdx = 0;
+    _payLen = _payIdx = 0;
+    _needNewline = false;
+    int n = snprintf(_pre, sizeof(_pre), "# capture: %lu records, %lu overwritten, %u bytes\n",
+                     (unsigned long)_records, (unsigned long)_overwritten, (unsigned)_used);
+    _preLen = (uint8_t)(n < (int)sizeof(_pre) ? n : sizeof(_pre) - 1);
+    _preIdx = 0;
+  }
+  if (_active || _expGeneration != _generation) return 0;
+  size_t n = 0;
+  while (n < maxLen) {
+    int c = nextChar();
+    if (c < 0) break;
+    buf[n++] = (char)c;
+  }
+  return n;
+}
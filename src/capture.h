@@ -0,0 +1,69 @@
+#pragma once
+// 控制流量擷取: 以環形緩衝區記錄每個收到的 WebSocket 控制框與抵達時間 (halMillis, 相對於開始擷取),
+// 匯出為駕駛腳本格式 (host/sim/drive_script.h), 可直接交給 host/replay 或模擬器重播。
+//   <ms> <payload>            文字框 (跳脫: \\ \n \r \xHH)
+//   <ms> @connect <client>    連線 / 斷線事件
+//   <ms> @disconnect <client>
+// 緩衝區滿時覆寫最舊的紀錄; 超過 MAX_FRAME 的框只記錄長度 (匯出為註解)。
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef CAPTURE_BYTES
+#define CAPTURE_BYTES 16384
+#endif
+
+enum CaptureKind : uint8_t { CAPTURE_TEXT, CAPTURE_CONNECT, CAPTURE_DISCONNECT, CAPTURE_OVERSIZE };
+
+class CaptureLog {
+public:
+  static const size_t CAPACITY = CAPTURE_BYTES;
+  static const size_t MAX_FRAME = 1024;
+
+  // 清除並開始擷取
+  void start(uint32_t nowMs);
+  void stop() { _active = false; }
+  bool active() const { return _active; }
+
+  void record(CaptureKind kind, uint8_t client, const uint8_t* data, size_t len, uint32_t nowMs);
+
+  uint32_t records() const { return _records; }
+  uint32_t overwritten() const { return _overwritten; }
+  size_t bytesUsed() const { return _used; }
+
+  // 分段匯出文字 (AsyncWebServer chunked response): index 為 0 時從頭開始, 回傳 0 表示結束。
+  // 擷取中不可匯出 (記錄與匯出在不同任務); 匯出途中重新開始擷取會提早結束。
+  size_t exportText(char* buf, size_t maxLen, size_t index);
+
+private:
+  static const size_t HEADER = 8; // ms(4) kind(1) client(1) len(2)
+  static_assert(CAPACITY >= HEADER + MAX_FRAME, "CAPTURE_BYTES too small");
+
+  void put(size_t pos, const uint8_t* data, size_t len);
+  uint8_t at(size_t pos) const { return _buf[pos % CAPACITY]; }
+  size_t recordSize(size_t pos) const;
+  void dropOldest();
+  bool loadRecord();
+  int nextChar();
+
+  uint8_t _buf[CAPACITY];
+  size_t _head = 0;      // 最舊紀錄的位置
+  size_t _used = 0;
+  uint32_t _records = 0;
+  uint32_t _overwritten = 0;
+  uint32_t _startMs = 0;
+  uint32_t _generation = 0;
+  volatile bool _active = false;
+
+  // 匯出游標
+  uint32_t _expGeneration = 0;
+  size_t _expPos = 0;
+  uint32_t _expLeft = 0;
+  char _pre[96];         // 目前要輸出的行首或整行
+  uint8_t _preLen = 0, _preIdx = 0;
+  size_t _payPos = 0;    // 目前紀錄 payload 的位置
+  uint16_t _payLen = 0, _payIdx = 0;
+  char _esc[4];
+  uint8_t _escLen = 0, _escIdx = 0;
+  bool _needNewline = false;
+};
@@ -0,0 +1,684 @@
+#include "car_control.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "car_variant.h"
+#include "hal.h"
+#include "json_scan.h"
+
+static int clampDuty(int v, int maxDuty) {
+  return v < -maxDuty ? -maxDuty : (v > maxDuty ? maxDuty : v);
+}
+
+const char* driveModeName(DriveMode mode) {
+  switch (mode) {
+    case AUTO: return "AUTO";
+    case CALIBRATE: return "CALIBRATE";
+    default: return "MANUAL";
+  }
+}
+
+static uint16_t floorDuty(int duty, uint16_t floor) { return (uint16_t)(duty < floor ? floor : duty); }
+
+MotorOutputs decideOutputs(int speedA, int speedB, const DutyFloor& floor) {
+  MotorOutputs out = {0, 0, 0, 0, true};
+
+  // --- Motor A (Throttle) 控制 ---
+  if (speedA > 0) out.aFwd = floorDuty(speedA, floor.aFwd);
+  else if (speedA < 0) out.aRev = floorDuty(-speedA, floor.aRev);
+
+  // --- Motor B (Steer) 控制 (加入最小啟動佔空比) ---
+  if (speedB > 0) out.bRight = floorDuty(speedB, floor.bRight);     // 右轉
+  else if (speedB < 0) out.bLeft = floorDuty(-speedB, floor.bLeft); // 左轉
+  return out;
+}
+
+MotorOutputs decideOutputs(int speedA, int speedB, int minDuty, bool floorA) {
+  uint16_t a = floorA ? (uint16_t)minDuty : 0;
+  return decideOutputs(speedA, speedB, DutyFloor{a, a, (uint16_t)minDuty, (uint16_t)minDuty});
+}
+
+void CarControl::begin() {
+  _lastCommandMs = halMillis();
+  holdSafe();
+}
+
+void CarControl::holdSafe() {
+  _missionActive = false;
+  if (_cal.active) {
+    _cal.active = false;
+    _mode = MANUAL;
+  }
+  _teleLen = 0;
+  _targetA = _targetB = 0;
+  _out = {0, 0, 0, 0, false};
+  halPinWrite(_stbyPin, false);
+  halPwmWrite(CH_A_FWD, 0); halPwmWrite(CH_A_REV, 0);
+  // 伺服模式沒有設定 Motor B 的 LEDC 通道, 不能寫入;
+  // 伺服停在中心 (不是停止脈衝: 沒有脈衝時有些伺服會鬆開或亂跳)
+  if (variant::SERVO && _servo) {
+    writeServo(_servoMap[100]);
+  } else {
+    halPwmWrite(CH_B_LEFT, 0); halPwmWrite(CH_B_RIGHT, 0);
+  }
+}
+
+void CarControl::writeServo(uint16_t duty) {
+  if (duty == _servoDuty) return;
+  _servoDuty = duty;
+  halPwmWrite(CH_SERVO, duty);
+}
+
+void CarControl::emergencyStop() {
+  // immediately stop PWM and disable STBY pin
+  holdSafe();
+  halLog("!!! EMERGENCY STOP Triggered !!!");
+}
+
+void CarControl::onClientDisconnected(int client) {
+  SyncPeer* peer = findSyncPeer(client, false);
+  if (peer) peer->active = false;
+  TelemetrySub* sub = findSub(client);
+  bool watcher = sub != nullptr && !sub->drove;
+  if (sub) sub->active = false;
+  if (watcher) return;
+  emergencyStop();
+}
+
+// 只寫入有變化的通道 (STBY 先啟用再輸出 PWM)
+void CarControl::apply(const MotorOutputs& out) {
+  if (out.standby != _out.standby) halPinWrite(_stbyPin, out.standby);
+  if (out.aFwd != _out.aFwd) halPwmWrite(CH_A_FWD, out.aFwd);
+  if (out.aRev != _out.aRev) halPwmWrite(CH_A_REV, out.aRev);
+  if (out.bRight != _out.bRight) halPwmWrite(CH_B_RIGHT, out.bRight);
+  if (out.bLeft != _out.bLeft) halPwmWrite(CH_B_LEFT, out.bLeft);
+  _out = out;
+}
+
+void CarControl::tick() {
+  uint32_t now = halMillis();
+  _teleLen = 0;
+  if (_missionActive) runMission(now);
+  if (_cal.active) runCalibration(now);
+  for (TelemetrySub& sub : _subs) {
+    if (!sub.active || (int32_t)(now - sub.dueMs) < 0) continue;
+    // 落後時 (loop 被阻塞) 不補送
+    sub.dueMs = now - sub.dueMs > sub.periodMs ? now + sub.periodMs : sub.dueMs + sub.periodMs;
+    sendTelemetry(sub.client);
+  }
+
+  // 馬達命令超時邏輯：若超過命令超時 (預設 COMMAND_TIMEOUT) 且馬達正在運行，則停止所有馬達
+  if (halMillis() - _lastCommandMs > _commandTimeoutMs) {
+    // targetA/B 儲存的是 Duty Cycle，所以只要不為 0，就表示馬達正在轉動
+    if (_targetA != 0 || _targetB != 0) {
+      halLog("Motors stopped due to command timeout.");
+      holdSafe();
+    }
+  }
+}
+
+// 腳位在開機時設定一次 (setupPWM), 之後的改變由 ConfigStore 延到下次開機
+void CarControl::configure(const CarConfig& cfg) {
+  _maxDuty = cfg.maxDuty;
+  _commandTimeoutMs = cfg.commandTimeoutMs;
+  _stbyPin = cfg.pinStby;
+  _mix = cfg.mixMode == MIX_DIFF ? MIX_DIFF : MIX_STEER;
+  // 校正過的方向使用自己的下限; 其餘沿用 min_duty (MIX_STEER 時油門馬達不設下限)
+  uint16_t shared = mix() == MIX_DIFF ? cfg.minDuty : 0;
+  _floor.aFwd = cfg.floorAFwd ? cfg.floorAFwd : shared;
+  _floor.aRev = cfg.floorARev ? cfg.floorARev : shared;
+  _floor.bLeft = cfg.floorBLeft ? cfg.floorBLeft : cfg.minDuty;
+  _floor.bRight = cfg.floorBRight ? cfg.floorBRight : cfg.minDuty;
+  if constexpr (variant::SERVO) {
+    // 脈寬 (µs) → LEDC duty: us · hz · 2^SERVO_RES / 10^6; 頻率為開機時的值 (reboot 欄位)
+    _servo = cfg.steerMode == STEER_SERVO;
+    for (int s = -100; s <= 100; s++) {
+      int span = s > 0 ? cfg.servoMaxUs - cfg.servoCenterUs : cfg.servoCenterUs - cfg.servoMinUs;
+      uint32_t us = (uint32_t)(cfg.servoCenterUs + s * span / 100);
+      _servoMap[s + 100] = (uint16_t)((uint64_t)us * cfg.servoHz * (1u << SERVO_RES) / 1000000);
+    }
+    // 停車時調整中心 (trim) 立即可見; begin() 之前 LEDC 尚未設定, 不寫入
+    if (_servo && _servoDuty != 0 && _targetB == 0) writeServo(_servoMap[100]);
+  }
+  if constexpr (variant::CURVES) {
+    // expo: y = x·(1-e) + x³·e (x、y 正規化到 ±1), 兩端仍為 0 與 100
+    for (int x = 0; x <= 100; x++) {
+      _curveThrottle[x] = (int8_t)(x * (100 - cfg.expoThrottle) / 100 + cfg.expoThrottle * x * x * x / 1000000);
+      _curveSteer[x] = (int8_t)(x * (100 - cfg.expoSteer) / 100 + cfg.expoSteer * x * x * x / 1000000);
+    }
+    _curves = cfg.expoThrottle != 0 || cfg.expoSteer != 0;
+  }
+  _teleLen = 0;
+}
+
+// 將搖桿輸入 (-100~100) 縮放至 Duty Cycle 範圍 (-maxDuty~maxDuty)
+int CarControl::scaleDuty(int input) const {
+  return clampDuty((input * _maxDuty) / 100, _maxDuty);
+}
+
+static int clampInput(int v) { return v < -100 ? -100 : (v > 100 ? 100 : v); }
+
+MixMode CarControl::mix() const { return variant::MIX < 0 ? _mix : (MixMode)variant::MIX; }
+
+void CarControl::driveOutputs(int throttle, int steer) {
+  if (variant::CURVES && _curves) {
+    throttle = clampInput(throttle);
+    steer = clampInput(steer);
+    throttle = throttle < 0 ? -_curveThrottle[-throttle] : _curveThrottle[throttle];
+    steer = steer < 0 ? -_curveSteer[-steer] : _curveSteer[steer];
+  }
+  if (mix() == MIX_DIFF) {
+    // 右轉 (steer > 0) 時左側較快; 超過 100 的部分截斷
+    int left = clampInput(clampInput(throttle) + clampInput(steer));
+    int right = clampInput(clampInput(throttle) - clampInput(steer));
+    throttle = left;
+    steer = right;
+  }
+  _targetA = scaleDuty(throttle);
+  _targetB = scaleDuty(steer);
+  if (variant::SERVO && _servo) {
+    // 伺服轉向: 只查表, Motor B 不輸出
+    writeServo(_servoMap[clampInput(steer) + 100]);
+    apply(decideOutputs(_targetA, 0, _floor));
+    return;
+  }
+  apply(decideOutputs(_targetA, _targetB, _floor));
+}
+
+void CarControl::handleText(const char* payload, size_t len, int client) {
+  // WebSocket 緩衝區結尾可能帶 '\0'
+  while (len > 0 && payload[len - 1] == '\0') len--;
+  _teleLen = 0;
+  _stats.frames++;
+  // V. 命令解析 (Command Parsing) - 單字元命令
+  if (len == 1) {
+    markDriver(client);
+    handleCommandChar(payload[0]);
+  } else {
+    // V. 命令解析 (Command Parsing) - JSON 遙控命令
+    handleJoystick(payload, len, client);
+  }
+}
+
+void CarControl::handleCommandChar(char cmd) {
+  switch (cmd) {
+    case 'A':
+      setMode(AUTO);
+      break;
+    case 'M':
+      setMode(MANUAL);
+      break;
+    case 'S':
+      emergencyStop();
+      break;
+  }
+  _lastCommandMs = halMillis();
+}
+
+namespace {
+struct JoystickFields {
+  int steer = 0;    // 搖桿輸入 (-100 ~ 100)
+  int throttle = 0; // 搖桿輸入 (-100 ~ 100)
+  int64_t t = 0;    // 客戶端時間戳記 / 序號, 原樣回傳為 "ack"
+  bool hasT = false;
+  int64_t ping = 0; // {"ping":t}: 連線品質量測, 原樣回傳為 "pong"
+  bool hasPing = false;
+  int64_t sub = 0;  // {"sub":hz}: 遙測訂閱, 0 取消
+  bool hasSub = false;
+  int64_t sync = 0; // {"sync":t1,"echo":t1',"t4":t4'}: 時鐘同步 (clock_sync.h)
+  bool hasSync = false;
+  int64_t echo = 0;
+  bool hasEcho = false;
+  int64_t t4 = 0;
+  const char* cfg = nullptr; // {"cfg":{...}}: 設定 (原始片段, 交給 ConfigHandler)
+  size_t cfgLen = 0;
+  const char* cal = nullptr; // {"cal":"a_fwd"|"mark"|"stop"}: 靜摩擦校正
+  size_t calLen = 0;
+};
+
+bool onJoystickField(void* ctx, const JsonField& f) {
+  JoystickFields* j = static_cast<JoystickFields*>(ctx);
+  if (f.is("steer")) j->steer = f.asInt(0);
+  else if (f.is("throttle")) j->throttle = f.asInt(0);
+  else if (f.is("t") && f.isInteger) {
+    j->t = f.intValue;
+    j->hasT = true;
+  } else if (f.is("ping") && f.isInteger) {
+    j->ping = f.intValue;
+    j->hasPing = true;
+  } else if (f.is("sub") && f.isInteger) {
+    j->sub = f.intValue;
+    j->hasSub = true;
+  } else if (f.is("sync") && f.isInteger) {
+    j->sync = f.intValue;
+    j->hasSync = true;
+  } else if (f.is("echo") && f.isInteger) {
+    j->echo = f.intValue;
+    j->hasEcho = true;
+  } else if (f.is("t4") && f.isInteger) {
+    j->t4 = f.intValue;
+  } else if (f.is("cfg") && f.type == JsonType::OBJECT) {
+    j->cfg = f.raw;
+    j->cfgLen = f.rawLen;
+  } else if (f.is("cal") && f.type == JsonType::STRING) {
+    j->cal = f.raw;
+    j->calLen = f.rawLen;
+  }
+  return true;
+}
+}  // namespace
+
+void CarControl::handleJoystick(const char* json, size_t len, int client) {
+  JoystickFields j;
+  const char* err = jsonScanObject(json, len, onJoystickField, &j);
+  if (err) {
+    _stats.parseErrors++;
+    char msg[64];
+    snprintf(msg, sizeof(msg), "WS Error: JSON parse failed: %s", err);
+    halLog(msg);
+    return;
+  }
+  // 時鐘同步、ping 與訂閱都只回覆給發送者, 不改變馬達狀態也不重設命令超時
+  // (否則閒置的網頁會讓車子一直保持輸出)
+  if (j.hasSync) {
+    handleSync(client, j.sync, j.hasEcho ? &j.echo : nullptr, j.t4);
+    return;
+  }
+  if (j.hasPing) {
+    recordUplink(client, j.ping);
+    sendPong(client, j.ping);
+    return;
+  }
+  // 訂閱與設定同樣不是駕駛命令
+  if (j.hasSub) {
+    subscribe(client, j.sub);
+    return;
+  }
+  if (j.cfg) {
+    handleConfig(client, j.cfg, j.cfgLen);
+    return;
+  }
+  markDriver(client);
+  // 校正會輸出 PWM: 發送者視為駕駛 (斷線時停車)
+  if (j.cal) {
+    handleCalibration(client, j.cal, j.calLen);
+    return;
+  }
+  if (j.hasT) recordUplink(client, j.t);
+  drive(j.throttle, j.steer, j.hasT ? &j.t : nullptr);
+}
+
+void CarControl::drive(int throttle, int steer, const int64_t* ack) {
+  _teleLen = 0;
+  // VI. 馬達控制 (Motor Control)
+  // OTA 更新期間馬達維持停止, 忽略遙控命令
+  if (_mode == MANUAL && !_locked) {
+    // 將搖桿輸入 (-100~100) 縮放至 Duty Cycle 範圍 (-maxDuty~maxDuty); MIX_DIFF 時 A/B 為左右兩側
+    driveOutputs(throttle, steer);
+    // Reset timeout on every joystick command
+    _lastCommandMs = halMillis();
+    _stats.applied++;
+  } else {
+    _stats.ignored++;
+  }
+
+  // 發送實時狀態回瀏覽器 (Console log)
+  broadcastStatus(throttle, steer, ack);
+}
+
+void CarControl::setMode(DriveMode mode) {
+  _teleLen = 0;
+  if (mode == MANUAL && _missionActive) {
+    holdSafe();
+    halLog("Mission aborted");
+  }
+  if (mode != CALIBRATE && _cal.active) {
+    holdSafe();
+    sendCalStatus("aborted");
+    halLog("Calibration aborted");
+  }
+  _mode = mode;
+  char msg[40];
+  snprintf(msg, sizeof(msg), "Mode Switched: %s", driveModeName(mode));
+  halLog(msg);
+}
+
+bool CarControl::startMission(const MissionSegment* segments, int count) {
+  if (_locked || count <= 0 || count > MAX_MISSION_SEGMENTS) return false;
+  // 任務取代進行中的校正
+  if (_cal.active) holdSafe();
+  uint32_t total = 0;
+  for (int i = 0; i < count; i++) {
+    _mission[i] = segments[i];
+    total += segments[i].ms;
+  }
+  if (!_missionActive) _missionPrevMode = _mode;
+  _missionLen = count;
+  _missionIndex = -1;  // 第一次 runMission() 開始第一個區段
+  _missionStartMs = _segmentStartMs = halMillis();
+  _missionActive = true;
+  _mode = AUTO;
+  char msg[64];
+  snprintf(msg, sizeof(msg), "Mission started: %d segments, %lu ms", count, (unsigned long)total);
+  halLog(msg);
+  runMission(_missionStartMs);
+  return true;
+}
+
+// 每個 tick: 依經過時間前進到目前的區段 (loop 被阻塞時跳過已過期的區段), 區段開始時輸出並廣播一次狀態
+void CarControl::runMission(uint32_t now) {
+  if (_locked || _mode != AUTO) {
+    holdSafe();
+    halLog("Mission aborted");
+    return;
+  }
+  int index = _missionIndex < 0 ? 0 : _missionIndex;
+  while (now - _segmentStartMs >= _mission[index].ms) {
+    _segmentStartMs += _mission[index].ms;
+    if (++index == _missionLen) {
+      holdSafe();
+      _mode = _missionPrevMode;
+      _lastCommandMs = now;
+      halLog("Mission complete");
+      broadcastStatus(0, 0, nullptr);
+      return;
+    }
+  }
+  // 任務本身就是命令來源, 不觸發命令超時
+  _lastCommandMs = now;
+  if (index == _missionIndex) return;
+  _missionIndex = index;
+  const MissionSegment& seg = _mission[index];
+  driveOutputs(seg.throttle, seg.steer);
+  broadcastStatus(seg.throttle, seg.steer, nullptr);
+}
+
+size_t CarControl::missionJson(char* buf, size_t maxLen) const {
+  uint32_t total = 0;
+  for (int i = 0; i < _missionLen; i++) total += _mission[i].ms;
+  int len = snprintf(buf, maxLen, "{\"active\":%s,\"segment\":%d,\"segments\":%d,\"elapsed_ms\":%lu,\"total_ms\":%lu}",
+                     _missionActive ? "true" : "false", _missionActive ? _missionIndex : -1, _missionLen,
+                     _missionActive ? (unsigned long)(halMillis() - _missionStartMs) : 0UL, (unsigned long)total);
+  return len > 0 && (size_t)len < maxLen ? (size_t)len : 0;
+}
+
+static const char* const CAL_NAMES[CAL_CHANNELS] = {"a_fwd", "a_rev", "b_left", "b_right"};
+
+// {"cal":"a_fwd"} 開始 (或改為另一個通道), {"cal":"mark"} 確認轉動, {"cal":"stop"} 中止
+void CarControl::handleCalibration(int client, const char* cmd, size_t len) {
+  _lastCommandMs = halMillis();
+  if (len == 4 && memcmp(cmd, "mark", 4) == 0) {
+    markCalibration();
+    return;
+  }
+  if (len == 4 && memcmp(cmd, "stop", 4) == 0) {
+    if (_cal.active) setMode(MANUAL);
+    return;
+  }
+  for (int ch = 0; ch < CAL_CHANNELS; ch++) {
+    if (strlen(CAL_NAMES[ch]) == len && memcmp(cmd, CAL_NAMES[ch], len) == 0) {
+      if (_servo && (ch == CAL_B_LEFT || ch == CAL_B_RIGHT)) {
+        static const char msg[] = "{\"cal\":null,\"error\":\"steering is a servo (steer_mode 1)\"}";
+        if (!halSend(client, msg, sizeof(msg) - 1)) _stats.txFailures++;
+      } else if (!startCalibration((CalChannel)ch, client)) {
+        static const char msg[] = "{\"cal\":null,\"error\":\"drive locked\"}";
+        if (!halSend(client, msg, sizeof(msg) - 1)) _stats.txFailures++;
+      }
+      return;
+    }
+  }
+  static const char msg[] = "{\"cal\":null,\"error\":\"cal must be a_fwd, a_rev, b_left, b_right, mark or stop\"}";
+  if (!halSend(client, msg, sizeof(msg) - 1)) _stats.txFailures++;
+}
+
+bool CarControl::startCalibration(CalChannel ch, int client) {
+  if (_locked) return false;
+  holdSafe();
+  uint32_t now = halMillis();
+  _cal = {true, ch, client, 0, (_maxDuty + CAL_STEPS - 1) / CAL_STEPS, now};
+  _mode = CALIBRATE;
+  _lastCommandMs = now;
+  char msg[48];
+  snprintf(msg, sizeof(msg), "Calibration started: %s", CAL_NAMES[ch]);
+  halLog(msg);
+  sendCalStatus("ramp");
+  return true;
+}
+
+// 每個 tick: 到時間就提高一步, 只驅動校正中的通道 (不經過混控、曲線與下限)
+void CarControl::runCalibration(uint32_t now) {
+  if (_locked) {
+    holdSafe();
+    halLog("Calibration aborted");
+    return;
+  }
+  // 校正本身就是命令來源, 不觸發命令超時
+  _lastCommandMs = now;
+  if (now - _cal.stepMs < CAL_STEP_MS) return;
+  _cal.stepMs = now;
+  if (_cal.duty + _cal.step > _maxDuty) {
+    _cal.duty = _maxDuty;
+    holdSafe();
+    sendCalStatus("failed", "no motion up to max_duty");
+    halLog("Calibration failed: no motion up to max_duty");
+    return;
+  }
+  _cal.duty += _cal.step;
+  MotorOutputs out = {0, 0, 0, 0, true};
+  switch (_cal.ch) {
+    case CAL_A_FWD: out.aFwd = (uint16_t)_cal.duty; _targetA = _cal.duty; break;
+    case CAL_A_REV: out.aRev = (uint16_t)_cal.duty; _targetA = -_cal.duty; break;
+    case CAL_B_LEFT: out.bLeft = (uint16_t)_cal.duty; _targetB = -_cal.duty; break;
+    default: out.bRight = (uint16_t)_cal.duty; _targetB = _cal.duty; break;
+  }
+  apply(out);
+  sendCalStatus("ramp");
+}
+
+// 確認時的 duty 即為下限 (操作者的反應時間讓它略高於實際的啟動點, 低速時寧可多一點);
+// 以 {"floor_x":duty} 經由設定層驗證、暫存並合併寫入 NVS, 設定層的回覆也轉給操作者
+void CarControl::markCalibration() {
+  if (!_cal.active || _cal.duty == 0) {
+    static const char msg[] = "{\"cal\":null,\"error\":\"not ramping\"}";
+    if (!halSend(_cal.client, msg, sizeof(msg) - 1)) _stats.txFailures++;
+    return;
+  }
+  holdSafe();
+  sendCalStatus("done");
+  char msg[64];
+  snprintf(msg, sizeof(msg), "Calibration done: %s = %d", CAL_NAMES[_cal.ch], _cal.duty);
+  halLog(msg);
+  char json[40];
+  int len = snprintf(json, sizeof(json), "{\"floor_%s\":%d}", CAL_NAMES[_cal.ch], _cal.duty);
+  handleConfig(_cal.client, json, (size_t)len);
+}
+
+// {"cal":{"ch":"a_fwd","state":"ramp","duty":12,"max":255}}: 只送給校正中的客戶端
+void CarControl::sendCalStatus(const char* state, const char* error) {
+  char buffer[128];
+  int len = snprintf(buffer, sizeof(buffer), "{\"cal\":{\"ch\":\"%s\",\"state\":\"%s\",\"duty\":%d,\"max\":%d",
+                     CAL_NAMES[_cal.ch], state, _cal.duty, _maxDuty);
+  if (error) len += snprintf(buffer + len, sizeof(buffer) - len, ",\"error\":\"%s\"", error);
+  len += snprintf(buffer + len, sizeof(buffer) - len, "}}");
+  if (len > 0 && (size_t)len < sizeof(buffer) && !halSend(_cal.client, buffer, (size_t)len)) _stats.txFailures++;
+}
+
+// {"cfg":{}} 只查詢; 新的值在下一個 tick 邊界才生效, 回覆給發送者
+void CarControl::handleConfig(int client, const char* json, size_t len) {
+  char reply[768];
+  size_t n = 0;
+  if (_configHandler) n = _configHandler(_configCtx, json, len, reply, sizeof(reply));
+  if (n == 0) {
+    static const char msg[] = "{\"cfg\":null,\"error\":\"config unavailable\"}";
+    memcpy(reply, msg, sizeof(msg));
+    n = sizeof(msg) - 1;
+  }
+  if (!halSend(client, reply, n)) _stats.txFailures++;
+}
+
+void CarControl::sendPong(int client, int64_t ping) {
+  _stats.pings++;
+  char buffer[160];
+  int len = snprintf(buffer, sizeof(buffer),
+                     "{\"pong\":%" PRId64 ",\"rssi\":%d,\"frames\":%lu,\"errors\":%lu,\"tx_fail\":%lu}", ping,
+                     halRssi(), (unsigned long)_stats.frames, (unsigned long)_stats.parseErrors,
+                     (unsigned long)_stats.txFailures);
+  if (len > 0 && (size_t)len < sizeof(buffer) && !halSend(client, buffer, (size_t)len)) _stats.txFailures++;
+}
+
+CarControl::SyncPeer* CarControl::findSyncPeer(int client, bool create) {
+  SyncPeer* oldest = nullptr;
+  for (SyncPeer& p : _sync) {
+    if (p.active && p.client == client) return &p;
+  }
+  if (!create) return nullptr;
+  uint32_t now = halMillis();
+  for (SyncPeer& p : _sync) {
+    if (!p.active) {
+      oldest = &p;
+      break;
+    }
+    if (oldest == nullptr || now - p.lastMs > now - oldest->lastMs) oldest = &p;
+  }
+  oldest->client = client;
+  oldest->active = true;
+  oldest->pending = false;
+  oldest->clock.reset();
+  return oldest;
+}
+
+// 上一次交換的 t4 隨本次請求送達, 才組成完整樣本; 回覆帶目前的估計讓網頁計算下行延遲
+void CarControl::handleSync(int client, int64_t t1, const int64_t* echo, int64_t t4) {
+  uint32_t now = halMillis();
+  SyncPeer* peer = findSyncPeer(client, true);
+  if (peer->pending && echo && *echo == peer->t1) peer->clock.addSample(peer->t1, peer->t2, peer->t2, t4);
+  peer->t1 = t1;
+  peer->t2 = now;
+  peer->pending = true;
+  peer->lastMs = now;
+
+  char buffer[192];
+  int len = snprintf(buffer, sizeof(buffer), "{\"sync\":%" PRId64 ",\"rx\":%lu,\"tx\":%lu", t1,
+                     (unsigned long)now, (unsigned long)now);
+  if (peer->clock.synced()) {
+    len += snprintf(buffer + len, sizeof(buffer) - len, ",\"off\":%.1f,\"up50\":%u,\"up95\":%u",
+                    peer->clock.offsetAt(now), _uplink.percentile(0.5), _uplink.percentile(0.95));
+  }
+  len += snprintf(buffer + len, sizeof(buffer) - len, "}");
+  if (len > 0 && (size_t)len < sizeof(buffer) && !halSend(client, buffer, (size_t)len)) _stats.txFailures++;
+}
+
+// t 為控制端送出時的時間 (瀏覽器 Date.now()); 只有已同步的控制端才能換算
+void CarControl::recordUplink(int client, int64_t t) {
+  SyncPeer* peer = findSyncPeer(client, false);
+  if (peer == nullptr || !peer->clock.synced()) return;
+  uint32_t now = halMillis();
+  _uplink.add((double)now - peer->clock.toLocal(t, now));
+}
+
+size_t CarControl::latencyJson(char* buf, size_t maxLen) const {
+  uint32_t now = halMillis();
+  int len = snprintf(buf, maxLen, "{\"clients\":[");
+  bool first = true;
+  for (const SyncPeer& p : _sync) {
+    if (!p.active || len <= 0 || (size_t)len >= maxLen) continue;
+    len += snprintf(buf + len, maxLen - len,
+                    "%s{\"client\":%d,\"samples\":%lu,\"offset_ms\":%.1f,\"drift_ppm\":%.1f,\"min_rtt_ms\":%lu}",
+                    first ? "" : ",", p.client, (unsigned long)p.clock.samples(), p.clock.offsetAt(now),
+                    p.clock.driftPpm(), (unsigned long)p.clock.minRttMs());
+    first = false;
+  }
+  if (len <= 0 || (size_t)len >= maxLen) return 0;
+  len += snprintf(buf + len, maxLen - len, "],\"uplink\":");
+  if ((size_t)len >= maxLen) return 0;
+  size_t n = _uplink.toJson(buf + len, maxLen - len);
+  if (n == 0 || len + n + 1 >= maxLen) return 0;
+  len += (int)n;
+  buf[len++] = '}';
+  buf[len] = 0;
+  return (size_t)len;
+}
+
+CarControl::TelemetrySub* CarControl::findSub(int client) {
+  for (TelemetrySub& sub : _subs) {
+    if (sub.active && sub.client == client) return &sub;
+  }
+  return nullptr;
+}
+
+int CarControl::subscribers() const {
+  int n = 0;
+  for (const TelemetrySub& sub : _subs) n += sub.active ? 1 : 0;
+  return n;
+}
+
+void CarControl::markDriver(int client) {
+  TelemetrySub* sub = findSub(client);
+  if (sub) sub->drove = true;
+}
+
+void CarControl::subscribe(int client, int64_t hz) {
+  TelemetrySub* sub = findSub(client);
+  if (hz <= 0) {
+    if (sub) sub->active = false;
+    return;
+  }
+  if (sub == nullptr) {
+    for (TelemetrySub& s : _subs) {
+      if (!s.active) {
+        sub = &s;
+        *sub = {client, 0, 0, false, true};
+        break;
+      }
+    }
+  }
+  if (sub == nullptr) {
+    // 訂閱已滿: 回覆一次, 讓儀表板知道要改用輪詢或稍後重試
+    char msg[] = "{\"tele\":null,\"error\":\"too many subscribers\"}";
+    if (!halSend(client, msg, sizeof(msg) - 1)) _stats.txFailures++;
+    return;
+  }
+  if (hz > MAX_TELEMETRY_HZ) hz = MAX_TELEMETRY_HZ;
+  sub->periodMs = (uint16_t)(1000 / hz);
+  sub->dueMs = halMillis() + sub->periodMs;
+  sendTelemetry(client);
+}
+
+// {"tele":{...}}: 儀表板一格所需的全部狀態, 固定欄位, 不含日誌
+const char* CarControl::telemetry(size_t* len) {
+  if (_teleLen == 0) {
+    uint32_t now = halMillis();
+    int n = snprintf(_tele, sizeof(_tele),
+                     "{\"tele\":{\"ms\":%lu,\"mode\":\"%s\",\"a\":%d,\"b\":%d,\"stby\":%d,\"cmd_age\":%lu,"
+                     "\"rssi\":%d,\"frames\":%lu,\"applied\":%lu,\"errors\":%lu,\"tx_fail\":%lu}}",
+                     (unsigned long)now, driveModeName(_mode), (int)_targetA, (int)_targetB,
+                     _out.standby ? 1 : 0, (unsigned long)(now - _lastCommandMs), halRssi(),
+                     (unsigned long)_stats.frames, (unsigned long)_stats.applied, (unsigned long)_stats.parseErrors,
+                     (unsigned long)_stats.txFailures);
+    _teleLen = n > 0 && (size_t)n < sizeof(_tele) ? (size_t)n : 0;
+  }
+  *len = _teleLen;
+  return _tele;
+}
+
+void CarControl::sendTelemetry(int client) {
+  _stats.telemetry++;
+  size_t len;
+  const char* tele = telemetry(&len);
+  if (len > 0 && !halSend(client, tele, len)) _stats.txFailures++;
+}
+
+void CarControl::broadcastStatus(int throttle, int steer, const int64_t* ack) {
+  // 顯示原始輸入與實際 Duty Cycle
+  char buffer[192];
+  int len = snprintf(buffer, sizeof(buffer),
+                     "{\"motorA\":%d,\"motorB\":%d,\"debug\":\"JSTK_Raw:%d/%d | DutyA:%d/DutyB:%d | Mode:%s\"",
+                     (int)_targetA, (int)_targetB, throttle, steer, (int)_targetA, (int)_targetB,
+                     driveModeName(_mode));
+  if (ack) len += snprintf(buffer + len, sizeof(buffer) - len, ",\"ack\":%" PRId64, *ack);
+  len += snprintf(buffer + len, sizeof(buffer) - len, "}");
+  if (len > 0 && (size_t)len < sizeof(buffer) && !halBroadcast(buffer, (size_t)len)) _stats.txFailures++;
+}
@@ -0,0 +1,252 @@
+#pragma once
+// 控制核心: 命令解析、搖桿混控、失效保護 (命令超時 / 急停) 與 PWM 輸出決策
+// 只透過 hal.h 接觸硬體與網路, 同一份程式碼在裝置與主機 (pio test -e native) 上執行。
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "clock_sync.h"
+#include "config_store.h"
+#include "gpio_pins.h"
+
+// 以下為編譯時的預設值, 執行期的值來自設定 (config_store.h, CarControl::configure)
+// LEDC Channel for PWM
+const int CH_A_FWD = 0;
+const int CH_A_REV = 1;
+const int CH_B_LEFT = 2;
+const int CH_B_RIGHT = 3;
+const int PWM_FREQ = 20000; // 20 kHz
+const int PWM_RES = 8;      // 8-bit, 0-255 duty cycle
+
+// 轉向伺服 (steer_mode 1): 通道 4 使用自己的 LEDC 計時器 (timer 2), 不影響馬達的 PWM 頻率
+const int CH_SERVO = 4;
+const int SERVO_FREQ = 50;       // Hz; 數位伺服可用到 333
+const int SERVO_RES = 14;        // bits (ESP32-C3 的上限): 50 Hz 時一階約 1.2 µs
+const int SERVO_MIN_US = 1000;   // 全左
+const int SERVO_CENTER_US = 1500;
+const int SERVO_MAX_US = 2000;   // 全右
+
+// 馬達控制變數
+const int MAX_DUTY = 255; // 最大 PWM Duty Cycle (0~255)
+// >>> 修正: 新增最小啟動佔空比以克服靜摩擦 <<<
+const int MIN_DUTY = 0;  // 最小啟動佔空比 (建議從 30~50 之間測試; 或以 CALIBRATE 模式量測每個方向)
+const unsigned long COMMAND_TIMEOUT = 300; // 300ms 沒收到命令則停止
+
+// === 應用程式模式 ===
+enum DriveMode { AUTO, MANUAL, CALIBRATE };
+const char* driveModeName(DriveMode mode);
+
+// 混控方式 (car_profiles.h 依車選擇)
+enum MixMode : uint8_t {
+  MIX_STEER = 0, // Motor A 油門, Motor B 轉向馬達 (shuttle)
+  MIX_DIFF = 1,  // Motor A 左側、Motor B 右側 (四驅差速), 兩側都套用 minDuty 下限
+};
+
+// 轉向方式 (steer_mode, 重新開機後生效)
+enum SteerMode : uint8_t {
+  STEER_MOTOR = 0, // Motor B 直流轉向馬達 (CH_B_LEFT / CH_B_RIGHT)
+  STEER_SERVO = 1, // 伺服 (CH_SERVO), Motor B 不輸出; 只能搭配 MIX_STEER
+};
+
+// 一次 PWM 決策的結果 (DRV8833 兩個 H 橋的四個輸入與 STBY)
+struct MotorOutputs {
+  uint16_t aFwd;
+  uint16_t aRev;
+  uint16_t bLeft;
+  uint16_t bRight;
+  bool standby; // true = STBY HIGH, 馬達啟用
+};
+
+// 控制通道計數 (由 /health 回報, 負載測試以前後差值計算伺服器端遺失)
+struct ControlStats {
+  uint32_t frames;       // 收到的文字框 (單字元 + JSON)
+  uint32_t applied;      // 套用到馬達的搖桿命令
+  uint32_t ignored;      // AUTO 模式或 OTA 鎖定時忽略的搖桿命令
+  uint32_t parseErrors;
+  uint32_t txFailures;   // 狀態廣播未送達所有客戶端
+  uint32_t pings;
+  uint32_t telemetry;    // 送給訂閱者的遙測
+};
+
+// 遙測訂閱 ({"sub":hz}): 車隊儀表板以低頻率取得每台車的狀態, 不必送控制命令
+const int MAX_TELEMETRY_SUBS = 4;
+const int MAX_TELEMETRY_HZ = 10;
+// 時鐘同步 ({"sync":t1,...}, 見 clock_sync.h): 同時估計 offset 的控制端數量, 超過時取代最久沒同步的
+const int MAX_SYNC_PEERS = 4;
+
+// 任務 (POST /api/mission): 依序執行的定時區段, 在 AUTO 模式下由 tick() 播放
+struct MissionSegment {
+  int8_t throttle;  // 與搖桿相同 (-100 ~ 100)
+  int8_t steer;
+  uint16_t ms;      // 1 ~ MAX_SEGMENT_MS
+};
+const int MAX_MISSION_SEGMENTS = 128;
+const uint16_t MAX_SEGMENT_MS = 30000;
+
+// 每個通道、每個方向的最小啟動 duty (克服靜摩擦); 0 = 不設下限
+struct DutyFloor {
+  uint16_t aFwd;
+  uint16_t aRev;
+  uint16_t bLeft;
+  uint16_t bRight;
+};
+
+// 將 Duty Cycle (-maxDuty~maxDuty) 轉為 H 橋輸出, 非 0 的輸出不低於該方向的下限
+MotorOutputs decideOutputs(int speedA, int speedB, const DutyFloor& floor);
+// 單一下限: Motor B (floorA 時兩個馬達) 套用 minDuty
+MotorOutputs decideOutputs(int speedA, int speedB, int minDuty = MIN_DUTY, bool floorA = false);
+
+// 靜摩擦校正 (CALIBRATE 模式): 一次一個通道方向, duty 每 CAL_STEP_MS 增加 maxDuty/CAL_STEPS,
+// 操作者看到輪子開始轉動時確認, 當時的 duty 寫入設定 (floor_*, 保存於 NVS)
+enum CalChannel : uint8_t { CAL_A_FWD, CAL_A_REV, CAL_B_LEFT, CAL_B_RIGHT, CAL_CHANNELS };
+const uint32_t CAL_STEP_MS = 300;
+const int CAL_STEPS = 64;
+
+// WebSocket {"cfg":{...}} 交給設定層 (main.cpp / 模擬器): 驗證並暫存, 將回覆寫入 reply, 回傳長度
+typedef size_t (*ConfigHandler)(void* ctx, const char* json, size_t len, char* reply, size_t maxLen);
+
+class CarControl {
+public:
+  // 初始狀態: 馬達停止 (需在 LEDC 設定完成後呼叫)
+  void begin();
+  // 處理一個 WebSocket 文字框 (單字元命令或 JSON 遙控命令); client 為發送者 (ping 的回覆對象)
+  void handleText(const char* payload, size_t len, int client = 0);
+  // 控制端斷線時立即停止馬達; 只訂閱遙測、從未送出命令的客戶端 (儀表板) 斷線則不影響駕駛
+  void onClientDisconnected(int client = -1);
+  // 每次 loop() 呼叫: 命令超時邏輯與到期的遙測
+  void tick();
+  // 套用設定的即時欄位 (duty 範圍與各方向下限、命令超時、混控與反應曲線) 與 STBY 腳位; 在兩次 tick() 之間呼叫
+  void configure(const CarConfig& cfg);
+  void onConfig(ConfigHandler handler, void* ctx) {
+    _configHandler = handler;
+    _configCtx = ctx;
+  }
+
+  // 搖桿設定點 (-100~100), WebSocket 的 JSON 命令與 REST /api/drive 共用; 只在 MANUAL 模式且未鎖定時套用
+  void drive(int throttle, int steer, const int64_t* ack = nullptr);
+  // 切換到 MANUAL 會中止執行中的任務與校正
+  void setMode(DriveMode mode);
+  // 切換到 AUTO 並從第一個區段開始 (取代執行中的任務); OTA 鎖定時回傳 false
+  bool startMission(const MissionSegment* segments, int count);
+  bool missionActive() const { return _missionActive; }
+  // 進入 CALIBRATE 模式並從 0 開始提高 ch 的 duty; client 收到進度 ({"cal":{...}}). OTA 鎖定時回傳 false
+  bool startCalibration(CalChannel ch, int client);
+  // 操作者確認已開始轉動: 停止並把目前的 duty 交給設定層 (ConfigHandler)
+  void markCalibration();
+  bool calibrating() const { return _cal.active; }
+  // GET /api/mission: {"active":..,"segment":..,"segments":..,"elapsed_ms":..,"total_ms":..}
+  size_t missionJson(char* buf, size_t maxLen) const;
+
+  void emergencyStop();
+  // 歸零所有輸出並關閉 STBY, 結束任務與校正 (校正中會把模式改回 MANUAL, 不發日誌)。
+  // 會改變 mode(), 與其他成員一樣只能在 loop 任務中呼叫 (不會在 tick() 中途切換模式);
+  // async_tcp 任務中需要立即停車時直接拉低 STBY 腳位, 再以 apiStop() 交給 loop()
+  void holdSafe();
+  // OTA 更新期間鎖定: 忽略遙控命令
+  void setDriveLocked(bool locked) { _locked = locked; }
+
+  DriveMode mode() const { return _mode; }
+  int targetA() const { return _targetA; }
+  int targetB() const { return _targetB; }
+  const MotorOutputs& outputs() const { return _out; }
+  uint32_t lastCommandMs() const { return _lastCommandMs; }
+  const ControlStats& stats() const { return _stats; }
+  int subscribers() const;
+  // 已同步時鐘的控制端送出的命令 ("t") 與 ping 的上行單向延遲 (ms)
+  const LatencyHistogram& uplink() const { return _uplink; }
+  // {"tele":{...}}: 遙測訂閱與 SSE (/events) 共用同一份, 每個 tick 最多組一次
+  const char* telemetry(size_t* len);
+  // GET /latency: {"clients":[{"client","samples","offset_ms","drift_ppm","min_rtt_ms"}],"uplink":{...}}
+  size_t latencyJson(char* buf, size_t maxLen) const;
+
+private:
+  struct TelemetrySub {
+    int client;
+    uint16_t periodMs;
+    uint32_t dueMs;
+    bool drove;  // 這個客戶端也送過命令
+    bool active;
+  };
+
+  struct Calibration {
+    bool active;
+    CalChannel ch;
+    int client;
+    int duty;
+    int step;
+    uint32_t stepMs;  // 目前 duty 開始的時間
+  };
+
+  struct SyncPeer {
+    int client;
+    bool active;
+    bool pending;     // 等待對端在下一次請求帶回 t4
+    int64_t t1;
+    uint32_t t2;      // 收到與回覆為同一個 millis()
+    uint32_t lastMs;
+    ClockSync clock;
+  };
+
+  void handleCommandChar(char cmd);
+  void handleJoystick(const char* json, size_t len, int client);
+  void apply(const MotorOutputs& out);
+  // ack: 命令中的 "t" (用於量測來回延遲), 沒有時為 nullptr
+  void broadcastStatus(int throttle, int steer, const int64_t* ack);
+  void sendPong(int client, int64_t ping);
+  void subscribe(int client, int64_t hz);
+  void sendTelemetry(int client);
+  void markDriver(int client);
+  TelemetrySub* findSub(int client);
+  void handleSync(int client, int64_t t1, const int64_t* echo, int64_t t4);
+  void handleConfig(int client, const char* json, size_t len);
+  void handleCalibration(int client, const char* cmd, size_t len);
+  void runCalibration(uint32_t now);
+  void sendCalStatus(const char* state, const char* error = nullptr);
+  int scaleDuty(int input) const;
+  // 搖桿/任務的設定點 (-100~100) 經反應曲線與混控後輸出
+  void driveOutputs(int throttle, int steer);
+  // 變體固定混控方式時 (car_variant.h) 在編譯時決定
+  MixMode mix() const;
+  void writeServo(uint16_t duty);
+  void recordUplink(int client, int64_t t);
+  SyncPeer* findSyncPeer(int client, bool create);
+  void runMission(uint32_t now);
+
+  // 設定的即時欄位 (預設為編譯時的常數)
+  int _maxDuty = MAX_DUTY;
+  DutyFloor _floor = {0, 0, MIN_DUTY, MIN_DUTY};  // MIX_STEER: 只有轉向馬達有下限
+  uint32_t _commandTimeoutMs = COMMAND_TIMEOUT;
+  uint8_t _stbyPin = motor_stby;
+  MixMode _mix = MIX_STEER;
+  // 反應曲線查表 (索引為 |輸入| 0~100), configure() 時計算, 命令路徑只查表
+  int8_t _curveThrottle[101] = {};
+  int8_t _curveSteer[101] = {};
+  bool _curves = false;  // 兩條都是線性時略過查表
+  // 轉向伺服: 轉向 (-100~100) 對應的 LEDC duty, configure() 時計算, 命令路徑只查表
+  bool _servo = false;
+  uint16_t _servoMap[201] = {};
+  uint16_t _servoDuty = 0;  // 最後寫入的值 (0 = begin() 之前, LEDC 尚未設定)
+  ConfigHandler _configHandler = nullptr;
+  void* _configCtx = nullptr;
+  // targetA/B 儲存縮放後的 Duty Cycle 值 (-maxDuty~maxDuty); MIX_DIFF 時為左/右側
+  volatile int _targetA = 0;
+  volatile int _targetB = 0;
+  uint32_t _lastCommandMs = 0;
+  DriveMode _mode = MANUAL;
+  volatile bool _locked = false;
+  MotorOutputs _out = {0, 0, 0, 0, false};
+  ControlStats _stats = {0, 0, 0, 0, 0, 0, 0};
+  TelemetrySub _subs[MAX_TELEMETRY_SUBS] = {};
+  char _tele[224];
+  size_t _teleLen = 0;      // 0 = 需要重新組 (tick 開始或狀態改變)
+  SyncPeer _sync[MAX_SYNC_PEERS] = {};
+  LatencyHistogram _uplink;
+  MissionSegment _mission[MAX_MISSION_SEGMENTS];
+  int _missionLen = 0;
+  int _missionIndex = 0;
+  uint32_t _missionStartMs = 0;
+  uint32_t _segmentStartMs = 0;
+  DriveMode _missionPrevMode = MANUAL;  // 任務結束後回到的模式
+  volatile bool _missionActive = false;
+  Calibration _cal = {};
+};
@@ -0,0 +1,53 @@
+#include "car_profiles.h"
+
+#include <string.h>
+
+#include "car_control.h"
+#include "gpio_pins.h"
+
+// CarConfig 欄位順序: pwmFreq, pwmRes, maxDuty, minDuty, commandTimeoutMs,
+//                     pinAFwd, pinARev, pinBLeft, pinBRight, pinStby, mixMode, expoThrottle, expoSteer, profile,
+//                     floorAFwd, floorARev, floorBLeft, floorBRight (0 = 未校正, 使用 minDuty),
+//                     steerMode, servoPin, servoHz, servoMinUs, servoCenterUs, servoMaxUs
+const CarProfile CAR_PROFILES[] = {
+    // 預設: 後輪驅動 + 轉向馬達 (gpio_pins.h)
+    {"default", {0, 0, 0, 0, 0, 0},
+     {PWM_FREQ, PWM_RES, MAX_DUTY, MIN_DUTY, COMMAND_TIMEOUT,
+      motorA_pwm_fwd, motorA_pwm_rev, motorB_pwm_left, motorB_pwm_right, motor_stby, MIX_STEER, 0, 0, 0, 0, 0, 0, 0,
+      STEER_MOTOR, servo_pwm, SERVO_FREQ, SERVO_MIN_US, SERVO_CENTER_US, SERVO_MAX_US}},
+    // 橘色 Car 08 Shuttle (esp32c3-0c4ea032119c)
+    {"orange-shuttle", {0x0C, 0x4E, 0xA0, 0x32, 0x11, 0x9C},
+     {PWM_FREQ, PWM_RES, MAX_DUTY, MIN_DUTY, COMMAND_TIMEOUT,
+      motorA_pwm_fwd, motorA_pwm_rev, motorB_pwm_left, motorB_pwm_right, motor_stby, MIX_STEER, 0, 0, 0, 0, 0, 0, 0,
+      STEER_MOTOR, servo_pwm, SERVO_FREQ, SERVO_MIN_US, SERVO_CENTER_US, SERVO_MAX_US}},
+    // 藍色 Car 08 Shuttle: 四驅攀爬車, 軟輪胎 (esp32c3-0c4ea032ad7c)
+    // Motor A 接左側、Motor B 接右側兩顆馬達 (host/sim 的 SKID_4WD), 差速混控; 低速攀爬需要細的油門
+    {"blue-4wd", {0x0C, 0x4E, 0xA0, 0x32, 0xAD, 0x7C},
+     {PWM_FREQ, PWM_RES, MAX_DUTY, MIN_DUTY, COMMAND_TIMEOUT,
+      motorA_pwm_fwd, motorA_pwm_rev, motorB_pwm_left, motorB_pwm_right, motor_stby, MIX_DIFF, 40, 30, 0, 0, 0, 0, 0,
+      STEER_MOTOR, servo_pwm, SERVO_FREQ, SERVO_MIN_US, SERVO_CENTER_US, SERVO_MAX_US}},
+    // 綠色車 (esp32c3-0c4ea032d24c)
+    {"green", {0x0C, 0x4E, 0xA0, 0x32, 0xD2, 0x4C},
+     {PWM_FREQ, PWM_RES, MAX_DUTY, MIN_DUTY, COMMAND_TIMEOUT,
+      motorA_pwm_fwd, motorA_pwm_rev, motorB_pwm_left, motorB_pwm_right, motor_stby, MIX_STEER, 0, 0, 0, 0, 0, 0, 0,
+      STEER_MOTOR, servo_pwm, SERVO_FREQ, SERVO_MIN_US, SERVO_CENTER_US, SERVO_MAX_US}},
+    // 空板子 (esp32c3-0c4ea03268c8): 桌上測試, 不接馬達
+    {"bare-board", {0x0C, 0x4E, 0xA0, 0x32, 0x68, 0xC8},
+     {PWM_FREQ, PWM_RES, MAX_DUTY, MIN_DUTY, COMMAND_TIMEOUT,
+      motorA_pwm_fwd, motorA_pwm_rev, motorB_pwm_left, motorB_pwm_right, motor_stby, MIX_STEER, 0, 0, 0, 0, 0, 0, 0,
+      STEER_MOTOR, servo_pwm, SERVO_FREQ, SERVO_MIN_US, SERVO_CENTER_US, SERVO_MAX_US}},
+    // 另一組接線 (原本在 gpio_pins.h 中註解掉的腳位): 以 NVS 的 "profile" 指定
+    {"alt-pins", {0, 0, 0, 0, 0, 0},
+     {PWM_FREQ, PWM_RES, MAX_DUTY, MIN_DUTY, COMMAND_TIMEOUT, 6, 5, 20, 21, 7, MIX_STEER, 0, 0, 0, 0, 0, 0, 0,
+      STEER_MOTOR, servo_pwm, SERVO_FREQ, SERVO_MIN_US, SERVO_CENTER_US, SERVO_MAX_US}},
+};
+const int CAR_PROFILE_COUNT = sizeof(CAR_PROFILES) / sizeof(CAR_PROFILES[0]);
+
+int selectProfile(const uint8_t* mac, int selected) {
+  if (selected > 0 && selected < CAR_PROFILE_COUNT) return selected;
+  static const uint8_t NONE[6] = {0, 0, 0, 0, 0, 0};
+  for (int i = 1; mac != nullptr && i < CAR_PROFILE_COUNT; i++) {
+    if (memcmp(CAR_PROFILES[i].mac, NONE, 6) != 0 && memcmp(CAR_PROFILES[i].mac, mac, 6) == 0) return i;
+  }
+  return 0;
+}
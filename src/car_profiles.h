@@ -0,0 +1,20 @@
+#pragma once
+// 車隊中每台車的內建 profile: 腳位、混控方式、PWM 與反應曲線
+// 開機時依 eFuse base MAC (即主機名稱 esp32c3-<mac> 中的 MAC) 選擇, 同一個韌體映像可以刷到所有車上;
+// NVS 的 "profile" (1~N) 可以指定其他 profile (例如換了車殼的板子), 個別欄位再由 NVS 覆寫 (config_store.h)。
+
+#include <stdint.h>
+
+#include "config_store.h"
+
+struct CarProfile {
+  const char* name;
+  uint8_t mac[6];   // 全 0: 不自動比對, 只能以 NVS 的 "profile" 指定
+  CarConfig cfg;    // cfg.profile 不使用
+};
+
+extern const CarProfile CAR_PROFILES[];  // [0] 為預設 (編譯時的常數), MAC 沒有符合時使用
+extern const int CAR_PROFILE_COUNT;
+
+// selected: NVS 指定的 profile (1~N), 0 = 依 mac 比對 (mac 可為 nullptr); 回傳 CAR_PROFILES 的索引
+int selectProfile(const uint8_t* mac, int selected);
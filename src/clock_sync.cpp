@@ -0,0 +1,119 @@
+#include "clock_sync.h"
+
+#include <math.h>
+#include <stdio.h>
+
+void ClockSync::reset() {
+  *this = ClockSync();
+}
+
+void ClockSync::addSample(int64_t t1, uint32_t t2, uint32_t t3, int64_t t4) {
+  int64_t rtt = (t4 - t1) - (int64_t)(uint32_t)(t3 - t2);
+  if (rtt < 0) rtt = 0; // 對端時鐘在交換途中被調整
+  Point p;
+  p.at = t2 + (t3 - t2) / 2;
+  p.offset = (((double)t2 - (double)t1) + ((double)t3 - (double)t4)) / 2;
+  p.rtt = rtt > UINT32_MAX ? UINT32_MAX : (uint32_t)rtt;
+
+  // 對端時鐘跳動 (使用者調整時間、NTP 步進) 或本機 millis() 溢位: 舊的估計不再有效
+  if (synced() && fabs(p.offset - offsetAt(p.at)) > (double)(STEP_MS + p.rtt)) reset();
+
+  if (_samples == 0 || p.rtt < _minRtt) _minRtt = p.rtt;
+  _samples++;
+  if (_windowN == 0 || p.rtt < _window.rtt) _window = p;
+  _windowN++;
+  if (_pointsN == 0) _ref = _window; // 第一個視窗未滿前先用目前最好的樣本
+  if (_windowN >= WINDOW) {
+    commit(_window);
+    _windowN = 0;
+  }
+}
+
+void ClockSync::commit(const Point& p) {
+  _points[_head] = p;
+  _head = (_head + 1) % POINTS;
+  if (_pointsN < POINTS) _pointsN++;
+  fit();
+}
+
+// 基準點: 延遲最小的點 (相同時取較新的)。漂移: 以最新的點為原點做最小平方直線擬合
+// (x: ms, y: offset 差值), 數值不受 offset 本身的大小影響
+void ClockSync::fit() {
+  const Point& last = _points[(_head + POINTS - 1) % POINTS];
+  double sx = 0, sy = 0, sxx = 0, sxy = 0;
+  int32_t span = 0;
+  const Point* best = &last;
+  for (int i = 0; i < _pointsN; i++) {
+    const Point& p = _points[i];
+    int32_t dt = (int32_t)(p.at - last.at);
+    double x = (double)dt;
+    double y = p.offset - last.offset;
+    sx += x;
+    sy += y;
+    sxx += x * x;
+    sxy += x * y;
+    if (-dt > span) span = -dt;
+    if (p.rtt < best->rtt || (p.rtt == best->rtt && dt > (int32_t)(best->at - last.at))) best = &p;
+  }
+  double n = _pointsN;
+  double den = n * sxx - sx * sx;
+  _drift = 0;
+  if (span >= DRIFT_SPAN_MS && den > 0) {
+    _drift = (n * sxy - sx * sy) / den;
+    if (_drift > MAX_DRIFT) _drift = MAX_DRIFT;
+    if (_drift < -MAX_DRIFT) _drift = -MAX_DRIFT;
+  }
+  _ref = *best;
+}
+
+double ClockSync::offsetAt(uint32_t nowMs) const {
+  return _ref.offset + _drift * (double)(int32_t)(nowMs - _ref.at);
+}
+
+const uint16_t LatencyHistogram::EDGES[BINS] = {1, 2, 3, 4, 5, 6, 8, 10, 15, 20, 30, 50, 100, 200, 500, 65535};
+
+void LatencyHistogram::reset() {
+  *this = LatencyHistogram();
+}
+
+void LatencyHistogram::add(double ms) {
+  if (ms < 0) {
+    _early++;
+    ms = 0;
+  }
+  int i = 0;
+  while (i < BINS - 1 && ms > EDGES[i]) i++;
+  _bins[i]++;
+  _count++;
+  _sum += ms;
+  if (ms > _max) _max = ms;
+}
+
+uint16_t LatencyHistogram::percentile(double q) const {
+  if (_count == 0) return 0;
+  uint32_t target = (uint32_t)ceil(q * _count);
+  if (target == 0) target = 1;
+  // 區間上限不超過實際的最大值
+  uint16_t top = _max > 65535 ? 65535 : (uint16_t)ceil(_max);
+  uint32_t seen = 0;
+  for (int i = 0; i < BINS - 1; i++) {
+    seen += _bins[i];
+    if (seen >= target) return EDGES[i] < top ? EDGES[i] : top;
+  }
+  return top;
+}
+
+size_t LatencyHistogram::toJson(char* buf, size_t maxLen) const {
+  int len = snprintf(buf, maxLen,
+                     "{\"n\":%lu,\"early\":%lu,\"mean\":%.1f,\"p50\":%u,\"p95\":%u,\"p99\":%u,\"max\":%.0f,\"bins\":[",
+                     (unsigned long)_count, (unsigned long)_early, meanMs(), percentile(0.5), percentile(0.95),
+                     percentile(0.99), _max);
+  bool first = true;
+  for (int i = 0; i < BINS && len > 0 && (size_t)len < maxLen; i++) {
+    if (_bins[i] == 0) continue;
+    len += snprintf(buf + len, maxLen - len, "%s[%u,%lu]", first ? "" : ",", EDGES[i], (unsigned long)_bins[i]);
+    first = false;
+  }
+  if (len > 0 && (size_t)len < maxLen) len += snprintf(buf + len, maxLen - len, "]}");
+  return len > 0 && (size_t)len < maxLen ? (size_t)len : 0;
+}
@@ -0,0 +1,83 @@
+#pragma once
+// 時鐘同步 (NTP 式) 與單向延遲分布
+// 瀏覽器的 "t" 是它自己的 Date.now(), 車上只有 millis(); 以控制通道上的交換估計兩個時鐘的差 (offset) 與漂移:
+//   瀏覽器 → 車  {"sync":t1,"echo":t1',"t4":t4'}   t1 瀏覽器送出時間; echo/t4 為上一次交換的 t1 與收到回覆的時間
+//   車 → 瀏覽器  {"sync":t1,"rx":t2,"tx":t3,...}    t2/t3 車上收到與回覆的 millis()
+// 車上在下一次請求收到 t4 後才得到完整樣本: 延遲 d = (t4-t1)-(t3-t2), offset θ = ((t2-t1)+(t3-t4))/2 (車 - 瀏覽器)。
+// 每 WINDOW 個樣本只保留延遲最小的一個 (排隊造成的不對稱最少); offset 取最近 POINTS 個最佳點中延遲最小者,
+// 漂移以這些點的最小平方法估計 (跨度至少 DRIFT_SPAN_MS, 較短時雜訊比漂移本身大, 視為 0)。
+// 單位一律 ms (兩端時鐘解析度), 估計誤差約 ±1 ms 加上最小延遲樣本的上下行不對稱。
+
+#include <stddef.h>
+#include <stdint.h>
+
+class ClockSync {
+public:
+  static const int WINDOW = 8;
+  static const int POINTS = 16;
+  static const int32_t DRIFT_SPAN_MS = 60000;
+  static const int64_t STEP_MS = 1000;   // 與預測相差超過此值: 對端時鐘被調整, 重新開始
+  static constexpr double MAX_DRIFT = 500e-6;
+
+  void reset();
+  // 一次完整的交換 (t1/t4: 對端時鐘, t2/t3: 本機 ms)
+  void addSample(int64_t t1, uint32_t t2, uint32_t t3, int64_t t4);
+
+  bool synced() const { return _samples > 0; }
+  uint32_t samples() const { return _samples; }
+  uint32_t minRttMs() const { return _minRtt; }
+  // 本機時間 nowMs 時的 offset (本機 - 對端, ms) 與漂移 (ppm, 本機相對對端)
+  double offsetAt(uint32_t nowMs) const;
+  double driftPpm() const { return _drift * 1e6; }
+  // 對端時間 remote 換算為本機 ms (相對 nowMs 的差值不超過 ±2^31 ms)
+  double toLocal(int64_t remote, uint32_t nowMs) const { return (double)remote + offsetAt(nowMs); }
+
+private:
+  struct Point {
+    uint32_t at;    // 本機時間 (t2 與 t3 的中點)
+    double offset;
+    uint32_t rtt;
+  };
+
+  void commit(const Point& p);
+  void fit();
+
+  Point _window = {};
+  int _windowN = 0;
+  Point _points[POINTS] = {};
+  int _pointsN = 0;
+  int _head = 0;          // 下一個寫入的位置
+  Point _ref = {};        // 估計的基準點 (延遲最小的最佳點, 或第一個視窗未滿前的最佳樣本)
+  double _drift = 0;
+  uint32_t _samples = 0;
+  uint32_t _minRtt = 0;
+};
+
+// 單向延遲分布 (固定的區間上限, 不配置記憶體); 百分位數回傳所在區間的上限 (不超過最大值)
+class LatencyHistogram {
+public:
+  static const int BINS = 16;
+  static const uint16_t EDGES[BINS]; // ms, 最後一個區間包含所有更大的值
+
+  void reset();
+  // 負值 (offset 誤差大於實際延遲) 計入第一個區間並另外計數
+  void add(double ms);
+
+  uint32_t count() const { return _count; }
+  uint32_t early() const { return _early; }
+  double maxMs() const { return _max; }
+  double meanMs() const { return _count ? _sum / _count : 0; }
+  uint16_t percentile(double q) const;
+  uint32_t bin(int i) const { return _bins[i]; }
+
+  // {"n":..,"early":..,"mean":..,"p50":..,"p95":..,"p99":..,"max":..,"bins":[[le,count],...]}
+  // 回傳長度; 緩衝區不足時回傳 0
+  size_t toJson(char* buf, size_t maxLen) const;
+
+private:
+  uint32_t _bins[BINS] = {};
+  uint32_t _count = 0;
+  uint32_t _early = 0;
+  double _sum = 0;
+  double _max = 0;
+};
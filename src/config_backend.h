@@ -0,0 +1,15 @@
+#pragma once
+// 執行期設定 (config_store.h) 的儲存層
+// 裝置上由 config_backend_nvs.cpp 實作 (NVS namespace "carcfg"),
+// 主機端 (單元測試、模擬器) 由 host/config_backend_file.cpp 實作。
+// 所有欄位都以 uint32 儲存, 型別與範圍由 config_store 的設定表決定。
+
+#include <stdint.h>
+
+// 開啟儲存區; 失敗時設定只存在 RAM (使用編譯時的預設值)
+bool cfgBackendOpen();
+// 沒有這個 key 時回傳 false
+bool cfgBackendRead(const char* key, uint32_t* value);
+bool cfgBackendWrite(const char* key, uint32_t value);
+// 寫入在 commit 之後才保證保存 (nvs_commit)
+bool cfgBackendCommit();
@@ -0,0 +1,33 @@
+#ifdef ESP_PLATFORM
+
+#include "config_backend.h"
+
+#include <nvs.h>
+#include <nvs_flash.h>
+
+static nvs_handle_t cfgHandle = 0;
+static bool cfgOpen = false;
+
+bool cfgBackendOpen() {
+  if (cfgOpen) return true;
+  // Arduino 的 initArduino() 已呼叫 nvs_flash_init(); 單獨使用 IDF 時在這裡初始化
+  esp_err_t err = nvs_open("carcfg", NVS_READWRITE, &cfgHandle);
+  if (err == ESP_ERR_NVS_NOT_INITIALIZED && nvs_flash_init() == ESP_OK) {
+    err = nvs_open("carcfg", NVS_READWRITE, &cfgHandle);
+  }
+  cfgOpen = err == ESP_OK;
+  return cfgOpen;
+}
+
+bool cfgBackendRead(const char* key, uint32_t* value) {
+  return cfgOpen && nvs_get_u32(cfgHandle, key, value) == ESP_OK;
+}
+
+// nvs_set_u32 對相同的值不會再寫入 flash, 呼叫端仍只寫入有變化的欄位
+bool cfgBackendWrite(const char* key, uint32_t value) {
+  return cfgOpen && nvs_set_u32(cfgHandle, key, value) == ESP_OK;
+}
+
+bool cfgBackendCommit() { return cfgOpen && nvs_commit(cfgHandle) == ESP_OK; }
+
+#endif
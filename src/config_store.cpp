@@ -0,0 +1,297 @@
+#include "config_store.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "car_control.h"
+#include "car_profiles.h"
+#include "car_variant.h"
+#include "config_backend.h"
+#include "json_scan.h"
+
+static const char* const VERSION_KEY = "ver";
+static const uint32_t LEDC_SRC_HZ = 80000000;  // APB: 頻率 x 2^解析度 不可超過
+
+#define CFG_FIELD(key, type, member, min, max, reboot) \
+  { key, ConfigType::type, (uint16_t)offsetof(CarConfig, member), min, max, reboot }
+
+const ConfigField ConfigStore::FIELDS[] = {
+    CFG_FIELD("pwm_freq", U32, pwmFreq, 100, 40000, true),
+    CFG_FIELD("pwm_res", U8, pwmRes, 1, 14, true),
+    CFG_FIELD("max_duty", U16, maxDuty, 1, 16383, false),
+    CFG_FIELD("min_duty", U16, minDuty, 0, 16383, false),
+    CFG_FIELD("cmd_timeout", U16, commandTimeoutMs, 50, 5000, false),
+    CFG_FIELD("pin_a_fwd", U8, pinAFwd, 0, 21, true),
+    CFG_FIELD("pin_a_rev", U8, pinARev, 0, 21, true),
+    CFG_FIELD("pin_b_left", U8, pinBLeft, 0, 21, true),
+    CFG_FIELD("pin_b_right", U8, pinBRight, 0, 21, true),
+    CFG_FIELD("pin_stby", U8, pinStby, 0, 21, true),
+    CFG_FIELD("mix", U8, mixMode, MIX_STEER, MIX_DIFF, false),
+    CFG_FIELD("expo_throttle", U8, expoThrottle, 0, 100, false),
+    CFG_FIELD("expo_steer", U8, expoSteer, 0, 100, false),
+    CFG_FIELD("profile", U8, profile, 0, 255, true),
+    CFG_FIELD("floor_a_fwd", U16, floorAFwd, 0, 16383, false),
+    CFG_FIELD("floor_a_rev", U16, floorARev, 0, 16383, false),
+    CFG_FIELD("floor_b_left", U16, floorBLeft, 0, 16383, false),
+    CFG_FIELD("floor_b_right", U16, floorBRight, 0, 16383, false),
+    CFG_FIELD("steer_mode", U8, steerMode, STEER_MOTOR, STEER_SERVO, true),
+    CFG_FIELD("servo_pin", U8, servoPin, 0, 21, true),
+    CFG_FIELD("servo_hz", U16, servoHz, 50, 333, true),
+    CFG_FIELD("servo_min_us", U16, servoMinUs, 500, 2500, false),
+    CFG_FIELD("servo_center_us", U16, servoCenterUs, 500, 2500, false),
+    CFG_FIELD("servo_max_us", U16, servoMaxUs, 500, 2500, false),
+};
+const int ConfigStore::FIELD_COUNT = sizeof(FIELDS) / sizeof(FIELDS[0]);
+
+CarConfig ConfigStore::defaults() { return CAR_PROFILES[0].cfg; }
+
+uint32_t ConfigStore::get(const CarConfig& cfg, const ConfigField& f) {
+  const uint8_t* p = (const uint8_t*)&cfg + f.offset;
+  switch (f.type) {
+    case ConfigType::U8: return *p;
+    case ConfigType::U16: return *(const uint16_t*)p;
+    default: return *(const uint32_t*)p;
+  }
+}
+
+bool ConfigStore::same(const CarConfig& a, const CarConfig& b) {
+  for (int i = 0; i < FIELD_COUNT; i++) {
+    if (get(a, FIELDS[i]) != get(b, FIELDS[i])) return false;
+  }
+  return true;
+}
+
+static void setField(CarConfig* cfg, const ConfigField& f, uint32_t value) {
+  uint8_t* p = (uint8_t*)cfg + f.offset;
+  switch (f.type) {
+    case ConfigType::U8: *p = (uint8_t)value; break;
+    case ConfigType::U16: *(uint16_t*)p = (uint16_t)value; break;
+    default: *(uint32_t*)p = value; break;
+  }
+}
+
+static bool sameField(const CarConfig& a, const CarConfig& b, const ConfigField& f) {
+  return ConfigStore::get(a, f) == ConfigStore::get(b, f);
+}
+
+// 欄位之間的限制; running 為執行中的設定 (解析度要重新開機才改變)
+static bool validate(const CarConfig& cfg, const CarConfig& running, char* err, size_t errLen) {
+  // 伺服的腳位只在 steer_mode 1 時使用
+  const uint8_t pins[] = {cfg.pinAFwd, cfg.pinARev, cfg.pinBLeft, cfg.pinBRight, cfg.pinStby, cfg.servoPin};
+  const char* const names[] = {"pin_a_fwd", "pin_a_rev", "pin_b_left", "pin_b_right", "pin_stby", "servo_pin"};
+  const int pinCount = cfg.steerMode == STEER_SERVO ? 6 : 5;
+  for (int i = 0; i < pinCount; i++) {
+    // ESP32-C3: GPIO11~17 接 SPI flash, 18/19 為 USB (USB CDC 序列埠)
+    if (pins[i] >= 11 && pins[i] <= 19) {
+      snprintf(err, errLen, "%s: GPIO %u is reserved (flash/USB)", names[i], pins[i]);
+      return false;
+    }
+    for (int j = 0; j < i; j++) {
+      if (pins[i] == pins[j]) {
+        snprintf(err, errLen, "%s: GPIO %u already used by %s", names[i], pins[i], names[j]);
+        return false;
+      }
+    }
+  }
+  if ((uint64_t)cfg.pwmFreq << cfg.pwmRes > LEDC_SRC_HZ) {
+    snprintf(err, errLen, "pwm_freq %lu Hz is too high for %u-bit resolution", (unsigned long)cfg.pwmFreq,
+             cfg.pwmRes);
+    return false;
+  }
+  uint8_t res = cfg.pwmRes < running.pwmRes ? cfg.pwmRes : running.pwmRes;
+  if (cfg.maxDuty > (1u << res) - 1) {
+    snprintf(err, errLen, "max_duty: %u exceeds %u-bit PWM", cfg.maxDuty, res);
+    return false;
+  }
+  if (cfg.minDuty > cfg.maxDuty) {
+    snprintf(err, errLen, "min_duty: must not exceed max_duty (%u)", cfg.maxDuty);
+    return false;
+  }
+  const uint16_t floors[] = {cfg.floorAFwd, cfg.floorARev, cfg.floorBLeft, cfg.floorBRight};
+  const char* const floorNames[] = {"floor_a_fwd", "floor_a_rev", "floor_b_left", "floor_b_right"};
+  for (int i = 0; i < 4; i++) {
+    if (floors[i] > cfg.maxDuty) {
+      snprintf(err, errLen, "%s: must not exceed max_duty (%u)", floorNames[i], cfg.maxDuty);
+      return false;
+    }
+  }
+  if (cfg.steerMode == STEER_SERVO) {
+    if (!variant::SERVO) {
+      snprintf(err, errLen, "steer_mode: servo is not in this build (CAR_FEATURE_SERVO=0)");
+      return false;
+    }
+    if (cfg.mixMode != MIX_STEER || variant::MIX > MIX_STEER) {
+      snprintf(err, errLen, "steer_mode: servo needs mix 0");
+      return false;
+    }
+  }
+  bool reversed = cfg.servoMinUs > cfg.servoMaxUs;
+  uint16_t lo = reversed ? cfg.servoMaxUs : cfg.servoMinUs;
+  uint16_t hi = reversed ? cfg.servoMinUs : cfg.servoMaxUs;
+  if (cfg.servoCenterUs < lo || cfg.servoCenterUs > hi) {
+    snprintf(err, errLen, "servo_center_us: must be between servo_min_us and servo_max_us");
+    return false;
+  }
+  if (cfg.profile > CAR_PROFILE_COUNT - 1) {
+    snprintf(err, errLen, "profile: 0 (by MAC) or 1..%d", CAR_PROFILE_COUNT - 1);
+    return false;
+  }
+  return true;
+}
+
+namespace {
+struct ParseCtx {
+  CarConfig cfg;
+  char* err;
+  size_t errLen;
+  bool failed;
+};
+
+bool onConfigField(void* ctx, const JsonField& f) {
+  ParseCtx* p = static_cast<ParseCtx*>(ctx);
+  for (int i = 0; i < ConfigStore::FIELD_COUNT; i++) {
+    const ConfigField& field = ConfigStore::FIELDS[i];
+    if (!f.is(field.key)) continue;
+    if (!f.isInteger || f.intValue < (int64_t)field.min || f.intValue > (int64_t)field.max) {
+      snprintf(p->err, p->errLen, "%s: must be an integer %lu..%lu", field.key, (unsigned long)field.min,
+               (unsigned long)field.max);
+      p->failed = true;
+      return false;
+    }
+    setField(&p->cfg, field, (uint32_t)f.intValue);
+    return true;
+  }
+  snprintf(p->err, p->errLen, "unknown key: %.*s", (int)(f.keyLen < 24 ? f.keyLen : 24), f.key);
+  p->failed = true;
+  return false;
+}
+}  // namespace
+
+bool ConfigStore::parse(const char* json, size_t len, const CarConfig& running, CarConfig* cfg, char* err,
+                        size_t errLen) {
+  ParseCtx ctx = {*cfg, err, errLen, false};
+  const char* scanErr = jsonScanObject(json, len, onConfigField, &ctx);
+  if (scanErr) {
+    snprintf(err, errLen, "JSON parse failed: %s", scanErr);
+    return false;
+  }
+  if (ctx.failed || !validate(ctx.cfg, running, err, errLen)) return false;
+  *cfg = ctx.cfg;
+  return true;
+}
+
+void ConfigStore::begin(const uint8_t* mac) {
+  _stats.loaded = 0;
+  uint32_t version = 0;
+  bool open = cfgBackendOpen();
+  bool readable = open && (!cfgBackendRead(VERSION_KEY, &version) || version <= VERSION);
+  // 先決定 profile: 其他欄位的預設值, 以及組合無效時的退路
+  uint32_t selected = 0;
+  if (!readable || !cfgBackendRead("profile", &selected) || selected >= (uint32_t)CAR_PROFILE_COUNT) selected = 0;
+  _profile = selectProfile(mac, (int)selected);
+  CarConfig base = CAR_PROFILES[_profile].cfg;
+  base.profile = (uint8_t)selected;
+  CarConfig cfg = base;
+  if (!open) {
+    _stats.failures++;
+  } else if (readable) {
+    // 較舊的版本: 目前沒有改變意義的欄位, 缺少的欄位使用預設值
+    for (int i = 0; i < FIELD_COUNT; i++) {
+      const ConfigField& f = FIELDS[i];
+      uint32_t value;
+      if (!cfgBackendRead(f.key, &value)) continue;
+      if (value < f.min || value > f.max) {
+        _stats.failures++;
+        continue;
+      }
+      setField(&cfg, f, value);
+      _stats.loaded++;
+    }
+    char err[64];
+    if (!validate(cfg, cfg, err, sizeof(err))) {
+      // 各欄位有效但組合無效 (例如兩個重複的腳位): 整組捨棄, 避免以錯誤的腳位開機
+      cfg = base;
+      _stats.failures++;
+    }
+  }
+  _active = _target = _saved = _staged = cfg;
+  _hasStaged = _dirty = false;
+}
+
+void ConfigStore::stage(const CarConfig& cfg) {
+  _staged = cfg;
+  _hasStaged = true;
+}
+
+bool ConfigStore::applyPending(uint32_t nowMs) {
+  if (!_hasStaged) return false;
+  _hasStaged = false;
+  _target = _staged;
+  bool changed = false;
+  _dirty = false;
+  for (int i = 0; i < FIELD_COUNT; i++) {
+    const ConfigField& f = FIELDS[i];
+    if (!sameField(_target, _saved, f)) _dirty = true;
+    if (f.reboot || sameField(_target, _active, f)) continue;
+    setField(&_active, f, get(_target, f));
+    changed = true;
+  }
+  _changedMs = nowMs;
+  _stats.applied++;
+  return changed;
+}
+
+void ConfigStore::tick(uint32_t nowMs) {
+  if (!_dirty || nowMs - _changedMs < SAVE_DELAY_MS) return;
+  // 失敗時下一個 SAVE_DELAY_MS 再試
+  if (!save()) _changedMs = nowMs;
+}
+
+void ConfigStore::flush() {
+  if (_dirty) save();
+}
+
+bool ConfigStore::save() {
+  bool ok = cfgBackendOpen();
+  uint32_t version = 0;
+  if (ok && (!cfgBackendRead(VERSION_KEY, &version) || version != VERSION)) ok = cfgBackendWrite(VERSION_KEY, VERSION);
+  for (int i = 0; ok && i < FIELD_COUNT; i++) {
+    const ConfigField& f = FIELDS[i];
+    if (sameField(_target, _saved, f)) continue;
+    ok = cfgBackendWrite(f.key, get(_target, f));
+    _stats.writes++;
+  }
+  if (ok) ok = cfgBackendCommit();
+  if (!ok) {
+    _stats.failures++;
+    return false;
+  }
+  _stats.commits++;
+  _saved = _target;
+  _dirty = false;
+  return true;
+}
+
+size_t ConfigStore::toJson(char* buf, size_t maxLen) const {
+  const CarConfig& cfg = latest();
+  int len = snprintf(buf, maxLen, "{\"ver\":%lu,\"profile\":\"%s\",\"cfg\":{", (unsigned long)VERSION,
+                     CAR_PROFILES[_profile].name);
+  for (int i = 0; i < FIELD_COUNT && len > 0 && (size_t)len < maxLen; i++) {
+    len += snprintf(buf + len, maxLen - len, "%s\"%s\":%lu", i ? "," : "", FIELDS[i].key,
+                    (unsigned long)get(cfg, FIELDS[i]));
+  }
+  bool first = true;
+  if (len > 0 && (size_t)len < maxLen) len += snprintf(buf + len, maxLen - len, "},\"reboot\":[");
+  for (int i = 0; i < FIELD_COUNT && len > 0 && (size_t)len < maxLen; i++) {
+    if (!FIELDS[i].reboot || sameField(cfg, _active, FIELDS[i])) continue;
+    len += snprintf(buf + len, maxLen - len, "%s\"%s\"", first ? "" : ",", FIELDS[i].key);
+    first = false;
+  }
+  if (len > 0 && (size_t)len < maxLen) {
+    len += snprintf(buf + len, maxLen - len, "],\"saved\":%s,\"writes\":%lu,\"commits\":%lu}",
+                    _dirty || _hasStaged ? "false" : "true", (unsigned long)_stats.writes,
+                    (unsigned long)_stats.commits);
+  }
+  return len > 0 && (size_t)len < maxLen ? (size_t)len : 0;
+}
@@ -0,0 +1,106 @@
+#pragma once
+// 執行期設定: 有型別、有版本的設定表, 預設值來自這台車的內建 profile (car_profiles.h, 依 eFuse MAC 選擇)
+// 開機時從 NVS (config_backend.h) 讀一次到 RAM, NVS 中有的欄位覆寫 profile 的值; 之後以 WebSocket {"cfg":{...}} 或 REST /api/config 修改:
+//   - 先整批驗證 (任一欄位無效則全部拒絕), 通過後暫存, 由 loop() 在控制 tick 之間一次套用
+//   - 腳位與 PWM 頻率/解析度要重新設定 LEDC, 只保存、下次開機生效 ("reboot" 列出尚未生效的欄位)
+//   - 寫入 NVS 合併: 最後一次修改 SAVE_DELAY_MS 之後才寫, 且只寫有變化的欄位 (拖動滑桿不會每步都寫 flash)
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct CarConfig {
+  uint32_t pwmFreq;           // Hz
+  uint8_t pwmRes;             // bits
+  uint16_t maxDuty;           // 搖桿 100% 對應的 duty
+  uint16_t minDuty;           // Motor B 的最小啟動 duty (0 = 不使用)
+  uint16_t commandTimeoutMs;  // 沒收到命令多久後停止馬達
+  uint8_t pinAFwd;
+  uint8_t pinARev;
+  uint8_t pinBLeft;
+  uint8_t pinBRight;
+  uint8_t pinStby;
+  uint8_t mixMode;            // MixMode (car_control.h)
+  uint8_t expoThrottle;       // 反應曲線 0~100 (0 = 線性)
+  uint8_t expoSteer;
+  uint8_t profile;            // NVS 指定的 profile (1~N), 0 = 依 MAC 選擇
+  uint16_t floorAFwd;         // 每個方向的最小啟動 duty (CALIBRATE 模式量測), 0 = 使用 minDuty
+  uint16_t floorARev;
+  uint16_t floorBLeft;
+  uint16_t floorBRight;
+  uint8_t steerMode;          // SteerMode (car_control.h)
+  uint8_t servoPin;
+  uint16_t servoHz;
+  uint16_t servoMinUs;        // 全左 / 中心 / 全右的脈寬 (µs); min > max 時反向
+  uint16_t servoCenterUs;
+  uint16_t servoMaxUs;
+};
+
+enum class ConfigType : uint8_t { U8, U16, U32 };
+
+struct ConfigField {
+  const char* key;     // JSON 名稱, 同時是 NVS key (最多 15 字元)
+  ConfigType type;
+  uint16_t offset;     // offsetof(CarConfig, ...)
+  uint32_t min;
+  uint32_t max;
+  bool reboot;         // 下次開機生效
+};
+
+struct ConfigStats {
+  uint16_t loaded;     // 開機時從 NVS 讀到的欄位
+  uint32_t applied;    // 套用的設定批次
+  uint32_t writes;     // 寫入 NVS 的欄位
+  uint32_t commits;    // NVS commit 次數
+  uint32_t failures;
+};
+
+class ConfigStore {
+public:
+  static const uint32_t VERSION = 1;             // 設定表改變意義時遞增; NVS 的版本較新 (降版) 時不讀取
+  static const uint32_t SAVE_DELAY_MS = 3000;
+  static const int FIELD_COUNT;
+  static const ConfigField FIELDS[];
+
+  // 編譯時的預設值 (CAR_PROFILES[0])
+  static CarConfig defaults();
+  static uint32_t get(const CarConfig& cfg, const ConfigField& f);
+  static bool same(const CarConfig& a, const CarConfig& b);
+
+  // 驗證 JSON 物件 {"key":value,...} 並合併到 *cfg; running 為執行中的設定 (max_duty 不可超過目前的解析度)。
+  // 成功回傳 true; 失敗時 *cfg 不變, err 為錯誤訊息 (直接放進 {"error":"..."})
+  static bool parse(const char* json, size_t len, const CarConfig& running, CarConfig* cfg, char* err, size_t errLen);
+
+  // 開機: 依 NVS 的 profile 或 mac (eFuse base MAC, nullptr = 不比對) 選擇 profile, 再以儲存層中的欄位覆寫;
+  // 超出範圍的欄位用 profile 的值
+  void begin(const uint8_t* mac = nullptr);
+  int profileIndex() const { return _profile; }
+  // 控制核心使用中的值 (reboot 欄位為開機時的值)
+  const CarConfig& active() const { return _active; }
+  // 最新的設定 (含尚未套用的暫存), parse() 的合併基礎
+  const CarConfig& latest() const { return _hasStaged ? _staged : _target; }
+  // 暫存, 下一次 applyPending() 生效
+  void stage(const CarConfig& cfg);
+  // 在控制 tick 邊界呼叫: 套用暫存的設定, 即時欄位有變化時回傳 true (呼叫端重新設定 CarControl)
+  bool applyPending(uint32_t nowMs);
+  // 合併寫入: 最後一次修改 SAVE_DELAY_MS 後寫入有變化的欄位
+  void tick(uint32_t nowMs);
+  // 立即寫入 (重新開機前)
+  void flush();
+  bool dirty() const { return _dirty; }
+  const ConfigStats& stats() const { return _stats; }
+  // {"ver":1,"profile":"...","cfg":{...},"reboot":[...],"saved":true,"writes":0,"commits":0}: cfg 為最新的設定
+  size_t toJson(char* buf, size_t maxLen) const;
+
+private:
+  bool save();
+
+  CarConfig _active = defaults();
+  CarConfig _target = defaults();  // 套用後的完整設定, 也是要寫入 NVS 的內容
+  CarConfig _saved = defaults();   // NVS 中的內容
+  CarConfig _staged = defaults();
+  int _profile = 0;
+  bool _hasStaged = false;
+  bool _dirty = false;
+  uint32_t _changedMs = 0;
+  ConfigStats _stats = {0, 0, 0, 0, 0};
+};
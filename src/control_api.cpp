@@ -0,0 +1,128 @@
+#include "control_api.h"
+
+#include <string.h>
+
+#include "json_scan.h"
+
+static const char* const ERR_TOO_LARGE = "body too large";
+
+static bool inRange(const JsonField& f, int64_t lo, int64_t hi) {
+  return f.type == JsonType::NUMBER && f.isInteger && f.intValue >= lo && f.intValue <= hi;
+}
+
+namespace {
+struct DriveCtx {
+  DriveSetpoint* out;
+  const char* err;
+};
+
+bool onDriveField(void* ctx, const JsonField& f) {
+  DriveCtx* d = static_cast<DriveCtx*>(ctx);
+  if (f.is("throttle") || f.is("steer")) {
+    if (!inRange(f, -100, 100)) {
+      d->err = "throttle and steer must be integers -100..100";
+      return false;
+    }
+    (f.is("throttle") ? d->out->throttle : d->out->steer) = (int)f.intValue;
+  } else if (f.is("t") && f.isInteger) {
+    d->out->t = f.intValue;
+    d->out->hasT = true;
+  }
+  return true;
+}
+
+struct ModeCtx {
+  DriveMode* out;
+  bool found;
+};
+
+bool onModeField(void* ctx, const JsonField& f) {
+  ModeCtx* m = static_cast<ModeCtx*>(ctx);
+  if (!f.is("mode") || f.type != JsonType::STRING) return true;
+  if (f.rawLen == 4 && memcmp(f.raw, "AUTO", 4) == 0) *m->out = AUTO;
+  else if (f.rawLen == 6 && memcmp(f.raw, "MANUAL", 6) == 0) *m->out = MANUAL;
+  else return true;
+  m->found = true;
+  return false;
+}
+
+struct SegmentCtx {
+  int64_t v[3];
+  int n;
+};
+
+bool onSegmentValue(void* ctx, const JsonField& f) {
+  SegmentCtx* s = static_cast<SegmentCtx*>(ctx);
+  if (s->n == 3 || f.type != JsonType::NUMBER || !f.isInteger) {
+    s->n = -1; // 多於三個或不是整數
+    return false;
+  }
+  s->v[s->n++] = f.intValue;
+  return true;
+}
+
+struct MissionCtx {
+  MissionSegment* out;
+  int max;
+  int count;
+  const char* err;
+  bool found;
+};
+
+bool onMissionSegment(void* ctx, const JsonField& f) {
+  MissionCtx* m = static_cast<MissionCtx*>(ctx);
+  if (m->count == m->max) {
+    m->err = "too many segments";
+    return false;
+  }
+  SegmentCtx s = {{0, 0, 0}, 0};
+  if (f.type != JsonType::ARRAY || jsonScanArray(f.raw, f.rawLen, onSegmentValue, &s) != nullptr || s.n != 3 ||
+      s.v[0] < -100 || s.v[0] > 100 || s.v[1] < -100 || s.v[1] > 100 || s.v[2] < 1 || s.v[2] > MAX_SEGMENT_MS) {
+    m->err = "segments are [throttle -100..100, steer -100..100, ms 1..30000]";
+    return false;
+  }
+  m->out[m->count++] = {(int8_t)s.v[0], (int8_t)s.v[1], (uint16_t)s.v[2]};
+  return true;
+}
+
+bool onMissionField(void* ctx, const JsonField& f) {
+  MissionCtx* m = static_cast<MissionCtx*>(ctx);
+  if (!f.is("segments")) return true;
+  m->found = true;
+  if (f.type != JsonType::ARRAY) {
+    m->err = "segments must be an array";
+    return false;
+  }
+  const char* err = jsonScanArray(f.raw, f.rawLen, onMissionSegment, m);
+  if (err && m->err == nullptr) m->err = err;
+  return false;
+}
+}  // namespace
+
+const char* parseDriveRequest(const char* body, size_t len, DriveSetpoint* out) {
+  if (len > MAX_API_BODY) return ERR_TOO_LARGE;
+  *out = {0, 0, 0, false};
+  DriveCtx ctx = {out, nullptr};
+  const char* err = jsonScanObject(body, len, onDriveField, &ctx);
+  return ctx.err ? ctx.err : err;
+}
+
+const char* parseModeRequest(const char* body, size_t len, DriveMode* out) {
+  if (len > MAX_API_BODY) return ERR_TOO_LARGE;
+  ModeCtx ctx = {out, false};
+  const char* err = jsonScanObject(body, len, onModeField, &ctx);
+  if (err) return err;
+  return ctx.found ? nullptr : "mode must be \"AUTO\" or \"MANUAL\"";
+}
+
+const char* parseMissionRequest(const char* body, size_t len, MissionSegment* out, int maxSegments, int* count) {
+  *count = 0;
+  if (len > MAX_API_BODY) return ERR_TOO_LARGE;
+  MissionCtx ctx = {out, maxSegments, 0, nullptr, false};
+  const char* err = jsonScanObject(body, len, onMissionField, &ctx);
+  if (ctx.err) return ctx.err;
+  if (err) return err;
+  if (!ctx.found || ctx.count == 0) return "segments must be a non-empty array";
+  *count = ctx.count;
+  return nullptr;
+}
@@ -0,0 +1,29 @@
+#pragma once
+// REST 控制 API (/api/*) 的請求本文解析: 給不想處理 WebSocket 的自動化腳本
+//   POST /api/drive    {"throttle":60,"steer":-20[,"t":...]}   與 WebSocket 的搖桿 JSON 相同 (命令超時同樣是 300 ms)
+//   POST /api/mode     {"mode":"AUTO"} / {"mode":"MANUAL"}
+//   POST /api/estop    (不需要本文)
+//   POST /api/mission  {"segments":[[throttle,steer,ms],...]}   一次上傳整段路線, 車上依序播放
+//   GET  /api/mission  目前的進度
+// 本文長度上限 MAX_API_BODY (超過回 413, 不緩衝); 以 json_scan 掃描, 不配置記憶體。
+// 與 WebSocket 不同, 超出範圍的值回 400 而不是截斷: 腳本的錯誤應該被看見。
+// 成功回傳 nullptr, 否則回傳錯誤訊息 (直接放進 {"error":"..."})。
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "car_control.h"
+
+const size_t MAX_API_BODY = 4096;
+
+struct DriveSetpoint {
+  int throttle;
+  int steer;
+  int64_t t;   // 選用, 原樣回傳為狀態廣播的 "ack"
+  bool hasT;
+};
+
+const char* parseDriveRequest(const char* body, size_t len, DriveSetpoint* out);
+const char* parseModeRequest(const char* body, size_t len, DriveMode* out);
+// 最多 maxSegments 個區段, 寫入 out 並設定 *count
+const char* parseMissionRequest(const char* body, size_t len, MissionSegment* out, int maxSegments, int* count);
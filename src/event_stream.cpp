@@ -0,0 +1,145 @@
+#include "event_stream.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static const char HELLO[] = "retry: 2000\n: esp32-car events\n\n";
+
+int EventStream::addSubscriber(int hz, uint32_t nowMs) {
+  if (hz < 0) hz = 0;
+  if (hz > MAX_HZ) hz = MAX_HZ;
+  for (int i = 0; i < MAX_SUBS; i++) {
+    Sub& s = _subs[i];
+    if (s.active) continue;
+    s = Sub();
+    s.active = true;
+    s.periodMs = hz ? (uint16_t)(1000 / hz) : 0;
+    s.teleDueMs = nowMs;
+    s.statusAtMs = nowMs - statusPeriod(s);
+    s.teleSeq = _slot[SSE_TELE].seq;   // 只送新的遙測 (到期時 teleDue() 要求發佈)
+    s.statusSeq = 0;                   // 最新的狀態立即送出一次
+    s.logSeq = _logSeq;
+    return i;
+  }
+  return -1;
+}
+
+void EventStream::removeSubscriber(int sub) {
+  if (sub >= 0 && sub < MAX_SUBS) _subs[sub].active = false;
+}
+
+// 連線的遙測到期, 而且手上的已經送出, 或還沒送出的那份已經舊了一個週期 (送不出去: 以新的取代)
+bool EventStream::teleWanted(const Sub& s, uint32_t nowMs) const {
+  if (!s.active || s.periodMs == 0 || (int32_t)(nowMs - s.teleDueMs) < 0) return false;
+  return s.teleSeq == _slot[SSE_TELE].seq || nowMs - _slot[SSE_TELE].atMs >= s.periodMs;
+}
+
+bool EventStream::teleDue(uint32_t nowMs) const {
+  for (const Sub& s : _subs) {
+    if (teleWanted(s, nowMs)) return true;
+  }
+  return false;
+}
+
+size_t EventStream::frame(char* out, size_t maxLen, const char* event, const char* json, size_t len) {
+  int head = snprintf(out, maxLen, "event: %s\ndata: ", event);
+  if (head <= 0 || (size_t)head + len + 2 > maxLen) return 0;
+  memcpy(out + head, json, len);
+  out[head + len] = '\n';
+  out[head + len + 1] = '\n';
+  return (size_t)head + len + 2;
+}
+
+void EventStream::publish(SseKind kind, const char* json, size_t len, uint32_t nowMs) {
+  if (kind != SSE_TELE && kind != SSE_STATUS) return;
+  char* buf = kind == SSE_TELE ? _tele : _status;
+  size_t n = frame(buf, MAX_EVENT, kind == SSE_TELE ? "tele" : "status", json, len);
+  if (n == 0) return;
+  Slot& slot = _slot[kind];
+  // 上一份發佈時連線已經到期 (可以送) 卻還沒送出: 被取代
+  for (const Sub& s : _subs) {
+    if (!s.active || slot.seq == 0) continue;
+    bool dropped = kind == SSE_TELE
+        ? s.teleSeq != slot.seq && s.periodMs != 0 && (int32_t)(slot.atMs - s.teleDueMs) >= 0
+        : s.statusSeq != slot.seq && (int32_t)(slot.atMs - (s.statusAtMs + statusPeriod(s))) >= 0;
+    if (dropped) _stats.dropped++;
+  }
+  slot.seq++;
+  slot.len = (uint16_t)n;
+  slot.atMs = nowMs;
+  _stats.published[kind]++;
+}
+
+void EventStream::publishLog(const char* text) {
+  char* out = _logs[_logSeq % LOG_SLOTS];
+  static const char HEAD[] = "event: log\ndata: {\"log\":\"";
+  size_t n = sizeof(HEAD) - 1;
+  memcpy(out, HEAD, n);
+  // 保留結尾 "}\n\n 與最長的跳脫序列 (\u00XX) 的空間
+  for (const char* p = text; *p && n + 6 + 4 < LOG_EVENT; p++) {
+    unsigned char c = (unsigned char)*p;
+    if (c == '"' || c == '\\') {
+      out[n++] = '\\';
+      out[n++] = (char)c;
+    } else if (c < 0x20) {
+      n += snprintf(out + n, LOG_EVENT - n, "\\u%04x", c);
+    } else {
+      out[n++] = (char)c;
+    }
+  }
+  memcpy(out + n, "\"}\n\n", 4);
+  _logLen[_logSeq % LOG_SLOTS] = (uint16_t)(n + 4);
+  _logSeq++;
+  _stats.published[SSE_LOG]++;
+}
+
+size_t EventStream::next(int sub, char* buf, size_t maxLen, uint32_t nowMs) {
+  if (sub < 0 || sub >= MAX_SUBS || !_subs[sub].active) return 0;
+  Sub& s = _subs[sub];
+  if (!s.hello) {
+    if (maxLen < sizeof(HELLO) - 1) return 0;
+    memcpy(buf, HELLO, sizeof(HELLO) - 1);
+    s.hello = true;
+    return sizeof(HELLO) - 1;
+  }
+  // 日誌依序送出; 落後超過緩衝區的部分已被覆寫
+  if (s.logSeq != _logSeq) {
+    if (_logSeq - s.logSeq > (uint32_t)LOG_SLOTS) {
+      _stats.dropped += _logSeq - s.logSeq - LOG_SLOTS;
+      s.logSeq = _logSeq - LOG_SLOTS;
+    }
+    int i = s.logSeq % LOG_SLOTS;
+    if (_logLen[i] > maxLen) return 0;
+    memcpy(buf, _logs[i], _logLen[i]);
+    s.logSeq++;
+    _stats.sent++;
+    return _logLen[i];
+  }
+  const Slot& status = _slot[SSE_STATUS];
+  if (status.seq != s.statusSeq && status.seq != 0 && nowMs - s.statusAtMs >= statusPeriod(s)) {
+    if (status.len > maxLen) return 0;
+    memcpy(buf, _status, status.len);
+    s.statusSeq = status.seq;
+    s.statusAtMs = nowMs;
+    _stats.sent++;
+    return status.len;
+  }
+  const Slot& tele = _slot[SSE_TELE];
+  if (s.periodMs != 0 && tele.seq != s.teleSeq && (int32_t)(nowMs - s.teleDueMs) >= 0) {
+    if (tele.len > maxLen) return 0;
+    memcpy(buf, _tele, tele.len);
+    s.teleSeq = tele.seq;
+    // 落後時 (連線送不出去) 不補送
+    s.teleDueMs = nowMs - s.teleDueMs > s.periodMs ? nowMs + s.periodMs : s.teleDueMs + s.periodMs;
+    _stats.sent++;
+    return tele.len;
+  }
+  return 0;
+}
+
+SseStats EventStream::stats() const {
+  SseStats st = _stats;
+  st.subscribers = 0;
+  for (const Sub& s : _subs) st.subscribers += s.active ? 1 : 0;
+  return st;
+}
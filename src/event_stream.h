@@ -0,0 +1,78 @@
+#pragma once
+// SSE 事件分送 (GET /events?rate=N, text/event-stream): 只想看車況的腳本與儀表板不需要 WebSocket 客戶端。
+//   event: tele     與 WebSocket {"sub":hz} 相同的遙測 JSON, 每個連線依自己的 rate 送出
+//   event: status   狀態廣播 (馬達輸出、模式、ack), 每個連線每個週期最多一則, 只送最新的
+//   event: log      遠端日誌 (心跳等), {"log":"..."}, 環形緩衝區 LOG_SLOTS 則
+// 每種事件發佈時只組一次 (含 SSE 框架), 各連線從共用的緩衝區複製, 不為每個連線重新序列化。
+// 連線太慢 (TCP 送不出去) 時不排隊: 新的遙測/狀態直接取代還沒送出的舊資料 (drop-oldest, 計入 dropped),
+// 日誌落後超過 LOG_SLOTS 則跳到最舊還在的一則。
+// 非執行緒安全: 裝置上由呼叫端以 critical section 保護 (loop 發佈與送出, 日誌可能來自其他任務)。
+
+#include <stddef.h>
+#include <stdint.h>
+
+enum SseKind : uint8_t { SSE_TELE, SSE_STATUS, SSE_LOG, SSE_KINDS };
+
+struct SseStats {
+  uint32_t published[SSE_KINDS];
+  uint32_t sent;          // 送出的事件 (每個連線各算一次)
+  uint32_t dropped;       // 到期卻來不及送出就被新資料取代的事件
+  int subscribers;
+};
+
+class EventStream {
+public:
+  static const int MAX_SUBS = 4;
+  static const int MAX_HZ = 20;
+  static const int DEFAULT_HZ = 2;
+  static const size_t MAX_EVENT = 320;  // 一則事件含框架的上限, 超過的發佈被略過
+  static const int LOG_SLOTS = 8;
+  static const size_t LOG_EVENT = 192;
+  static constexpr const char* CONTENT_TYPE = "text/event-stream";
+
+  // 新增連線, hz 為遙測頻率 (0 = 只收狀態與日誌, 上限 MAX_HZ); 已滿回傳 -1
+  int addSubscriber(int hz, uint32_t nowMs);
+  void removeSubscriber(int sub);
+  // 有任何連線的遙測已到期: 呼叫端組好遙測再 publish(SSE_TELE, ...)
+  bool teleDue(uint32_t nowMs) const;
+
+  // SSE_TELE / SSE_STATUS; json 不可含換行, 超過 MAX_EVENT 的略過
+  void publish(SseKind kind, const char* json, size_t len, uint32_t nowMs);
+  // 日誌為純文字, 跳脫為 {"log":"..."} (過長截斷)
+  void publishLog(const char* text);
+
+  // 寫出該連線下一則事件 (完整, 不切割), 回傳位元組數; 沒有可送的或 maxLen 放不下回傳 0
+  size_t next(int sub, char* buf, size_t maxLen, uint32_t nowMs);
+
+  SseStats stats() const;
+
+private:
+  struct Slot {
+    uint32_t seq;       // 0 = 還沒有資料
+    uint16_t len;
+    uint32_t atMs;      // 發佈時間
+  };
+  struct Sub {
+    bool active;
+    bool hello;         // 已送出 retry 與開頭註解
+    uint16_t periodMs;  // 0 = 不送遙測
+    uint32_t teleDueMs;
+    uint32_t statusAtMs;
+    uint32_t teleSeq;   // 最後送出的版本
+    uint32_t statusSeq;
+    uint32_t logSeq;    // 下一則要送的日誌
+  };
+
+  static size_t frame(char* out, size_t maxLen, const char* event, const char* json, size_t len);
+  static uint16_t statusPeriod(const Sub& s) { return s.periodMs ? s.periodMs : 1000 / MAX_HZ; }
+  bool teleWanted(const Sub& s, uint32_t nowMs) const;
+
+  char _tele[MAX_EVENT];
+  char _status[MAX_EVENT];
+  char _logs[LOG_SLOTS][LOG_EVENT];
+  uint16_t _logLen[LOG_SLOTS] = {};
+  Slot _slot[2] = {};       // SSE_TELE, SSE_STATUS
+  uint32_t _logSeq = 0;     // 已發佈的日誌數
+  Sub _subs[MAX_SUBS] = {};
+  SseStats _stats = {};
+};
@@ -0,0 +1,252 @@
+#pragma once
+// 車隊儀表板 (GET /fleet): 任何一台車、模擬器或 tools/fleet_dash.py 都提供同一份內容。
+// 從 /peers 取得車輛清單, 每台車一條 WebSocket 以 {"sub":2} 訂閱低頻遙測, 全部畫在一個 canvas 上;
+// 點選一格取得該車的控制權 (一次只控制一台)。車輛數與歷史長度固定上限, 記憶體不隨時間增長。
+
+const char fleet_html[] = R"rawliteral(
+<!doctype html>
+<html lang="zh-TW">
+<head>
+  <meta charset="utf-8" />
+  <meta name="viewport" content="width=device-width,initial-scale=1" />
+  <title>ESP32 Car Fleet</title>
+  <style>
+    html,body{height:100%;margin:0;background:#0b0d11;color:#e6eef6;font-family:Inter,system-ui,Segoe UI,Roboto,"Noto Sans TC",sans-serif;overflow:hidden}
+    .bar{position:absolute;left:0;right:0;top:0;height:32px;display:flex;align-items:center;gap:12px;padding:0 12px;background:#0f1720;font-size:13px;color:#98a2b3;font-variant-numeric:tabular-nums}
+    .bar b{color:#e6eef6}
+    canvas{position:absolute;left:0;top:32px;width:100%;height:calc(100% - 32px);cursor:pointer}
+  </style>
+</head>
+<body>
+  <div class="bar"><b>車隊</b><span id="summary">-</span><span id="control"></span></div>
+  <canvas id="grid"></canvas>
+  <script>
+    // 上限: 同時監看的車輛數與每台的歷史樣本 (遙測 SUB_HZ 次/秒)
+    const MAX_CARS = 32, SUB_HZ = 2, HISTORY = 60, STALE_MS = 3000 / SUB_HZ;
+    const cars = [];
+    const canvas = document.getElementById('grid');
+    const summaryEl = document.getElementById('summary');
+    const controlEl = document.getElementById('control');
+
+    // --- 車輛與連線: 每台一條 WebSocket (HTTP 埠 +1), 斷線以指數退避重連 ---
+    function addCar(name, host){
+        if (cars.length >= MAX_CARS || cars.some(c => c.host === host)) return;
+        const c = {name, host, ws:null, state:'connecting', tele:null, lastAt:0, retry:1000, timer:null,
+                   hist:new Float32Array(HISTORY), histN:0, histHead:0, msgs:0};
+        cars.push(c);
+        connect(c);
+        dirty();
+    }
+
+    function wsUrl(host){
+        const i = host.lastIndexOf(':');
+        return i < 0 ? `ws://${host}:81` : `ws://${host.slice(0, i)}:${Number(host.slice(i + 1)) + 1}`;
+    }
+
+    function connect(c){
+        c.state = 'connecting';
+        let ws;
+        try { ws = new WebSocket(wsUrl(c.host)); } catch (e) { retry(c); return; }
+        c.ws = ws;
+        ws.onopen = () => { c.retry = 1000; ws.send(JSON.stringify({sub:SUB_HZ})); };
+        ws.onmessage = (e) => {
+            // 只處理遙測; 其他控制端造成的狀態廣播與日誌不解析
+            if (typeof e.data !== 'string' || e.data.indexOf('"tele"') < 0) return;
+            let m;
+            try { m = JSON.parse(e.data); } catch (_) { return; }
+            if (!m.tele) { c.state = 'full'; dirty(); ws.close(); return; } // 車上訂閱已滿, 稍後重試
+            c.tele = m.tele; c.lastAt = performance.now(); c.state = 'live'; c.msgs++;
+            c.hist[c.histHead] = m.tele.a; c.histHead = (c.histHead + 1) % HISTORY;
+            if (c.histN < HISTORY) c.histN++;
+            dirty();
+        };
+        ws.onclose = () => {
+            c.ws = null;
+            if (control.car === c) releaseControl();
+            if (c.state !== 'full') c.state = 'down';
+            dirty();
+            retry(c);
+        };
+    }
+
+    function retry(c){
+        clearTimeout(c.timer);
+        c.timer = setTimeout(() => connect(c), c.state === 'full' ? 30000 : c.retry);
+        c.retry = Math.min(30000, c.retry * 2);
+    }
+
+    async function discover(){
+        try {
+            const res = await fetch('/peers', {cache:'no-store'});
+            const j = await res.json();
+            for (const p of j.peers) addCar(p.name, p.host);
+        } catch (e) { console.warn('peers', e); }
+    }
+
+    // --- 控制: 一次只交給一台車; 換車或釋放前先送出停止 ---
+    const control = {car:null, keys:new Set(), steer:0, throttle:0, timer:null};
+    const KEYS = {ArrowUp:'up', KeyW:'up', ArrowDown:'down', KeyS:'down', ArrowLeft:'left', KeyA:'left', ArrowRight:'right', KeyD:'right'};
+
+    // 字串為單字元命令 ('S' 急停), 物件為 JSON 搖桿命令
+    function send(c, msg){ if (c && c.ws && c.ws.readyState === WebSocket.OPEN) c.ws.send(typeof msg === 'string' ? msg : JSON.stringify(msg)); }
+
+    function takeControl(c){
+        if (control.car === c) return;
+        releaseControl();
+        if (!c.ws || c.ws.readyState !== WebSocket.OPEN) return;
+        control.car = c;
+        dirty();
+    }
+
+    function releaseControl(){
+        const c = control.car;
+        control.keys.clear();
+        if (c && (control.steer || control.throttle)) send(c, {t:Date.now(), steer:0, throttle:0});
+        control.steer = control.throttle = 0;
+        clearTimeout(control.timer);
+        control.timer = null;
+        control.car = null;
+        dirty();
+    }
+
+    // 按鍵有變化時立即送出, 按住時每 100 ms 保活 (車上 COMMAND_TIMEOUT 300 ms)
+    function driveUpdate(full){
+        const k = control.keys, scale = full ? 100 : 60;
+        const steer = ((k.has('right') ? 1 : 0) - (k.has('left') ? 1 : 0)) * scale;
+        const throttle = ((k.has('up') ? 1 : 0) - (k.has('down') ? 1 : 0)) * scale;
+        const changed = steer !== control.steer || throttle !== control.throttle;
+        control.steer = steer; control.throttle = throttle;
+        if (changed) driveSend();
+    }
+
+    function driveSend(){
+        clearTimeout(control.timer);
+        control.timer = null;
+        if (!control.car) return;
+        send(control.car, {t:Date.now(), steer:control.steer, throttle:control.throttle});
+        if (control.steer || control.throttle) control.timer = setTimeout(driveSend, 100);
+        dirty();
+    }
+
+    window.addEventListener('keydown', (e) => {
+        if (!control.car) return;
+        if (e.code === 'Escape') { releaseControl(); return; }
+        if (e.code === 'Space') { send(control.car, 'S'); control.keys.clear(); driveUpdate(false); e.preventDefault(); return; }
+        const k = KEYS[e.code];
+        if (!k) return;
+        e.preventDefault();
+        control.keys.add(k);
+        driveUpdate(e.shiftKey);
+    });
+    window.addEventListener('keyup', (e) => {
+        const k = KEYS[e.code];
+        if (!k || !control.car) return;
+        control.keys.delete(k);
+        driveUpdate(e.shiftKey);
+    });
+    // 失去焦點時收不到 keyup: 停車
+    window.addEventListener('blur', () => { control.keys.clear(); if (control.car) driveUpdate(false); });
+
+    // --- 繪圖: 一個 canvas, 有變化才在下一個 animation frame 重畫 ---
+    let queued = false, tiles = {cols:1, w:0, h:0};
+    function dirty(){ if (queued) return; queued = true; requestAnimationFrame(draw); }
+
+    function layout(){
+        const dpr = window.devicePixelRatio || 1;
+        canvas.width = Math.round(canvas.clientWidth * dpr);
+        canvas.height = Math.round(canvas.clientHeight * dpr);
+        dirty();
+    }
+
+    const STATE_COLOR = {live:'#22c55e', stale:'#eab308', connecting:'#64748b', down:'#ef4444', full:'#f97316'};
+
+    function draw(){
+        queued = false;
+        const g = canvas.getContext('2d'), W = canvas.width, H = canvas.height, dpr = window.devicePixelRatio || 1;
+        g.fillStyle = '#0b0d11';
+        g.fillRect(0, 0, W, H);
+        const n = Math.max(1, cars.length);
+        // 格子接近 2:1, 全部放進畫面
+        const cols = Math.max(1, Math.min(n, Math.round(Math.sqrt(n * W / H / 2))));
+        const rows = Math.ceil(n / cols);
+        const w = W / cols, h = H / rows, pad = 6 * dpr;
+        tiles = {cols, w, h};
+        let live = 0;
+        cars.forEach((c, i) => {
+            if (c.state === 'live') live++;
+            const x = (i % cols) * w + pad, y = Math.floor(i / cols) * h + pad, tw = w - 2 * pad, th = h - 2 * pad;
+            g.fillStyle = '#0f1720';
+            g.fillRect(x, y, tw, th);
+            if (control.car === c) { g.strokeStyle = '#3b82f6'; g.lineWidth = 3 * dpr; g.strokeRect(x, y, tw, th); }
+            const fs = Math.max(10, Math.min(16, th / 8)) * dpr;
+            g.fillStyle = STATE_COLOR[c.state];
+            g.beginPath(); g.arc(x + fs, y + fs, fs / 3, 0, 2 * Math.PI); g.fill();
+            g.font = `600 ${fs}px system-ui`;
+            g.fillStyle = '#e6eef6';
+            g.fillText(c.name, x + fs * 1.8, y + fs * 1.35);
+            g.font = `${fs * 0.8}px system-ui`;
+            g.fillStyle = '#98a2b3';
+            g.fillText(`${c.host} · ${c.state}`, x + fs * 0.6, y + fs * 2.7);
+            const t = c.tele;
+            if (t) {
+                g.fillText(`${t.mode} · RSSI ${t.rssi} · 命令 ${t.cmd_age > 9999 ? '-' : t.cmd_age + ' ms'} · err ${t.errors}/${t.tx_fail}`, x + fs * 0.6, y + fs * 3.9);
+                // 馬達 A (油門) / B (轉向) 長條, 中心為 0
+                bar(g, x + fs * 0.6, y + fs * 4.6, tw - fs * 1.2, fs * 0.5, t.a / 255, '#22c55e', '#f97316');
+                bar(g, x + fs * 0.6, y + fs * 5.4, tw - fs * 1.2, fs * 0.5, t.b / 255, '#3b82f6', '#ef4444');
+                spark(g, c, x + fs * 0.6, y + fs * 6.3, tw - fs * 1.2, th - fs * 6.9);
+            }
+        });
+        summaryEl.textContent = `${cars.length} 台 · ${live} 連線中 · 遙測 ${SUB_HZ} Hz`;
+        controlEl.textContent = control.car
+            ? `控制: ${control.car.name} (steer ${control.steer} / throttle ${control.throttle}) · Esc 釋放`
+            : '點選一台車取得控制 (方向鍵 / WASD, Shift 全速, 空白鍵急停, Esc 釋放; 雙擊開啟遙控頁)';
+    }
+
+    function bar(g, x, y, w, h, v, pos, neg){
+        g.fillStyle = 'rgba(255,255,255,0.06)';
+        g.fillRect(x, y, w, h);
+        const mid = x + w / 2, len = Math.max(-1, Math.min(1, v)) * w / 2;
+        g.fillStyle = v >= 0 ? pos : neg;
+        g.fillRect(len >= 0 ? mid : mid + len, y, Math.abs(len), h);
+    }
+
+    function spark(g, c, x, y, w, h){
+        if (h < 8 || c.histN < 2) return;
+        g.beginPath();
+        for (let i = 0; i < c.histN; i++) {
+            const v = c.hist[(c.histHead - c.histN + i + HISTORY) % HISTORY];
+            const px = x + (HISTORY - c.histN + i) * w / (HISTORY - 1), py = y + h / 2 - v / 255 * h / 2;
+            if (i === 0) g.moveTo(px, py); else g.lineTo(px, py);
+        }
+        g.strokeStyle = '#98a2b3';
+        g.lineWidth = 1;
+        g.stroke();
+    }
+
+    function carAt(e){
+        const dpr = window.devicePixelRatio || 1, r = canvas.getBoundingClientRect();
+        const col = Math.floor((e.clientX - r.left) * dpr / tiles.w), row = Math.floor((e.clientY - r.top) * dpr / tiles.h);
+        return col < tiles.cols ? cars[row * tiles.cols + col] : undefined;
+    }
+    canvas.addEventListener('click', (e) => { const c = carAt(e); if (c) takeControl(c); });
+    canvas.addEventListener('dblclick', (e) => { const c = carAt(e); if (c) { releaseControl(); window.open(`http://${c.host}/`, 'drive'); } });
+    window.addEventListener('resize', layout);
+
+    // 遙測逾時檢查
+    setInterval(() => {
+        const now = performance.now();
+        for (const c of cars) if (c.state === 'live' && now - c.lastAt > STALE_MS) { c.state = 'stale'; dirty(); }
+    }, 500);
+
+    window.onload = () => {
+        layout();
+        // ?hosts=192.168.1.41,192.168.1.42:8080 手動加入 (不在 mDNS 上的車)
+        const extra = new URLSearchParams(window.location.search).get('hosts');
+        if (extra) extra.split(',').filter(Boolean).forEach(h => addCar(h, h.includes(':') ? h : h + ':80'));
+        discover();
+        setInterval(discover, 30000);
+    };
+  </script>
+</body>
+</html>
+)rawliteral";
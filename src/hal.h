@@ -0,0 +1,17 @@
+#pragma once
+// 硬體抽象層 (HAL)
+// 控制核心 (car_control) 只透過這些函式接觸硬體與網路:
+// 裝置上由 hal_arduino.cpp 實作 (ledcWrite / digitalWrite / millis / WebSocket),
+// 主機端 (pio test -e native、模擬器) 由 host/hal_native.cpp 實作。
+
+#include <stddef.h>
+#include <stdint.h>
+
+void halPwmWrite(uint8_t channel, uint32_t duty);  // ledcWrite
+void halPinWrite(uint8_t pin, bool high);          // digitalWrite
+uint32_t halMillis();                              // millis
+// 傳輸層: 狀態廣播給所有控制端 (回傳 false 表示至少一個客戶端未送出), 日誌同時輸出到 Serial
+bool halBroadcast(const char* data, size_t len);
+bool halSend(int client, const char* data, size_t len); // 只回覆給一個控制端 (ping/pong)
+void halLog(const char* message);
+int halRssi();                                     // WiFi.RSSI(), 未知時為 0
@@ -0,0 +1,30 @@
+#ifdef ARDUINO
+
+#include <Arduino.h>
+#include <WebSocketsServer.h>
+#include <WiFi.h>
+
+#include "hal.h"
+
+extern WebSocketsServer webSocket;          // main.cpp
+void sendLogMessage(const String& message); // main.cpp
+void publishStatusEvent(const char* json, size_t len); // main.cpp (SSE /events)
+
+void halPwmWrite(uint8_t channel, uint32_t duty) { ledcWrite(channel, duty); }
+
+void halPinWrite(uint8_t pin, bool high) { digitalWrite(pin, high ? HIGH : LOW); }
+
+uint32_t halMillis() { return millis(); }
+
+bool halBroadcast(const char* data, size_t len) {
+  publishStatusEvent(data, len);
+  return webSocket.broadcastTXT(data, len);
+}
+
+bool halSend(int client, const char* data, size_t len) { return webSocket.sendTXT((uint8_t)client, data, len); }
+
+void halLog(const char* message) { sendLogMessage(String(message)); }
+
+int halRssi() { return WiFi.RSSI(); }
+
+#endif
@@ -0,0 +1,231 @@
+#include "json_scan.h"
+
+#include <string.h>
+
+static const int MAX_DEPTH = 8;
+
+static const char* const ERR_INVALID = "InvalidInput";
+static const char* const ERR_INCOMPLETE = "IncompleteInput";
+
+bool JsonField::is(const char* name) const {
+  return strlen(name) == keyLen && memcmp(name, key, keyLen) == 0;
+}
+
+namespace {
+
+struct Cursor {
+  const char* p;
+  const char* end;
+
+  bool atEnd() const { return p >= end; }
+  void skipWs() {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) p++;
+  }
+};
+
+// p 指向開頭的引號; 成功後 p 指向結尾引號之後
+const char* scanString(Cursor& c, const char** start, size_t* len) {
+  c.p++;
+  *start = c.p;
+  while (c.p < c.end) {
+    char ch = *c.p;
+    if (ch == '"') {
+      *len = (size_t)(c.p - *start);
+      c.p++;
+      return nullptr;
+    }
+    if (ch == '\\') c.p++;
+    else if ((unsigned char)ch < 0x20) return ERR_INVALID;
+    c.p++;
+  }
+  return ERR_INCOMPLETE;
+}
+
+const char* scanNumber(Cursor& c, JsonField& f) {
+  const char* start = c.p;
+  bool neg = false;
+  if (*c.p == '-') { neg = true; c.p++; }
+  if (c.atEnd()) return ERR_INCOMPLETE;
+  if (*c.p < '0' || *c.p > '9') return ERR_INVALID;
+
+  uint64_t mag = 0;
+  bool overflow = false;
+  double num = 0;
+  while (c.p < c.end && *c.p >= '0' && *c.p <= '9') {
+    int d = *c.p++ - '0';
+    if (mag > (UINT64_MAX - d) / 10) overflow = true;
+    else mag = mag * 10 + d;
+    num = num * 10 + d;
+  }
+  bool integer = true;
+  if (c.p < c.end && *c.p == '.') {
+    integer = false;
+    c.p++;
+    double scale = 0.1;
+    if (c.atEnd() || *c.p < '0' || *c.p > '9') return c.atEnd() ? ERR_INCOMPLETE : ERR_INVALID;
+    while (c.p < c.end && *c.p >= '0' && *c.p <= '9') {
+      num += (*c.p++ - '0') * scale;
+      scale *= 0.1;
+    }
+  }
+  if (c.p < c.end && (*c.p == 'e' || *c.p == 'E')) {
+    integer = false;
+    c.p++;
+    bool expNeg = false;
+    if (c.p < c.end && (*c.p == '+' || *c.p == '-')) expNeg = *c.p++ == '-';
+    if (c.atEnd() || *c.p < '0' || *c.p > '9') return c.atEnd() ? ERR_INCOMPLETE : ERR_INVALID;
+    int exp = 0;
+    while (c.p < c.end && *c.p >= '0' && *c.p <= '9') {
+      if (exp < 400) exp = exp * 10 + (*c.p - '0');
+      c.p++;
+    }
+    for (int i = 0; i < exp; i++) num = expNeg ? num / 10 : num * 10;
+  }
+  f.type = JsonType::NUMBER;
+  f.numValue = neg ? -num : num;
+  f.isInteger = integer && !overflow && mag <= (uint64_t)INT64_MAX;
+  f.intValue = f.isInteger ? (neg ? -(int64_t)mag : (int64_t)mag) : 0;
+  f.raw = start;
+  f.rawLen = (size_t)(c.p - start);
+  return nullptr;
+}
+
+const char* scanLiteral(Cursor& c, const char* word) {
+  size_t n = strlen(word);
+  if ((size_t)(c.end - c.p) < n) {
+    return memcmp(c.p, word, (size_t)(c.end - c.p)) == 0 ? ERR_INCOMPLETE : ERR_INVALID;
+  }
+  if (memcmp(c.p, word, n) != 0) return ERR_INVALID;
+  c.p += n;
+  return nullptr;
+}
+
+// 略過巢狀物件/陣列 (p 指向 '{' 或 '[')
+const char* skipNested(Cursor& c) {
+  char stack[MAX_DEPTH];
+  int depth = 0;
+  while (c.p < c.end) {
+    char ch = *c.p;
+    if (ch == '"') {
+      const char* s;
+      size_t n;
+      const char* err = scanString(c, &s, &n);
+      if (err) return err;
+      continue;
+    }
+    if (ch == '{' || ch == '[') {
+      if (depth == MAX_DEPTH) return "TooDeep";
+      stack[depth++] = ch == '{' ? '}' : ']';
+    } else if (ch == '}' || ch == ']') {
+      if (depth == 0 || stack[depth - 1] != ch) return ERR_INVALID;
+      if (--depth == 0) {
+        c.p++;
+        return nullptr;
+      }
+    }
+    c.p++;
+  }
+  return ERR_INCOMPLETE;
+}
+
+const char* scanValue(Cursor& c, JsonField& f) {
+  if (c.atEnd()) return ERR_INCOMPLETE;
+  f.isInteger = false;
+  f.intValue = 0;
+  f.numValue = 0;
+  const char* start = c.p;
+  const char* err = nullptr;
+  switch (*c.p) {
+    case '"':
+      f.type = JsonType::STRING;
+      return scanString(c, &f.raw, &f.rawLen);
+    case '{':
+    case '[':
+      f.type = *c.p == '{' ? JsonType::OBJECT : JsonType::ARRAY;
+      err = skipNested(c);
+      break;
+    case 't':
+      f.type = JsonType::BOOL;
+      err = scanLiteral(c, "true");
+      f.intValue = 1;
+      break;
+    case 'f':
+      f.type = JsonType::BOOL;
+      err = scanLiteral(c, "false");
+      break;
+    case 'n':
+      f.type = JsonType::NUL;
+      err = scanLiteral(c, "null");
+      break;
+    default:
+      return scanNumber(c, f);
+  }
+  f.raw = start;
+  f.rawLen = (size_t)(c.p - start);
+  return err;
+}
+
+}  // namespace
+
+const char* jsonScanObject(const char* json, size_t len, JsonFieldCallback cb, void* ctx) {
+  Cursor c = { json, json + len };
+  // 容許結尾的 '\0' (WebSocket 緩衝區)
+  while (c.end > c.p && c.end[-1] == '\0') c.end--;
+  c.skipWs();
+  if (c.atEnd()) return "EmptyInput";
+  if (*c.p != '{') return ERR_INVALID;
+  c.p++;
+  c.skipWs();
+  if (c.atEnd()) return ERR_INCOMPLETE;
+  if (*c.p == '}') return nullptr;
+
+  bool keepGoing = true;
+  for (;;) {
+    c.skipWs();
+    if (c.atEnd()) return ERR_INCOMPLETE;
+    if (*c.p != '"') return ERR_INVALID;
+    JsonField f;
+    const char* err = scanString(c, &f.key, &f.keyLen);
+    if (err) return err;
+    c.skipWs();
+    if (c.atEnd()) return ERR_INCOMPLETE;
+    if (*c.p++ != ':') return ERR_INVALID;
+    c.skipWs();
+    err = scanValue(c, f);
+    if (err) return err;
+    if (keepGoing) keepGoing = cb(ctx, f);
+    c.skipWs();
+    if (c.atEnd()) return ERR_INCOMPLETE;
+    char ch = *c.p++;
+    if (ch == '}') return nullptr;
+    if (ch != ',') return ERR_INVALID;
+  }
+}
+
+const char* jsonScanArray(const char* json, size_t len, JsonFieldCallback cb, void* ctx) {
+  Cursor c = { json, json + len };
+  while (c.end > c.p && c.end[-1] == '\0') c.end--;
+  c.skipWs();
+  if (c.atEnd()) return "EmptyInput";
+  if (*c.p != '[') return ERR_INVALID;
+  c.p++;
+  c.skipWs();
+  if (c.atEnd()) return ERR_INCOMPLETE;
+  if (*c.p == ']') return nullptr;
+
+  bool keepGoing = true;
+  for (;;) {
+    c.skipWs();
+    JsonField f;
+    f.key = nullptr;
+    f.keyLen = 0;
+    const char* err = scanValue(c, f);
+    if (err) return err;
+    if (keepGoing) keepGoing = cb(ctx, f);
+    c.skipWs();
+    if (c.atEnd()) return ERR_INCOMPLETE;
+    char ch = *c.p++;
+    if (ch == ']') return nullptr;
+    if (ch != ',') return ERR_INVALID;
+  }
+}
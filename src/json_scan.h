@@ -0,0 +1,36 @@
+#pragma once
+// 輕量 JSON 物件掃描器 (控制命令熱路徑使用)
+// 只掃描最外層物件的 key/value, 不配置記憶體、不複製字串; 巢狀物件/陣列以原始片段交給呼叫者,
+// 需要時可再對該片段呼叫 jsonScanObject()。輸入長度有上限, 不依賴結尾 '\0'。
+
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+
+enum class JsonType : uint8_t { NUMBER, STRING, BOOL, NUL, OBJECT, ARRAY };
+
+struct JsonField {
+  const char* key;     // 不含引號, 未處理跳脫字元
+  size_t keyLen;
+  JsonType type;
+  const char* raw;     // 值的原始片段 (字串不含引號)
+  size_t rawLen;
+  bool isInteger;      // NUMBER 且沒有小數/指數部分
+  int64_t intValue;    // isInteger 時有效; BOOL 為 0/1
+  double numValue;     // NUMBER 時有效
+
+  bool is(const char* name) const;
+  // 與 ArduinoJson 的 `doc[key] | fallback` 相同: 不是整數或超出 int 範圍時回傳 fallback
+  int asInt(int fallback) const {
+    return isInteger && intValue >= INT_MIN && intValue <= INT_MAX ? (int)intValue : fallback;
+  }
+};
+
+// 回傳 false 結束掃描 (視為成功)
+typedef bool (*JsonFieldCallback)(void* ctx, const JsonField& field);
+
+// 成功回傳 nullptr, 否則回傳錯誤名稱 ("InvalidInput", "IncompleteInput", "TooDeep", "EmptyInput")
+const char* jsonScanObject(const char* json, size_t len, JsonFieldCallback cb, void* ctx);
+
+// 陣列的每個元素 (JsonField 的 key 為 nullptr); 錯誤名稱同上
+const char* jsonScanArray(const char* json, size_t len, JsonFieldCallback cb, void* ctx);
@@ -0,0 +1,115 @@
+#include "lzss_decoder.h"
+
+bool LzssDecoder::begin(uint8_t windowBits, uint8_t lookaheadBits, uint32_t outputLimit, Sink sink, void* ctx) {
+  if (windowBits < MIN_WINDOW_BITS || windowBits > MAX_WINDOW_BITS) return false;
+  if (lookaheadBits < 3 || lookaheadBits >= windowBits) return false;
+  _windowBits = windowBits;
+  _lookaheadBits = lookaheadBits;
+  _mask = (uint16_t)((1u << windowBits) - 1);
+  _flushAt = (uint16_t)(1u << (windowBits - 1)); // 交出前最多累積半個視窗
+  _head = 0;
+  _pending = 0;
+  _phase = TAG;
+  _bitsLeft = 0;
+  _accum = 0;
+  _accumBits = 0;
+  _produced = 0;
+  _limit = outputLimit;
+  _sink = sink;
+  _ctx = ctx;
+  _failed = false;
+  return true;
+}
+
+bool LzssDecoder::readBits(uint8_t count, uint16_t* out) {
+  while (_accumBits < count) {
+    if (_bitsLeft == 0) {
+      if (_inLen == 0) return false;
+      _bitBuf = *_in++;
+      _inLen--;
+      _bitsLeft = 8;
+    }
+    uint8_t take = count - _accumBits;
+    if (take > _bitsLeft) take = _bitsLeft;
+    uint8_t bits = (uint8_t)(_bitBuf >> (_bitsLeft - take)) & (uint8_t)((1u << take) - 1);
+    _accum = (uint16_t)(_accum << take) | bits;
+    _accumBits += take;
+    _bitsLeft -= take;
+  }
+  *out = _accum;
+  _accum = 0;
+  _accumBits = 0;
+  return true;
+}
+
+bool LzssDecoder::emit(uint8_t b) {
+  if (_produced >= _limit) {
+    _failed = true;
+    return false;
+  }
+  _window[_head] = b;
+  _head = (_head + 1) & _mask;
+  _produced++;
+  if (++_pending >= _flushAt) return flush();
+  return true;
+}
+
+bool LzssDecoder::flush() {
+  if (_failed) return false;
+  if (_pending == 0) return true;
+  uint16_t size = (uint16_t)(_mask + 1);
+  uint16_t start = (uint16_t)(_head - _pending) & _mask;
+  uint16_t first = size - start;
+  if (first > _pending) first = _pending;
+  bool ok = _sink(_ctx, _window + start, first);
+  if (ok && first < _pending) ok = _sink(_ctx, _window, _pending - first);
+  _pending = 0;
+  if (!ok) _failed = true;
+  return ok;
+}
+
+bool LzssDecoder::feed(const uint8_t* data, size_t len) {
+  if (_failed) return false;
+  _in = data;
+  _inLen = len;
+  uint16_t v;
+  for (;;) {
+    switch (_phase) {
+      case TAG:
+        if (_produced == _limit) {
+          // 已解出全部資料: 只允許最後一個 byte 的填充位元
+          if (_inLen > 0) _failed = true;
+          return !_failed;
+        }
+        if (!readBits(1, &v)) return true;
+        _phase = v ? LITERAL : INDEX;
+        break;
+      case LITERAL:
+        if (!readBits(8, &v)) return true;
+        if (!emit((uint8_t)v)) return false;
+        _phase = TAG;
+        break;
+      case INDEX:
+        if (!readBits(_windowBits, &v)) return true;
+        _distance = v + 1;
+        if (_distance > _produced) {
+          _failed = true; // 參照到串流開始之前
+          return false;
+        }
+        _phase = COUNT;
+        break;
+      case COUNT:
+        if (!readBits(_lookaheadBits, &v)) return true;
+        _copyLeft = v + 1;
+        _phase = COPYING;
+        break;
+      case COPYING:
+        while (_copyLeft > 0) {
+          if (!emit(_window[(uint16_t)(_head - _distance) & _mask])) return false;
+          _copyLeft--;
+        }
+        _phase = TAG;
+        break;
+    }
+  }
+}
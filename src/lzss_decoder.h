@@ -0,0 +1,59 @@
+#pragma once
+// 串流式 LZSS 解壓 (heatshrink 位元格式), 用於壓縮的 OTA 上傳 (tools/ota_pack.py)
+// 只使用固定大小的視窗緩衝區, 解出的資料直接從視窗分段交給 sink, 不另外配置記憶體。
+//
+// 位元流 (MSB first):
+//   1 + 8 bits              -> literal byte
+//   0 + W bits + L bits     -> back-reference: 距離 = index + 1, 長度 = count + 1
+// W = window bits, L = lookahead bits (由容器標頭提供)
+
+#include <stddef.h>
+#include <stdint.h>
+
+class LzssDecoder {
+public:
+  static const uint8_t MAX_WINDOW_BITS = 11; // 2 KiB 視窗
+  static const uint8_t MIN_WINDOW_BITS = 4;
+
+  // 回傳 false 時解壓中止
+  typedef bool (*Sink)(void* ctx, const uint8_t* data, size_t len);
+
+  // outputLimit: 預期的解壓後長度, 超過即視為錯誤
+  bool begin(uint8_t windowBits, uint8_t lookaheadBits, uint32_t outputLimit, Sink sink, void* ctx);
+  bool feed(const uint8_t* data, size_t len);
+  // 把視窗中尚未交出的資料送給 sink; 之後 produced() == outputLimit 才算完整
+  bool flush();
+
+  uint32_t produced() const { return _produced; }
+  bool complete() const { return _produced == _limit && _pending == 0; }
+
+private:
+  enum Phase : uint8_t { TAG, LITERAL, INDEX, COUNT, COPYING };
+
+  bool readBits(uint8_t count, uint16_t* out);
+  bool emit(uint8_t b);
+
+  uint8_t _window[1 << MAX_WINDOW_BITS];
+  uint16_t _mask = 0;
+  uint16_t _head = 0;       // 下一個寫入位置
+  uint16_t _pending = 0;    // 尚未交給 sink 的位元組數
+  uint16_t _flushAt = 0;
+  uint8_t _windowBits = 0;
+  uint8_t _lookaheadBits = 0;
+
+  Phase _phase = TAG;
+  const uint8_t* _in = nullptr;
+  size_t _inLen = 0;
+  uint8_t _bitBuf = 0;
+  uint8_t _bitsLeft = 0;    // _bitBuf 中尚未讀取的位元數
+  uint16_t _accum = 0;      // 跨 feed() 的部分欄位
+  uint8_t _accumBits = 0;
+  uint16_t _distance = 0;
+  uint16_t _copyLeft = 0;
+
+  uint32_t _produced = 0;
+  uint32_t _limit = 0;
+  Sink _sink = nullptr;
+  void* _ctx = nullptr;
+  bool _failed = false;
+};
@@ -1,39 +1,104 @@
 #include <WiFi.h>
 #include <ArduinoOTA.h>
 #include <WebSocketsServer.h>
-#include <ArduinoJson.h>
 #include <ESPmDNS.h>
 #include <ESPAsyncWebServer.h>
+#include <esp_mac.h>          // eFuse MAC (選擇車的 profile)
 #include <esp_ota_ops.h>      // For OTA partition functions
 #include <esp_partition.h>    // For finding partitions
+#include "car_variant.h"      // 建置變體: 功能開關與固定的混控方式 (platformio.ini 的 [env:car-*])
+#if CAR_FEATURE_FLEET
+#include <mdns.h>             // 非阻塞的 mDNS 查詢 (車隊探索)
+#endif
+#include "boot_selftest.h"
+#include "capture.h"
+#include "car_control.h"
+#include "car_profiles.h"
+#include "config_store.h"
+#include "control_api.h"
+#include "event_stream.h"
+#if CAR_FEATURE_FLEET
+#include "fleet_ui.h"
+#endif
 #include "gpio_pins.h"
+#if CAR_FEATURE_VIDEO
+#include "mjpeg_relay.h"
+#endif
+#include "ota_backend.h"
+#include "ota_stream.h"
+#include "ota_update.h"
+#include "web_api.h"
+#include "web_ui.h"
 
 // === 全域設定與連線狀態 ===
 // OTA & Web Services
 WebSocketsServer webSocket(81);
 AsyncWebServer server(80);
 
-// LEDC Channel for PWM
-const int CH_A_FWD = 0;
-const int CH_A_REV = 1;
-const int CH_B_LEFT = 2;
-const int CH_B_RIGHT = 3;
-const int PWM_FREQ = 20000; // 20 kHz
-const int PWM_RES = 8;      // 8-bit, 0-255 duty cycle
-
-// 馬達控制變數
-const int MAX_DUTY = 255; // 最大 PWM Duty Cycle (0~255)
-// >>> 修正: 新增最小啟動佔空比以克服靜摩擦 <<<
-const int MIN_DUTY = 0;  // 最小啟動佔空比 (建議從 30~50 之間測試)
-// targetA/B 現在將儲存縮放後的 Duty Cycle 值 (0~MAX_DUTY)
-volatile int targetA = 0; 
-volatile int targetB = 0;
-unsigned long lastCommandTime = 0;
-const unsigned long COMMAND_TIMEOUT = 300; // 300ms 沒收到命令則停止
-
-// === 應用程式模式 ===
-enum DriveMode { AUTO, MANUAL };
-DriveMode currentMode = MANUAL;
+// 控制核心: 命令解析、混控、失效保護與 PWM 決策 (car_control.cpp)
+CarControl car;
+
+// STBY 腳位 (開機時的設定, 重新開機才改變): async_tcp 任務中需要立即停車時只寫這個腳位,
+// car 只在 loop 任務中使用, 由 loop() 接著 holdSafe() 讓控制核心的狀態一致
+uint8_t stbyPin = motor_stby;
+
+void motorsOff() { digitalWrite(stbyPin, LOW); }
+
+// web_api.h 的處理器在 async_tcp 任務中執行, 與 loop() 共用的狀態以 portMUX 保護
+void muxEnter(void* mux) { portENTER_CRITICAL((portMUX_TYPE*)mux); }
+void muxExit(void* mux) { portEXIT_CRITICAL((portMUX_TYPE*)mux); }
+
+// 執行期設定 (NVS, config_store.h): WebSocket 在 loop() 中、REST 在 async_tcp 任務中暫存,
+// loop() 在 car.tick() 之前套用並合併寫入 NVS (handleConfig)。暫存與讀取都在 configMux 內
+ConfigStore config;
+portMUX_TYPE configMux = portMUX_INITIALIZER_UNLOCKED;
+const WebLock configLock = {muxEnter, muxExit, &configMux};
+
+// 控制流量擷取 (/capture), 記錄於 webSocketEvent (loop 任務);
+// HTTP 處理器在 async_tcp 任務中執行, 只留下請求由 loop() 開始/停止
+#if CAR_FEATURE_CAPTURE
+CaptureLog capture;
+volatile uint8_t captureRequest = CAPTURE_REQ_NONE;
+#endif
+
+// 影像轉送 (/stream): 從相機節點讀取 MJPEG 轉給瀏覽器, 見 setupVideo()
+// 上游預設可用 -DVIDEO_UPSTREAM=\"http://192.168.1.50:81/stream\" 設定
+#if CAR_FEATURE_VIDEO
+#ifndef VIDEO_UPSTREAM
+#define VIDEO_UPSTREAM ""
+#endif
+MjpegRelay video;
+#endif
+
+// SSE 事件 (/events): 遙測、狀態廣播與日誌, 見 setupEvents()
+// 日誌可能來自 async_tcp 任務 (HTTP 處理器), 發佈與取出都在 eventsMux 內
+EventStream events;
+portMUX_TYPE eventsMux = portMUX_INITIALIZER_UNLOCKED;
+
+// 車隊探索 (/peers): 在 loop() 中以非阻塞 mDNS 查詢 _esp32car._tcp, 結果供 /fleet 儀表板使用
+#if CAR_FEATURE_FLEET
+const int MAX_PEERS = 16;
+const unsigned long PEER_QUERY_INTERVAL = 30000;
+Peer peers[MAX_PEERS];
+int peerCount = 0;
+portMUX_TYPE peerMux = portMUX_INITIALIZER_UNLOCKED; // loop() 寫入, async_tcp 讀取
+#endif
+
+// === OTA 設定 ===
+// ArduinoOTA 與 HTTP /update 共用同一組密碼, 可用 -DOTA_PASSWORD=\"...\" 覆寫
+#ifndef OTA_PASSWORD
+#define OTA_PASSWORD "mysecurepassword"
+#endif
+const char* OTA_HTTP_USER = "ota";
+const unsigned long OTA_STALL_TIMEOUT = 10000; // 10 秒沒收到資料則放棄本次更新
+OtaUpdater httpOta;
+OtaStream otaStream(httpOta);              // 完整影像或 delta 修補檔
+AsyncWebServerRequest* otaOwner = nullptr; // 目前持有更新工作階段的 HTTP 請求
+// otaStream 的開始/寫入/放棄與 otaOwner 在 otaMutex 內: 上傳與斷線在 async_tcp 任務, 停滯逾時在 loop()。
+// 寫入會抹除與寫入快閃, 不能放在 portMUX 臨界區內, 所以用 mutex
+SemaphoreHandle_t otaMutex = nullptr;
+volatile unsigned long otaLastChunkAt = 0;
+unsigned long otaRebootAt = 0;
 
 // ----------------------------------------------------------------------
 // I. 遠端日誌 (Remote Logging)
@@ -45,6 +110,16 @@ void sendLogMessage(const String& message) {
   // 將日誌訊息廣播給所有已連線的瀏覽器客戶端
   // 瀏覽器端的 JavaScript 會將此訊息輸出到 Console
   webSocket.broadcastTXT(message.c_str(), message.length());
+  portENTER_CRITICAL(&eventsMux);
+  events.publishLog(message.c_str());
+  portEXIT_CRITICAL(&eventsMux);
+}
+
+// halBroadcast() 的狀態廣播同時發佈為 SSE status 事件 (hal_arduino.cpp)
+void publishStatusEvent(const char* json, size_t len) {
+  portENTER_CRITICAL(&eventsMux);
+  events.publish(SSE_STATUS, json, len, millis());
+  portEXIT_CRITICAL(&eventsMux);
 }
 
 // ----------------------------------------------------------------------
@@ -120,129 +195,32 @@ void connectToWiFi() {
 // IV. 網路事件處理 (Network Event Handling)
 // ----------------------------------------------------------------------
 
-void emergencyStopNow() {
-  targetA = targetB = 0;
-  // immediately stop PWM and disable STBY pin
-  digitalWrite(motor_stby, LOW);
-  ledcWrite(CH_A_FWD, 0); ledcWrite(CH_A_REV, 0);
-  ledcWrite(CH_B_LEFT, 0); ledcWrite(CH_B_RIGHT, 0);
-  sendLogMessage("!!! EMERGENCY STOP Triggered !!!");
+// 擷取關閉 (CAR_FEATURE_CAPTURE=0) 時為空函式
+void recordCapture(CaptureKind type, uint8_t num, const uint8_t* payload, size_t length) {
+#if CAR_FEATURE_CAPTURE
+  capture.record(type, num, payload, length, millis());
+#endif
 }
 
 // 處理來自 WebSocket 客戶端的命令 (單字元或 JSON)
 void webSocketEvent(uint8_t num, WStype_t type, uint8_t * payload, size_t length) {
   switch (type) {
     case WStype_CONNECTED: { 
+        recordCapture(CAPTURE_CONNECT, num, nullptr, 0);
         IPAddress ip = webSocket.remoteIP(num);
         sendLogMessage("--- WS Client Connected from " + ip.toString() + " ---");
       }
       break;
     case WStype_DISCONNECTED:
+      recordCapture(CAPTURE_DISCONNECT, num, nullptr, 0);
       sendLogMessage("--- WS Client Disconnected ---");
       // 斷線時立即停止馬達
-      emergencyStopNow();
+      car.onClientDisconnected(num);
       break;
     case WStype_TEXT:
-      {
-        String msg = String((char*)payload);
-        // V. 命令解析 (Command Parsing) - 單字元命令
-        if (msg.length() == 1) {
-          char cmd = msg.charAt(0);
-          switch (cmd) {
-            case 'A': 
-              currentMode = AUTO; 
-              sendLogMessage("Mode Switched: AUTO"); 
-              break;
-            case 'M': 
-              currentMode = MANUAL; 
-              sendLogMessage("Mode Switched: MANUAL"); 
-              break;
-            case 'S':
-              emergencyStopNow();
-              break;
-          }
-          lastCommandTime = millis(); 
-        } else {
-          // V. 命令解析 (Command Parsing) - JSON 遙控命令
-          JsonDocument doc;
-          DeserializationError err = deserializeJson(doc, (const char*)payload); 
-          if (!err) {
-            int steer = doc["steer"] | 0;    // 搖桿輸入 (-100 ~ 100)
-            int throttle = doc["throttle"] | 0; // 搖桿輸入 (-100 ~ 100)
-            
-            // VI. 馬達控制 (Motor Control)
-            if (currentMode == MANUAL) {
-                
-                // --- [修復 MAX_DUTY 問題] ---
-                // 將搖桿輸入 (-100~100) 縮放至 Duty Cycle 範圍 (-MAX_DUTY~MAX_DUTY)
-                int scaledThrottle = (throttle * MAX_DUTY) / 100;
-                int scaledSteer = (steer * MAX_DUTY) / 100;
-
-                // 更新目標速度 (targetA/B 現在儲存的是實際的 duty cycle)
-                targetA = constrain(scaledThrottle, -MAX_DUTY, MAX_DUTY); // 前後
-                targetB = constrain(scaledSteer, -MAX_DUTY, MAX_DUTY);    // 左右
-                
-                // 立即應用速度
-                digitalWrite(motor_stby, HIGH);
-                
-                int speedA = targetA;
-                int speedB = targetB;
-                
-                // --- Motor A (Throttle) 控制 ---
-                if (speedA > 0) { 
-                    ledcWrite(CH_A_FWD, speedA); ledcWrite(CH_A_REV, 0); 
-                } 
-                else if (speedA < 0) { 
-                    ledcWrite(CH_A_FWD, 0); ledcWrite(CH_A_REV, abs(speedA)); 
-                } 
-                else { 
-                    ledcWrite(CH_A_FWD, 0); ledcWrite(CH_A_REV, 0); 
-                }
-
-                // --- Motor B (Steer) 控制 (已修正：加入最小啟動佔空比) ---
-                if (speedB > 0) { // 右轉
-                    int duty = speedB;
-                    // 如果速度大於 0 且小於 MIN_DUTY，則強制設定為 MIN_DUTY
-                    if (duty > 0 && duty < MIN_DUTY) duty = MIN_DUTY; 
-                    
-                    ledcWrite(CH_B_RIGHT, duty); 
-                    ledcWrite(CH_B_LEFT, 0); 
-                } 
-                else if (speedB < 0) { // 左轉
-                    int duty = abs(speedB);
-                    // 如果速度小於 0 且絕對值小於 MIN_DUTY，則強制設定為 MIN_DUTY
-                    if (duty > 0 && duty < MIN_DUTY) duty = MIN_DUTY; 
-                    
-                    ledcWrite(CH_B_RIGHT, 0); 
-                    ledcWrite(CH_B_LEFT, duty); 
-                } 
-                else { 
-                    ledcWrite(CH_B_RIGHT, 0); 
-                    ledcWrite(CH_B_LEFT, 0); 
-                }
-                // -----------------------------
-
-                // Reset timeout on every joystick command
-                lastCommandTime = millis(); 
-            }
-
-            // 發送實時狀態回瀏覽器 (Console log)
-            JsonDocument status;
-            status["motorA"] = targetA;
-            status["motorB"] = targetB;
-            // 優化 debug 訊息，顯示原始輸入與實際 Duty Cycle
-            status["debug"] = String("JSTK_Raw:") + throttle + "/" + steer + " | DutyA:" + targetA + "/DutyB:" + targetB + " | Mode:" + String(currentMode == AUTO ? "AUTO" : "MANUAL");
-            
-            size_t json_len = measureJson(status);
-            char buffer[json_len + 1];
-            size_t len = serializeJson(status, buffer, json_len + 1);
-            webSocket.broadcastTXT(buffer, len);
-            
-          } else {
-            sendLogMessage("WS Error: JSON parse failed: " + String(err.c_str()));
-          }
-        }
-      }
+      recordCapture(CAPTURE_TEXT, num, payload, length);
+      // V./VI. 命令解析與馬達控制 (car_control.cpp)
+      car.handleText((const char*)payload, length, num);
       break;
     default:
       break;
@@ -253,309 +231,531 @@ void webSocketEvent(uint8_t num, WStype_t type, uint8_t * payload, size_t length
 // VII. 網頁服務 (Web Services)
 // ----------------------------------------------------------------------
 
-// 網頁前端 HTML 內容 (日誌已移至 Console)
-const char index_html[] = R"rawliteral(
-<!doctype html>
-<html lang="zh-TW">
-<head>
-  <meta charset="utf-8" />
-  <meta name="viewport" content="width=device-width,initial-scale=1" />
-  <title>ESP32 Car Remote Control (User App)</title>
-  <style>
-    :root{--bg:#0b0d11;--card:#0f1720;--accent:#3b82f6;--muted:#98a2b3}
-    html,body{height:100%;margin:0;background:linear-gradient(180deg,var(--bg),#071022);color:#e6eef6;font-family:Inter,system-ui,Segoe UI,Roboto,"Noto Sans TC",sans-serif}
-    .app{display:grid;grid-template-columns:1fr;grid-template-rows:1fr;height:100vh;padding:12px;box-sizing:border-box;position:relative}
-    .viewer{background:rgba(255,255,255,0.02);border-radius:12px;padding:0;position:relative;overflow:hidden;}
-    .videoFrame{width:100%;height:100%;object-fit:cover;background:#000}
-    .overlay{position:absolute;left:12px;top:12px;background:rgba(0,0,0,0.45);padding:6px 8px;border-radius:8px;font-size:13px;color:var(--muted);z-index:5}
-    .controls{position:absolute;top:0;left:0;width:100%;height:100%;display:flex;justify-content:space-between;align-items:flex-end;pointer-events:none}
-    .stick{width:120px;height:120px;border-radius:50%;background:rgba(255,255,255,0.15);display:grid;place-items:center;position:relative;pointer-events:auto; touch-action: none;}
-    .base{width:70px;height:70px;border-radius:50%;background:rgba(255,255,255,0.05);border:2px dashed rgba(255,255,255,0.03);display:grid;place-items:center}
-    .knob{width:40px;height:40px;border-radius:50%;background:linear-gradient(180deg,#fff,#cbd5e1);transform:translate(-50%,-50%);position:absolute;left:50%;top:50%;box-shadow:0 6px 18px rgba(2,6,23,0.6)}
-    .value{font-size:12px;color:var(--muted);text-align:center;margin-top:4px}
-    
-    /* 新增: 主導控制輸入顯示樣式 */
-    .dominant-display {
-        position: absolute;
-        top: 50%;
-        left: 50%;
-        transform: translate(-50%, -50%);
-        background: rgba(15, 23, 32, 0.95); /* Semi-transparent card background */
-        padding: 20px 30px;
-        border-radius: 12px;
-        box-shadow: 0 4px 15px rgba(0, 0, 0, 0.5);
-        z-index: 10;
-        transition: opacity 0.3s ease-in-out, visibility 0.3s;
-        opacity: 0; /* 預設隱藏 */
-        pointer-events: none; /* 讓搖桿可以點擊穿透 */
-        display: flex;
-        align-items: center;
-        gap: 20px;
-    }
-    .dominant-name { 
-        font-size: 1.2rem; 
-        color: #cbd5e1;
-        font-weight: 500;
-        min-width: 80px; /* 確保名稱區域穩定 */
-        text-align: left;
+// async_tcp 任務中的處理器 (/health, /latency, /api/*) 讀取的 car 狀態 (car 只在 loop 任務中使用):
+// loop() 在 car.tick() 之後與套用 REST 命令後發佈
+portMUX_TYPE statusMux = portMUX_INITIALIZER_UNLOCKED;
+StatusBoard carStatus({muxEnter, muxExit, &statusMux});
+
+// 健康檢查: 車隊更新工具 (tools/fleet_ota.py) 以 build_sha256 與 uptime 確認新版本已開機
+void handleHealth(AsyncWebServerRequest *request) {
+  esp_app_desc_t desc;
+  esp_ota_get_partition_description(esp_ota_get_running_partition(), &desc);
+  HealthInfo info = {};
+  info.uptimeMs = millis();
+  info.version = desc.version;
+  info.otaState = OtaUpdater::stateName(httpOta.state());
+  info.selftest = bootSelfTestStateName();
+  info.rssi = WiFi.RSSI();
+  info.resetReason = (int)esp_reset_reason();
+  info.heap = ESP.getFreeHeap();
+  info.wsClients = webSocket.connectedClients();
+  info.wsDropped = -1;
+  portENTER_CRITICAL(&eventsMux);
+  info.sse = events.stats();
+  portEXIT_CRITICAL(&eventsMux);
+  char body[600];
+  healthJson(info, carStatus, body, sizeof(body));
+  request->send(200, "application/json", body);
+}
+
+// 單向延遲: 已同步時鐘的控制端 (見 clock_sync.h) 的 offset/漂移與上行延遲分布
+void handleLatency(AsyncWebServerRequest *request) {
+  char body[1024];
+  int code = carStatus.latencyReply(body, sizeof(body));
+  request->send(code, "application/json", body);
+}
+
+// SSE 事件: curl -N http://<car>/events?rate=5 (rate 為遙測 Hz, 0 = 只收狀態與日誌)
+// AsyncEventSource 拿不到請求參數 (每個連線的 rate), 佇列固定 32 則且滿了丟棄最新的; 這裡沿用它的做法:
+// 標頭送出後接手底層的 AsyncClient, 之後由 loop() 依 TCP 送出緩衝的空間寫入。
+// 送不下的事件留在 EventStream, 被下一份取代 (drop-oldest), 慢的連線不會累積舊資料。
+struct EventConn {
+  AsyncClient* client;   // 接手後才設定, 在 loop() 中刪除
+  volatile bool closed;
+};
+EventConn eventConns[EventStream::MAX_SUBS];
+
+class EventStreamResponse : public AsyncWebServerResponse {
+public:
+  explicit EventStreamResponse(int sub) : _sub(sub) {
+    _code = 200;
+    _contentType = EventStream::CONTENT_TYPE;
+    _sendContentLength = false;
+    addHeader("Cache-Control", "no-store");
+    addHeader("Connection", "keep-alive");
+  }
+  // 標頭還沒送達就斷線: 請求連同回應被刪除, 釋放訂閱
+  ~EventStreamResponse() {
+    if (_sub < 0) return;
+    portENTER_CRITICAL(&eventsMux);
+    events.removeSubscriber(_sub);
+    portEXIT_CRITICAL(&eventsMux);
+  }
+  void _respond(AsyncWebServerRequest *request) override {
+    String head = _assembleHead(request->version());
+    request->client()->write(head.c_str(), _headLength);
+    _state = RESPONSE_WAIT_ACK;
+  }
+  size_t _ack(AsyncWebServerRequest *request, size_t len, uint32_t) override {
+    if (len == 0 || _sub < 0) return 0;
+    int sub = _sub;
+    _sub = -1;
+    AsyncClient* client = request->client();
+    client->setRxTimeout(0);
+    client->onError(nullptr, nullptr);
+    client->onAck(nullptr, nullptr);
+    client->onPoll(nullptr, nullptr);
+    client->onData(nullptr, nullptr);
+    client->onTimeout([](void*, AsyncClient* c, uint32_t) { c->close(true); }, nullptr);
+    client->onDisconnect([](void* arg, AsyncClient*) { eventConns[(intptr_t)arg].closed = true; }, (void*)(intptr_t)sub);
+    eventConns[sub].closed = false;
+    eventConns[sub].client = client;
+    delete request; // 連同本回應; 連線保留
+    return 0;
+  }
+  bool _sourceValid() const override { return true; }
+
+private:
+  int _sub;
+};
+
+void setupEvents() {
+  server.on("/events", HTTP_GET, [](AsyncWebServerRequest *request){
+    const AsyncWebParameter* p = request->getParam("rate");
+    int hz = eventsRate(p ? p->value().c_str() : nullptr);
+    portENTER_CRITICAL(&eventsMux);
+    int sub = events.addSubscriber(hz, millis());
+    portEXIT_CRITICAL(&eventsMux);
+    if (sub < 0) {
+      request->send(503, "application/json", "{\"error\":\"too many event streams\"}");
+      return;
     }
-    .dominant-value { 
-        font-size: 2.5rem; 
-        font-weight: 800; 
-        min-width: 120px; /* 確保數值區域穩定 */
-        text-align: right; 
-        font-variant-numeric: tabular-nums;
-        transition: color 0.3s;
+    request->send(new EventStreamResponse(sub));
+  });
+}
+
+// 在 loop() 中: 有連線到期才組遙測 (各連線共用), 再把每個連線可送的事件寫進 TCP 送出緩衝
+void handleEvents() {
+  unsigned long now = millis();
+  portENTER_CRITICAL(&eventsMux);
+  bool due = events.teleDue(now);
+  portEXIT_CRITICAL(&eventsMux);
+  if (due) {
+    size_t len;
+    const char* tele = car.telemetry(&len);
+    portENTER_CRITICAL(&eventsMux);
+    events.publish(SSE_TELE, tele, len, now);
+    portEXIT_CRITICAL(&eventsMux);
+  }
+  char buf[EventStream::MAX_EVENT];
+  for (int i = 0; i < EventStream::MAX_SUBS; i++) {
+    AsyncClient* client = eventConns[i].client;
+    if (client == nullptr) continue;
+    if (eventConns[i].closed) {
+      eventConns[i].client = nullptr;
+      portENTER_CRITICAL(&eventsMux);
+      events.removeSubscriber(i);
+      portEXIT_CRITICAL(&eventsMux);
+      delete client;
+      continue;
     }
-    /* 顏色反饋 */
-    .c-fwd { color: #22c55e; } /* 綠色 (前進) */
-    .c-rev { color: #f97316; } /* 橙色 (倒車) */
-    .c-left { color: #ef4444; } /* 紅色 (左轉) */
-    .c-right { color: #3b82f6; } /* 藍色 (右轉) */
-
-  </style>
-</head>
-<body>
-  <div class="app">
-    <div class="viewer">
-      <img id="video" class="videoFrame" alt="遠端影像" src="" />
-      <div class="overlay">IP: <span id="imgSource">N/A</span> | WS: <span id="wsStatus">未連線</span></div>
-      
-      <!-- 新增: 主導控制輸入顯示 (Dominant Input Display) -->
-      <div id="dominant-display" class="dominant-display">
-          <span id="domName" class="dominant-name"></span>
-          <span id="domValue" class="dominant-value"></span>
-      </div>
-
-      <div class="controls">
-        <div style="margin:12px; display:flex; flex-direction:column; gap:8px;">
-          <div class="stick" id="stickLeft" data-role="steer"><div class="base"></div><div class="knob" id="knobLeft"></div></div>
-          <div class="value">方向: <span id="valSteer">0</span></div>
-        </div>
-        <div style="margin:12px; display:flex; flex-direction:column; gap:8px;">
-          <div class="stick" id="stickRight" data-role="throttle"><div class="base"></div><div class="knob" id="knobRight"></div></div>
-          <div class="value">油門: <span id="valThrottle">0</span></div>
-        </div>
-      </div>
-    </div>
-  </div>
-
-  <script>
-    class VirtualStick {
-      constructor(stickEl, knobEl, onChange){
-        this.el = stickEl; this.knob = knobEl; this.cb = onChange; this.max = Math.min(stickEl.clientWidth, stickEl.clientHeight)/2 - 8;
-        this.center = {x: this.el.clientWidth/2, y: this.el.clientHeight/2};
-        this.pointerId = null; this.pos = {x:0,y:0}; this.deadzone = 6;
-        this._bind();
-      }
-      _bind(){
-        this.el.style.touchAction = 'none';
-        this.el.addEventListener('pointerdown', e=>this._start(e));
-        window.addEventListener('pointermove', e=>this._move(e));
-        window.addEventListener('pointerup', e=>this._end(e));
-        window.addEventListener('pointercancel', e=>this._end(e));
-        window.addEventListener('resize', ()=>{this.center = {x:this.el.clientWidth/2,y:this.el.clientHeight/2};this.max = Math.min(this.el.clientWidth,this.el.clientHeight)/2 - 8});
-      }
-      _start(e){ if(this.pointerId!==null) return; this.pointerId = e.pointerId; this.el.setPointerCapture?.(e.pointerId); this._move(e); }
-      _move(e){ if(this.pointerId===null || e.pointerId!==this.pointerId) return; const rect = this.el.getBoundingClientRect(); let x = e.clientX - rect.left - rect.width/2; let y = e.clientY - rect.top - rect.height/2; const d = Math.hypot(x,y); if(d>this.max){ const r = this.max/d; x*=r; y*=r; } this.pos = {x,y}; this.knob.style.left = (50 + (x/rect.width*100))+'%'; this.knob.style.top = (50 + (y/rect.height*100))+'%'; this._fire(); }
-      _end(e){ if(this.pointerId===null || e.pointerId!==e.pointerId) return; this.pointerId=null; this.pos={x:0,y:0}; this.knob.style.left='50%'; this.knob.style.top='50%'; this._fire(); }
-      // 此處 n.x, n.y 介於 -1 到 1 之間
-      _fire(){ const norm = {x: Math.abs(this.pos.x) < this.deadzone ? 0 : this.pos.x/this.max, y: Math.abs(this.pos.y) < this.deadzone ? 0 : this.pos.y/this.max}; if(this.cb) this.cb(norm); }
+    bool added = false;
+    for (;;) {
+      size_t room = client->space();
+      portENTER_CRITICAL(&eventsMux);
+      size_t n = events.next(i, buf, room < sizeof(buf) ? room : sizeof(buf), now);
+      portEXIT_CRITICAL(&eventsMux);
+      if (n == 0) break;
+      client->add(buf, n);
+      added = true;
     }
+    if (added) client->send();
+  }
+}
 
-    const wsStatusEl = document.getElementById('wsStatus');
-    const valSteer = document.getElementById('valSteer');
-    const valThrottle = document.getElementById('valThrottle');
-    const stickL = document.getElementById('stickLeft');
-    const stickR = document.getElementById('stickRight');
-    
-    // 取得新的主導顯示元素
-    const domDisplayEl = document.getElementById('dominant-display');
-    const domNameEl = document.getElementById('domName');
-    const domValueEl = document.getElementById('domValue');
+// REST 控制 (/api/*, 見 control_api.h 與 web_api.h): 處理器在 async_tcp 任務中解析與驗證, 命令交給 loop() 套用
+// (car 只在 loop 任務中使用)。急停立即拉低 STBY, 其餘由 loop() 的 apiApply() 處理。
+portMUX_TYPE apiMux = portMUX_INITIALIZER_UNLOCKED;
+ApiQueue api = {{muxEnter, muxExit, &apiMux}, {}};
 
+void apiReply(AsyncWebServerRequest *request, int code, const char* body) {
+  request->send(code, "application/json", body);
+}
 
-    // config.sendRate: 50ms (20Hz)
-    const state = {steer:0, throttle:0, ws:null, sendInterval:null, videoInterval:null, config:{videoUrl:'',videoFps:10,wsUrl:'',sendRate:50}};
+// 本文緩衝在 request->_tempObject (請求結束時由 AsyncWebServer 釋放); 超過 MAX_API_BODY 不緩衝
+void apiBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+  if (total > MAX_API_BODY) return;
+  if (index == 0) request->_tempObject = malloc(total);
+  if (request->_tempObject != nullptr && index + len <= total) memcpy((uint8_t*)request->_tempObject + index, data, len);
+}
 
-    // n.x*100 或 -n.y*100 確保輸出在 -100 到 100 之間
-    const left = new VirtualStick(stickL, document.getElementById('knobLeft'), n=>{ 
-        state.steer = Math.round(n.x*100); 
-        valSteer.textContent=state.steer; 
-        updateDominantDisplay(); // 搖桿移動時也立即更新顯示
-    });
-    const right = new VirtualStick(stickR, document.getElementById('knobRight'), n=>{ 
-        state.throttle = Math.round(-n.y*100); 
-        valThrottle.textContent=state.throttle; 
-        updateDominantDisplay(); // 搖桿移動時也立即更新顯示
-    });
-    
-    // --- 新增: 更新主導控制輸入顯示 ---
-    function updateDominantDisplay() {
-        const steer = state.steer;
-        const throttle = state.throttle;
-        const absSteer = Math.abs(steer);
-        const absThrottle = Math.abs(throttle);
-
-        // 重設數值顏色類別
-        domValueEl.className = 'dominant-value';
-
-        if (absSteer === 0 && absThrottle === 0) {
-            // 隱藏顯示 (不操作時)
-            domDisplayEl.style.opacity = '0';
-            return;
-        }
+// 本文 (沒有時為空字串); 超過上限或配置失敗時已回覆錯誤並回傳 nullptr
+const char* apiRequestBody(AsyncWebServerRequest *request, size_t* len) {
+  char reply[64];
+  *len = request->contentLength();
+  if (*len > MAX_API_BODY) {
+    apiReply(request, apiError(413, "body too large", reply, sizeof(reply)), reply);
+    return nullptr;
+  }
+  if (*len == 0) return "";
+  if (request->_tempObject == nullptr) {
+    apiReply(request, apiError(500, "out of memory", reply, sizeof(reply)), reply);
+    return nullptr;
+  }
+  return (const char*)request->_tempObject;
+}
 
-        // 顯示面板
-        domDisplayEl.style.opacity = '1';
-
-        let name = '';
-        let value = 0;
-        let colorClass = '';
-
-        if (absSteer >= absThrottle) {
-            // 轉向 (Steer) 為主導 (或兩者相等，優先顯示 Steer)
-            value = steer;
-            if (value > 0) {
-                name = '右轉 (STEER)';
-                colorClass = 'c-right';
-            } else if (value < 0) {
-                name = '左轉 (STEER)';
-                colorClass = 'c-left';
-            } else {
-                // 如果 Steer=0 且 Throttle!=0, 則轉向顯示 Throttle
-                if (absThrottle > 0) {
-                    value = throttle;
-                    if (value > 0) { name = '前進 (THROTTLE)'; colorClass = 'c-fwd'; }
-                    else { name = '倒車 (REVERSE)'; colorClass = 'c-rev'; }
-                } else {
-                    // 兩者皆為 0，但在開頭已處理
-                    name = '靜止 (IDLE)';
-                    colorClass = '';
-                }
-            }
-        } 
-        
-        if (absThrottle > absSteer) {
-            // 油門 (Throttle) 為主導
-            value = throttle;
-            if (value > 0) {
-                name = '前進 (THROTTLE)';
-                colorClass = 'c-fwd';
-            } else {
-                name = '倒車 (REVERSE)';
-                colorClass = 'c-rev';
-            }
-        }
-        
-        domNameEl.textContent = name;
-        domValueEl.textContent = `${Math.abs(value)}%`;
-        
-        if (colorClass) {
-            domValueEl.classList.add(colorClass);
-        }
+void handleApiDrive(AsyncWebServerRequest *request) {
+  size_t len;
+  const char* body = apiRequestBody(request, &len);
+  if (body == nullptr) return;
+  char reply[128];
+  apiReply(request, apiDrive(&api, carStatus.mode(), body, len, reply, sizeof(reply)), reply);
+}
+
+void handleApiMode(AsyncWebServerRequest *request) {
+  size_t len;
+  const char* body = apiRequestBody(request, &len);
+  if (body == nullptr) return;
+  char reply[128];
+  apiReply(request, apiMode(&api, body, len, reply, sizeof(reply)), reply);
+}
+
+// 只拉低 STBY (馬達立即失去動力); car 的輸出、任務與校正由 loop() 的 emergencyStop() 歸零
+void handleApiStop(AsyncWebServerRequest *request) {
+  motorsOff();
+  char reply[32];
+  apiReply(request, apiStop(&api, reply, sizeof(reply)), reply);
+}
+
+void handleApiMission(AsyncWebServerRequest *request) {
+  size_t len;
+  const char* body = apiRequestBody(request, &len);
+  if (body == nullptr) return;
+  char reply[128];
+  apiReply(request, apiMission(&api, otaStream.active(), body, len, reply, sizeof(reply)), reply);
+}
+
+// WebSocket {"cfg":{...}} (CarControl::onConfig, loop 任務)
+size_t onWsConfig(void*, const char* json, size_t len, char* reply, size_t maxLen) {
+  return configWsReply(&config, configLock, json, len, reply, maxLen);
+}
+
+void handleApiConfig(AsyncWebServerRequest *request) {
+  size_t len;
+  const char* body = apiRequestBody(request, &len);
+  if (body == nullptr) return;
+  char reply[768];
+  apiReply(request, apiConfigPost(&config, configLock, body, len, reply, sizeof(reply)), reply);
+}
+
+void setupApi() {
+  server.on("/api/drive", HTTP_POST, handleApiDrive, nullptr, apiBody);
+  server.on("/api/mode", HTTP_POST, handleApiMode, nullptr, apiBody);
+  server.on("/api/estop", HTTP_POST, handleApiStop, nullptr, apiBody);
+  server.on("/api/mission", HTTP_POST, handleApiMission, nullptr, apiBody);
+  server.on("/api/mission", HTTP_GET, [](AsyncWebServerRequest *request){
+    char body[128];
+    apiReply(request, carStatus.missionReply(body, sizeof(body)), body);
+  });
+  server.on("/api/config", HTTP_POST, handleApiConfig, nullptr, apiBody);
+  server.on("/api/config", HTTP_GET, [](AsyncWebServerRequest *request){
+    char body[768];
+    apiReply(request, apiConfigGet(config, configLock, body, sizeof(body)), body);
+  });
+}
+
+// 在 loop() 中套用 REST 命令 (在 car.tick() 之前, 急停優先); 下一個 GET /api/mission 或 /api/drive 看到套用的結果
+void handleApiRequests() {
+  if (apiApply(&api, car)) carStatus.publish(car, millis(), true);
+}
+
+// 在 loop() 中、car.tick() 之前套用暫存的設定 (一次換掉全部即時欄位), 並合併寫入 NVS
+void handleConfig() {
+  portENTER_CRITICAL(&configMux);
+  bool changed = config.applyPending(millis());
+  CarConfig active = config.active();
+  portEXIT_CRITICAL(&configMux);
+  if (changed) {
+    car.configure(active);
+    sendLogMessage("Config applied");
+  }
+  config.tick(millis());
+}
+
+#if CAR_FEATURE_CAPTURE
+// 控制流量擷取: POST /capture/start 清除並開始, POST /capture/stop 停止, GET /capture 下載 (駕駛腳本格式)
+//   curl -X POST http://<car>/capture/start ; ... ; curl -X POST http://<car>/capture/stop
+//   curl -o field.txt http://<car>/capture ; 以 host/replay 重播
+void sendCaptureStatus(AsyncWebServerRequest *request, const char* state) {
+  char body[128];
+  request->send(captureStatusReply(capture, state, body, sizeof(body)), "application/json", body);
+}
+
+void setupCapture() {
+  server.on("/capture/start", HTTP_POST, [](AsyncWebServerRequest *request){
+    captureRequest = CAPTURE_REQ_START;
+    sendCaptureStatus(request, "starting");
+  });
+  server.on("/capture/stop", HTTP_POST, [](AsyncWebServerRequest *request){
+    captureRequest = CAPTURE_REQ_STOP;
+    sendCaptureStatus(request, "stopping");
+  });
+  server.on("/capture", HTTP_GET, [](AsyncWebServerRequest *request){
+    char body[96];
+    int code = captureDownloadCheck(capture, captureRequest, body, sizeof(body));
+    if (code != 200) {
+      request->send(code, "application/json", body);
+      return;
     }
-    // ----------------------
+    request->send(request->beginChunkedResponse("text/plain", [](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+      return capture.exportText((char*)buffer, maxLen, index);
+    }));
+  });
+}
 
-    // --- 日誌輔助函式: 輸出到瀏覽器 Console ---
-    function appendLog(message) {
-        const timestamp = new Date().toLocaleTimeString('en-US', {hour12: false});
-        console.log(`[ESP32 LOG] [${timestamp}] ${message}`); 
+// 在 loop() 中套用 /capture 的開始/停止請求 (與 webSocketEvent 同一任務)
+void handleCaptureRequest() {
+  uint8_t req = captureRequest;
+  if (req == CAPTURE_REQ_NONE) return;
+  captureRequest = CAPTURE_REQ_NONE;
+  captureApply(capture, req, millis());
+}
+#endif
+
+#if CAR_FEATURE_VIDEO
+// 影像轉送: 從相機節點 (例如 ESP32-CAM 的 http://<cam>:81/stream, 或任何送出 JPEG 的 HTTP 來源) 讀取,
+// GET /stream 以 multipart/x-mixed-replace 轉給所有觀看者 (一條長連線, 取代網頁逐張輪詢);
+// GET /frame.jpg 單張快照, GET /video 狀態, POST /video/source?url=http://... 更換上游 (不保存)。
+// 有觀看者時才連上游, 閒置 VIDEO_IDLE_MS 後中斷。上游資料、HTTP 回應與轉送器都在 async_tcp 任務中處理,
+// loop() 只負責建立與回收上游連線 (handleVideoUpstream)。
+const unsigned long VIDEO_IDLE_MS = 10000;
+const unsigned long VIDEO_RETRY_MS = 2000;
+const unsigned long VIDEO_STALL_MS = 5000;   // 連線中超過此時間沒有資料則重連
+char videoUrl[128] = VIDEO_UPSTREAM;
+char videoUrlPending[128];
+volatile bool videoUrlChanged = false;
+char videoRequest[192];                      // 上游的 GET 請求
+AsyncClient* videoClient = nullptr;          // 只在 loop() 建立與刪除
+volatile bool videoConnected = false;
+volatile bool videoClosed = false;
+volatile uint8_t videoViewerCount = 0;
+volatile unsigned long videoWantedAt = 0;    // 最近一次快照請求
+volatile unsigned long videoDataAt = 0;
+unsigned long videoConnectAt = 0;
+unsigned long videoRetryAt = 0;
+struct VideoViewer {
+  AsyncWebServerRequest* request;
+  AsyncWebServerResponse* response;
+};
+VideoViewer videoViewers[MjpegRelay::MAX_VIEWERS];
+
+// "http://host[:port]/path" → host, port, path
+bool parseHttpUrl(const char* url, char* host, size_t hostLen, uint16_t* port, const char** path) {
+  if (strncmp(url, "http://", 7) != 0) return false;
+  const char* h = url + 7;
+  size_t n = strcspn(h, ":/");
+  if (n == 0 || n >= hostLen) return false;
+  memcpy(host, h, n);
+  host[n] = 0;
+  *port = h[n] == ':' ? (uint16_t)atoi(h + n + 1) : 80;
+  const char* slash = strchr(h, '/');
+  *path = slash ? slash : "/";
+  return *port != 0;
+}
+
+// 轉送器發佈新框時, 讓等待中的 /stream 回應立即取資料
+// (AsyncWebServer 在 filler 回傳 RESPONSE_TRY_AGAIN 後要等下一次 ack 或 poll 才會再呼叫)
+void kickVideoViewers(int except) {
+  static bool kicking = false;
+  if (kicking) return;
+  kicking = true;
+  for (int i = 0; i < MjpegRelay::MAX_VIEWERS; i++) {
+    VideoViewer& v = videoViewers[i];
+    if (i != except && v.request != nullptr && !v.response->_finished()) v.response->_ack(v.request, 0, millis());
+  }
+  kicking = false;
+}
+
+void videoConnect() {
+  char host[64];
+  uint16_t port;
+  const char* path;
+  if (!parseHttpUrl(videoUrl, host, sizeof(host), &port, &path)) {
+    sendLogMessage(String("Video: bad upstream URL ") + videoUrl);
+    videoUrl[0] = 0;
+    return;
+  }
+  snprintf(videoRequest, sizeof(videoRequest), "GET %s HTTP/1.1\r\nHost: %s\r\nConnection: close\r\n\r\n", path, host);
+  AsyncClient* client = new AsyncClient();
+  client->onConnect([](void*, AsyncClient* c) {
+    videoConnected = true;
+    videoDataAt = millis();
+    c->write(videoRequest);
+  });
+  // HTTP 回應標頭與 multipart 分隔線不是 JPEG, 由轉送器略過
+  client->onData([](void*, AsyncClient*, void* data, size_t len) {
+    videoDataAt = millis();
+    uint32_t seq = video.seq();
+    video.feed((const uint8_t*)data, len, millis());
+    if (video.seq() != seq) kickVideoViewers(-1);
+  });
+  // 連線失敗 (onError 之後) 或斷線都會呼叫; 在 loop() 中刪除
+  client->onDisconnect([](void*, AsyncClient*) {
+    video.resetUpstream();
+    videoConnected = false;
+    videoClosed = true;
+  });
+  videoClient = client;
+  videoClosed = false;
+  videoConnectAt = millis();
+  if (!client->connect(host, port)) {
+    delete client;
+    videoClient = nullptr;
+    videoRetryAt = millis() + VIDEO_RETRY_MS;
+  }
+}
+
+// 在 loop() 中建立、停止與回收上游連線
+void handleVideoUpstream() {
+  unsigned long now = millis();
+  if (videoClosed) {
+    videoClosed = false;
+    delete videoClient;
+    videoClient = nullptr;
+    videoRetryAt = now + VIDEO_RETRY_MS;
+  }
+  if (videoUrlChanged) {
+    strcpy(videoUrl, videoUrlPending);
+    videoUrlChanged = false;
+    videoRetryAt = now;
+    if (videoClient) videoClient->close();
+    sendLogMessage(String("Video upstream: ") + videoUrl);
+    return;
+  }
+  bool wanted = videoViewerCount > 0 || now - videoWantedAt < VIDEO_IDLE_MS;
+  if (videoClient == nullptr) {
+    if (wanted && videoUrl[0] && (long)(now - videoRetryAt) >= 0) videoConnect();
+  } else if (!wanted || (videoConnected ? now - videoDataAt > VIDEO_STALL_MS : now - videoConnectAt > VIDEO_STALL_MS)) {
+    videoClient->close();
+  }
+}
+
+void setupVideo() {
+  server.on("/stream", HTTP_GET, [](AsyncWebServerRequest *request){
+    if (videoUrl[0] == 0) {
+      request->send(503, "application/json", "{\"error\":\"no video source, POST /video/source?url=...\"}");
+      return;
     }
-    // ----------------------
-
-    function connectWs(){ 
-        if(state.ws){ try{state.ws.close()}catch(e){} state.ws=null; } 
-        const wsUrl = `ws://${window.location.hostname}:81`;
-        
-        appendLog(`嘗試連線到 WebSocket: ${wsUrl}`);
-        wsStatusEl.textContent = 'Connecting...';
-
-        try{ 
-            state.ws = new WebSocket(wsUrl); 
-            state.ws.binaryType='arraybuffer'; 
-            
-            state.ws.onopen=()=>{
-                wsStatusEl.textContent = 'OPEN';
-                appendLog('WebSocket 連線成功。');
-            }; 
-            
-            state.ws.onclose=()=>{
-                wsStatusEl.textContent = 'CLOSED';
-                appendLog('WebSocket 已斷線，3秒後重試連線...');
-                setTimeout(connectWs, 3000); // 重試連線
-            }; 
-            
-            state.ws.onerror=()=>{
-                wsStatusEl.textContent = 'ERROR';
-                appendLog('WebSocket 連線錯誤。');
-            }; 
-            
-            state.ws.onmessage = (event) => {
-                const data = event.data;
-                
-                // 嘗試解析 JSON (控制狀態/遠端日誌)
-                try {
-                    const json = JSON.parse(data);
-                    if (json.debug) {
-                        // 這是來自 ESP32 的遠端日誌 (JSON 格式)
-                        appendLog(json.debug);
-                    } else if (json.motorA !== undefined) {
-                        // 馬達狀態更新 (可選)
-                        // appendLog(`Motor A:${json.motorA}, B:${json.motorB}`);
-                    }
-                } catch(e) {
-                    // 如果不是 JSON，則視為遠端日誌文本
-                    appendLog(data);
-                }
-            };
-        }catch(e){ 
-            wsStatusEl.textContent = 'ERROR'; 
-            appendLog(`WebSocket 建立失敗: ${e.message}`);
-        } 
+    int viewer = video.begin() ? video.addViewer() : -1;
+    if (viewer < 0) {
+      request->send(503, "application/json", "{\"error\":\"too many viewers\"}");
+      return;
     }
-
-    // 發送搖桿命令到 WebSocket
-    function startSending(rate){ 
-      if(state.sendInterval) clearInterval(state.sendInterval); 
-      state.sendInterval=setInterval(()=>{ 
-        
-        // **優化: 如果搖桿處於中心位置 (0, 0)，則不發送消息**
-        if(state.steer === 0 && state.throttle === 0) {
-            updateDominantDisplay(); // 確保歸零時顯示隱藏
-            return; // 停止執行，不發送 WS 消息
-        }
-        
-        if(state.ws && state.ws.readyState===WebSocket.OPEN){ 
-          // t: timestamp, steer: 轉向 (-100 to 100), throttle: 油門 (-100 to 100)
-          // 這裡發送的是原始的 -100 ~ 100 搖桿百分比
-          state.ws.send(JSON.stringify({t:Date.now(),steer:state.steer,throttle:state.throttle})); 
-          
-          // 定時器觸發時也更新顯示，確保顯示與發送同步
-          updateDominantDisplay();
-        } 
-      }, rate); 
+    videoViewerCount++;
+    AsyncWebServerResponse *response = request->beginChunkedResponse(MjpegRelay::CONTENT_TYPE,
+        [viewer](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+      uint32_t seq = video.seq();
+      size_t n = video.read(viewer, buffer, maxLen, millis());
+      // 本觀看者送完舊框, 暫存的新框才發佈: 通知其他觀看者
+      if (video.seq() != seq) kickVideoViewers(viewer);
+      return n == MjpegRelay::AGAIN ? RESPONSE_TRY_AGAIN : n;
+    });
+    response->addHeader("Cache-Control", "no-store");
+    videoViewers[viewer] = {request, response};
+    request->onDisconnect([viewer](){
+      videoViewers[viewer] = {nullptr, nullptr};
+      video.removeViewer(viewer);
+      videoViewerCount--;
+    });
+    request->send(response);
+  });
+  server.on("/frame.jpg", HTTP_GET, [](AsyncWebServerRequest *request){
+    videoWantedAt = millis();
+    int viewer = video.ready() ? video.addViewer(true) : -1;
+    if (viewer < 0) {
+      request->send(503, "application/json", "{\"error\":\"no frame\"}");
+      return;
     }
-    
-    // 影像輪詢邏輯 (僅為範例，需配合 ESP32 影像串流伺服器)
-    async function fetchFrame(){ const url=state.config.videoUrl; if(!url) return; try{ const res=await fetch(url+(url.includes('?')?'&':'?')+'t='+Date.now(),{cache:'no-store'}); if(!res.ok) throw new Error('bad'); const blob=await res.blob(); const img=document.getElementById('video'); const old=img.src; img.src=URL.createObjectURL(blob); if(old&&old.startsWith('blob:')) URL.revokeObjectURL(old); }catch(e){ console.warn(e); } }
-    function startVideoPoll(){ stopVideoPoll(); const fps=Math.max(1,parseInt(state.config.videoFps||10)); state.videoInterval=setInterval(fetchFrame, Math.round(1000/fps)); document.getElementById('imgSource').textContent=state.config.videoUrl||'N/A'; }
-    function stopVideoPoll(){ if(state.videoInterval) clearInterval(state.videoInterval); state.videoInterval=null; }
+    AsyncWebServerResponse *response = request->beginResponse("image/jpeg", video.publishedLen(),
+        [viewer](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+      return video.read(viewer, buffer, maxLen, millis());
+    });
+    response->addHeader("Cache-Control", "no-store");
+    response->addHeader("X-Frame-Seq", String(video.seq()));
+    response->addHeader("X-Frame-Age", String(video.publishedAgeMs(millis())));
+    request->onDisconnect([viewer](){ video.removeViewer(viewer); });
+    request->send(response);
+  });
+  server.on("/video/source", HTTP_POST, [](AsyncWebServerRequest *request){
+    const AsyncWebParameter* p = request->getParam("url");
+    if (p == nullptr || (p->value().length() > 0 && !p->value().startsWith("http://")) ||
+        p->value().length() >= sizeof(videoUrlPending)) {
+      request->send(400, "application/json", "{\"error\":\"url must be http://host[:port]/path (empty to disable)\"}");
+      return;
+    }
+    strcpy(videoUrlPending, p->value().c_str());
+    videoUrlChanged = true;
+    request->send(200, "application/json", "{\"ok\":true}");
+  });
+  server.on("/video", HTTP_GET, [](AsyncWebServerRequest *request){
+    const char* upstream = videoUrl[0] == 0 ? "none" : (videoConnected ? "connected" : (videoClient ? "connecting" : "idle"));
+    char body[320];
+    videoInfoJson(video, videoUrl, upstream, millis(), body, sizeof(body));
+    request->send(200, "application/json", body);
+  });
+}
+#endif
 
-    window.addEventListener('beforeunload', ()=>{ if(state.ws) state.ws.close(); stopSending(); stopVideoPoll(); });
-    
-    window.onload = () => {
-        connectWs();
-        startSending(50); // 每 50ms 發送一次控制命令
-        updateDominantDisplay(); // 初始檢查並隱藏顯示
-        // 設定影像串流 URL 範例 (如果您的 ESP32 提供影像串流)
-        // state.config.videoUrl = 'http://' + window.location.hostname + '/stream';
-        // startVideoPoll(); 
-    };
-  </script>
-</body>
-</html>
-)rawliteral";
+#if CAR_FEATURE_FLEET
+// 車隊探索: 每 30 秒送出一次 PTR 查詢, 之後每次 loop() 只檢查是否完成 (不阻塞控制迴圈)
+void handlePeerDiscovery() {
+  static mdns_search_once_t* search = nullptr;
+  static unsigned long lastQueryAt = 0;
+  if (search == nullptr) {
+    if (lastQueryAt != 0 && millis() - lastQueryAt < PEER_QUERY_INTERVAL) return;
+    if (WiFi.status() != WL_CONNECTED) return;
+    lastQueryAt = millis();
+    search = mdns_query_async_new(NULL, "_esp32car", "_tcp", MDNS_TYPE_PTR, 3000, MAX_PEERS);
+    return;
+  }
+  mdns_result_t* results = nullptr;
+  if (!mdns_query_async_get_results(search, 0, &results)) return;
+  mdns_query_async_delete(search);
+  search = nullptr;
+
+  Peer found[MAX_PEERS];
+  int n = 0;
+  for (mdns_result_t* r = results; r != nullptr && n < MAX_PEERS; r = r->next) {
+    mdns_ip_addr_t* a = r->addr;
+    while (a != nullptr && a->addr.type != ESP_IPADDR_TYPE_V4) a = a->next;
+    if (a == nullptr || r->hostname == nullptr) continue;
+    if (IPAddress(a->addr.u_addr.ip4.addr) == WiFi.localIP()) continue; // 自己另外列出
+    snprintf(found[n].name, sizeof(found[n].name), "%s", r->hostname);
+    snprintf(found[n].host, sizeof(found[n].host), IPSTR ":%u", IP2STR(&a->addr.u_addr.ip4), r->port);
+    n++;
+  }
+  mdns_query_results_free(results);
+  portENTER_CRITICAL(&peerMux);
+  memcpy(peers, found, sizeof(Peer) * n);
+  peerCount = n;
+  portEXIT_CRITICAL(&peerMux);
+}
+
+void handlePeers(AsyncWebServerRequest *request) {
+  Peer copy[MAX_PEERS];
+  portENTER_CRITICAL(&peerMux);
+  int n = peerCount;
+  memcpy(copy, peers, sizeof(Peer) * n);
+  portEXIT_CRITICAL(&peerMux);
+
+  String self = ArduinoOTA.getHostname();
+  String selfHost = WiFi.localIP().toString() + ":80";
+  char body[(MAX_PEERS + 1) * 80 + 64];
+  peersJson(self.c_str(), selfHost.c_str(), copy, n, body, sizeof(body));
+  request->send(200, "application/json", body);
+}
+#endif
 
 // 設置 HTTP Server 和 WebSocket
 void setupWebServer() {
@@ -579,10 +779,33 @@ void setupWebServer() {
     request->send(200, "text/html", index_html);
   });
 
+#if CAR_FEATURE_FLEET
+  // 車隊儀表板: 列出本機與 mDNS 找到的其他車, 每台以 WebSocket 訂閱遙測
+  server.on("/fleet", HTTP_GET, [](AsyncWebServerRequest *request){
+    request->send(200, "text/html", fleet_html);
+  });
+  server.on("/peers", HTTP_GET, handlePeers);
+#endif
+
+  server.on("/health", HTTP_GET, handleHealth);
+  server.on("/latency", HTTP_GET, handleLatency);
+  setupEvents();
+  setupApi();
+#if CAR_FEATURE_CAPTURE
+  setupCapture();
+#endif
+#if CAR_FEATURE_VIDEO
+  setupVideo();
+#endif
+
   server.begin();
   webSocket.begin();
   webSocket.onEvent(webSocketEvent);
 
+  // mDNS 已由 ArduinoOTA 啟動 (hostname esp32c3-<mac>), 這裡只加上車隊探索用的服務;
+  // 沒有 /fleet 的變體仍公告, 讓其他車的儀表板找得到它
+  MDNS.addService("esp32car", "tcp", 80);
+
   sendLogMessage("Web UI Ready on port 80. Remote Control Active at http://" + WiFi.localIP().toString());
 }
 
@@ -590,6 +813,113 @@ void setupWebServer() {
 // VIII. OTA 服務 (Over-The-Air Update)
 // ----------------------------------------------------------------------
 
+// HTTP 串流更新: 接收到的每個區塊直接寫入非作用中的 OTA 分區並累計 SHA-256。
+// 用法: curl -u ota:<password> -H "X-Image-SHA256: $(sha256sum firmware.bin | cut -d' ' -f1)"
+//         -H "Content-Type: application/octet-stream" --data-binary @firmware.bin http://<car>/update
+// 也接受 multipart 上傳 (curl -F image=@firmware.bin), 此時可用 X-Image-Size 提供影像長度。
+// body 若是 tools/ota_delta.py 產生的修補檔則以執行中影像為基底重建, 不需 X-Image-SHA256。
+void handleOtaChunk(AsyncWebServerRequest *request, size_t index, uint8_t *data, size_t len, size_t total) {
+  if (index == 0 && !request->authenticate(OTA_HTTP_USER, OTA_PASSWORD)) return; // onRequest 回覆 401
+  xSemaphoreTake(otaMutex, portMAX_DELAY);
+  if (index == 0 && !otaStream.active()) {                           // 已有更新時 onRequest 回覆 409
+    // 先更新時間再開始, loop() 的停滯檢查不會看到上一次上傳的時間
+    otaLastChunkAt = millis();
+    // 更新期間馬達保持停止: motorsOff() 只拉低 STBY, 鎖定與 holdSafe() 由 loop() 接手 (handleHttpOTA)
+    AsyncWebHeader* shaHeader = request->getHeader("X-Image-SHA256");
+    if (otaUploadBegin(otaStream, httpOta, shaHeader ? shaHeader->value().c_str() : nullptr, total, millis(), motorsOff)) {
+      otaOwner = request;
+      request->onDisconnect([request]() {
+        xSemaphoreTake(otaMutex, portMAX_DELAY);
+        if (otaOwner == request) {
+          otaStream.abort("client disconnected");
+          otaOwner = nullptr;
+        }
+        xSemaphoreGive(otaMutex);
+      });
+    }
+  }
+  if (otaOwner == request) {
+    otaLastChunkAt = millis();
+    otaStream.write(data, len, millis());
+  }
+  xSemaphoreGive(otaMutex);
+}
+
+// 目前執行中的影像資訊; build_sha256 即 delta 修補檔的基底雜湊
+void handleOtaInfo(AsyncWebServerRequest *request) {
+  esp_app_desc_t desc;
+  esp_ota_get_partition_description(esp_ota_get_running_partition(), &desc);
+  const esp_partition_t* next = esp_ota_get_next_update_partition(NULL);
+  char built[sizeof(desc.date) + sizeof(desc.time) + 1];
+  snprintf(built, sizeof(built), "%s %s", desc.date, desc.time);
+  char body[320];
+  otaInfoJson(next ? next->label : "none", desc.version, built, body, sizeof(body));
+  request->send(200, "application/json", body);
+}
+
+void setupHttpOTA() {
+  otaMutex = xSemaphoreCreateMutex();
+  server.on("/update", HTTP_POST,
+    [](AsyncWebServerRequest *request) {
+      if (!request->authenticate(OTA_HTTP_USER, OTA_PASSWORD)) {
+        return request->requestAuthentication();
+      }
+      bool ok;
+      char body[300];
+      xSemaphoreTake(otaMutex, portMAX_DELAY);
+      bool owner = otaOwner == request;
+      if (owner) otaOwner = nullptr;
+      int code = otaUpdateReply(otaStream, httpOta, owner, millis(), &ok, body, sizeof(body));
+      xSemaphoreGive(otaMutex);
+      request->send(code, "application/json", body);
+      if (ok) otaRebootAt = millis() + 1500; // 等回應送出後再重新啟動
+    },
+    [](AsyncWebServerRequest *request, const String& filename, size_t index, uint8_t *data, size_t len, bool final) {
+      // multipart 上傳: 總長度只能由 X-Image-Size 標頭得知
+      AsyncWebHeader* sizeHeader = request->getHeader("X-Image-Size");
+      size_t total = sizeHeader ? (size_t)sizeHeader->value().toInt() : 0;
+      handleOtaChunk(request, index, data, len, total);
+    },
+    [](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+      handleOtaChunk(request, index, data, len, total);
+    });
+
+  server.on("/ota/info", HTTP_GET, handleOtaInfo);
+}
+
+// 在 loop() 中發佈 HTTP OTA 進度 (WebSocket 只在此任務中使用)
+void publishOtaProgress() {
+  static OtaProgressFeed feed;
+  char buffer[240];
+  char log[96];
+  size_t len = feed.next(otaStream, httpOta, millis(), buffer, sizeof(buffer), log, sizeof(log));
+  if (len == 0) return;
+  webSocket.broadcastTXT(buffer, len);
+  if (log[0]) sendLogMessage(log);
+}
+
+void handleHttpOTA() {
+  if (otaStream.active()) {
+    // 寫入期間持續確保馬達停止 (上傳處理器已拉低 STBY, 這裡讓 car 的狀態一致); 若客戶端中途停止傳送則放棄
+    if (car.outputs().standby || car.missionActive() || car.calibrating()) car.holdSafe();
+    // 只嘗試取得: 取不到表示 async_tcp 正在寫入區塊, 上傳沒有停滯
+    if (millis() - otaLastChunkAt > OTA_STALL_TIMEOUT && xSemaphoreTake(otaMutex, 0) == pdTRUE) {
+      if (otaStream.active() && millis() - otaLastChunkAt > OTA_STALL_TIMEOUT) {
+        otaOwner = nullptr;
+        otaStream.abort("upload stalled");
+      }
+      xSemaphoreGive(otaMutex);
+    }
+  }
+  publishOtaProgress();
+  if (otaRebootAt != 0 && (long)(millis() - otaRebootAt) >= 0) {
+    sendLogMessage("HTTP OTA: Update Finished. Rebooting...");
+    config.flush();
+    delay(100);
+    ESP.restart();
+  }
+}
+
 void setupOTA() {
   String hostname = "esp32c3-" + String(WiFi.macAddress());
   hostname.replace(":", ""); // remove colons for clean name
@@ -597,7 +927,7 @@ void setupOTA() {
 
   // 設定 OTA 參數
   ArduinoOTA.setHostname(hostname.c_str());
-  ArduinoOTA.setPassword("mysecurepassword"); // 替換為您的密碼
+  ArduinoOTA.setPassword(OTA_PASSWORD);
   
   // OTA 事件處理
   ArduinoOTA.onStart([]() { sendLogMessage("OTA: Start updating " + String(ArduinoOTA.getCommand() == U_FLASH ? "sketch" : "filesystem")); });
@@ -612,18 +942,32 @@ void setupOTA() {
 // IX. 馬達初始化 (Motor Initialization)
 // ----------------------------------------------------------------------
 
-void setupPWM() {
+// 回傳 false 表示有 LEDC 通道設定失敗 (ledcSetup 回傳 0)
+// 頻率、解析度與腳位來自開機時載入的設定 (預設為 PWM_FREQ / PWM_RES / gpio_pins.h)
+bool setupPWM(const CarConfig& cfg) {
   // 設置 LEDC 通道頻率與解析度
-  ledcSetup(CH_A_FWD, PWM_FREQ, PWM_RES);
-  ledcSetup(CH_A_REV, PWM_FREQ, PWM_RES);
-  ledcSetup(CH_B_LEFT, PWM_FREQ, PWM_RES);
-  ledcSetup(CH_B_RIGHT, PWM_FREQ, PWM_RES);
+  bool ok = ledcSetup(CH_A_FWD, cfg.pwmFreq, cfg.pwmRes) != 0;
+  ok = ledcSetup(CH_A_REV, cfg.pwmFreq, cfg.pwmRes) != 0 && ok;
 
   // 將 LEDC 通道連接到 GPIO 引腳
-  ledcAttachPin(motorA_pwm_fwd, CH_A_FWD);
-  ledcAttachPin(motorA_pwm_rev, CH_A_REV);
-  ledcAttachPin(motorB_pwm_left, CH_B_LEFT);
-  ledcAttachPin(motorB_pwm_right, CH_B_RIGHT);
+  ledcAttachPin(cfg.pinAFwd, CH_A_FWD);
+  ledcAttachPin(cfg.pinARev, CH_A_REV);
+
+  if (variant::SERVO && cfg.steerMode == STEER_SERVO) {
+    // 伺服轉向: CH_SERVO 在自己的計時器上以伺服頻率輸出; Motor B 的兩個輸入保持 LOW (滑行)
+    ok = ledcSetup(CH_SERVO, cfg.servoHz, SERVO_RES) != 0 && ok;
+    ledcAttachPin(cfg.servoPin, CH_SERVO);
+    pinMode(cfg.pinBLeft, OUTPUT);
+    digitalWrite(cfg.pinBLeft, LOW);
+    pinMode(cfg.pinBRight, OUTPUT);
+    digitalWrite(cfg.pinBRight, LOW);
+    return ok;
+  }
+  ok = ledcSetup(CH_B_LEFT, cfg.pwmFreq, cfg.pwmRes) != 0 && ok;
+  ok = ledcSetup(CH_B_RIGHT, cfg.pwmFreq, cfg.pwmRes) != 0 && ok;
+  ledcAttachPin(cfg.pinBLeft, CH_B_LEFT);
+  ledcAttachPin(cfg.pinBRight, CH_B_RIGHT);
+  return ok;
 }
 
 // ----------------------------------------------------------------------
@@ -635,26 +979,57 @@ void setup() {
   //WRITE_PERI_REG(RTC_CNTL_BROWN_OUT_REG, 0); // 關閉 brownout 檢測
 
   Serial.begin(115200);
+  // 先以編譯時的預設腳位停用馬達: 下面的影像驗證與 NVS 讀取需要一段時間, 暖開機時 STBY 不能懸空
+  pinMode(motor_stby, OUTPUT);
+  digitalWrite(motor_stby, LOW);
   delay(100);
 
+  // OTA 後首次開機: 啟動自我測試與回滾計時器
+  bootSelfTestBegin();
+
+  // 執行中影像的建置雜湊 (/health、/ota/info 與 delta 更新的基底): 驗證需讀完整個影像, 只在開機時做一次
+  if (!otaBackendScanRunning()) Serial.printf("Running image hash unavailable: %s\n", otaBackendError());
+
   //esp_reset_reason_t reason = esp_reset_reason();
   //Serial.printf("Reset reason: %d\n", reason);
 
-  // X. 馬達開關 (Motor Enable)
-  pinMode(motor_stby, OUTPUT);
-  digitalWrite(motor_stby, LOW); // 預設禁用馬達
+  // 執行期設定: 依 eFuse MAC 選擇這台車的 profile, 再以 NVS 中的值覆寫
+  uint8_t mac[6];
+  esp_efuse_mac_get_default(mac);
+  config.begin(mac);
+  const CarConfig& cfg = config.active();
+  Serial.printf("Profile: %s (MAC %02X:%02X:%02X:%02X:%02X:%02X)\n", CAR_PROFILES[config.profileIndex()].name,
+                mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+  Serial.printf("Variant: %s\n", variant::NAME);
+  if (variant::MIX >= 0 && cfg.mixMode != variant::MIX) {
+    // 混控方式在這個映像中是固定的, 設定中的 mix 不生效
+    Serial.printf("Warning: variant %s drives mix %d, profile/NVS asks for %u\n", variant::NAME, variant::MIX,
+                  cfg.mixMode);
+  }
+  car.configure(cfg);
+  car.onConfig(onWsConfig, nullptr);
+
+  // X. 馬達開關 (Motor Enable): 設定的 STBY 腳位與預設不同時, 釋放預設腳位
+  if (cfg.pinStby != motor_stby) pinMode(motor_stby, INPUT);
+  stbyPin = cfg.pinStby;
+  pinMode(cfg.pinStby, OUTPUT);
+  digitalWrite(cfg.pinStby, LOW); // 預設禁用馬達
 
   // I. 馬達初始化 (Motor Initialization)
-  setupPWM();
+  bootSelfTestReportPwm(setupPWM(cfg));
+  car.begin();
+  carStatus.publish(car, millis(), true);
 
   // II. 網路連線 (Network Connection) - 需有 Launcher App 儲存的憑證
   connectToWiFi();
   
-  // III. OTA 服務 (Over-The-Air Update)
+  // III. OTA 服務 (Over-The-Air Update) - ArduinoOTA 與 HTTP /update
   setupOTA();
+  setupHttpOTA();
 
   // IV. 網頁服務 (Web Services)
   setupWebServer();
+  bootSelfTestReportNetwork(WiFi.status() == WL_CONNECTED);
   
   sendLogMessage("User App setup complete. Ready to receive commands.");
 
@@ -664,25 +1039,32 @@ void loop() {
   // 保持 OTA 服務運行
   ArduinoOTA.handle();
   // 保持 WebSocket 服務運行
+#if CAR_FEATURE_CAPTURE
+  handleCaptureRequest();
+#endif
+  handleApiRequests();
+#if CAR_FEATURE_VIDEO
+  handleVideoUpstream();
+#endif
+#if CAR_FEATURE_FLEET
+  handlePeerDiscovery();
+#endif
   webSocket.loop();
+  // HTTP OTA 進度發佈、停滯偵測與更新後重新啟動
+  handleHttpOTA();
   
-  // 馬達命令超時邏輯：若超過 COMMAND_TIMEOUT 且馬達正在運行，則停止所有馬達
-  if (millis() - lastCommandTime > COMMAND_TIMEOUT) {
-    // targetA/B 儲存的是 Duty Cycle，所以只要不為 0，就表示馬達正在轉動
-    if (targetA != 0 || targetB != 0) { 
-      sendLogMessage("Motors stopped due to command timeout.");
-      targetA = targetB = 0; // 重設目標速度
-      digitalWrite(motor_stby, LOW); // 禁用馬達
-      // 確保 PWM 也停止
-      ledcWrite(CH_A_FWD, 0); ledcWrite(CH_A_REV, 0);
-      ledcWrite(CH_B_LEFT, 0); ledcWrite(CH_B_RIGHT, 0);
-    }
-  }
+  // OTA 更新期間鎖定遙控命令; 馬達命令超時邏輯
+  car.setDriveLocked(otaStream.active());
+  bootSelfTestControlTick(millis());
+  handleConfig();
+  car.tick();
+  carStatus.publish(car, millis(), false);
+  handleEvents();
 
   // 心跳日誌
   static unsigned long lastLogMillis = 0;
   if (millis() - lastLogMillis > 5000) { 
-    sendLogMessage("Heartbeat: Car system active, Mode=" + String(currentMode == AUTO ? "AUTO" : "MANUAL"));
+    sendLogMessage("Heartbeat: Car system active, Mode=" + String(driveModeName(car.mode())));
     lastLogMillis = millis();
   }
 }
@@ -0,0 +1,184 @@
+#include "mjpeg_relay.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+MjpegRelay::~MjpegRelay() {
+  free(_buf[0]);
+  free(_buf[1]);
+}
+
+bool MjpegRelay::begin() {
+  if (ready()) return true;
+  uint8_t* a = (uint8_t*)malloc(MAX_FRAME);
+  uint8_t* b = (uint8_t*)malloc(MAX_FRAME);
+  if (a == nullptr || b == nullptr) {
+    free(a);
+    free(b);
+    return false;
+  }
+  _buf[0] = a;
+  _buf[1] = b;
+  return true;
+}
+
+void MjpegRelay::resetUpstream() {
+  _inFrame = false;
+  _skip = false;
+  _prev = 0;
+}
+
+bool MjpegRelay::publishedBusy() const {
+  for (const Viewer& v : _viewers) {
+    if (v.active && v.sending) return true;
+  }
+  return false;
+}
+
+void MjpegRelay::publish() {
+  _published = _write;
+  _write = 1 - _write;
+  _seq++;
+  _publishedMs = _pendingMs;
+  _pending = false;
+  _stats.lastFrameMs = _publishedMs;
+  _stats.lastFrameLen = (uint32_t)_len[_published];
+}
+
+void MjpegRelay::feed(const uint8_t* data, size_t len, uint32_t nowMs) {
+  if (!ready()) return;
+  size_t i = 0;
+  while (i < len) {
+    uint8_t b = data[i];
+    if (!_inFrame) {
+      i++;
+      if (_prev == 0xFF && b == 0xD8) {
+        // 新框開始: 還沒發佈的框已經過時
+        if (_pending && !publishedBusy()) publish();
+        if (_pending) {
+          _pending = false;
+          _stats.superseded++;
+        }
+        _inFrame = true;
+        _skip = false;
+        _buf[_write][0] = 0xFF;
+        _buf[_write][1] = 0xD8;
+        _fill = 2;
+        b = 0;
+      }
+      _prev = b;
+      continue;
+    }
+    // 框內: 整段複製到下一個 0xFF (熵編碼資料中的 0xFF 一律是 FF 00 或 RST, EOI 只出現在結尾)
+    const uint8_t* ff = (const uint8_t*)memchr(data + i, 0xFF, len - i);
+    size_t run = ff ? (size_t)(ff - (data + i)) + 1 : len - i;
+    if (_prev == 0xFF && b == 0xD9) run = 1;
+    if (!_skip && _fill + run > MAX_FRAME) {
+      _skip = true;
+      _stats.oversize++;
+    }
+    if (!_skip) {
+      memcpy(_buf[_write] + _fill, data + i, run);
+      _fill += run;
+    }
+    bool eoi = _prev == 0xFF && b == 0xD9;
+    _prev = data[i + run - 1];
+    i += run;
+    if (!eoi) continue;
+    _inFrame = false;
+    _prev = 0;
+    if (_skip) continue;
+    _len[_write] = _fill;
+    _pending = true;
+    _pendingMs = nowMs;
+    _stats.framesIn++;
+    if (!publishedBusy()) publish();
+  }
+}
+
+int MjpegRelay::addViewer(bool single) {
+  if (single && _pending && !publishedBusy()) publish();
+  if (single && _published < 0) return -1;
+  for (int i = 0; i < MAX_VIEWERS; i++) {
+    Viewer& v = _viewers[i];
+    if (v.active) continue;
+    memset(&v, 0, sizeof(v));
+    v.active = true;
+    v.single = single;
+    if (single) startFrame(v, 0);
+    return i;
+  }
+  return -1;
+}
+
+void MjpegRelay::removeViewer(int viewer) {
+  if (viewer < 0 || viewer >= MAX_VIEWERS) return;
+  _viewers[viewer].active = false;
+  _viewers[viewer].sending = false;
+  if (_pending && !publishedBusy()) publish();
+}
+
+void MjpegRelay::startFrame(Viewer& v, uint32_t nowMs) {
+  v.sending = true;
+  v.seq = _seq;
+  v.pos = 0;
+  v.headerLen = 0;
+  if (v.single) return;
+  int n = snprintf(v.header, sizeof(v.header),
+                   "--frame\r\nContent-Type: image/jpeg\r\nContent-Length: %u\r\nX-Frame-Seq: %lu\r\n"
+                   "X-Frame-Age: %lu\r\n\r\n",
+                   (unsigned)_len[_published], (unsigned long)_seq, (unsigned long)(nowMs - _publishedMs));
+  v.headerLen = (uint8_t)(n < (int)sizeof(v.header) ? n : sizeof(v.header) - 1);
+}
+
+void MjpegRelay::finishFrame(Viewer& v) {
+  v.sending = false;
+  v.done = v.single;
+  _stats.framesOut++;
+  if (_pending && !publishedBusy()) publish();
+}
+
+size_t MjpegRelay::read(int viewer, uint8_t* buf, size_t maxLen, uint32_t nowMs) {
+  if (viewer < 0 || viewer >= MAX_VIEWERS || !_viewers[viewer].active) return 0;
+  Viewer& v = _viewers[viewer];
+  if (!v.sending) {
+    if (v.done) return 0;
+    // 有更新的框等著發佈時不開始送舊框, 讓正在送的觀看者送完後立即換新
+    if (_pending && !publishedBusy()) publish();
+    if (_pending || _published < 0 || v.seq == _seq) return AGAIN;
+    startFrame(v, nowMs);
+  }
+  static const uint8_t TRAILER[2] = {'\r', '\n'};
+  size_t jpegLen = _len[_published];
+  size_t trailerLen = v.single ? 0 : sizeof(TRAILER);
+  size_t total = v.headerLen + jpegLen + trailerLen;
+  size_t n = 0;
+  while (n < maxLen && v.pos < total) {
+    const uint8_t* src;
+    size_t avail;
+    if (v.pos < v.headerLen) {
+      src = (const uint8_t*)v.header + v.pos;
+      avail = v.headerLen - v.pos;
+    } else if (v.pos < v.headerLen + jpegLen) {
+      src = _buf[_published] + (v.pos - v.headerLen);
+      avail = v.headerLen + jpegLen - v.pos;
+    } else {
+      src = TRAILER + (v.pos - v.headerLen - jpegLen);
+      avail = total - v.pos;
+    }
+    if (avail > maxLen - n) avail = maxLen - n;
+    memcpy(buf + n, src, avail);
+    n += avail;
+    v.pos += avail;
+  }
+  if (v.pos == total) finishFrame(v);
+  return n;
+}
+
+MjpegStats MjpegRelay::stats() const {
+  MjpegStats s = _stats;
+  s.viewers = 0;
+  for (const Viewer& v : _viewers) s.viewers += v.active ? 1 : 0;
+  return s;
+}
@@ -0,0 +1,100 @@
+#pragma once
+// MJPEG 轉送: 從上游 (相機節點的 multipart 串流、或串接的 JPEG 檔) 切出完整的 JPEG 框,
+// 以 multipart/x-mixed-replace 轉給多個觀看者。每個觀看者一律從最新的框開始送,
+// 慢的觀看者跳過中間的框而不是排隊 (遙控看到的必須是現在的畫面)。
+//   --frame\r\n
+//   Content-Type: image/jpeg\r\n
+//   Content-Length: <n>\r\n
+//   X-Frame-Seq: <seq>\r\n
+//   X-Frame-Age: <ms>\r\n      框完整收到到開始送出的時間
+//   \r\n<jpeg>\r\n
+// 兩個框緩衝區: 上游寫入其中一個, 觀看者讀另一個 (已發佈), 不複製到每個觀看者。
+// 觀看者送到一半時新框先暫存, 送完才發佈; 期間再來的框取代暫存的框 (superseded)。
+// 非執行緒安全: 裝置上 feed() 與 read() 都在 async_tcp 任務中呼叫。
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef MJPEG_MAX_FRAME
+#define MJPEG_MAX_FRAME 32768
+#endif
+
+struct MjpegStats {
+  uint32_t framesIn;      // 上游完整的框
+  uint32_t framesOut;     // 送給觀看者的框 (每個觀看者各算一次)
+  uint32_t oversize;      // 超過 MAX_FRAME 而丟棄
+  uint32_t superseded;    // 發佈前就被更新的框取代 (觀看者太慢)
+  uint32_t lastFrameMs;   // 最近一次發佈的時間
+  uint32_t lastFrameLen;
+  int viewers;
+};
+
+class MjpegRelay {
+public:
+  static const size_t MAX_FRAME = MJPEG_MAX_FRAME;
+  static const int MAX_VIEWERS = 4;
+  static const size_t AGAIN = (size_t)-1; // read(): 目前沒有資料, 稍後再呼叫
+  static constexpr const char* CONTENT_TYPE = "multipart/x-mixed-replace; boundary=frame";
+
+  MjpegRelay() = default;
+  MjpegRelay(const MjpegRelay&) = delete;
+  MjpegRelay& operator=(const MjpegRelay&) = delete;
+  ~MjpegRelay();
+
+  // 配置兩個框緩衝區 (第一次使用時呼叫); 失敗回傳 false
+  bool begin();
+  bool ready() const { return _buf[0] != nullptr; }
+
+  // 上游資料 (任意切割); 在 SOI (FF D8) 與 EOI (FF D9) 之間的位元組為一個框, 其餘 (multipart 標頭) 忽略
+  void feed(const uint8_t* data, size_t len, uint32_t nowMs);
+  // 上游斷線: 丟棄寫到一半的框
+  void resetUpstream();
+
+  // 新增觀看者, 回傳編號; 已滿回傳 -1。single 為 true 時只送一個框的 JPEG 本身 (/frame.jpg),
+  // 加入時就鎖定目前的框, 之後的 publishedLen() 即為其 Content-Length; 還沒有框時回傳 -1
+  int addViewer(bool single = false);
+  void removeViewer(int viewer);
+  // 已發佈的框長度 (single 觀看者的 Content-Length); 還沒有框回傳 0
+  size_t publishedLen() const { return _published < 0 ? 0 : _len[_published]; }
+  uint32_t publishedAgeMs(uint32_t nowMs) const { return _published < 0 ? 0 : nowMs - _publishedMs; }
+  uint32_t seq() const { return _seq; } // 已發佈的框編號, 有新框時遞增
+
+  // 寫出下一段輸出, 回傳位元組數; 串流觀看者沒有新框時回傳 AGAIN, single 觀看者送完回傳 0
+  size_t read(int viewer, uint8_t* buf, size_t maxLen, uint32_t nowMs);
+
+  MjpegStats stats() const;
+
+private:
+  struct Viewer {
+    bool active;
+    bool single;
+    bool sending;       // 正在送已發佈的框
+    bool done;
+    uint32_t seq;       // 最後送出的框
+    size_t pos;         // 在 (標頭 + 框 + 結尾) 中的位置
+    uint8_t headerLen;
+    char header[128];
+  };
+
+  void publish();
+  bool publishedBusy() const;
+  void startFrame(Viewer& v, uint32_t nowMs);
+  void finishFrame(Viewer& v);
+
+  uint8_t* _buf[2] = {nullptr, nullptr};
+  size_t _len[2] = {0, 0};
+  int _published = -1;        // 觀看者讀取的緩衝區
+  uint32_t _seq = 0;          // 已發佈的框編號
+  uint32_t _publishedMs = 0;
+  // 上游寫入狀態
+  int _write = 0;
+  size_t _fill = 0;
+  bool _inFrame = false;
+  bool _skip = false;         // 目前的框太大, 略過到 EOI
+  uint8_t _prev = 0;
+  bool _pending = false;      // 寫入緩衝區有完整的框, 等觀看者送完舊框再發佈
+  uint32_t _pendingMs = 0;
+
+  Viewer _viewers[MAX_VIEWERS] = {};
+  MjpegStats _stats = {};
+};
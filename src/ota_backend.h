@@ -0,0 +1,25 @@
+#pragma once
+// OTA 快閃寫入後端
+// 裝置上由 ota_backend_esp32.cpp 以 esp_ota_* 實作 (寫入非作用中的 ota_0/ota_1 分區);
+// 主機端建置 (模擬器) 提供以檔案為目標的實作。
+
+#include <stddef.h>
+#include <stdint.h>
+
+// 開啟下一個 OTA 分區準備寫入; imageSize 為 0 表示未知長度
+bool otaBackendBegin(uint32_t imageSize);
+bool otaBackendWrite(const uint8_t* data, size_t len);
+// commit=true: 驗證影像並設為下次開機分區; commit=false: 放棄本次寫入
+bool otaBackendEnd(bool commit);
+// 目標分區名稱 (例如 "ota_1")
+const char* otaBackendTargetLabel();
+// 最近一次錯誤的描述
+const char* otaBackendError();
+
+// --- 目前執行中的影像 (delta 更新的基底) ---
+const char* otaBackendRunningLabel();
+// 開機時呼叫一次: 驗證執行中的影像 (需讀完整個影像) 並快取雜湊與長度, 之後的查詢不再讀取快閃
+bool otaBackendScanRunning();
+// 影像附加的 SHA-256 (即 firmware.bin 最後 32 bytes, 建置雜湊) 與影像長度; 未掃描或驗證失敗時回傳 false
+bool otaBackendRunningImage(uint8_t sha256Out[32], uint32_t* sizeOut);
+bool otaBackendReadRunning(uint32_t offset, uint8_t* buf, size_t len);
@@ -0,0 +1,100 @@
+#ifdef ESP_PLATFORM
+
+#include "ota_backend.h"
+
+#include <esp_image_format.h>
+#include <esp_ota_ops.h>
+#include <esp_partition.h>
+#include <string.h>
+
+static const esp_partition_t* targetPartition = nullptr;
+static esp_ota_handle_t otaHandle = 0;
+static esp_err_t lastError = ESP_OK;
+
+bool otaBackendBegin(uint32_t imageSize) {
+  targetPartition = esp_ota_get_next_update_partition(NULL);
+  if (targetPartition == nullptr) {
+    lastError = ESP_ERR_NOT_FOUND;
+    return false;
+  }
+  if (imageSize > targetPartition->size) {
+    lastError = ESP_ERR_INVALID_SIZE;
+    return false;
+  }
+  // 依序寫入時逐一抹除 sector, 避免一開始就整區抹除而長時間阻塞 async_tcp 任務
+#ifdef OTA_WITH_SEQUENTIAL_WRITES
+  size_t eraseHint = OTA_WITH_SEQUENTIAL_WRITES;
+#else
+  size_t eraseHint = imageSize ? imageSize : OTA_SIZE_UNKNOWN;
+#endif
+  lastError = esp_ota_begin(targetPartition, eraseHint, &otaHandle);
+  return lastError == ESP_OK;
+}
+
+bool otaBackendWrite(const uint8_t* data, size_t len) {
+  lastError = esp_ota_write(otaHandle, data, len);
+  return lastError == ESP_OK;
+}
+
+bool otaBackendEnd(bool commit) {
+  if (!commit) {
+    esp_ota_abort(otaHandle);
+    otaHandle = 0;
+    return true;
+  }
+  // esp_ota_end 會驗證影像格式與附加的 SHA-256
+  lastError = esp_ota_end(otaHandle);
+  otaHandle = 0;
+  if (lastError != ESP_OK) return false;
+  lastError = esp_ota_set_boot_partition(targetPartition);
+  return lastError == ESP_OK;
+}
+
+const char* otaBackendTargetLabel() {
+  return targetPartition ? targetPartition->label : "none";
+}
+
+const char* otaBackendError() {
+  return esp_err_to_name(lastError);
+}
+
+const char* otaBackendRunningLabel() {
+  return esp_ota_get_running_partition()->label;
+}
+
+// setup() 中掃描一次; HTTP 處理器 (async_tcp 任務) 與 delta 更新只讀取結果
+static bool runningValid = false;
+static esp_err_t runningError = ESP_ERR_INVALID_STATE;  // 尚未掃描
+static uint8_t runningSha[32];
+static uint32_t runningSize = 0;
+
+bool otaBackendScanRunning() {
+  const esp_partition_t* running = esp_ota_get_running_partition();
+  esp_partition_pos_t pos = { running->address, running->size };
+  esp_image_metadata_t meta;
+  runningValid = false;
+  runningError = esp_image_verify(ESP_IMAGE_VERIFY_SILENT, &pos, &meta);
+  if (runningError == ESP_OK && !meta.image.hash_appended) runningError = ESP_ERR_NOT_SUPPORTED;
+  if (runningError != ESP_OK) return false;
+  memcpy(runningSha, meta.image_digest, sizeof(runningSha));
+  runningSize = meta.image_len;
+  runningValid = true;
+  return true;
+}
+
+bool otaBackendRunningImage(uint8_t sha256Out[32], uint32_t* sizeOut) {
+  if (!runningValid) {
+    lastError = runningError;
+    return false;
+  }
+  memcpy(sha256Out, runningSha, sizeof(runningSha));
+  if (sizeOut) *sizeOut = runningSize;
+  return true;
+}
+
+bool otaBackendReadRunning(uint32_t offset, uint8_t* buf, size_t len) {
+  lastError = esp_partition_read(esp_ota_get_running_partition(), offset, buf, len);
+  return lastError == ESP_OK;
+}
+
+#endif
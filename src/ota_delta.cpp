@@ -0,0 +1,164 @@
+#include "ota_delta.h"
+
+#include <string.h>
+
+#include "ota_backend.h"
+
+static uint32_t readLe32(const uint8_t* p) {
+  return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+bool DeltaPatcher::matchesMagic(const uint8_t* data, size_t len) {
+  return len >= 4 && memcmp(data, "EDLT", 4) == 0;
+}
+
+void DeltaPatcher::begin(OtaUpdater* out) {
+  _out = out;
+  _phase = HEADER;
+  _headerLen = 0;
+  _produced = 0;
+  _baseCursor = 0;
+}
+
+bool DeltaPatcher::fail(const char* reason) {
+  _phase = FAILED;
+  _out->abort(reason);
+  return false;
+}
+
+bool DeltaPatcher::startUpdate(uint32_t nowMs) {
+  if (!matchesMagic(_header, HEADER_LEN) || _header[4] != VERSION) return fail("unsupported delta patch");
+  _baseSize = readLe32(_header + 8);
+  _targetSize = readLe32(_header + 12);
+
+  uint8_t runningSha[Sha256::DIGEST_LEN];
+  uint32_t runningSize = 0;
+  if (!otaBackendRunningImage(runningSha, &runningSize)) return fail("running image hash unavailable");
+  if (memcmp(runningSha, _header + 16, Sha256::DIGEST_LEN) != 0 || _baseSize != runningSize) {
+    return fail("delta base does not match running image");
+  }
+  // 目標雜湊交給 OtaUpdater, 結束時驗證重建結果
+  if (!_out->begin(_targetSize, _header + 48, nowMs)) {
+    _phase = FAILED;
+    return false;
+  }
+  _phase = _targetSize == 0 ? DONE : OPCODE;
+  return true;
+}
+
+// 從基底 _baseCursor 複製 len bytes 到輸出
+bool DeltaPatcher::emitFromBase(uint32_t len, uint32_t nowMs) {
+  while (len > 0) {
+    uint32_t n = len < sizeof(_scratch) ? len : sizeof(_scratch);
+    if (!otaBackendReadRunning(_baseCursor, _scratch, n)) return fail(otaBackendError());
+    if (!_out->write(_scratch, n, nowMs)) {
+      _phase = FAILED;
+      return false;
+    }
+    _baseCursor += n;
+    _produced += n;
+    len -= n;
+  }
+  return true;
+}
+
+void DeltaPatcher::opFinished() {
+  _phase = _produced == _targetSize ? DONE : OPCODE;
+}
+
+// 參數讀齊後執行或準備接收資料
+bool DeltaPatcher::startOp(uint32_t nowMs) {
+  uint32_t len = _args[_argCount - 1];
+  if (len == 0 || len > _targetSize - _produced) return fail("delta op exceeds target size");
+  if (_op == OP_COPY && len > MAX_COPY) return fail("delta COPY too long");
+  if (_op == OP_INSERT) {
+    _remaining = len;
+    _phase = INSERT_DATA;
+    return true;
+  }
+  // zigzag 解碼相對位移
+  int32_t rel = (int32_t)(_args[0] >> 1) ^ -(int32_t)(_args[0] & 1);
+  int64_t offset = (int64_t)_baseCursor + rel;
+  if (offset < 0 || offset + len > _baseSize) return fail("delta op outside base image");
+  _baseCursor = (uint32_t)offset;
+  if (_op == OP_COPY) {
+    if (!emitFromBase(len, nowMs)) return false;
+    opFinished();
+    return true;
+  }
+  _remaining = len;
+  _phase = ADD_DATA;
+  return true;
+}
+
+bool DeltaPatcher::feed(const uint8_t* data, size_t len, uint32_t nowMs) {
+  while (len > 0) {
+    switch (_phase) {
+      case HEADER: {
+        size_t n = HEADER_LEN - _headerLen;
+        if (n > len) n = len;
+        memcpy(_header + _headerLen, data, n);
+        _headerLen += n; data += n; len -= n;
+        if (_headerLen == HEADER_LEN && !startUpdate(nowMs)) return false;
+        break;
+      }
+      case OPCODE:
+        _op = *data++; len--;
+        if (_op == OP_COPY || _op == OP_ADD) _argCount = 2;
+        else if (_op == OP_INSERT) _argCount = 1;
+        else return fail("bad delta opcode");
+        _argIndex = 0;
+        _varint = 0;
+        _shift = 0;
+        _phase = VARINT;
+        break;
+      case VARINT: {
+        uint8_t b = *data++; len--;
+        if (_shift > 28) return fail("bad delta varint");
+        _varint |= (uint32_t)(b & 0x7f) << _shift;
+        _shift += 7;
+        if (b & 0x80) break;
+        _args[_argIndex++] = _varint;
+        _varint = 0;
+        _shift = 0;
+        if (_argIndex == _argCount && !startOp(nowMs)) return false;
+        break;
+      }
+      case ADD_DATA: {
+        uint32_t n = _remaining;
+        if (n > len) n = len;
+        if (n > sizeof(_scratch)) n = sizeof(_scratch);
+        if (!otaBackendReadRunning(_baseCursor, _scratch, n)) return fail(otaBackendError());
+        for (uint32_t i = 0; i < n; i++) _scratch[i] += data[i];
+        if (!_out->write(_scratch, n, nowMs)) {
+          _phase = FAILED;
+          return false;
+        }
+        data += n; len -= n;
+        _baseCursor += n;
+        _produced += n;
+        _remaining -= n;
+        if (_remaining == 0) opFinished();
+        break;
+      }
+      case INSERT_DATA: {
+        uint32_t n = _remaining;
+        if (n > len) n = len;
+        if (!_out->write(data, n, nowMs)) {
+          _phase = FAILED;
+          return false;
+        }
+        data += n; len -= n;
+        _produced += n;
+        _remaining -= n;
+        if (_remaining == 0) opFinished();
+        break;
+      }
+      case DONE:
+        return fail("trailing data after delta patch");
+      case FAILED:
+        return false;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,63 @@
+#pragma once
+// Delta OTA 修補檔 (由 tools/ota_delta.py 產生)
+// 以目前執行中的影像為基底, 邊接收修補檔邊把重建的影像寫入 OtaUpdater。
+//
+// 格式 (little-endian):
+//   header (80 bytes): "EDLT" | u8 version | u8 flags | u16 reserved
+//                      | u32 baseSize | u32 targetSize
+//                      | base sha256 (基底的建置雜湊) | target sha256 (完整目標 .bin)
+//   ops, 直到產生 targetSize bytes:
+//     0x01 COPY   zigzag(offset 相對位移), len          -> 從基底複製
+//     0x02 ADD    zigzag(offset 相對位移), len, bytes[] -> 基底 + 差值 (mod 256)
+//     0x03 INSERT len, bytes[]                         -> 直接寫入
+// 位移相對於上一個 COPY/ADD 結束的基底位置; 整數為 LEB128 varint。
+// COPY 不消耗輸入, 整段在同一次 feed() (async_tcp 任務) 中讀快閃並寫入, 所以長度上限為 MAX_COPY。
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ota_update.h"
+
+class DeltaPatcher {
+public:
+  static const size_t HEADER_LEN = 80;
+  static const uint8_t VERSION = 1;
+  static const uint32_t MAX_COPY = 16384;  // 單一 COPY 的快閃讀取/抹除/寫入約 0.2 s
+
+  static bool matchesMagic(const uint8_t* data, size_t len);
+
+  void begin(OtaUpdater* out);
+  // 回傳 false 表示格式錯誤或寫入失敗, 原因已交給 OtaUpdater
+  bool feed(const uint8_t* data, size_t len, uint32_t nowMs);
+  bool complete() const { return _phase == DONE; }
+
+private:
+  enum Phase : uint8_t { HEADER, OPCODE, VARINT, ADD_DATA, INSERT_DATA, DONE, FAILED };
+
+  bool fail(const char* reason);
+  bool startUpdate(uint32_t nowMs);
+  bool startOp(uint32_t nowMs);
+  bool emitFromBase(uint32_t len, uint32_t nowMs);
+  void opFinished();
+
+  enum : uint8_t { OP_COPY = 1, OP_ADD = 2, OP_INSERT = 3 };
+
+  OtaUpdater* _out = nullptr;
+  Phase _phase = HEADER;
+  uint8_t _header[HEADER_LEN];
+  size_t _headerLen = 0;
+  uint32_t _baseSize = 0;
+  uint32_t _targetSize = 0;
+  uint32_t _produced = 0;
+  uint32_t _baseCursor = 0;
+
+  uint8_t _op = 0;
+  uint8_t _argCount = 0;
+  uint8_t _argIndex = 0;
+  uint32_t _args[2];
+  uint32_t _varint = 0;
+  uint8_t _shift = 0;
+  uint32_t _remaining = 0;
+
+  uint8_t _scratch[512];
+};
@@ -0,0 +1,148 @@
+#include "ota_stream.h"
+
+#include <string.h>
+
+static const uint8_t ESP_IMAGE_MAGIC = 0xE9;
+static const uint8_t CONTAINER_VERSION = 1;
+
+static uint32_t readLe32(const uint8_t* p) {
+  return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+bool OtaStream::begin(uint32_t transferSize, const uint8_t* imageSha256, uint32_t nowMs) {
+  if (active() || _updater.active()) return false;
+  _haveImageSha = imageSha256 != nullptr;
+  if (_haveImageSha) memcpy(_imageSha, imageSha256, sizeof(_imageSha));
+  _transferSize = transferSize;
+  _payloadSize = transferSize;
+  _received = 0;
+  _containerLen = 0;
+  _containerChecked = false;
+  _compressed = false;
+  _sniffLen = 0;
+  _format = UNKNOWN;
+  _nowMs = nowMs;
+  _phase = SNIFF;
+  return true;
+}
+
+// 壓縮容器標頭讀齊後設定解壓器; 內容的雜湊與長度改用容器提供的值
+bool OtaStream::startContainer() {
+  if (_container[4] != CONTAINER_VERSION ||
+      !_lzss.begin(_container[5], _container[6], readLe32(_container + 8), &OtaStream::inflated, this)) {
+    abort("unsupported compressed update");
+    return false;
+  }
+  _payloadSize = readLe32(_container + 8);
+  memcpy(_imageSha, _container + 12, sizeof(_imageSha));
+  _haveImageSha = true;
+  return true;
+}
+
+bool OtaStream::inflated(void* ctx, const uint8_t* data, size_t len) {
+  return static_cast<OtaStream*>(ctx)->payload(data, len);
+}
+
+bool OtaStream::startFormat() {
+  if (_sniff[0] == ESP_IMAGE_MAGIC) {
+    if (!_haveImageSha) {
+      abort("missing or malformed X-Image-SHA256 header");
+      return false;
+    }
+    _format = IMAGE;
+    if (!_updater.begin(_payloadSize, _imageSha, _nowMs)) {
+      _phase = ENDED;
+      return false;
+    }
+  } else if (DeltaPatcher::matchesMagic(_sniff, _sniffLen)) {
+    _format = DELTA;
+    _delta.begin(&_updater);
+  } else {
+    abort("unknown update format");
+    return false;
+  }
+  _phase = STREAM;
+  return route(_sniff, _sniffLen);
+}
+
+bool OtaStream::route(const uint8_t* data, size_t len) {
+  bool ok = _format == DELTA ? _delta.feed(data, len, _nowMs) : _updater.write(data, len, _nowMs);
+  if (!ok) _phase = ENDED;
+  return ok;
+}
+
+// 未壓縮 (或已解壓) 的內容: 先判斷格式再轉交
+bool OtaStream::payload(const uint8_t* data, size_t len) {
+  if (_format == UNKNOWN) {
+    size_t n = SNIFF_LEN - _sniffLen;
+    if (n > len) n = len;
+    memcpy(_sniff + _sniffLen, data, n);
+    _sniffLen += n; data += n; len -= n;
+    if (_sniffLen < SNIFF_LEN) return true;
+    if (!startFormat()) return false;
+  }
+  return len == 0 || route(data, len);
+}
+
+bool OtaStream::write(const uint8_t* data, size_t len, uint32_t nowMs) {
+  if (!active()) return false;
+  _received += len;
+  _nowMs = nowMs;
+  while (!_containerChecked && len > 0) {
+    // 先收集足夠判斷是否為壓縮容器的位元組, 是的話再收完整個容器標頭
+    bool isContainer = _containerLen >= SNIFF_LEN && memcmp(_container, "EHSZ", SNIFF_LEN) == 0;
+    size_t want = isContainer ? CONTAINER_HEADER_LEN : SNIFF_LEN;
+    size_t n = want - _containerLen;
+    if (n > len) n = len;
+    memcpy(_container + _containerLen, data, n);
+    _containerLen += n; data += n; len -= n;
+    if (_containerLen < want) continue;
+    if (!isContainer && memcmp(_container, "EHSZ", SNIFF_LEN) == 0) continue;
+    _containerChecked = true;
+    if (isContainer) {
+      _compressed = true;
+      if (!startContainer()) return false;
+    } else if (!payload(_container, _containerLen)) {
+      return false;
+    }
+  }
+  if (len == 0) return true;
+  if (!_compressed) return payload(data, len);
+  if (!_lzss.feed(data, len)) {
+    if (active()) abort("compressed stream corrupt");
+    return false;
+  }
+  return true;
+}
+
+bool OtaStream::finish(uint32_t nowMs) {
+  if (!active()) return false;
+  _nowMs = nowMs;
+  if (_compressed && (!_lzss.flush() || !_lzss.complete())) {
+    if (active()) abort("compressed stream truncated");
+    return false;
+  }
+  if (_format == UNKNOWN) {
+    abort("update body too short");
+    return false;
+  }
+  if (_format == DELTA && !_delta.complete()) {
+    abort("delta patch truncated");
+    return false;
+  }
+  _phase = ENDED;
+  return _updater.finish(nowMs);
+}
+
+void OtaStream::abort(const char* reason) {
+  _phase = ENDED;
+  _updater.abort(reason);
+}
+
+const char* OtaStream::formatName() const {
+  switch (_format) {
+    case IMAGE: return _compressed ? "lzss+image" : "image";
+    case DELTA: return _compressed ? "lzss+delta" : "delta";
+    default: return _compressed ? "lzss" : "unknown";
+  }
+}
@@ -0,0 +1,64 @@
+#pragma once
+// OTA 上傳內容的格式分派
+// 依前幾個 bytes 判斷上傳的是完整影像 (0xE9 開頭) 或 delta 修補檔 ("EDLT"),
+// 再交給 OtaUpdater 或 DeltaPatcher。HTTP 層只需要把 body 依序餵進來。
+//
+// 兩種內容都可以再包一層 LZSS 壓縮容器 (tools/ota_pack.py), 邊收邊解壓:
+//   "EHSZ" | u8 version | u8 windowBits | u8 lookaheadBits | u8 reserved
+//   | u32 rawSize | raw sha256 (解壓後內容) | 壓縮位元流
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "lzss_decoder.h"
+#include "ota_delta.h"
+#include "ota_update.h"
+
+class OtaStream {
+public:
+  explicit OtaStream(OtaUpdater& updater) : _updater(updater) {}
+
+  // transferSize: HTTP body 長度 (0 = 未知)
+  // imageSha256: 未壓縮的完整影像必須提供 (X-Image-SHA256); 修補檔與壓縮容器自帶雜湊, 可為 nullptr
+  bool begin(uint32_t transferSize, const uint8_t* imageSha256, uint32_t nowMs);
+  bool write(const uint8_t* data, size_t len, uint32_t nowMs);
+  bool finish(uint32_t nowMs);
+  void abort(const char* reason);
+
+  // 包含尚未判斷格式的階段 (此時 OtaUpdater 還沒開始)
+  bool active() const { return _phase == SNIFF || _phase == STREAM; }
+  const char* formatName() const;
+  uint32_t received() const { return _received; }
+  uint32_t transferSize() const { return _transferSize; }
+
+private:
+  enum Phase : uint8_t { IDLE, SNIFF, STREAM, ENDED };
+  enum Format : uint8_t { UNKNOWN, IMAGE, DELTA };
+
+  static const size_t SNIFF_LEN = 4;
+  static const size_t CONTAINER_HEADER_LEN = 44;
+
+  bool startContainer();
+  bool payload(const uint8_t* data, size_t len);
+  bool startFormat();
+  bool route(const uint8_t* data, size_t len);
+  static bool inflated(void* ctx, const uint8_t* data, size_t len);
+
+  OtaUpdater& _updater;
+  DeltaPatcher _delta;
+  LzssDecoder _lzss;
+  volatile Phase _phase = IDLE;
+  Format _format = UNKNOWN;
+  bool _compressed = false;
+  bool _containerChecked = false;
+  uint8_t _imageSha[Sha256::DIGEST_LEN];
+  bool _haveImageSha = false;
+  uint8_t _container[CONTAINER_HEADER_LEN];
+  size_t _containerLen = 0;
+  uint32_t _payloadSize = 0;
+  uint8_t _sniff[SNIFF_LEN];
+  size_t _sniffLen = 0;
+  volatile uint32_t _received = 0;
+  uint32_t _transferSize = 0;
+  uint32_t _nowMs = 0;
+};
@@ -0,0 +1,91 @@
+#include "ota_update.h"
+
+#include <string.h>
+
+#include "ota_backend.h"
+
+bool OtaUpdater::begin(uint32_t totalSize, const uint8_t expectedSha256[Sha256::DIGEST_LEN], uint32_t nowMs) {
+  if (active()) {
+    _error = "update already in progress";
+    return false;
+  }
+  memcpy(_expected, expectedSha256, Sha256::DIGEST_LEN);
+  memset(_digest, 0, sizeof(_digest));
+  _sha.reset();
+  _written = 0;
+  _total = totalSize;
+  _startMs = _lastMs = nowMs;
+  _error = "";
+  if (!otaBackendBegin(totalSize)) {
+    fail(otaBackendError());
+    return false;
+  }
+  _state = OtaState::WRITING;
+  return true;
+}
+
+bool OtaUpdater::write(const uint8_t* data, size_t len, uint32_t nowMs) {
+  if (!active()) return false;
+  if (_total != 0 && _written + len > _total) {
+    abort("image larger than announced size");
+    return false;
+  }
+  _sha.update(data, len);
+  if (!otaBackendWrite(data, len)) {
+    abort(otaBackendError());
+    return false;
+  }
+  _written += len;
+  _lastMs = nowMs;
+  return true;
+}
+
+bool OtaUpdater::finish(uint32_t nowMs) {
+  if (!active()) return false;
+  _lastMs = nowMs;
+  if (_total != 0 && _written != _total) {
+    abort("image truncated");
+    return false;
+  }
+  _sha.finish(_digest);
+  if (memcmp(_digest, _expected, Sha256::DIGEST_LEN) != 0) {
+    abort("sha256 mismatch");
+    return false;
+  }
+  if (!otaBackendEnd(true)) {
+    fail(otaBackendError());
+    return false;
+  }
+  _state = OtaState::DONE;
+  return true;
+}
+
+void OtaUpdater::abort(const char* reason) {
+  if (active()) otaBackendEnd(false);
+  fail(reason);
+}
+
+void OtaUpdater::fail(const char* reason) {
+  _error = reason;
+  _state = OtaState::FAILED;
+}
+
+OtaProgress OtaUpdater::progress() const {
+  OtaProgress p;
+  p.state = _state;
+  p.written = _written;
+  p.total = _total;
+  p.elapsedMs = _lastMs - _startMs;
+  p.bytesPerSec = p.elapsedMs ? (uint32_t)((uint64_t)p.written * 1000 / p.elapsedMs) : 0;
+  return p;
+}
+
+const char* OtaUpdater::stateName(OtaState s) {
+  switch (s) {
+    case OtaState::IDLE: return "idle";
+    case OtaState::WRITING: return "writing";
+    case OtaState::DONE: return "done";
+    case OtaState::FAILED: return "failed";
+  }
+  return "?";
+}
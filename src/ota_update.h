@@ -0,0 +1,51 @@
+#pragma once
+// 串流式 OTA 更新 (HTTP POST /update)
+// 邊接收邊寫入非作用中的 OTA 分區, 同時增量計算 SHA-256; 不緩衝完整影像。
+// 寫入在 async_tcp 任務中進行, 進度以 progress() 快照交給 loop() 發佈。
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sha256.h"
+
+enum class OtaState : uint8_t { IDLE, WRITING, DONE, FAILED };
+
+struct OtaProgress {
+  OtaState state;
+  uint32_t written;     // 已寫入快閃的位元組
+  uint32_t total;       // 預期總長度 (0 = 未知)
+  uint32_t elapsedMs;
+  uint32_t bytesPerSec; // 平均寫入速率
+};
+
+class OtaUpdater {
+public:
+  // expectedSha256: 影像的 32 bytes SHA-256, 結束時比對
+  bool begin(uint32_t totalSize, const uint8_t expectedSha256[Sha256::DIGEST_LEN], uint32_t nowMs);
+  bool write(const uint8_t* data, size_t len, uint32_t nowMs);
+  // 比對雜湊並交由後端驗證/切換開機分區
+  bool finish(uint32_t nowMs);
+  void abort(const char* reason);
+
+  bool active() const { return _state == OtaState::WRITING; }
+  OtaState state() const { return _state; }
+  OtaProgress progress() const;
+  const char* error() const { return _error; }
+  // 實際計算出的雜湊 (finish() 之後有效)
+  const uint8_t* digest() const { return _digest; }
+
+  static const char* stateName(OtaState s);
+
+private:
+  void fail(const char* reason);
+
+  Sha256 _sha;
+  uint8_t _expected[Sha256::DIGEST_LEN];
+  uint8_t _digest[Sha256::DIGEST_LEN];
+  volatile OtaState _state = OtaState::IDLE;
+  volatile uint32_t _written = 0;
+  uint32_t _total = 0;
+  uint32_t _startMs = 0;
+  volatile uint32_t _lastMs = 0;
+  const char* _error = "";
+};
@@ -0,0 +1,134 @@
+#include "sha256.h"
+
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+
+#include <mbedtls/version.h>
+
+Sha256::Sha256() { mbedtls_sha256_init(&_ctx); reset(); }
+Sha256::~Sha256() { mbedtls_sha256_free(&_ctx); }
+
+#if MBEDTLS_VERSION_NUMBER >= 0x03000000
+// mbedtls 3.x (IDF 5): *_ret 版本已移除, 原名稱改為回傳錯誤碼
+void Sha256::reset() { mbedtls_sha256_starts(&_ctx, 0); }
+
+void Sha256::update(const uint8_t* data, size_t len) { mbedtls_sha256_update(&_ctx, data, len); }
+
+void Sha256::finish(uint8_t out[DIGEST_LEN]) { mbedtls_sha256_finish(&_ctx, out); }
+#else
+// mbedtls 2.x (IDF 4.4, Arduino-ESP32 2.x): 不回傳錯誤碼的 mbedtls_sha256_starts() 等已棄用
+void Sha256::reset() { mbedtls_sha256_starts_ret(&_ctx, 0); }
+
+void Sha256::update(const uint8_t* data, size_t len) { mbedtls_sha256_update_ret(&_ctx, data, len); }
+
+void Sha256::finish(uint8_t out[DIGEST_LEN]) { mbedtls_sha256_finish_ret(&_ctx, out); }
+#endif
+
+#else
+
+// --- 可攜實作 (FIPS 180-4), 僅供主機端建置使用 ---
+static const uint32_t K[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static inline uint32_t rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+Sha256::Sha256() { reset(); }
+Sha256::~Sha256() {}
+
+void Sha256::reset() {
+  static const uint32_t H0[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+  };
+  memcpy(_state, H0, sizeof(_state));
+  _bitLen = 0;
+  _bufLen = 0;
+}
+
+void Sha256::transform(const uint8_t* block) {
+  uint32_t w[64];
+  for (int i = 0; i < 16; i++) {
+    w[i] = (uint32_t)block[i * 4] << 24 | (uint32_t)block[i * 4 + 1] << 16 |
+           (uint32_t)block[i * 4 + 2] << 8 | (uint32_t)block[i * 4 + 3];
+  }
+  for (int i = 16; i < 64; i++) {
+    uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+    uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+    w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+  }
+  uint32_t a = _state[0], b = _state[1], c = _state[2], d = _state[3];
+  uint32_t e = _state[4], f = _state[5], g = _state[6], h = _state[7];
+  for (int i = 0; i < 64; i++) {
+    uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + K[i] + w[i];
+    uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+    h = g; g = f; f = e; e = d + t1;
+    d = c; c = b; b = a; a = t1 + t2;
+  }
+  _state[0] += a; _state[1] += b; _state[2] += c; _state[3] += d;
+  _state[4] += e; _state[5] += f; _state[6] += g; _state[7] += h;
+}
+
+void Sha256::update(const uint8_t* data, size_t len) {
+  _bitLen += (uint64_t)len * 8;
+  while (len > 0) {
+    size_t n = 64 - _bufLen;
+    if (n > len) n = len;
+    memcpy(_buf + _bufLen, data, n);
+    _bufLen += n; data += n; len -= n;
+    if (_bufLen == 64) { transform(_buf); _bufLen = 0; }
+  }
+}
+
+void Sha256::finish(uint8_t out[DIGEST_LEN]) {
+  uint64_t bitLen = _bitLen;
+  uint8_t pad = 0x80;
+  update(&pad, 1);
+  pad = 0;
+  while (_bufLen != 56) update(&pad, 1);
+  uint8_t lenBytes[8];
+  for (int i = 0; i < 8; i++) lenBytes[i] = (uint8_t)(bitLen >> (56 - 8 * i));
+  update(lenBytes, 8);
+  for (int i = 0; i < 8; i++) {
+    out[i * 4] = (uint8_t)(_state[i] >> 24);
+    out[i * 4 + 1] = (uint8_t)(_state[i] >> 16);
+    out[i * 4 + 2] = (uint8_t)(_state[i] >> 8);
+    out[i * 4 + 3] = (uint8_t)_state[i];
+  }
+}
+
+#endif
+
+void Sha256::toHex(const uint8_t digest[DIGEST_LEN], char out[DIGEST_LEN * 2 + 1]) {
+  static const char HEX_CHARS[] = "0123456789abcdef";
+  for (size_t i = 0; i < DIGEST_LEN; i++) {
+    out[i * 2] = HEX_CHARS[digest[i] >> 4];
+    out[i * 2 + 1] = HEX_CHARS[digest[i] & 0x0f];
+  }
+  out[DIGEST_LEN * 2] = '\0';
+}
+
+static int hexNibble(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+bool Sha256::fromHex(const char* hex, uint8_t out[DIGEST_LEN]) {
+  if (hex == nullptr || strlen(hex) != DIGEST_LEN * 2) return false;
+  for (size_t i = 0; i < DIGEST_LEN; i++) {
+    int hi = hexNibble(hex[i * 2]);
+    int lo = hexNibble(hex[i * 2 + 1]);
+    if (hi < 0 || lo < 0) return false;
+    out[i] = (uint8_t)(hi << 4 | lo);
+  }
+  return true;
+}
@@ -0,0 +1,38 @@
+#pragma once
+// 增量 SHA-256 計算
+// 裝置上使用 mbedtls (ESP32-C3 有 SHA 硬體加速), 主機端編譯時使用內建的可攜實作。
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef ESP_PLATFORM
+#include <mbedtls/sha256.h>
+#endif
+
+class Sha256 {
+public:
+  static const size_t DIGEST_LEN = 32;
+
+  Sha256();
+  ~Sha256();
+
+  void reset();
+  void update(const uint8_t* data, size_t len);
+  void finish(uint8_t out[DIGEST_LEN]);
+
+  // 64 字元小寫十六進位 (+ 結尾 '\0')
+  static void toHex(const uint8_t digest[DIGEST_LEN], char out[DIGEST_LEN * 2 + 1]);
+  // 接受大小寫; 長度或字元不合法時回傳 false
+  static bool fromHex(const char* hex, uint8_t out[DIGEST_LEN]);
+
+private:
+#ifdef ESP_PLATFORM
+  mbedtls_sha256_context _ctx;
+#else
+  void transform(const uint8_t* block);
+  uint32_t _state[8];
+  uint64_t _bitLen;
+  uint8_t _buf[64];
+  size_t _bufLen;
+#endif
+};
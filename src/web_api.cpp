@@ -0,0 +1,353 @@
+#include "web_api.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "car_variant.h"
+#include "hal.h"
+#include "ota_backend.h"
+
+static void lockEnter(const WebLock& lock) {
+  if (lock.enter) lock.enter(lock.ctx);
+}
+
+static void lockExit(const WebLock& lock) {
+  if (lock.exit) lock.exit(lock.ctx);
+}
+
+// 回覆本文; 回傳狀態碼方便處理器直接 return
+static int reply200(const char* body, char* reply, size_t maxLen) {
+  snprintf(reply, maxLen, "%s", body);
+  return 200;
+}
+
+int apiError(int code, const char* error, char* reply, size_t maxLen) {
+  snprintf(reply, maxLen, "{\"error\":\"%s\"}", error);
+  return code;
+}
+
+// --- car 狀態快照 ---
+
+void StatusBoard::publish(const CarControl& car, uint32_t nowMs, bool rebuild) {
+  if (rebuild || (int32_t)(nowMs - _dueMs) >= 0) {
+    _dueMs = nowMs + PERIOD_MS;
+    car.missionJson(_mission, sizeof(_mission));
+    if (car.latencyJson(_latency, sizeof(_latency)) == 0) _latency[0] = '\0';
+    rebuild = true;
+  }
+  lockEnter(_lock);
+  _shared.mode = car.mode();
+  _shared.stats = car.stats();
+  if (rebuild) {
+    memcpy(_shared.mission, _mission, sizeof(_mission));
+    memcpy(_shared.latency, _latency, sizeof(_latency));
+  }
+  lockExit(_lock);
+}
+
+DriveMode StatusBoard::mode() const {
+  lockEnter(_lock);
+  DriveMode mode = _shared.mode;
+  lockExit(_lock);
+  return mode;
+}
+
+ControlStats StatusBoard::stats(DriveMode* mode) const {
+  lockEnter(_lock);
+  ControlStats stats = _shared.stats;
+  *mode = _shared.mode;
+  lockExit(_lock);
+  return stats;
+}
+
+int StatusBoard::missionReply(char* reply, size_t maxLen) const {
+  lockEnter(_lock);
+  snprintf(reply, maxLen, "%s", _shared.mission);
+  lockExit(_lock);
+  return 200;
+}
+
+int StatusBoard::latencyReply(char* reply, size_t maxLen) const {
+  lockEnter(_lock);
+  bool ok = _shared.latency[0] != '\0' && strlen(_shared.latency) < maxLen;
+  if (ok) memcpy(reply, _shared.latency, strlen(_shared.latency) + 1);
+  lockExit(_lock);
+  return ok ? 200 : apiError(500, "buffer", reply, maxLen);
+}
+
+// --- REST 控制 ---
+
+int apiDrive(ApiQueue* q, DriveMode mode, const char* body, size_t len, char* reply, size_t maxLen) {
+  DriveSetpoint sp;
+  const char* err = parseDriveRequest(body, len, &sp);
+  if (err) return apiError(400, err, reply, maxLen);
+  if (mode != MANUAL) {
+    return apiError(409, mode == AUTO ? "AUTO mode, switch to MANUAL first" : "CALIBRATE mode, switch to MANUAL first",
+                    reply, maxLen);
+  }
+  lockEnter(q->lock);
+  q->pending.setpoint = sp;
+  q->pending.drive = true;
+  lockExit(q->lock);
+  return reply200("{\"ok\":true}", reply, maxLen);
+}
+
+int apiMode(ApiQueue* q, const char* body, size_t len, char* reply, size_t maxLen) {
+  DriveMode mode;
+  const char* err = parseModeRequest(body, len, &mode);
+  if (err) return apiError(400, err, reply, maxLen);
+  lockEnter(q->lock);
+  q->pending.newMode = mode;
+  q->pending.mode = true;
+  lockExit(q->lock);
+  return reply200(mode == AUTO ? "{\"ok\":true,\"mode\":\"AUTO\"}" : "{\"ok\":true,\"mode\":\"MANUAL\"}", reply, maxLen);
+}
+
+int apiStop(ApiQueue* q, char* reply, size_t maxLen) {
+  lockEnter(q->lock);
+  q->pending.drive = q->pending.mode = q->pending.mission = false;
+  q->pending.stop = true;
+  lockExit(q->lock);
+  return reply200("{\"ok\":true}", reply, maxLen);
+}
+
+int apiMission(ApiQueue* q, bool updating, const char* body, size_t len, char* reply, size_t maxLen) {
+  MissionSegment segments[MAX_MISSION_SEGMENTS];
+  int count;
+  const char* err = parseMissionRequest(body, len, segments, MAX_MISSION_SEGMENTS, &count);
+  if (err) return apiError(400, err, reply, maxLen);
+  if (updating) return apiError(409, "update in progress", reply, maxLen);
+  uint32_t total = 0;
+  for (int i = 0; i < count; i++) total += segments[i].ms;
+  lockEnter(q->lock);
+  memcpy(q->pending.segments, segments, sizeof(MissionSegment) * count);
+  q->pending.missionLen = count;
+  q->pending.mission = true;
+  lockExit(q->lock);
+  snprintf(reply, maxLen, "{\"ok\":true,\"segments\":%d,\"total_ms\":%lu}", count, (unsigned long)total);
+  return 200;
+}
+
+bool apiApply(ApiQueue* q, CarControl& car) {
+  ApiPending& p = q->pending;
+  MissionSegment segments[MAX_MISSION_SEGMENTS];
+  lockEnter(q->lock);
+  bool stop = p.stop, mode = p.mode, drive = p.drive, mission = p.mission;
+  DriveMode newMode = p.newMode;
+  DriveSetpoint sp = p.setpoint;
+  int missionLen = p.missionLen;
+  if (mission) memcpy(segments, p.segments, sizeof(MissionSegment) * missionLen);
+  p.stop = p.mode = p.drive = p.mission = false;
+  lockExit(q->lock);
+  if (stop) car.emergencyStop();
+  if (mode) car.setMode(newMode);
+  if (mission && !car.startMission(segments, missionLen)) halLog("Mission rejected: drive locked");
+  if (drive) car.drive(sp.throttle, sp.steer, sp.hasT ? &sp.t : nullptr);
+  return stop || mode || mission || drive;
+}
+
+// --- 執行期設定 ---
+
+bool configStage(ConfigStore* store, const WebLock& lock, const char* json, size_t len, char* reply, size_t maxLen,
+                 char* err, size_t errLen) {
+  lockEnter(lock);
+  CarConfig running = store->active();
+  CarConfig cfg = store->latest();
+  lockExit(lock);
+  if (!ConfigStore::parse(json, len, running, &cfg, err, errLen)) return false;
+  lockEnter(lock);
+  if (!ConfigStore::same(cfg, store->latest())) store->stage(cfg);
+  ConfigStore snapshot = *store;
+  lockExit(lock);
+  snapshot.toJson(reply, maxLen);
+  return true;
+}
+
+size_t configWsReply(ConfigStore* store, const WebLock& lock, const char* json, size_t len, char* reply, size_t maxLen) {
+  char err[96];
+  if (!configStage(store, lock, json, len, reply, maxLen, err, sizeof(err))) {
+    snprintf(reply, maxLen, "{\"cfg\":null,\"error\":\"%s\"}", err);
+  }
+  return strlen(reply);
+}
+
+int apiConfigPost(ConfigStore* store, const WebLock& lock, const char* body, size_t len, char* reply, size_t maxLen) {
+  char err[96];
+  if (!configStage(store, lock, body, len, reply, maxLen, err, sizeof(err))) return apiError(400, err, reply, maxLen);
+  return 200;
+}
+
+int apiConfigGet(const ConfigStore& store, const WebLock& lock, char* reply, size_t maxLen) {
+  lockEnter(lock);
+  ConfigStore snapshot = store;
+  lockExit(lock);
+  snapshot.toJson(reply, maxLen);
+  return 200;
+}
+
+// --- 健康檢查 ---
+
+size_t healthJson(const HealthInfo& info, const StatusBoard& status, char* buf, size_t maxLen) {
+  DriveMode mode;
+  ControlStats ws = status.stats(&mode);
+  char shaHex[Sha256::DIGEST_LEN * 2 + 1];
+  runningShaHex(shaHex, nullptr);
+  char dropped[32] = "";
+  if (info.wsDropped >= 0) snprintf(dropped, sizeof(dropped), ",\"dropped\":%llu", (unsigned long long)info.wsDropped);
+  int n = snprintf(buf, maxLen,
+                   "{\"ok\":true,\"uptime_ms\":%lu,\"version\":\"%s\",\"variant\":\"%s\",\"build_sha256\":\"%s\",\"running\":\"%s\","
+                   "\"mode\":\"%s\",\"ota\":\"%s\",\"selftest\":\"%s\",\"rssi\":%d,\"reset_reason\":%d,\"heap\":%lu,"
+                   "\"ws\":{\"clients\":%u,\"frames\":%lu,\"applied\":%lu,\"ignored\":%lu,\"errors\":%lu,\"tx_fail\":%lu%s},"
+                   "\"sse\":{\"subs\":%d,\"sent\":%lu,\"dropped\":%lu}}",
+                   (unsigned long)info.uptimeMs, info.version, variant::NAME, shaHex, otaBackendRunningLabel(),
+                   driveModeName(mode), info.otaState, info.selftest, info.rssi, info.resetReason,
+                   (unsigned long)info.heap, info.wsClients, (unsigned long)ws.frames, (unsigned long)ws.applied,
+                   (unsigned long)ws.ignored, (unsigned long)ws.parseErrors, (unsigned long)ws.txFailures, dropped,
+                   info.sse.subscribers, (unsigned long)info.sse.sent, (unsigned long)info.sse.dropped);
+  return n > 0 && (size_t)n < maxLen ? (size_t)n : 0;
+}
+
+bool runningShaHex(char hex[Sha256::DIGEST_LEN * 2 + 1], uint32_t* size) {
+  uint8_t sha[Sha256::DIGEST_LEN];
+  hex[0] = '\0';
+  if (!otaBackendRunningImage(sha, size)) return false;
+  Sha256::toHex(sha, hex);
+  return true;
+}
+
+// --- HTTP OTA ---
+
+bool otaUploadBegin(OtaStream& stream, OtaUpdater& updater, const char* shaHeader, size_t total, uint32_t nowMs,
+                    void (*stopMotors)()) {
+  if (stream.active()) return false;
+  uint8_t expected[Sha256::DIGEST_LEN];
+  bool haveSha = shaHeader != nullptr && Sha256::fromHex(shaHeader, expected);
+  if (shaHeader != nullptr && !haveSha) {
+    updater.abort("malformed X-Image-SHA256 header");
+    return false;
+  }
+  // 更新期間馬達保持停止: 這裡只拉低 STBY, 鎖定與 holdSafe() 由 loop() 接手
+  stopMotors();
+  return stream.begin(total, haveSha ? expected : nullptr, nowMs);
+}
+
+int otaUpdateReply(OtaStream& stream, OtaUpdater& updater, bool owner, uint32_t nowMs, bool* ok, char* reply,
+                   size_t maxLen) {
+  *ok = false;
+  if (!owner) {
+    bool busy = stream.active();
+    snprintf(reply, maxLen, "{\"ok\":false,\"error\":\"%s\"}", busy ? "update already in progress" : updater.error());
+    return busy ? 409 : 400;
+  }
+  *ok = stream.finish(nowMs);
+  OtaProgress p = updater.progress();
+  char digest[Sha256::DIGEST_LEN * 2 + 1];
+  Sha256::toHex(updater.digest(), digest);
+  snprintf(reply, maxLen,
+           "{\"ok\":%s,\"format\":\"%s\",\"received\":%lu,\"bytes\":%lu,\"ms\":%lu,\"sha256\":\"%s\",\"error\":\"%s\"}",
+           *ok ? "true" : "false", stream.formatName(), (unsigned long)stream.received(), (unsigned long)p.written,
+           (unsigned long)p.elapsedMs, digest, updater.error());
+  return *ok ? 200 : 400;
+}
+
+size_t otaInfoJson(const char* next, const char* version, const char* built, char* buf, size_t maxLen) {
+  uint32_t size = 0;
+  char shaHex[Sha256::DIGEST_LEN * 2 + 1];
+  runningShaHex(shaHex, &size);
+  int n = snprintf(buf, maxLen,
+                   "{\"running\":\"%s\",\"next\":\"%s\",\"version\":\"%s\",\"built\":\"%s\",\"size\":%lu,\"build_sha256\":\"%s\"}",
+                   otaBackendRunningLabel(), next, version, built, (unsigned long)size, shaHex);
+  return n > 0 && (size_t)n < maxLen ? (size_t)n : 0;
+}
+
+size_t OtaProgressFeed::next(const OtaStream& stream, const OtaUpdater& updater, uint32_t nowMs, char* buf,
+                             size_t maxLen, char* log, size_t logLen) {
+  log[0] = '\0';
+  OtaProgress p = updater.progress();
+  bool stateChanged = p.state != _lastState;
+  if (!stateChanged && (p.state != OtaState::WRITING || nowMs - _lastPublish < PERIOD_MS)) return 0;
+  _lastState = p.state;
+  _lastPublish = nowMs;
+  if (stateChanged) {
+    snprintf(log, logLen, "HTTP OTA: %s -> %s (%lu bytes)", OtaUpdater::stateName(p.state), otaBackendTargetLabel(),
+             (unsigned long)p.written);
+  }
+  int n = snprintf(buf, maxLen,
+                   "{\"ota\":{\"state\":\"%s\",\"format\":\"%s\",\"rx\":%lu,\"bytes\":%lu,\"total\":%lu,\"ms\":%lu,\"Bps\":%lu,\"error\":\"%s\"}}",
+                   OtaUpdater::stateName(p.state), stream.formatName(), (unsigned long)stream.received(),
+                   (unsigned long)p.written, (unsigned long)p.total, (unsigned long)p.elapsedMs,
+                   (unsigned long)p.bytesPerSec, updater.error());
+  return n > 0 && (size_t)n < maxLen ? (size_t)n : 0;
+}
+
+// --- 控制流量擷取 ---
+
+int captureStatusReply(const CaptureLog& capture, const char* state, char* reply, size_t maxLen) {
+  snprintf(reply, maxLen, "{\"capture\":\"%s\",\"records\":%lu,\"overwritten\":%lu,\"bytes\":%lu}", state,
+           (unsigned long)capture.records(), (unsigned long)capture.overwritten(), (unsigned long)capture.bytesUsed());
+  return 200;
+}
+
+int captureDownloadCheck(const CaptureLog& capture, uint8_t request, char* reply, size_t maxLen) {
+  if (capture.active() || request != CAPTURE_REQ_NONE) {
+    return apiError(409, "capture running, POST /capture/stop first", reply, maxLen);
+  }
+  if (maxLen) reply[0] = '\0';
+  return 200;
+}
+
+void captureApply(CaptureLog& capture, uint8_t request, uint32_t nowMs) {
+  if (request == CAPTURE_REQ_START) {
+    capture.start(nowMs);
+    halLog("Capture started");
+  } else if (request == CAPTURE_REQ_STOP && capture.active()) {
+    capture.stop();
+    char msg[48];
+    snprintf(msg, sizeof(msg), "Capture stopped: %lu records", (unsigned long)capture.records());
+    halLog(msg);
+  }
+}
+
+// --- 影像轉送 ---
+
+size_t videoInfoJson(const MjpegRelay& video, const char* source, const char* upstream, uint32_t nowMs, char* buf,
+                     size_t maxLen) {
+  MjpegStats st = video.stats();
+  int n = snprintf(buf, maxLen,
+                   "{\"source\":\"%s\",\"upstream\":\"%s\",\"frames_in\":%lu,\"frames_out\":%lu,\"superseded\":%lu,"
+                   "\"oversize\":%lu,\"viewers\":%d,\"age_ms\":%lu,\"frame_bytes\":%lu}",
+                   source, upstream, (unsigned long)st.framesIn, (unsigned long)st.framesOut,
+                   (unsigned long)st.superseded, (unsigned long)st.oversize, st.viewers,
+                   (unsigned long)video.publishedAgeMs(nowMs), (unsigned long)st.lastFrameLen);
+  return n > 0 && (size_t)n < maxLen ? (size_t)n : 0;
+}
+
+// --- 車隊 ---
+
+size_t peersJson(const char* self, const char* selfHost, const Peer* peers, int count, char* buf, size_t maxLen) {
+  size_t n = 0;
+  auto put = [&](int written) {
+    if (written > 0) n += (size_t)written;
+    if (n >= maxLen) n = maxLen - 1;
+  };
+  put(snprintf(buf, maxLen, "{\"self\":\"%s\",\"peers\":[", self));
+  bool first = true;
+  if (selfHost[0] != '\0') {
+    put(snprintf(buf + n, maxLen - n, "{\"name\":\"%s\",\"host\":\"%s\"}", self, selfHost));
+    first = false;
+  }
+  for (int i = 0; i < count; i++) {
+    put(snprintf(buf + n, maxLen - n, "%s{\"name\":\"%s\",\"host\":\"%s\"}", first ? "" : ",", peers[i].name,
+                 peers[i].host));
+    first = false;
+  }
+  put(snprintf(buf + n, maxLen - n, "]}"));
+  return n;
+}
+
+// --- SSE ---
+
+int eventsRate(const char* arg) {
+  return arg == nullptr || arg[0] == '\0' ? EventStream::DEFAULT_HZ : atoi(arg);
+}
@@ -0,0 +1,167 @@
+#pragma once
+// HTTP 處理器的共用部分: 車上 (main.cpp) 與虛擬車 (host/emulator) 呼叫同一組函式
+// 驗證請求、交給 loop() 的暫存與回應本文都在這裡; 送出回應、認證、串流連線與 loop() 的排程留在各自的程式。
+// 處理器回傳 HTTP 狀態碼並把 JSON 寫入 reply (以 '\0' 結尾)。
+// 車上的處理器在 async_tcp 任務中執行, 與 loop() 共用的狀態以 WebLock 保護 (portMUX);
+// 模擬器是單執行緒, 使用 NO_LOCK。car 只在 loop 任務中使用, 處理器讀取 StatusBoard 的快照。
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "capture.h"
+#include "car_control.h"
+#include "config_store.h"
+#include "control_api.h"
+#include "event_stream.h"
+#include "mjpeg_relay.h"
+#include "ota_stream.h"
+#include "ota_update.h"
+#include "sha256.h"
+
+struct WebLock {
+  void (*enter)(void* ctx);
+  void (*exit)(void* ctx);
+  void* ctx;
+};
+
+const WebLock NO_LOCK = {nullptr, nullptr, nullptr};
+
+int apiError(int code, const char* error, char* reply, size_t maxLen);
+
+// --- car 狀態快照 (/health, /latency, GET /api/mission 與 /api/drive 的模式檢查) ---
+// loop() 在每次 car.tick() 之後發佈: 模式與計數每次更新, JSON 片段每 PERIOD_MS 或 rebuild 時重建
+class StatusBoard {
+public:
+  static const uint32_t PERIOD_MS = 100;
+
+  explicit StatusBoard(const WebLock& lock) : _lock(lock) {}
+
+  void publish(const CarControl& car, uint32_t nowMs, bool rebuild);
+  DriveMode mode() const;
+  ControlStats stats(DriveMode* mode) const;
+  int missionReply(char* reply, size_t maxLen) const;   // GET /api/mission
+  int latencyReply(char* reply, size_t maxLen) const;   // GET /latency
+
+private:
+  struct Shared {
+    DriveMode mode;
+    ControlStats stats;
+    char mission[128];
+    char latency[1024];  // 空字串: 緩衝區不足
+  };
+
+  WebLock _lock;
+  Shared _shared = {};
+  char _mission[sizeof(Shared::mission)];  // 在 loop 中組好, 再於鎖內複製
+  char _latency[sizeof(Shared::latency)];
+  uint32_t _dueMs = 0;
+};
+
+// --- REST 控制 (/api/*, 本文格式見 control_api.h) ---
+// 處理器只排入命令, loop() 在 car.tick() 之前以 apiApply() 套用。設定點只保留最新的一個;
+// 急停丟棄還沒套用的命令 (車上的處理器另外立即拉低 STBY)。
+struct ApiPending {
+  bool stop;
+  bool mode;
+  DriveMode newMode;
+  bool drive;
+  DriveSetpoint setpoint;
+  bool mission;
+  int missionLen;
+  MissionSegment segments[MAX_MISSION_SEGMENTS];
+};
+
+struct ApiQueue {
+  WebLock lock;
+  ApiPending pending;
+};
+
+// mode: StatusBoard::mode(); 不是 MANUAL 時回 409
+int apiDrive(ApiQueue* q, DriveMode mode, const char* body, size_t len, char* reply, size_t maxLen);
+int apiMode(ApiQueue* q, const char* body, size_t len, char* reply, size_t maxLen);
+int apiStop(ApiQueue* q, char* reply, size_t maxLen);
+// updating: OTA 上傳中 (任務會被鎖定拒絕, 直接回 409)
+int apiMission(ApiQueue* q, bool updating, const char* body, size_t len, char* reply, size_t maxLen);
+// loop(): 取出並套用排入的命令 (急停優先); 有命令時回傳 true (呼叫端接著重建 StatusBoard)
+bool apiApply(ApiQueue* q, CarControl& car);
+
+// --- 執行期設定 (WebSocket {"cfg":...} 與 /api/config) ---
+// 驗證後暫存 (下一個控制 tick 生效, 見 ConfigStore::applyPending), reply 為暫存後的設定;
+// 失敗時回傳 false, err 為錯誤訊息。NVS 寫入只在 loop() 中, 不改變這裡讀取的欄位
+bool configStage(ConfigStore* store, const WebLock& lock, const char* json, size_t len, char* reply, size_t maxLen,
+                 char* err, size_t errLen);
+// CarControl::onConfig 的回覆: 目前的設定或 {"cfg":null,"error":"..."}
+size_t configWsReply(ConfigStore* store, const WebLock& lock, const char* json, size_t len, char* reply, size_t maxLen);
+int apiConfigPost(ConfigStore* store, const WebLock& lock, const char* body, size_t len, char* reply, size_t maxLen);
+int apiConfigGet(const ConfigStore& store, const WebLock& lock, char* reply, size_t maxLen);
+
+// --- 健康檢查 (GET /health) ---
+struct HealthInfo {
+  uint32_t uptimeMs;
+  const char* version;
+  const char* otaState;
+  const char* selftest;
+  int rssi;
+  int resetReason;
+  uint32_t heap;
+  unsigned wsClients;
+  int64_t wsDropped;  // < 0: 不提供 (車上的 WebSocketsServer 沒有這個統計)
+  SseStats sse;
+};
+
+size_t healthJson(const HealthInfo& info, const StatusBoard& status, char* buf, size_t maxLen);
+
+// 執行中影像的 SHA-256 (delta 修補檔的基底); 不明時回傳 false, hex 為空字串
+bool runningShaHex(char hex[Sha256::DIGEST_LEN * 2 + 1], uint32_t* size);
+
+// --- HTTP OTA (POST /update, GET /ota/info) ---
+// 第一個區塊 (認證之後): 解析 X-Image-SHA256 (沒有時為 nullptr), 呼叫 stopMotors 後開始串流;
+// 成功時回傳 true, 呼叫端記下擁有這次上傳的連線。更新已在進行、標頭錯誤或無法開始時回傳 false,
+// 錯誤由 otaUpdateReply 回覆
+bool otaUploadBegin(OtaStream& stream, OtaUpdater& updater, const char* shaHeader, size_t total, uint32_t nowMs,
+                    void (*stopMotors)());
+// 上傳結束: owner 為此連線擁有上傳時才 finish; *ok 為成功 (呼叫端接著排程重新啟動)
+int otaUpdateReply(OtaStream& stream, OtaUpdater& updater, bool owner, uint32_t nowMs, bool* ok, char* reply,
+                   size_t maxLen);
+// built: "日期 時間"; next: 下一個 OTA 分區
+size_t otaInfoJson(const char* next, const char* version, const char* built, char* buf, size_t maxLen);
+
+// loop(): 狀態改變或寫入中每 PERIOD_MS 組一次 {"ota":{...}} 廣播; 不需發佈時回傳 0。
+// 狀態改變時 log 為要發的日誌, 否則為空字串
+class OtaProgressFeed {
+public:
+  static const uint32_t PERIOD_MS = 500;
+  size_t next(const OtaStream& stream, const OtaUpdater& updater, uint32_t nowMs, char* buf, size_t maxLen, char* log,
+              size_t logLen);
+
+private:
+  OtaState _lastState = OtaState::IDLE;
+  uint32_t _lastPublish = 0;
+};
+
+// --- 控制流量擷取 (/capture) ---
+// 處理器只記下請求, loop() 以 captureApply() 開始/停止 (與 WebSocket 事件同一任務)
+enum CaptureRequest : uint8_t { CAPTURE_REQ_NONE, CAPTURE_REQ_START, CAPTURE_REQ_STOP };
+
+int captureStatusReply(const CaptureLog& capture, const char* state, char* reply, size_t maxLen);
+// GET /capture: 擷取中或還有未套用的請求時回 409, 否則回 200 (reply 不使用, 呼叫端串流 exportText)
+int captureDownloadCheck(const CaptureLog& capture, uint8_t request, char* reply, size_t maxLen);
+void captureApply(CaptureLog& capture, uint8_t request, uint32_t nowMs);
+
+// --- 影像轉送 (GET /video) ---
+// source: 上游 URL 或檔案; upstream: "none" / "idle" / "connecting" / "connected"
+size_t videoInfoJson(const MjpegRelay& video, const char* source, const char* upstream, uint32_t nowMs, char* buf,
+                     size_t maxLen);
+
+// --- 車隊 (GET /peers) ---
+struct Peer {
+  char name[32];
+  char host[24];
+};
+
+// selfHost 為空字串時不列出本機
+size_t peersJson(const char* self, const char* selfHost, const Peer* peers, int count, char* buf, size_t maxLen);
+
+// --- SSE (GET /events?rate=N) ---
+// 沒有 rate 參數 (nullptr 或空字串) 時為 EventStream::DEFAULT_HZ
+int eventsRate(const char* arg);
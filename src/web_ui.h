@@ -0,0 +1,776 @@
+#pragma once
+// 遙控網頁 (車上由 setupWebServer() 提供, 主機端模擬器提供同一份內容)
+
+// 網頁前端 HTML 內容 (日誌已移至 Console)
+const char index_html[] = R"rawliteral(
+<!doctype html>
+<html lang="zh-TW">
+<head>
+  <meta charset="utf-8" />
+  <meta name="viewport" content="width=device-width,initial-scale=1" />
+  <title>ESP32 Car Remote Control (User App)</title>
+  <style>
+    :root{--bg:#0b0d11;--card:#0f1720;--accent:#3b82f6;--muted:#98a2b3}
+    html,body{height:100%;margin:0;background:linear-gradient(180deg,var(--bg),#071022);color:#e6eef6;font-family:Inter,system-ui,Segoe UI,Roboto,"Noto Sans TC",sans-serif}
+    .app{display:grid;grid-template-columns:1fr;grid-template-rows:1fr;height:100vh;padding:12px;box-sizing:border-box;position:relative}
+    .viewer{background:rgba(255,255,255,0.02);border-radius:12px;padding:0;position:relative;overflow:hidden;}
+    .videoFrame{width:100%;height:100%;object-fit:cover;background:#000}
+    .overlay{position:absolute;left:12px;top:12px;background:rgba(0,0,0,0.45);padding:6px 8px;border-radius:8px;font-size:13px;color:var(--muted);z-index:5}
+    .controls{position:absolute;top:0;left:0;width:100%;height:100%;display:flex;justify-content:space-between;align-items:flex-end;pointer-events:none}
+    .stick{width:120px;height:120px;border-radius:50%;background:rgba(255,255,255,0.15);display:grid;place-items:center;position:relative;pointer-events:auto; touch-action: none;}
+    .base{width:70px;height:70px;border-radius:50%;background:rgba(255,255,255,0.05);border:2px dashed rgba(255,255,255,0.03);display:grid;place-items:center}
+    .knob{width:40px;height:40px;border-radius:50%;background:linear-gradient(180deg,#fff,#cbd5e1);transform:translate(-50%,-50%);position:absolute;left:50%;top:50%;box-shadow:0 6px 18px rgba(2,6,23,0.6)}
+    .value{font-size:12px;color:var(--muted);text-align:center;margin-top:4px}
+    .link{display:flex;align-items:center;gap:6px;margin-top:4px;font-variant-numeric:tabular-nums}
+    .link canvas{width:96px;height:20px;background:rgba(255,255,255,0.04);border-radius:3px}
+    .cal{display:flex;align-items:center;gap:6px;margin-top:6px;font-variant-numeric:tabular-nums}
+    .cal button,.cal select{font-size:13px;background:#1e293b;color:#e6eef6;border:1px solid #334155;border-radius:6px;padding:3px 8px}
+    .cal #calMark{background:#166534}
+    
+    /* 新增: 主導控制輸入顯示樣式 */
+    .dominant-display {
+        position: absolute;
+        top: 50%;
+        left: 50%;
+        transform: translate(-50%, -50%);
+        background: rgba(15, 23, 32, 0.95); /* Semi-transparent card background */
+        padding: 20px 30px;
+        border-radius: 12px;
+        box-shadow: 0 4px 15px rgba(0, 0, 0, 0.5);
+        z-index: 10;
+        transition: opacity 0.3s ease-in-out, visibility 0.3s;
+        opacity: 0; /* 預設隱藏 */
+        pointer-events: none; /* 讓搖桿可以點擊穿透 */
+        display: flex;
+        align-items: center;
+        gap: 20px;
+    }
+    .dominant-name { 
+        font-size: 1.2rem; 
+        color: #cbd5e1;
+        font-weight: 500;
+        min-width: 80px; /* 確保名稱區域穩定 */
+        text-align: left;
+    }
+    .dominant-value { 
+        font-size: 2.5rem; 
+        font-weight: 800; 
+        min-width: 120px; /* 確保數值區域穩定 */
+        text-align: right; 
+        font-variant-numeric: tabular-nums;
+        transition: color 0.3s;
+    }
+    /* 顏色反饋 */
+    .c-fwd { color: #22c55e; } /* 綠色 (前進) */
+    .c-rev { color: #f97316; } /* 橙色 (倒車) */
+    .c-left { color: #ef4444; } /* 紅色 (左轉) */
+    .c-right { color: #3b82f6; } /* 藍色 (右轉) */
+
+  </style>
+</head>
+<body>
+  <div class="app">
+    <div class="viewer">
+      <canvas id="video" class="videoFrame"></canvas>
+      <div class="overlay">IP: <span id="imgSource">N/A</span> | Video: <span id="videoStats">-</span> | WS: <span id="wsStatus">未連線</span> | Pad: <span id="padStatus">-</span>
+        <div class="link"><canvas id="rttSpark" width="96" height="20"></canvas><span id="linkStats">-</span></div>
+        <div class="cal" id="calPanel" hidden>校正:
+          <select id="calCh"><option value="a_fwd">A 前進</option><option value="a_rev">A 後退</option><option value="b_left">B 左</option><option value="b_right">B 右</option></select>
+          <button id="calStart">開始</button><button id="calMark">轉動了</button><button id="calStop">停止</button><span id="calStatus">-</span></div></div>
+      
+      <!-- 新增: 主導控制輸入顯示 (Dominant Input Display) -->
+      <div id="dominant-display" class="dominant-display">
+          <span id="domName" class="dominant-name"></span>
+          <span id="domValue" class="dominant-value"></span>
+      </div>
+
+      <div class="controls">
+        <div style="margin:12px; display:flex; flex-direction:column; gap:8px;">
+          <div class="stick" id="stickLeft" data-role="steer"><div class="base"></div><div class="knob" id="knobLeft"></div></div>
+          <div class="value">方向: <span id="valSteer">0</span></div>
+        </div>
+        <div style="margin:12px; display:flex; flex-direction:column; gap:8px;">
+          <div class="stick" id="stickRight" data-role="throttle"><div class="base"></div><div class="knob" id="knobRight"></div></div>
+          <div class="value">油門: <span id="valThrottle">0</span></div>
+        </div>
+      </div>
+    </div>
+  </div>
+
+  <!-- 控制連線 Web Worker (以 Blob URL 載入, 不需要額外的 HTTP 路由) -->
+  <script id="netWorker" type="text/js-worker">
+    // 主執行緒 → worker: {type:'connect', url}, {type:'stick', steer, throttle}, {type:'video', url, mode}, {type:'video-stop'},
+    //                   {type:'cal', cmd}
+    // worker → 主執行緒: {type:'status', text}, {type:'link', rtt, p50, p95, rate, sent, acked, drops, rssi, up, down},
+    //                   {type:'log', text}, {type:'ota', ota}, {type:'frame', bitmap, fps, age, dropped}, {type:'video', text},
+    //                   {type:'cal', cal, error}, {type:'cfg', cfg, error}
+    const stick = {steer:0, throttle:0};
+    let ws = null, url = '';
+
+    function log(text){ postMessage({type:'log', text}); }
+    function status(text){ postMessage({type:'status', text}); }
+
+    function connect(){
+      if(ws){ try{ws.close()}catch(e){} ws=null; }
+      log(`嘗試連線到 WebSocket: ${url}`);
+      status('Connecting...');
+      try{
+        ws = new WebSocket(url);
+        ws.binaryType='arraybuffer';
+        ws.onopen=()=>{
+          status('OPEN');
+          log('WebSocket 連線成功。');
+          startPing();
+          startSync();
+          // 斷線時車端已停車: 搖桿若仍有輸入, 立即重新送出
+          tx.lastAt = 0;
+          txSchedule();
+        };
+        ws.onclose=()=>{
+          stopSending();
+          stopPing();
+          stopSync();
+          tx.pending.clear();
+          status('CLOSED');
+          log('WebSocket 已斷線，3秒後重試連線...');
+          setTimeout(connect, 3000); // 重試連線
+        };
+        ws.onerror=()=>{
+          status('ERROR');
+          log('WebSocket 連線錯誤。');
+        };
+        ws.onmessage=(event)=>{
+          const data = event.data;
+          // 嘗試解析 JSON (控制狀態/遠端日誌); 馬達狀態只用來計算 RTT, 不轉給主執行緒
+          try {
+            const json = JSON.parse(data);
+            if (json.ack !== undefined) txAck(json.ack);
+            if (json.pong !== undefined) { onPong(json); return; }
+            if (json.sync !== undefined) { onSync(json); return; }
+            if (json.cal !== undefined) { postMessage({type:'cal', cal:json.cal, error:json.error}); return; }
+            if (json.cfg !== undefined) { postMessage({type:'cfg', cfg:json.cfg, error:json.error}); return; }
+            if (json.debug) log(json.debug);  // 這是來自 ESP32 的遠端日誌 (JSON 格式)
+            else if (json.ota) postMessage({type:'ota', ota:json.ota});
+          } catch(e) {
+            // 如果不是 JSON，則視為遠端日誌文本
+            log(data);
+          }
+        };
+      }catch(e){
+        status('ERROR');
+        log(`WebSocket 建立失敗: ${e.message}`);
+      }
+    }
+
+    // 發送搖桿命令: 搖桿有明顯變化時立即送出 (間隔不小於 minGap), 保持不動時只送保活,
+    // 回到中心時送出一次停止。minGap 依命令確認 (狀態廣播的 ack) 的 RTT 與 bufferedAmount 調整;
+    // 保活間隔必須低於車端的 COMMAND_TIMEOUT (300 ms), 否則馬達會被超時停止。
+    const tx = {STEP:3, MIN_GAP:20, MAX_GAP:200, KEEPALIVE_MIN:100, KEEPALIVE_MAX:150,
+                minGap:20, keepalive:100, srtt:0, last:{steer:0,throttle:0}, lastAt:0, timer:null, pending:new Map()};
+
+    function txChanged(){
+      const d = Math.max(Math.abs(stick.steer-tx.last.steer), Math.abs(stick.throttle-tx.last.throttle));
+      const centered = stick.steer===0 && stick.throttle===0;
+      return d >= tx.STEP || (centered && d > 0);
+    }
+
+    // 依目前搖桿與上次送出的內容排定下一次送出 (搖桿事件與每次送出後呼叫)
+    function txSchedule(){
+      if(tx.timer) clearTimeout(tx.timer);
+      tx.timer = null;
+      const idle = stick.steer===0 && stick.throttle===0 && tx.last.steer===0 && tx.last.throttle===0;
+      if(idle) return; // 已停止: 不需要保活
+      const due = tx.lastAt + (txChanged() ? tx.minGap : tx.keepalive);
+      tx.timer = setTimeout(txSend, Math.max(0, due - performance.now()));
+    }
+
+    function txSend(){
+      tx.timer = null;
+      if(!ws || ws.readyState!==WebSocket.OPEN) return; // onopen 會重新排程
+      if(ws.bufferedAmount > 0){
+        // 上一個框還沒送出 (Wi-Fi 壅塞): 放慢並稍後重試, 只送最新的搖桿值
+        tx.minGap = Math.min(tx.MAX_GAP, tx.minGap*2);
+        tx.timer = setTimeout(txSend, tx.minGap);
+        return;
+      }
+      // t: 命令編號 (車端以 ack 回傳, 用來量測 RTT), steer/throttle: -100 ~ 100 搖桿百分比
+      const t = Date.now();
+      ws.send(JSON.stringify({t:t,steer:stick.steer,throttle:stick.throttle}));
+      trackSent(t);
+      link.sent++;
+      tx.last = {steer:stick.steer, throttle:stick.throttle};
+      tx.lastAt = performance.now();
+      txSchedule();
+    }
+
+    function trackSent(t){
+      tx.pending.set(t, performance.now());
+      if(tx.pending.size > 32) tx.pending.delete(tx.pending.keys().next().value);
+    }
+
+    // 回傳 RTT (ms); 不是自己送出的 (廣播中也會有其他控制端的 ack) 回傳 null
+    function matchEcho(t){
+      const sentAt = tx.pending.get(t);
+      if(sentAt===undefined) return null;
+      tx.pending.delete(t);
+      return performance.now() - sentAt;
+    }
+
+    function txAck(ack){
+      const rtt = matchEcho(ack);
+      if(rtt===null) return;
+      link.acked++;
+      addRtt(rtt);
+    }
+
+    function addRtt(rtt){
+      tx.srtt = tx.srtt ? tx.srtt*0.875 + rtt*0.125 : rtt;
+      tx.minGap = Math.min(tx.MAX_GAP, Math.max(tx.MIN_GAP, Math.round(tx.srtt/2)));
+      tx.keepalive = Math.min(tx.KEEPALIVE_MAX, Math.max(tx.KEEPALIVE_MIN, tx.minGap*2));
+      link.samples.push(rtt);
+      if(link.samples.length > link.WINDOW) link.samples.shift();
+      const sorted = link.samples.slice().sort((a,b)=>a-b);
+      const q = (p)=>sorted[Math.min(sorted.length-1, Math.floor(p*sorted.length))];
+      postMessage({type:'link', rtt, p50:q(0.5), p95:q(0.95), rate:Math.round(1000/tx.minGap),
+                   sent:link.sent, acked:link.acked, drops:link.drops, rssi:link.rssi, up:sync.up, down:sync.downP50});
+    }
+
+    // --- 連線品質: 每秒一次 {"ping":t}, 車端只回覆給本連線 {"pong":t,"rssi","frames","errors","tx_fail"} ---
+    // 搖桿不動時也持續量測; ping 不會重設車端的命令超時。
+    const link = {WINDOW:64, samples:[], sent:0, acked:0, drops:null, rssi:null, timer:null};
+
+    function startPing(){
+      stopPing();
+      link.timer = setInterval(()=>{
+        if(!ws || ws.readyState!==WebSocket.OPEN || ws.bufferedAmount > 0) return;
+        const t = Date.now();
+        ws.send(JSON.stringify({ping:t}));
+        trackSent(t);
+      }, 1000);
+    }
+    function stopPing(){ if(link.timer) clearInterval(link.timer); link.timer=null; }
+
+    function onPong(json){
+      link.rssi = json.rssi || null;
+      link.drops = (json.tx_fail|0) + (json.errors|0);
+      const rtt = matchEcho(json.pong);
+      if(rtt!==null) addRtt(rtt);
+    }
+
+    // --- 時鐘同步 (NTP 式, 見 clock_sync.h): 車端由交換估計本頁 Date.now() 與車上 millis() 的差,
+    // 以此把每個命令的 t 換算為上行延遲 (車端統計, GET /latency)。回覆帶回目前的 offset,
+    // 這裡用它計算下行延遲 (車端 tx → 本頁收到)。t4 隨下一次請求送回; 開始時每 250 ms, 8 次後每秒一次 ---
+    const sync = {FAST:8, WINDOW:32, t1:0, t4:0, n:0, timer:null, down:[], downP50:null, up:null};
+
+    function startSync(){
+      stopSync();
+      sync.t1 = sync.t4 = sync.n = 0;
+      sync.down = [];
+      const tick = ()=>{
+        sync.timer = setTimeout(tick, sync.n < sync.FAST ? 250 : 1000);
+        if(!ws || ws.readyState!==WebSocket.OPEN || ws.bufferedAmount > 0) return;
+        const msg = {sync:Date.now()};
+        if(sync.t4){ msg.echo = sync.t1; msg.t4 = sync.t4; }
+        sync.t1 = msg.sync;
+        sync.t4 = 0;
+        sync.n++;
+        ws.send(JSON.stringify(msg));
+      };
+      tick();
+    }
+    function stopSync(){ if(sync.timer) clearTimeout(sync.timer); sync.timer=null; }
+
+    function onSync(json){
+      if(json.sync !== sync.t1) return; // 已被較新的請求取代
+      sync.t4 = Date.now();
+      if(json.off === undefined) return; // 車端還沒有完整樣本
+      sync.down.push(sync.t4 + json.off - json.tx);
+      if(sync.down.length > sync.WINDOW) sync.down.shift();
+      const sorted = sync.down.slice().sort((a,b)=>a-b);
+      sync.downP50 = sorted[Math.floor(sorted.length/2)];
+      sync.up = json.up50 || null;
+    }
+
+    function stopSending(){ if(tx.timer) clearTimeout(tx.timer); tx.timer=null; }
+
+    // --- 影像: 一條長連線讀取 /stream (multipart/x-mixed-replace), 在 worker 中切框並解碼,
+    // 只把最新的 ImageBitmap 轉移給主執行緒; 解碼跟不上時丟棄舊框, 不排隊。
+    // mode 'poll' 為舊的逐張 GET /frame.jpg, 只留作比較 (http://<car>/?video=poll)。
+    // age: 車端 X-Frame-Age (框完整收到到開始送出) + 傳輸與解碼時間 ---
+    const video = {url:'', mode:'stream', ctrl:null, retry:null, decoding:false, next:null,
+                   frames:0, windowAt:0, fps:0, dropped:0};
+
+    function videoStatus(text){ postMessage({type:'video', text}); }
+
+    function stopVideo(){
+      if(video.retry) clearTimeout(video.retry);
+      video.retry = null;
+      if(video.ctrl) video.ctrl.abort();
+      video.ctrl = null;
+    }
+
+    async function startVideo(){
+      stopVideo();
+      const ctrl = new AbortController();
+      video.ctrl = ctrl;
+      video.frames = 0; video.windowAt = performance.now(); video.fps = 0;
+      try {
+        if(video.mode === 'poll') await pollFrames(ctrl.signal);
+        else await readStream(ctrl.signal);
+        videoStatus('ended');
+      } catch(e) {
+        if(ctrl.signal.aborted) return;
+        videoStatus(e.message);
+      }
+      if(video.ctrl === ctrl) video.retry = setTimeout(startVideo, 3000);
+    }
+
+    // 可重複使用的接收緩衝區: 只在空間不足時搬移或加倍, 不為每個 chunk 重新配置
+    const rx = {buf:new Uint8Array(65536), start:0, end:0,
+      append(chunk){
+        if(this.end + chunk.length > this.buf.length){
+          const live = this.end - this.start;
+          if(live + chunk.length > this.buf.length){
+            const dst = new Uint8Array(Math.max(this.buf.length*2, live + chunk.length));
+            dst.set(this.buf.subarray(this.start, this.end));
+            this.buf = dst;
+          } else {
+            this.buf.copyWithin(0, this.start, this.end);
+          }
+          this.start = 0; this.end = live;
+        }
+        this.buf.set(chunk, this.end);
+        this.end += chunk.length;
+      },
+      headerEnd(){
+        for(let i = this.start; i + 3 < this.end; i++){
+          if(this.buf[i]===13 && this.buf[i+1]===10 && this.buf[i+2]===13 && this.buf[i+3]===10) return i;
+        }
+        return -1;
+      }
+    };
+
+    async function readStream(signal){
+      const res = await fetch(video.url, {cache:'no-store', signal});
+      if(!res.ok || !res.body) throw new Error(`HTTP ${res.status}`);
+      videoStatus('streaming');
+      const reader = res.body.getReader();
+      const text = new TextDecoder();
+      rx.start = rx.end = 0;
+      let part = null; // {len, age, at}
+      for(;;){
+        const {value, done} = await reader.read();
+        if(done) return;
+        rx.append(value);
+        for(;;){
+          if(!part){
+            const he = rx.headerEnd();
+            if(he < 0) break;
+            const head = text.decode(rx.buf.subarray(rx.start, he));
+            rx.start = he + 4;
+            const len = /content-length:\s*(\d+)/i.exec(head);
+            if(!len) continue; // 不是框的標頭 (例如前一框結尾的空行)
+            const age = /x-frame-age:\s*(\d+)/i.exec(head);
+            part = {len:Number(len[1]), age:age ? Number(age[1]) : 0, at:performance.now()};
+          }
+          if(rx.end - rx.start < part.len) break;
+          const jpeg = rx.buf.slice(rx.start, rx.start + part.len);
+          rx.start += part.len;
+          onJpeg(jpeg, part.age, part.at);
+          part = null;
+        }
+      }
+    }
+
+    // 舊的輪詢方式: 每 100 ms 一次 (原本的 videoFps 10), 同一框 (X-Frame-Seq) 不重複解碼
+    async function pollFrames(signal){
+      let seq = null;
+      for(;;){
+        const at = performance.now();
+        const res = await fetch(video.url + (video.url.includes('?') ? '&' : '?') + 't=' + Date.now(), {cache:'no-store', signal});
+        if(!res.ok) throw new Error(`HTTP ${res.status}`);
+        const jpeg = new Uint8Array(await res.arrayBuffer());
+        if(res.headers.get('X-Frame-Seq') !== seq || seq === null){
+          seq = res.headers.get('X-Frame-Seq');
+          onJpeg(jpeg, Number(res.headers.get('X-Frame-Age')) || 0, at);
+        }
+        await new Promise(r => setTimeout(r, Math.max(0, 100 - (performance.now() - at))));
+      }
+    }
+
+    function onJpeg(jpeg, age, at){
+      if(video.decoding){
+        if(video.next) video.dropped++;
+        video.next = {jpeg, age, at};
+        return;
+      }
+      decode({jpeg, age, at});
+    }
+
+    async function decode(f){
+      video.decoding = true;
+      try {
+        const bitmap = await createImageBitmap(new Blob([f.jpeg], {type:'image/jpeg'}));
+        const now = performance.now();
+        video.frames++;
+        if(now - video.windowAt >= 1000){
+          video.fps = video.frames * 1000 / (now - video.windowAt);
+          video.frames = 0;
+          video.windowAt = now;
+        }
+        postMessage({type:'frame', bitmap, fps:video.fps, age:Math.round(f.age + now - f.at), dropped:video.dropped}, [bitmap]);
+      } catch(e) {
+        video.dropped++; // 損壞的 JPEG
+      }
+      video.decoding = false;
+      const next = video.next;
+      video.next = null;
+      if(next) decode(next);
+    }
+
+    onmessage = (e) => {
+      const m = e.data;
+      if(m.type==='connect'){ url = m.url; connect(); }
+      else if(m.type==='stick'){ stick.steer = m.steer; stick.throttle = m.throttle; txSchedule(); }
+      else if(m.type==='video'){ video.url = m.url; video.mode = m.mode; startVideo(); }
+      else if(m.type==='video-stop'){ stopVideo(); }
+      else if(m.type==='cal'){ if(ws && ws.readyState===1) ws.send(JSON.stringify({cal:m.cmd})); }
+    };
+  </script>
+  <script>
+    class VirtualStick {
+      constructor(stickEl, knobEl, onChange){
+        this.el = stickEl; this.knob = knobEl; this.cb = onChange; this.max = Math.min(stickEl.clientWidth, stickEl.clientHeight)/2 - 8;
+        this.center = {x: this.el.clientWidth/2, y: this.el.clientHeight/2};
+        this.pointerId = null; this.pos = {x:0,y:0}; this.deadzone = 6;
+        this._bind();
+      }
+      _bind(){
+        this.el.style.touchAction = 'none';
+        this.el.addEventListener('pointerdown', e=>this._start(e));
+        window.addEventListener('pointermove', e=>this._move(e));
+        window.addEventListener('pointerup', e=>this._end(e));
+        window.addEventListener('pointercancel', e=>this._end(e));
+        window.addEventListener('resize', ()=>{this.center = {x:this.el.clientWidth/2,y:this.el.clientHeight/2};this.max = Math.min(this.el.clientWidth,this.el.clientHeight)/2 - 8});
+      }
+      // 版面只在按下時讀一次 (getBoundingClientRect 會強制 layout), 移動時不讀也不寫 DOM
+      _start(e){ if(this.pointerId!==null) return; this.pointerId = e.pointerId; this.rect = this.el.getBoundingClientRect(); this.el.setPointerCapture?.(e.pointerId); this._move(e); }
+      _move(e){ if(this.pointerId===null || e.pointerId!==this.pointerId) return; const rect = this.rect; let x = e.clientX - rect.left - rect.width/2; let y = e.clientY - rect.top - rect.height/2; const d = Math.hypot(x,y); if(d>this.max){ const r = this.max/d; x*=r; y*=r; } this.pos = {x,y}; this.dirty = true; requestRender(); this._fire(); }
+      _end(e){ if(this.pointerId===null || e.pointerId!==this.pointerId) return; this.pointerId=null; this.pos={x:0,y:0}; this.dirty = true; requestRender(); this._fire(); }
+      // 由 render() 在 requestAnimationFrame 中呼叫
+      render(){ if(!this.dirty) return; this.dirty = false; const r = this.rect; this.knob.style.left = (r ? 50 + this.pos.x/r.width*100 : 50)+'%'; this.knob.style.top = (r ? 50 + this.pos.y/r.height*100 : 50)+'%'; }
+      // 此處 n.x, n.y 介於 -1 到 1 之間
+      _fire(){ const norm = {x: Math.abs(this.pos.x) < this.deadzone ? 0 : this.pos.x/this.max, y: Math.abs(this.pos.y) < this.deadzone ? 0 : this.pos.y/this.max}; if(this.cb) this.cb(norm); }
+    }
+
+    const wsStatusEl = document.getElementById('wsStatus');
+    const linkStatsEl = document.getElementById('linkStats');
+    const padStatusEl = document.getElementById('padStatus');
+    const videoStatsEl = document.getElementById('videoStats');
+    const valSteer = document.getElementById('valSteer');
+    const valThrottle = document.getElementById('valThrottle');
+    const stickL = document.getElementById('stickLeft');
+    const stickR = document.getElementById('stickRight');
+    
+    // 取得新的主導顯示元素
+    const domDisplayEl = document.getElementById('dominant-display');
+    const domNameEl = document.getElementById('domName');
+    const domValueEl = document.getElementById('domValue');
+
+
+    const state = {steer:0, throttle:0, link:'-', pad:'-', video:'-', config:{videoUrl:'/stream',videoMode:'stream',wsUrl:''}};
+
+    // n.x*100 或 -n.y*100 確保輸出在 -100 到 100 之間
+    // 搖桿事件只更新 state 並交給控制連線 worker; 畫面由 render() 在下一個 animation frame 更新
+    const left = new VirtualStick(stickL, document.getElementById('knobLeft'), n=>{ 
+        state.steer = Math.round(n.x*100); 
+        sendStick();
+    });
+    const right = new VirtualStick(stickR, document.getElementById('knobRight'), n=>{ 
+        state.throttle = Math.round(-n.y*100); 
+        sendStick();
+    });
+
+    // --- RTT sparkline: 最近 48 個樣本, 只在有新樣本的畫面重畫 (一條 path, 不配置物件) ---
+    const spark = {
+        el: document.getElementById('rttSpark'), data: new Float32Array(48), n: 0, head: 0, dirty: false,
+        push(v){ this.data[this.head] = v; this.head = (this.head + 1) % this.data.length; if (this.n < this.data.length) this.n++; this.dirty = true; },
+        draw(){
+            if (!this.dirty || !this.el.getContext) return;
+            this.dirty = false;
+            const c = this.el.getContext('2d'), w = this.el.width, h = this.el.height, len = this.data.length;
+            let max = 50, last = 0;
+            for (let i = 0; i < this.n; i++) max = Math.max(max, this.data[i]);
+            c.clearRect(0, 0, w, h);
+            c.beginPath();
+            for (let i = 0; i < this.n; i++) {
+                const v = this.data[(this.head - this.n + i + len) % len];
+                const x = (len - this.n + i) * (w - 1) / (len - 1), y = h - 1 - v / max * (h - 2);
+                if (i === 0) c.moveTo(x, y); else c.lineTo(x, y);
+                last = v;
+            }
+            // 綠: < 50 ms, 黃: < 150 ms, 紅: 以上 (超過 COMMAND_TIMEOUT 的一半就容易超時停車)
+            c.strokeStyle = last < 50 ? '#22c55e' : (last < 150 ? '#eab308' : '#ef4444');
+            c.lineWidth = 1.5;
+            c.stroke();
+        }
+    };
+
+    // --- 影像: worker 解碼後轉移過來的 ImageBitmap, 只在 render() 畫最新的一張 ---
+    const view = {
+        el: document.getElementById('video'), bitmap: null,
+        show(bitmap){ if (this.bitmap) this.bitmap.close(); this.bitmap = bitmap; requestRender(); },
+        draw(){
+            const b = this.bitmap;
+            if (!b || !this.el.getContext) return;
+            this.bitmap = null;
+            if (this.el.width !== b.width || this.el.height !== b.height) { this.el.width = b.width; this.el.height = b.height; }
+            this.el.getContext('2d').drawImage(b, 0, 0);
+            b.close();
+        }
+    };
+
+    // --- DOM 更新: 每個畫面最多一次, 值沒變就不寫 ---
+    let renderQueued = false;
+    const shown = new Map();
+    function requestRender(){ if(renderQueued) return; renderQueued = true; requestAnimationFrame(render); }
+    function setText(el, v){ v = String(v); if(shown.get(el)!==v){ shown.set(el, v); el.textContent = v; } }
+    function setProp(el, key, v){ const k = el.id + '.' + key; if(shown.get(k)!==v){ shown.set(k, v); if(key==='className') el.className = v; else el.style[key] = v; } }
+    function render(){
+        renderQueued = false;
+        left.render();
+        right.render();
+        setText(valSteer, state.steer);
+        setText(valThrottle, state.throttle);
+        setText(linkStatsEl, state.link);
+        setText(padStatusEl, state.pad);
+        setText(videoStatsEl, state.video);
+        view.draw();
+        spark.draw();
+        updateDominantDisplay();
+    }
+    
+    // --- 新增: 更新主導控制輸入顯示 (只在 render() 中呼叫) ---
+    function updateDominantDisplay() {
+        const steer = state.steer;
+        const throttle = state.throttle;
+        const absSteer = Math.abs(steer);
+        const absThrottle = Math.abs(throttle);
+
+        if (absSteer === 0 && absThrottle === 0) {
+            // 隱藏顯示 (不操作時)
+            setProp(domDisplayEl, 'opacity', '0');
+            return;
+        }
+
+        // 顯示面板
+        setProp(domDisplayEl, 'opacity', '1');
+
+        let name = '';
+        let value = 0;
+        let colorClass = '';
+
+        if (absSteer >= absThrottle) {
+            // 轉向 (Steer) 為主導 (或兩者相等，優先顯示 Steer)
+            value = steer;
+            if (value > 0) {
+                name = '右轉 (STEER)';
+                colorClass = 'c-right';
+            } else if (value < 0) {
+                name = '左轉 (STEER)';
+                colorClass = 'c-left';
+            } else {
+                // 如果 Steer=0 且 Throttle!=0, 則轉向顯示 Throttle
+                if (absThrottle > 0) {
+                    value = throttle;
+                    if (value > 0) { name = '前進 (THROTTLE)'; colorClass = 'c-fwd'; }
+                    else { name = '倒車 (REVERSE)'; colorClass = 'c-rev'; }
+                } else {
+                    // 兩者皆為 0，但在開頭已處理
+                    name = '靜止 (IDLE)';
+                    colorClass = '';
+                }
+            }
+        } 
+        
+        if (absThrottle > absSteer) {
+            // 油門 (Throttle) 為主導
+            value = throttle;
+            if (value > 0) {
+                name = '前進 (THROTTLE)';
+                colorClass = 'c-fwd';
+            } else {
+                name = '倒車 (REVERSE)';
+                colorClass = 'c-rev';
+            }
+        }
+        
+        setText(domNameEl, name);
+        setText(domValueEl, `${Math.abs(value)}%`);
+        // 數值顏色類別
+        setProp(domValueEl, 'className', colorClass ? `dominant-value ${colorClass}` : 'dominant-value');
+    }
+    // ----------------------
+
+    // --- 日誌輔助函式: 輸出到瀏覽器 Console ---
+    function appendLog(message) {
+        const timestamp = new Date().toLocaleTimeString('en-US', {hour12: false});
+        console.log(`[ESP32 LOG] [${timestamp}] ${message}`); 
+    }
+    // ----------------------
+
+    // --- 控制連線 (Web Worker, 見 netWorker) ---
+    // WebSocket、重連與送出排程都在 worker 中執行, 主執行緒只轉交搖桿值與顯示結果。
+    // (SharedArrayBuffer 需要 cross-origin isolation, 車上的 HTTP 頁面無法提供, 因此使用 postMessage)
+    const net = new Worker(URL.createObjectURL(new Blob([document.getElementById('netWorker').textContent], {type:'text/javascript'})));
+    net.onmessage = (e) => {
+        const m = e.data;
+        if (m.type === 'status') {
+            wsStatusEl.textContent = m.text;
+        } else if (m.type === 'link') {
+            const ms = (v)=>v < 10 ? v.toFixed(1) : Math.round(v);
+            state.link = `p50 ${ms(m.p50)} / p95 ${ms(m.p95)} ms · ${m.rate} Hz · sent ${m.sent} ack ${m.acked}` +
+                         (m.up !== null || m.down !== null ? ` · ↑ ${m.up ?? '-'} ↓ ${m.down !== null ? ms(Math.max(0, m.down)) : '-'} ms` : '') +
+                         (m.drops !== null ? ` · drops ${m.drops}` : '') + (m.rssi ? ` · RSSI ${m.rssi} dBm` : '');
+            spark.push(m.rtt);
+            requestRender();
+        } else if (m.type === 'frame') {
+            state.video = `${m.fps.toFixed(1)} fps · ${m.age} ms` + (m.dropped ? ` · drop ${m.dropped}` : '');
+            view.show(m.bitmap);
+        } else if (m.type === 'video') {
+            if (m.text !== 'streaming') state.video = m.text;
+            requestRender();
+        } else if (m.type === 'log') {
+            appendLog(m.text);
+        } else if (m.type === 'ota') {
+            // OTA 進度 (HTTP /update)
+            const o = m.ota;
+            const pct = o.total ? ` ${Math.round(o.bytes*100/o.total)}%` : '';
+            appendLog(`OTA ${o.state} (${o.format})${pct} ${o.bytes}B @ ${(o.Bps/1024).toFixed(1)} KiB/s ${o.error||''}`);
+        } else if (m.type === 'cal') {
+            const c = m.cal;
+            calStatusEl.textContent = c ? `${c.ch} ${c.state} duty ${c.duty}/${c.max}${c.error ? ' · ' + c.error : ''}` : m.error;
+        } else if (m.type === 'cfg') {
+            // 校正完成後設定層的回覆: 下限已暫存, 3 秒後寫入 NVS
+            if (m.cfg === null) calStatusEl.textContent += ` · ${m.error}`;
+            else appendLog(`Config: ${JSON.stringify(m.cfg)}`);
+        }
+    };
+
+    function sendStick(){ net.postMessage({type:'stick', steer:state.steer, throttle:state.throttle}); }
+
+    // --- 靜摩擦校正: http://<car>/?cal ---
+    // 車子架高, 選擇通道後按「開始」, duty 逐步增加; 看到輪子開始轉動時按「轉動了」(或空白鍵),
+    // 當時的 duty 成為該方向的最小啟動 duty (floor_*), 保存於 NVS。
+    const calStatusEl = document.getElementById('calStatus');
+    function calCommand(cmd){ net.postMessage({type:'cal', cmd}); }
+    if (new URLSearchParams(window.location.search).has('cal')) {
+        document.getElementById('calPanel').hidden = false;
+        document.getElementById('calStart').onclick = () => calCommand(document.getElementById('calCh').value);
+        document.getElementById('calMark').onclick = () => calCommand('mark');
+        document.getElementById('calStop').onclick = () => calCommand('stop');
+        window.addEventListener('keydown', (e) => { if (e.code === 'Space') { e.preventDefault(); calCommand('mark'); } });
+    }
+
+    // --- 遊戲手把 (Gamepad API) ---
+    // 左搖桿 X → 方向, 右搖桿 Y (或 RT/LT 扳機) → 油門, 寫入與觸控搖桿相同的 state。
+    // navigator.getGamepads() 只能在主執行緒使用: 每個 animation frame 讀一次, 值有變才交給 worker,
+    // 所以手把不動時觸控搖桿仍可操作。deadzone / expo 可用網址參數設定並記在 localStorage:
+    //   http://<car>/?deadzone=0.1&expo=0.4
+    const pad = {index:null, last:{steer:0,throttle:0}, deadzone:0.08, expo:0.3};
+
+    function loadPadConfig(){
+        const q = new URLSearchParams(window.location.search);
+        let saved = {};
+        try { saved = JSON.parse(localStorage.getItem('padConfig') || '{}'); } catch(e) {}
+        for (const [k, max] of [['deadzone', 0.5], ['expo', 1]]) {
+            const v = q.has(k) ? parseFloat(q.get(k)) : saved[k];
+            if (Number.isFinite(v)) pad[k] = Math.min(max, Math.max(0, v));
+        }
+        try { localStorage.setItem('padConfig', JSON.stringify({deadzone:pad.deadzone, expo:pad.expo})); } catch(e) {}
+    }
+
+    // 去除 deadzone 後重新縮放到 0~1, 再套用 expo (中心附近較細, 滿舵不變)
+    function shapeAxis(v){
+        const a = Math.abs(v);
+        if (a <= pad.deadzone) return 0;
+        const x = Math.min(1, (a - pad.deadzone) / (1 - pad.deadzone));
+        return Math.sign(v) * ((1 - pad.expo) * x + pad.expo * x * x * x);
+    }
+
+    function setPadInput(steer, throttle){
+        if (steer === pad.last.steer && throttle === pad.last.throttle) return;
+        pad.last = {steer, throttle};
+        state.steer = steer;
+        state.throttle = throttle;
+        sendStick();
+        requestRender();
+    }
+
+    function pollGamepad(){
+        if (pad.index === null) return;
+        const gp = navigator.getGamepads()[pad.index];
+        if (gp) {
+            const standard = gp.mapping === 'standard';
+            const steer = Math.round(shapeAxis(gp.axes[0] || 0) * 100);
+            let throttle = Math.round(-shapeAxis(gp.axes[standard ? 3 : 1] || 0) * 100);
+            if (throttle === 0 && standard) throttle = Math.round(shapeAxis(gp.buttons[7].value - gp.buttons[6].value) * 100);
+            setPadInput(steer, throttle);
+        }
+        requestAnimationFrame(pollGamepad);
+    }
+
+    window.addEventListener('gamepadconnected', (e) => {
+        const idle = pad.index === null;
+        pad.index = e.gamepad.index;
+        state.pad = e.gamepad.id.split('(')[0].trim() || 'connected';
+        appendLog(`Gamepad connected: ${e.gamepad.id} (deadzone ${pad.deadzone}, expo ${pad.expo})`);
+        requestRender();
+        if (idle) requestAnimationFrame(pollGamepad);
+    });
+    window.addEventListener('gamepaddisconnected', (e) => {
+        if (e.gamepad.index !== pad.index) return;
+        pad.index = null;
+        state.pad = '-';
+        setPadInput(0, 0); // 手把斷線時停車
+        requestRender();
+    });
+    // 分頁隱藏時 animation frame 停止, 不能讓最後的手把輸入繼續保活
+    document.addEventListener('visibilitychange', () => { if (document.hidden && pad.index !== null) setPadInput(0, 0); });
+
+    function connectWs(){ 
+        // 控制 WebSocket 在 HTTP 埠 +1 (車上為 80/81, 模擬器為 --port/--port+1)
+        const wsPort = window.location.port ? Number(window.location.port) + 1 : 81;
+        net.postMessage({type:'connect', url:`ws://${window.location.hostname}:${wsPort}`});
+    }
+    
+    // 影像: 車上 /stream 轉送相機節點的 MJPEG (一條長連線, 由 worker 讀取與解碼)。
+    //   http://<car>/?video=poll 改回逐張 GET /frame.jpg (比較用), ?video=off 關閉
+    function loadVideoConfig(){
+        const mode = new URLSearchParams(window.location.search).get('video');
+        if (mode === 'poll') { state.config.videoMode = 'poll'; state.config.videoUrl = '/frame.jpg'; }
+        else if (mode === 'off') state.config.videoUrl = '';
+    }
+    function startVideo(){
+        const url = state.config.videoUrl;
+        document.getElementById('imgSource').textContent = url || 'N/A';
+        // worker 由 blob: URL 建立, 相對路徑要先換成絕對網址
+        if (url) net.postMessage({type:'video', url:new URL(url, window.location.href).href, mode:state.config.videoMode});
+    }
+    function stopVideo(){ net.postMessage({type:'video-stop'}); }
+    // 分頁隱藏時不佔用車上的頻寬
+    document.addEventListener('visibilitychange', () => { if (document.hidden) stopVideo(); else startVideo(); });
+
+    window.addEventListener('beforeunload', ()=>{ net.terminate(); });
+    
+    window.onload = () => {
+        connectWs(); // 控制命令由搖桿事件觸發 (worker 中的 txSchedule)
+        loadPadConfig();
+        requestRender(); // 初始檢查並隱藏顯示
+        loadVideoConfig();
+        startVideo();
+    };
+  </script>
+</body>
+</html>
+)rawliteral";
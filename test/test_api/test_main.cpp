@@ -0,0 +1,273 @@
+// REST 控制 API: 請求本文解析、處理器與 loop() 之間的命令佇列、任務播放 (pio test -e native)
+// 時間由 halNative.nowMs 手動推進, 硬體輸出由 host/hal_native.cpp 記錄。
+
+#include <string.h>
+#include <unity.h>
+
+#include <string>
+
+#include "car_control.h"
+#include "control_api.h"
+#include "gpio_pins.h"
+#include "hal_native.h"
+#include "web_api.h"
+
+static CarControl car;
+static MissionSegment segments[MAX_MISSION_SEGMENTS];
+static ApiQueue api;
+static char reply[256];
+
+// 記錄鎖的使用: 處理器與 loop() 的每次存取都要成對進出
+static int lockDepth = 0;
+static int lockEntries = 0;
+static void countEnter(void*) {
+  TEST_ASSERT_EQUAL_INT(0, lockDepth);
+  lockDepth++;
+  lockEntries++;
+}
+static void countExit(void*) { lockDepth--; }
+
+static const char* parseMission(const char* body, int* count) {
+  return parseMissionRequest(body, strlen(body), segments, MAX_MISSION_SEGMENTS, count);
+}
+
+static void tickFor(uint32_t ms) {
+  for (uint32_t i = 0; i < ms; i++) {
+    halNative.nowMs++;
+    car.tick();
+  }
+}
+
+void setUp(void) {
+  halNativeReset();
+  halNative.nowMs = 1000;
+  car = CarControl();
+  car.begin();
+  api = {{countEnter, countExit, nullptr}, {}};
+  lockDepth = lockEntries = 0;
+}
+
+void tearDown(void) {}
+
+void test_drive_request_is_validated(void) {
+  DriveSetpoint sp;
+  const char* ok = "{\"throttle\":60,\"steer\":-20,\"t\":42}";
+  TEST_ASSERT_NULL(parseDriveRequest(ok, strlen(ok), &sp));
+  TEST_ASSERT_EQUAL_INT(60, sp.throttle);
+  TEST_ASSERT_EQUAL_INT(-20, sp.steer);
+  TEST_ASSERT_TRUE(sp.hasT);
+  const char* high = "{\"throttle\":150}";
+  TEST_ASSERT_NOT_NULL(parseDriveRequest(high, strlen(high), &sp));
+  const char* frac = "{\"steer\":1.5}";
+  TEST_ASSERT_NOT_NULL(parseDriveRequest(frac, strlen(frac), &sp));
+  TEST_ASSERT_EQUAL_STRING("IncompleteInput", parseDriveRequest(ok, 12, &sp)); // 長度以參數為準
+}
+
+void test_mode_request(void) {
+  DriveMode mode = MANUAL;
+  const char* autoBody = "{\"mode\":\"AUTO\"}";
+  TEST_ASSERT_NULL(parseModeRequest(autoBody, strlen(autoBody), &mode));
+  TEST_ASSERT_EQUAL(AUTO, mode);
+  const char* bad = "{\"mode\":\"auto\"}";
+  TEST_ASSERT_NOT_NULL(parseModeRequest(bad, strlen(bad), &mode));
+}
+
+void test_mission_request_bounds(void) {
+  int count = -1;
+  TEST_ASSERT_NULL(parseMission("{\"segments\":[[60,0,800],[40,-100,250],[0,0,1]]}", &count));
+  TEST_ASSERT_EQUAL_INT(3, count);
+  TEST_ASSERT_EQUAL_INT(-100, segments[1].steer);
+  TEST_ASSERT_EQUAL_UINT16(250, segments[1].ms);
+  TEST_ASSERT_NOT_NULL(parseMission("{\"segments\":[]}", &count));
+  TEST_ASSERT_NOT_NULL(parseMission("{\"segments\":[[60,0]]}", &count));
+  TEST_ASSERT_NOT_NULL(parseMission("{\"segments\":[[60,0,0]]}", &count));
+  TEST_ASSERT_NOT_NULL(parseMission("{\"segments\":[[60,0,100,1]]}", &count));
+  TEST_ASSERT_NOT_NULL(parseMission("{\"segments\":[[60,0,40000]]}", &count));
+  TEST_ASSERT_EQUAL_INT(0, count);
+
+  std::string many = "{\"segments\":[";
+  for (int i = 0; i <= MAX_MISSION_SEGMENTS; i++) many += i ? ",[1,2,3]" : "[1,2,3]";
+  many += "]}";
+  TEST_ASSERT_EQUAL_STRING("too many segments", parseMission(many.c_str(), &count));
+  std::string big(MAX_API_BODY + 1, ' ');
+  TEST_ASSERT_EQUAL_STRING("body too large", parseMission(big.c_str(), &count));
+}
+
+void test_mission_plays_segments_in_order(void) {
+  MissionSegment m[] = {{100, 0, 200}, {50, -100, 100}};
+  TEST_ASSERT_TRUE(car.startMission(m, 2));
+  TEST_ASSERT_EQUAL(AUTO, car.mode());
+  TEST_ASSERT_EQUAL_INT(MAX_DUTY, halNative.pwm[CH_A_FWD]);
+  // 超過命令超時 (300 ms) 也持續輸出
+  tickFor(199);
+  TEST_ASSERT_EQUAL_INT(MAX_DUTY, halNative.pwm[CH_A_FWD]);
+  tickFor(1);
+  TEST_ASSERT_EQUAL_INT(50 * MAX_DUTY / 100, halNative.pwm[CH_A_FWD]);
+  TEST_ASSERT_EQUAL_INT(MAX_DUTY, halNative.pwm[CH_B_LEFT]);
+  tickFor(100);
+  TEST_ASSERT_FALSE(car.missionActive());
+  TEST_ASSERT_FALSE(halNative.pins[motor_stby]);
+  TEST_ASSERT_EQUAL(MANUAL, car.mode()); // 回到任務開始前的模式
+  TEST_ASSERT_EQUAL_STRING("Mission complete", halNative.lastLog);
+}
+
+void test_joystick_is_ignored_during_mission(void) {
+  MissionSegment m[] = {{30, 0, 1000}};
+  car.startMission(m, 1);
+  const char* cmd = "{\"steer\":0,\"throttle\":-100}";
+  car.handleText(cmd, strlen(cmd));
+  TEST_ASSERT_EQUAL_INT(30 * MAX_DUTY / 100, halNative.pwm[CH_A_FWD]);
+  TEST_ASSERT_EQUAL_UINT32(1, car.stats().ignored);
+}
+
+void test_mission_aborts_on_stop_manual_or_lock(void) {
+  MissionSegment m[] = {{80, 0, 5000}};
+  car.startMission(m, 1);
+  car.handleText("S", 1);
+  TEST_ASSERT_FALSE(car.missionActive());
+  tickFor(10);
+  TEST_ASSERT_EQUAL_INT(0, halNative.pwm[CH_A_FWD]);
+
+  car.startMission(m, 1);
+  car.setMode(MANUAL);
+  TEST_ASSERT_FALSE(car.missionActive());
+  TEST_ASSERT_FALSE(halNative.pins[motor_stby]);
+
+  car.startMission(m, 1);
+  car.setDriveLocked(true);
+  tickFor(1);
+  TEST_ASSERT_FALSE(car.missionActive());
+  TEST_ASSERT_EQUAL_STRING("Mission aborted", halNative.lastLog);
+  TEST_ASSERT_FALSE(car.startMission(m, 1));
+}
+
+void test_mission_skips_expired_segments_after_stall(void) {
+  MissionSegment m[] = {{100, 0, 50}, {-100, 0, 50}, {20, 0, 500}};
+  car.startMission(m, 3);
+  halNative.nowMs += 120; // loop 被阻塞: 直接跳到第三段, 不補播第二段
+  car.tick();
+  TEST_ASSERT_EQUAL_INT(20 * MAX_DUTY / 100, halNative.pwm[CH_A_FWD]);
+  TEST_ASSERT_EQUAL_INT(0, halNative.pwm[CH_A_REV]);
+  char json[128];
+  TEST_ASSERT_TRUE(car.missionJson(json, sizeof(json)) > 0);
+  TEST_ASSERT_EQUAL_STRING("{\"active\":true,\"segment\":2,\"segments\":3,\"elapsed_ms\":120,\"total_ms\":600}", json);
+}
+
+void test_rest_commands_wait_for_loop(void) {
+  const char* drive = "{\"throttle\":60,\"steer\":0}";
+  TEST_ASSERT_EQUAL_INT(200, apiDrive(&api, MANUAL, drive, strlen(drive), reply, sizeof(reply)));
+  TEST_ASSERT_EQUAL_STRING("{\"ok\":true}", reply);
+  TEST_ASSERT_EQUAL_INT(0, car.targetA());  // 處理器不碰 car
+  TEST_ASSERT_TRUE(apiApply(&api, car));
+  TEST_ASSERT_EQUAL_INT(60 * MAX_DUTY / 100, car.targetA());
+  TEST_ASSERT_FALSE(apiApply(&api, car));   // 已取出
+  TEST_ASSERT_EQUAL_INT(0, lockDepth);
+
+  // 模式檢查依 loop() 發佈的模式; 本文錯誤先於模式檢查
+  TEST_ASSERT_EQUAL_INT(409, apiDrive(&api, AUTO, drive, strlen(drive), reply, sizeof(reply)));
+  TEST_ASSERT_EQUAL_STRING("{\"error\":\"AUTO mode, switch to MANUAL first\"}", reply);
+  TEST_ASSERT_EQUAL_INT(409, apiDrive(&api, CALIBRATE, drive, strlen(drive), reply, sizeof(reply)));
+  TEST_ASSERT_EQUAL_INT(400, apiDrive(&api, AUTO, "{\"throttle\":101}", 16, reply, sizeof(reply)));
+  TEST_ASSERT_FALSE(apiApply(&api, car));
+}
+
+void test_estop_drops_pending_commands(void) {
+  const char* mission = "{\"segments\":[[60,0,800]]}";
+  const char* mode = "{\"mode\":\"AUTO\"}";
+  TEST_ASSERT_EQUAL_INT(200, apiMission(&api, false, mission, strlen(mission), reply, sizeof(reply)));
+  TEST_ASSERT_EQUAL_STRING("{\"ok\":true,\"segments\":1,\"total_ms\":800}", reply);
+  TEST_ASSERT_EQUAL_INT(200, apiMode(&api, mode, strlen(mode), reply, sizeof(reply)));
+  TEST_ASSERT_EQUAL_INT(200, apiStop(&api, reply, sizeof(reply)));
+  TEST_ASSERT_TRUE(apiApply(&api, car));
+  TEST_ASSERT_FALSE(car.missionActive());
+  TEST_ASSERT_EQUAL(MANUAL, car.mode());
+  TEST_ASSERT_EQUAL_STRING("!!! EMERGENCY STOP Triggered !!!", halNative.lastLog);
+
+  // 急停之後排入的命令照常套用
+  TEST_ASSERT_EQUAL_INT(200, apiStop(&api, reply, sizeof(reply)));
+  TEST_ASSERT_EQUAL_INT(200, apiMission(&api, false, mission, strlen(mission), reply, sizeof(reply)));
+  TEST_ASSERT_TRUE(apiApply(&api, car));
+  TEST_ASSERT_TRUE(car.missionActive());
+}
+
+void test_mission_rejected_during_update(void) {
+  const char* mission = "{\"segments\":[[60,0,800]]}";
+  TEST_ASSERT_EQUAL_INT(409, apiMission(&api, true, mission, strlen(mission), reply, sizeof(reply)));
+  TEST_ASSERT_EQUAL_STRING("{\"error\":\"update in progress\"}", reply);
+  // 處理器通過後才開始更新: loop() 套用時被鎖定拒絕
+  TEST_ASSERT_EQUAL_INT(200, apiMission(&api, false, mission, strlen(mission), reply, sizeof(reply)));
+  car.setDriveLocked(true);
+  TEST_ASSERT_TRUE(apiApply(&api, car));
+  TEST_ASSERT_FALSE(car.missionActive());
+  TEST_ASSERT_EQUAL_STRING("Mission rejected: drive locked", halNative.lastLog);
+}
+
+void test_status_board_is_a_snapshot(void) {
+  StatusBoard status(api.lock);
+  status.publish(car, halNative.nowMs, true);
+  MissionSegment m[] = {{50, 0, 1000}};
+  car.startMission(m, 1);
+  tickFor(10);
+  // 模式與計數每次發佈都更新, JSON 片段每 PERIOD_MS 重建
+  status.publish(car, halNative.nowMs, false);
+  TEST_ASSERT_EQUAL(AUTO, status.mode());
+  TEST_ASSERT_EQUAL_INT(200, status.missionReply(reply, sizeof(reply)));
+  TEST_ASSERT_NOT_NULL(strstr(reply, "\"active\":false"));
+  halNative.nowMs += StatusBoard::PERIOD_MS;
+  status.publish(car, halNative.nowMs, false);
+  status.missionReply(reply, sizeof(reply));
+  TEST_ASSERT_NOT_NULL(strstr(reply, "\"active\":true"));
+  TEST_ASSERT_EQUAL_INT(200, status.latencyReply(reply, sizeof(reply)));
+  TEST_ASSERT_EQUAL_INT(500, status.latencyReply(reply, 8));
+  TEST_ASSERT_EQUAL_STRING("{\"error", reply);
+  TEST_ASSERT_EQUAL_INT(0, lockDepth);
+  TEST_ASSERT_TRUE(lockEntries > 0);
+}
+
+void test_estop_during_calibration_waits_for_loop(void) {
+  TEST_ASSERT_TRUE(car.startCalibration(CAL_A_FWD, 3));
+  for (int i = 0; i < 3; i++) tickFor(CAL_STEP_MS);
+  TEST_ASSERT_TRUE(halNative.pwm[CH_A_FWD] > 0);
+  // 處理器 (async_tcp) 只排入急停: 模式與校正狀態留到 loop() 才改變
+  TEST_ASSERT_EQUAL_INT(200, apiStop(&api, reply, sizeof(reply)));
+  TEST_ASSERT_EQUAL(CALIBRATE, car.mode());
+  TEST_ASSERT_TRUE(car.calibrating());
+  TEST_ASSERT_TRUE(apiApply(&api, car));
+  TEST_ASSERT_EQUAL(MANUAL, car.mode());
+  TEST_ASSERT_FALSE(car.calibrating());
+  TEST_ASSERT_EQUAL_INT(0, halNative.pwm[CH_A_FWD]);
+  TEST_ASSERT_FALSE(halNative.pins[motor_stby]);
+}
+
+void test_peers_and_event_rate(void) {
+  Peer peers[2] = {{"esp32c3-a", "10.0.0.2:80"}, {"esp32c3-b", "10.0.0.3:80"}};
+  char body[256];
+  peersJson("esp32c3-self", "10.0.0.1:80", peers, 2, body, sizeof(body));
+  TEST_ASSERT_EQUAL_STRING("{\"self\":\"esp32c3-self\",\"peers\":[{\"name\":\"esp32c3-self\",\"host\":\"10.0.0.1:80\"},"
+                           "{\"name\":\"esp32c3-a\",\"host\":\"10.0.0.2:80\"},{\"name\":\"esp32c3-b\",\"host\":\"10.0.0.3:80\"}]}",
+                           body);
+  peersJson("emulator-8080", "", peers, 1, body, sizeof(body));
+  TEST_ASSERT_EQUAL_STRING("{\"self\":\"emulator-8080\",\"peers\":[{\"name\":\"esp32c3-a\",\"host\":\"10.0.0.2:80\"}]}", body);
+  TEST_ASSERT_EQUAL_INT(EventStream::DEFAULT_HZ, eventsRate(nullptr));
+  TEST_ASSERT_EQUAL_INT(EventStream::DEFAULT_HZ, eventsRate(""));
+  TEST_ASSERT_EQUAL_INT(0, eventsRate("0"));
+  TEST_ASSERT_EQUAL_INT(5, eventsRate("5"));
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_drive_request_is_validated);
+  RUN_TEST(test_mode_request);
+  RUN_TEST(test_mission_request_bounds);
+  RUN_TEST(test_mission_plays_segments_in_order);
+  RUN_TEST(test_joystick_is_ignored_during_mission);
+  RUN_TEST(test_mission_aborts_on_stop_manual_or_lock);
+  RUN_TEST(test_mission_skips_expired_segments_after_stall);
+  RUN_TEST(test_rest_commands_wait_for_loop);
+  RUN_TEST(test_estop_drops_pending_commands);
+  RUN_TEST(test_mission_rejected_during_update);
+  RUN_TEST(test_status_board_is_a_snapshot);
+  RUN_TEST(test_estop_during_calibration_waits_for_loop);
+  RUN_TEST(test_peers_and_event_rate);
+  return UNITY_END();
+}
@@ -0,0 +1,88 @@
+// 控制熱路徑的微基準 (pio test -e native -f test_bench -v)
+// 只輸出每次呼叫的平均時間, 不做時間斷言 (主機負載會影響結果)。
+
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#include <chrono>
+
+#include "car_control.h"
+#include "hal_native.h"
+#include "json_scan.h"
+
+static const int ITERATIONS = 200000;
+static volatile int sink;
+
+template <typename F>
+static void bench(const char* name, F&& body) {
+  for (int i = 0; i < ITERATIONS / 10; i++) body(i); // 暖機
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < ITERATIONS; i++) body(i);
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  char msg[96];
+  snprintf(msg, sizeof(msg), "%-28s %8.1f ns/call", name, ns / ITERATIONS);
+  TEST_MESSAGE(msg);
+}
+
+static const char* const FRAMES[] = {
+    "{\"steer\":-37,\"throttle\":82}",
+    "{\"steer\":0,\"throttle\":0}",
+    "{\"throttle\":-100,\"steer\":100}",
+    "{\"steer\":12,\"throttle\":45,\"seq\":123456,\"t\":987654321}",
+};
+static size_t frameLen[4];
+
+static bool countField(void* ctx, const JsonField& f) {
+  *static_cast<int*>(ctx) += (int)f.keyLen;
+  return true;
+}
+
+void setUp(void) {
+  halNativeReset();
+  for (int i = 0; i < 4; i++) frameLen[i] = strlen(FRAMES[i]);
+}
+
+void tearDown(void) {}
+
+void test_bench_json_scan(void) {
+  bench("jsonScanObject", [](int i) {
+    int keys = 0;
+    jsonScanObject(FRAMES[i & 3], frameLen[i & 3], countField, &keys);
+    sink = keys;
+  });
+}
+
+void test_bench_decide_outputs(void) {
+  bench("decideOutputs", [](int i) {
+    MotorOutputs out = decideOutputs((i % 511) - 255, ((i * 7) % 511) - 255);
+    sink = out.aFwd + out.bLeft;
+  });
+}
+
+void test_bench_handle_text(void) {
+  CarControl car;
+  car.begin();
+  // 含狀態 JSON 的組裝與廣播 (hal_native 只複製到 lastBroadcast)
+  bench("CarControl::handleText", [&car](int i) {
+    halNative.nowMs = (uint32_t)i;
+    car.handleText(FRAMES[i & 3], frameLen[i & 3]);
+  });
+  TEST_ASSERT_EQUAL_UINT32(ITERATIONS + ITERATIONS / 10, halNative.broadcasts);
+}
+
+void test_bench_tick(void) {
+  CarControl car;
+  car.begin();
+  car.handleText(FRAMES[0], frameLen[0]);
+  bench("CarControl::tick (no timeout)", [&car](int) { car.tick(); });
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_bench_json_scan);
+  RUN_TEST(test_bench_decide_outputs);
+  RUN_TEST(test_bench_handle_text);
+  RUN_TEST(test_bench_tick);
+  return UNITY_END();
+}
@@ -0,0 +1,125 @@
+// 控制流量擷取與重播格式 (pio test -e native)
+// CaptureLog 匯出的文字必須能被 loadDriveScript() 讀回成原本的位元組與時間。
+
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#include <string>
+#include <vector>
+
+#include "capture.h"
+#include "drive_script.h"
+
+static CaptureLog capture;
+
+static std::string exportAll(size_t chunk) {
+  std::string text;
+  char buf[256];
+  size_t n;
+  while ((n = capture.exportText(buf, chunk, text.size())) > 0) text.append(buf, n);
+  return text;
+}
+
+static void roundTrip(const std::string& text, std::vector<ScriptEvent>* events) {
+  const char* path = "capture_test.txt";
+  FILE* f = fopen(path, "w");
+  fwrite(text.data(), 1, text.size(), f);
+  fclose(f);
+  std::string error;
+  bool ok = loadDriveScript(path, events, &error);
+  remove(path);
+  TEST_ASSERT_TRUE_MESSAGE(ok, error.c_str());
+}
+
+static void recordText(const char* s, size_t len, uint32_t ms) {
+  capture.record(CAPTURE_TEXT, 0, (const uint8_t*)s, len, ms);
+}
+
+void setUp(void) {
+  capture = CaptureLog();
+}
+
+void tearDown(void) {}
+
+void test_inactive_capture_records_nothing(void) {
+  recordText("M", 1, 10);
+  TEST_ASSERT_EQUAL_UINT32(0, capture.records());
+}
+
+void test_export_round_trips_frames_and_events(void) {
+  capture.start(1000);
+  capture.record(CAPTURE_CONNECT, 2, nullptr, 0, 1000);
+  recordText("{\"steer\":0,\"throttle\":80}", 27, 1050);
+  // 換行、反斜線、結尾 '\0' 與行首的 '@' / 空白都要原樣讀回
+  static const char odd[] = "@a\\b\nc\r\x01 \0";
+  recordText(odd, sizeof(odd) - 1, 1051);
+  recordText(" S", 2, 1100);
+  capture.record(CAPTURE_DISCONNECT, 2, nullptr, 0, 1300);
+  capture.stop();
+
+  std::vector<ScriptEvent> ev;
+  roundTrip(exportAll(7), &ev); // 小區塊: 跨越跳脫序列的邊界
+  TEST_ASSERT_EQUAL(5, (int)ev.size());
+  TEST_ASSERT_TRUE(ev[0].type == ScriptEventType::CONNECT);
+  TEST_ASSERT_EQUAL(2, ev[0].client);
+  TEST_ASSERT_EQUAL_UINT32(0, ev[0].atMs);
+  TEST_ASSERT_EQUAL_UINT32(50, ev[1].atMs);
+  TEST_ASSERT_EQUAL_STRING("{\"steer\":0,\"throttle\":80}", ev[1].payload.c_str());
+  TEST_ASSERT_EQUAL_UINT32(51, ev[2].atMs);
+  TEST_ASSERT_EQUAL(sizeof(odd) - 1, ev[2].payload.size());
+  TEST_ASSERT_EQUAL_MEMORY(odd, ev[2].payload.data(), sizeof(odd) - 1);
+  TEST_ASSERT_EQUAL_STRING(" S", ev[3].payload.c_str());
+  TEST_ASSERT_TRUE(ev[4].type == ScriptEventType::DISCONNECT);
+  TEST_ASSERT_EQUAL_UINT32(300, ev[4].atMs);
+}
+
+void test_full_buffer_overwrites_oldest(void) {
+  capture.start(0);
+  char frame[64];
+  uint32_t n = 0;
+  while (capture.overwritten() == 0) {
+    int len = snprintf(frame, sizeof(frame), "{\"t\":%u,\"steer\":0,\"throttle\":50}", n);
+    recordText(frame, (size_t)len, n++);
+  }
+  capture.stop();
+  TEST_ASSERT_TRUE(capture.bytesUsed() <= CaptureLog::CAPACITY);
+
+  std::vector<ScriptEvent> ev;
+  roundTrip(exportAll(256), &ev);
+  TEST_ASSERT_EQUAL_UINT32(capture.records(), (uint32_t)ev.size());
+  // 保留的是最新的連續紀錄
+  TEST_ASSERT_EQUAL_UINT32(n - 1, ev.back().atMs);
+  TEST_ASSERT_EQUAL_UINT32(capture.overwritten(), ev.front().atMs);
+}
+
+void test_oversize_frame_is_noted_not_stored(void) {
+  capture.start(0);
+  std::string big(CaptureLog::MAX_FRAME + 1, 'x');
+  recordText(big.data(), big.size(), 5);
+  recordText("M", 1, 6);
+  capture.stop();
+  std::string text = exportAll(256);
+  TEST_ASSERT_NOT_NULL(strstr(text.c_str(), "# 5 client 0 sent 1025 bytes"));
+  std::vector<ScriptEvent> ev;
+  roundTrip(text, &ev);
+  TEST_ASSERT_EQUAL(1, (int)ev.size());
+  TEST_ASSERT_EQUAL_STRING("M", ev[0].payload.c_str());
+}
+
+void test_no_export_while_capturing(void) {
+  capture.start(0);
+  recordText("M", 1, 1);
+  char buf[64];
+  TEST_ASSERT_EQUAL(0, (int)capture.exportText(buf, sizeof(buf), 0));
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_inactive_capture_records_nothing);
+  RUN_TEST(test_export_round_trips_frames_and_events);
+  RUN_TEST(test_full_buffer_overwrites_oldest);
+  RUN_TEST(test_oversize_frame_is_noted_not_stored);
+  RUN_TEST(test_no_export_while_capturing);
+  return UNITY_END();
+}
@@ -0,0 +1,99 @@
+// 時鐘同步與延遲分布 (pio test -e native)
+// 以已知的 offset、漂移與上下行延遲產生交換樣本, 估計值必須收斂到真實值。
+
+#include <math.h>
+#include <stdio.h>
+#include <unity.h>
+
+#include "clock_sync.h"
+
+static ClockSync sync;
+
+// 對端 (瀏覽器) 時鐘: remote = BASE + local * (1 + drift) ; 上行 up ms、下行 down ms
+static const int64_t BASE = 1739000000000LL;
+
+static int64_t remoteAt(double localMs, double drift) {
+  return BASE + (int64_t)llround(localMs * (1 + drift));
+}
+
+// 在本機時間 at 收到請求, 回傳 offset 真實值 (本機 - 對端)
+static double exchange(uint32_t at, double up, double down, double drift) {
+  int64_t t1 = remoteAt(at - up, drift);
+  int64_t t4 = remoteAt(at + down, drift);
+  sync.addSample(t1, at, at, t4);
+  return (double)at - (double)remoteAt(at, drift);
+}
+
+void setUp(void) {
+  sync.reset();
+}
+
+void tearDown(void) {}
+
+void test_symmetric_delay_gives_exact_offset(void) {
+  double truth = exchange(5000, 3, 3, 0);
+  TEST_ASSERT_TRUE(sync.synced());
+  TEST_ASSERT_EQUAL_UINT32(6, sync.minRttMs());
+  TEST_ASSERT_TRUE(fabs(sync.offsetAt(5000) - truth) < 0.01);
+  TEST_ASSERT_TRUE(fabs(sync.toLocal(remoteAt(4990, 0), 5000) - 4990) < 0.01);
+}
+
+void test_min_delay_sample_wins_in_window(void) {
+  // 排隊造成的大延遲只在上行: 那些樣本的 offset 偏差 (up-down)/2, 必須被視窗濾掉
+  double truth = 0;
+  for (int i = 0; i < ClockSync::WINDOW * 3; i++) {
+    bool queued = i % ClockSync::WINDOW != 1;
+    truth = exchange(1000 + i * 1000, queued ? 40 : 2, 2, 0);
+  }
+  TEST_ASSERT_TRUE(fabs(sync.offsetAt(1000 + ClockSync::WINDOW * 3 * 1000) - truth) < 1.0);
+}
+
+void test_drift_is_estimated(void) {
+  const double drift = 80e-6; // 80 ppm
+  uint32_t at = 0;
+  for (int i = 0; i < ClockSync::WINDOW * ClockSync::POINTS; i++) {
+    at = 2000 + i * 1000;
+    exchange(at, 2 + i % 3, 2, drift);
+  }
+  // 對端走得快: 本機相對對端為負漂移
+  TEST_ASSERT_TRUE(fabs(sync.driftPpm() + 80) < 20);
+  // 外推 10 秒後的誤差仍在 2 ms 內
+  double later = (double)(at + 10000) - (double)remoteAt(at + 10000, drift);
+  TEST_ASSERT_TRUE(fabs(sync.offsetAt(at + 10000) - later) < 2.0);
+}
+
+void test_remote_clock_step_restarts(void) {
+  for (int i = 0; i < ClockSync::WINDOW * 2; i++) exchange(1000 + i * 1000, 2, 2, 0);
+  uint32_t before = sync.samples();
+  // 瀏覽器時間被往前調 1 小時
+  sync.addSample(BASE + 3600000 + 20000, 20002, 20002, BASE + 3600000 + 20004);
+  TEST_ASSERT_TRUE(sync.samples() < before);
+  TEST_ASSERT_TRUE(fabs(sync.offsetAt(20002) - (20002.0 - (double)(BASE + 3600000 + 20002))) < 0.01);
+}
+
+void test_histogram_percentiles_and_json(void) {
+  LatencyHistogram h;
+  for (int i = 0; i < 90; i++) h.add(2.5);
+  for (int i = 0; i < 9; i++) h.add(18);
+  h.add(-1);
+  TEST_ASSERT_EQUAL_UINT32(100, h.count());
+  TEST_ASSERT_EQUAL_UINT32(1, h.early());
+  TEST_ASSERT_EQUAL_UINT16(3, h.percentile(0.5));
+  TEST_ASSERT_EQUAL_UINT16(18, h.percentile(0.95)); // 區間上限 20, 但最大值只有 18
+  char buf[256];
+  TEST_ASSERT_TRUE(h.toJson(buf, sizeof(buf)) > 0);
+  TEST_ASSERT_EQUAL_STRING(
+      "{\"n\":100,\"early\":1,\"mean\":3.9,\"p50\":3,\"p95\":18,\"p99\":18,\"max\":18,\"bins\":[[1,1],[3,90],[20,9]]}",
+      buf);
+  TEST_ASSERT_EQUAL(0, (int)h.toJson(buf, 20));
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_symmetric_delay_gives_exact_offset);
+  RUN_TEST(test_min_delay_sample_wins_in_window);
+  RUN_TEST(test_drift_is_estimated);
+  RUN_TEST(test_remote_clock_step_restarts);
+  RUN_TEST(test_histogram_percentiles_and_json);
+  return UNITY_END();
+}
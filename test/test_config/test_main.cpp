@@ -0,0 +1,391 @@
+// 執行期設定: 驗證、tick 邊界套用、合併寫入與每台車的 profile (pio test -e native)
+// 儲存層為 host/config_backend_file.cpp 的記憶體模式, 時間由 halNative.nowMs 手動推進。
+
+#include <string.h>
+#include <unity.h>
+
+#include "car_control.h"
+#include "car_profiles.h"
+#include "config_backend.h"
+#include "config_backend_file.h"
+#include "config_store.h"
+#include "hal_native.h"
+#include "web_api.h"
+
+static ConfigStore config;
+static CarControl car;
+static char err[96];
+
+static bool stage(const char* json) {
+  CarConfig cfg = config.latest();
+  if (!ConfigStore::parse(json, strlen(json), config.active(), &cfg, err, sizeof(err))) return false;
+  config.stage(cfg);
+  return true;
+}
+
+// 與 loop() 相同的順序: 套用設定、寫入、控制 tick
+static void loopOnce() {
+  if (config.applyPending(halNative.nowMs)) car.configure(config.active());
+  config.tick(halNative.nowMs);
+  car.tick();
+}
+
+void setUp(void) {
+  halNativeReset();
+  halNative.nowMs = 1000;
+  cfgFileBackendBegin(nullptr);
+  config = ConfigStore();
+  config.begin();
+  car = CarControl();
+  car.configure(config.active());
+  car.begin();
+}
+
+void tearDown(void) {}
+
+void test_defaults_match_compiled_constants(void) {
+  const CarConfig& cfg = config.active();
+  TEST_ASSERT_EQUAL_UINT32(PWM_FREQ, cfg.pwmFreq);
+  TEST_ASSERT_EQUAL_UINT8(PWM_RES, cfg.pwmRes);
+  TEST_ASSERT_EQUAL_UINT16(MAX_DUTY, cfg.maxDuty);
+  TEST_ASSERT_EQUAL_UINT16(COMMAND_TIMEOUT, cfg.commandTimeoutMs);
+  TEST_ASSERT_EQUAL_UINT8(motor_stby, cfg.pinStby);
+  TEST_ASSERT_EQUAL_UINT16(0, config.stats().loaded);
+}
+
+void test_invalid_batch_is_rejected_whole(void) {
+  TEST_ASSERT_FALSE(stage("{\"min_duty\":40,\"cmd_timeout\":10}"));
+  TEST_ASSERT_EQUAL_STRING("cmd_timeout: must be an integer 50..5000", err);
+  TEST_ASSERT_FALSE(stage("{\"min_duty\":40,\"deadband\":3}"));
+  TEST_ASSERT_EQUAL_STRING("unknown key: deadband", err);
+  TEST_ASSERT_FALSE(stage("{\"max_duty\":1023}"));  // 執行中仍是 8-bit
+  TEST_ASSERT_FALSE(stage("{\"min_duty\":300}"));
+  TEST_ASSERT_FALSE(stage("{\"pin_b_left\":3}"));   // 與 pin_a_fwd 重複
+  TEST_ASSERT_FALSE(stage("{\"pin_stby\":18}"));    // USB
+  TEST_ASSERT_FALSE(stage("{\"pwm_freq\":40000,\"pwm_res\":12}"));
+  TEST_ASSERT_FALSE(stage("{\"min_duty\":40.5}"));
+  loopOnce();
+  TEST_ASSERT_EQUAL_UINT16(MIN_DUTY, config.active().minDuty);
+  TEST_ASSERT_EQUAL_UINT32(0, config.stats().applied);
+}
+
+void test_live_fields_apply_at_tick_boundary(void) {
+  TEST_ASSERT_TRUE(stage("{\"min_duty\":40,\"max_duty\":200}"));
+  // 暫存期間控制核心仍用舊的值
+  car.drive(0, 10);
+  TEST_ASSERT_EQUAL_INT(10 * MAX_DUTY / 100, halNative.pwm[CH_B_RIGHT]);
+  loopOnce();
+  car.drive(0, 10);
+  TEST_ASSERT_EQUAL_INT(40, halNative.pwm[CH_B_RIGHT]);  // 20 < min_duty
+  car.drive(100, 0);
+  TEST_ASSERT_EQUAL_INT(200, halNative.pwm[CH_A_FWD]);
+}
+
+void test_command_timeout_is_configurable(void) {
+  TEST_ASSERT_TRUE(stage("{\"cmd_timeout\":1000}"));
+  loopOnce();
+  car.drive(50, 0);
+  halNative.nowMs += COMMAND_TIMEOUT + 1;
+  loopOnce();
+  TEST_ASSERT_TRUE(halNative.pins[motor_stby]);
+  halNative.nowMs += 1000;
+  loopOnce();
+  TEST_ASSERT_FALSE(halNative.pins[motor_stby]);
+}
+
+void test_reboot_fields_wait_for_next_boot(void) {
+  TEST_ASSERT_TRUE(stage("{\"pwm_res\":10,\"pin_stby\":6}"));
+  loopOnce();
+  TEST_ASSERT_EQUAL_UINT8(PWM_RES, config.active().pwmRes);
+  char json[512];
+  TEST_ASSERT_TRUE(config.toJson(json, sizeof(json)) > 0);
+  TEST_ASSERT_NOT_NULL(strstr(json, "\"reboot\":[\"pwm_res\",\"pin_stby\"]"));
+  config.flush();
+  // 重新開機: 從儲存層讀回, 新的解析度下 max_duty 可以超過 255
+  config = ConfigStore();
+  config.begin();
+  TEST_ASSERT_EQUAL_UINT8(10, config.active().pwmRes);
+  TEST_ASSERT_EQUAL_UINT8(6, config.active().pinStby);
+  TEST_ASSERT_EQUAL_UINT16(2, config.stats().loaded);
+  TEST_ASSERT_TRUE(stage("{\"max_duty\":1023}"));
+}
+
+void test_writes_are_coalesced(void) {
+  // 拖動滑桿: 每 100 ms 一次修改, 最後一次之後 SAVE_DELAY_MS 才寫入一次
+  for (int duty = 20; duty <= 60; duty += 2) {
+    char json[32];
+    snprintf(json, sizeof(json), "{\"min_duty\":%d}", duty);
+    TEST_ASSERT_TRUE(stage(json));
+    loopOnce();
+    halNative.nowMs += 100;
+  }
+  TEST_ASSERT_EQUAL_UINT32(0, cfgFileBackendCommits());
+  TEST_ASSERT_TRUE(config.dirty());
+  halNative.nowMs += ConfigStore::SAVE_DELAY_MS;
+  loopOnce();
+  TEST_ASSERT_EQUAL_UINT32(1, cfgFileBackendCommits());
+  TEST_ASSERT_EQUAL_UINT32(2, cfgFileBackendWrites());  // "ver" 與 min_duty
+  uint32_t value;
+  TEST_ASSERT_TRUE(cfgBackendRead("min_duty", &value));
+  TEST_ASSERT_EQUAL_UINT32(60, value);
+  // 改回原本的值: 不再寫入
+  TEST_ASSERT_TRUE(stage("{\"min_duty\":40}"));
+  loopOnce();
+  TEST_ASSERT_TRUE(stage("{\"min_duty\":60}"));
+  loopOnce();
+  TEST_ASSERT_FALSE(config.dirty());
+}
+
+void test_invalid_stored_values_fall_back_to_defaults(void) {
+  cfgBackendWrite("min_duty", 70000);  // 超出範圍: 只捨棄這個欄位
+  cfgBackendWrite("cmd_timeout", 500);
+  cfgBackendWrite("pin_stby", 3);      // 與 pin_a_fwd 重複: 整組捨棄
+  config = ConfigStore();
+  config.begin();
+  TEST_ASSERT_EQUAL_UINT16(COMMAND_TIMEOUT, config.active().commandTimeoutMs);
+  TEST_ASSERT_EQUAL_UINT8(motor_stby, config.active().pinStby);
+  TEST_ASSERT_EQUAL_UINT32(2, config.stats().failures);
+
+  cfgFileBackendBegin(nullptr);
+  cfgBackendWrite("cmd_timeout", 500);
+  cfgBackendWrite("ver", ConfigStore::VERSION + 1);  // 較新的韌體寫入 (降版後): 不讀取
+  config = ConfigStore();
+  config.begin();
+  TEST_ASSERT_EQUAL_UINT16(COMMAND_TIMEOUT, config.active().commandTimeoutMs);
+}
+
+// 與 main.cpp 的 onWsConfig 相同 (web_api.h): 驗證並暫存, 回覆最新的設定或錯誤
+static size_t wsConfig(void*, const char* json, size_t len, char* reply, size_t maxLen) {
+  return configWsReply(&config, NO_LOCK, json, len, reply, maxLen);
+}
+
+void test_websocket_config_goes_through_handler(void) {
+  car.onConfig(wsConfig, nullptr);
+  const char* msg = "{\"cfg\":{\"min_duty\":35}}";
+  car.handleText(msg, strlen(msg), 2);
+  TEST_ASSERT_EQUAL_INT(2, halNative.lastSendClient);
+  TEST_ASSERT_NOT_NULL(strstr(halNative.lastSend, "\"min_duty\":35"));
+  TEST_ASSERT_EQUAL_UINT32(0, car.stats().applied);  // 不是駕駛命令
+  const char* bad = "{\"cfg\":{\"min_duty\":-1}}";
+  car.handleText(bad, strlen(bad), 2);
+  TEST_ASSERT_EQUAL_STRING("{\"cfg\":null,\"error\":\"min_duty: must be an integer 0..16383\"}", halNative.lastSend);
+  loopOnce();
+  TEST_ASSERT_EQUAL_UINT16(35, config.active().minDuty);
+}
+
+static const uint8_t BLUE_4WD_MAC[6] = {0x0C, 0x4E, 0xA0, 0x32, 0xAD, 0x7C};
+
+void test_profile_selected_by_mac_or_nvs(void) {
+  uint8_t unknown[6] = {0x0C, 0x4E, 0xA0, 0x00, 0x00, 0x01};
+  config = ConfigStore();
+  config.begin(unknown);
+  TEST_ASSERT_EQUAL_STRING("default", CAR_PROFILES[config.profileIndex()].name);
+  config = ConfigStore();
+  config.begin(BLUE_4WD_MAC);
+  TEST_ASSERT_EQUAL_STRING("blue-4wd", CAR_PROFILES[config.profileIndex()].name);
+  TEST_ASSERT_EQUAL_UINT8(MIX_DIFF, config.active().mixMode);
+  // NVS 指定的 profile 優先於 MAC, 個別欄位再覆寫 profile 的值
+  int alt = CAR_PROFILE_COUNT - 1;
+  char json[48];
+  snprintf(json, sizeof(json), "{\"profile\":%d,\"min_duty\":30}", alt);
+  TEST_ASSERT_TRUE(stage(json));
+  loopOnce();
+  config.flush();
+  config = ConfigStore();
+  config.begin(BLUE_4WD_MAC);
+  TEST_ASSERT_EQUAL_STRING("alt-pins", CAR_PROFILES[config.profileIndex()].name);
+  TEST_ASSERT_EQUAL_UINT8(6, config.active().pinAFwd);
+  TEST_ASSERT_EQUAL_UINT16(30, config.active().minDuty);
+  snprintf(json, sizeof(json), "{\"profile\":%d}", CAR_PROFILE_COUNT);
+  TEST_ASSERT_FALSE(stage(json));
+}
+
+void test_differential_mixing_with_expo(void) {
+  config = ConfigStore();
+  config.begin(BLUE_4WD_MAC);  // MIX_DIFF, expo_throttle 40, expo_steer 30
+  car.configure(config.active());
+  car.drive(100, 0);
+  TEST_ASSERT_EQUAL_INT(MAX_DUTY, halNative.pwm[CH_A_FWD]);    // 左側前進
+  TEST_ASSERT_EQUAL_INT(MAX_DUTY, halNative.pwm[CH_B_RIGHT]);  // 右側前進 (B 的 RIGHT 通道)
+  // 50% 油門經 expo 40: 50·0.6 + 0.125·40 = 35%
+  car.drive(50, 0);
+  TEST_ASSERT_EQUAL_INT(35 * MAX_DUTY / 100, halNative.pwm[CH_A_FWD]);
+  // 原地右轉: 左側前進、右側後退
+  car.drive(0, 100);
+  TEST_ASSERT_EQUAL_INT(MAX_DUTY, halNative.pwm[CH_A_FWD]);
+  TEST_ASSERT_EQUAL_INT(MAX_DUTY, halNative.pwm[CH_B_LEFT]);
+  TEST_ASSERT_EQUAL_INT(0, halNative.pwm[CH_B_RIGHT]);
+  // 混控結果截斷在 ±100
+  car.drive(100, 100);
+  TEST_ASSERT_EQUAL_INT(MAX_DUTY, halNative.pwm[CH_A_FWD]);
+  TEST_ASSERT_EQUAL_INT(0, halNative.pwm[CH_B_LEFT]);
+  TEST_ASSERT_EQUAL_INT(0, halNative.pwm[CH_B_RIGHT]);
+  // 兩側都套用 min_duty
+  TEST_ASSERT_TRUE(stage("{\"min_duty\":60,\"expo_throttle\":0}"));
+  loopOnce();
+  car.drive(5, 0);
+  TEST_ASSERT_EQUAL_INT(60, halNative.pwm[CH_A_FWD]);
+  TEST_ASSERT_EQUAL_INT(60, halNative.pwm[CH_B_RIGHT]);
+}
+
+static void sendFrom(int client, const char* text) { car.handleText(text, strlen(text), client); }
+
+static void stepCalibration(int steps) {
+  for (int i = 0; i < steps; i++) {
+    halNative.nowMs += CAL_STEP_MS;
+    loopOnce();
+  }
+}
+
+void test_calibration_stores_per_direction_floor(void) {
+  car.onConfig(wsConfig, nullptr);
+  const int step = (MAX_DUTY + CAL_STEPS - 1) / CAL_STEPS;
+  sendFrom(3, "{\"cal\":\"b_left\"}");
+  TEST_ASSERT_EQUAL_INT(CALIBRATE, car.mode());
+  TEST_ASSERT_EQUAL_INT(3, halNative.lastSendClient);
+  TEST_ASSERT_NOT_NULL(strstr(halNative.lastSend, "\"ch\":\"b_left\",\"state\":\"ramp\",\"duty\":0"));
+  stepCalibration(4);
+  TEST_ASSERT_EQUAL_INT(4 * step, halNative.pwm[CH_B_LEFT]);
+  TEST_ASSERT_EQUAL_INT(0, halNative.pwm[CH_B_RIGHT] + halNative.pwm[CH_A_FWD] + halNative.pwm[CH_A_REV]);
+  // 校正期間搖桿命令被忽略, 也不會觸發命令超時
+  sendFrom(3, "{\"steer\":100,\"throttle\":100}");
+  TEST_ASSERT_EQUAL_INT(4 * step, halNative.pwm[CH_B_LEFT]);
+  stepCalibration(1);
+  TEST_ASSERT_EQUAL_INT(5 * step, halNative.pwm[CH_B_LEFT]);
+
+  sendFrom(3, "{\"cal\":\"mark\"}");
+  TEST_ASSERT_EQUAL_INT(MANUAL, car.mode());
+  TEST_ASSERT_FALSE(halNative.pins[motor_stby]);
+  TEST_ASSERT_EQUAL_UINT16(5 * step, config.latest().floorBLeft);
+  loopOnce();
+  // 只有校正過的方向使用新的下限, 右轉仍使用 min_duty (0)
+  car.drive(0, -1);
+  TEST_ASSERT_EQUAL_INT(5 * step, halNative.pwm[CH_B_LEFT]);
+  car.drive(0, 1);
+  TEST_ASSERT_EQUAL_INT(MAX_DUTY / 100, halNative.pwm[CH_B_RIGHT]);
+  // 油門的下限: MIX_STEER 時原本沒有, 校正後套用
+  sendFrom(3, "{\"cal\":\"a_fwd\"}");
+  stepCalibration(2);
+  sendFrom(3, "{\"cal\":\"mark\"}");
+  loopOnce();
+  car.drive(1, 0);
+  TEST_ASSERT_EQUAL_INT(2 * step, halNative.pwm[CH_A_FWD]);
+  config.flush();
+  uint32_t value = 0;
+  TEST_ASSERT_TRUE(cfgBackendRead("floor_b_left", &value));
+  TEST_ASSERT_EQUAL_UINT32(5 * step, value);
+}
+
+void test_calibration_stops_safely(void) {
+  car.onConfig(wsConfig, nullptr);
+  // 到 max_duty 都沒有確認: 停止, 不寫入設定
+  sendFrom(3, "{\"cal\":\"a_rev\"}");
+  stepCalibration(CAL_STEPS + 1);
+  TEST_ASSERT_EQUAL_INT(MANUAL, car.mode());
+  TEST_ASSERT_FALSE(halNative.pins[motor_stby]);
+  TEST_ASSERT_NOT_NULL(strstr(halNative.lastSend, "\"state\":\"failed\""));
+  TEST_ASSERT_EQUAL_UINT16(0, config.latest().floorARev);
+  // 急停、{"cal":"stop"}、斷線與 OTA 鎖定都會中止
+  sendFrom(3, "{\"cal\":\"a_rev\"}");
+  stepCalibration(3);
+  sendFrom(3, "S");
+  TEST_ASSERT_EQUAL_INT(MANUAL, car.mode());
+  TEST_ASSERT_EQUAL_INT(0, halNative.pwm[CH_A_REV]);
+  sendFrom(3, "{\"cal\":\"a_rev\"}");
+  stepCalibration(3);
+  sendFrom(3, "{\"cal\":\"stop\"}");
+  TEST_ASSERT_NOT_NULL(strstr(halNative.lastSend, "\"state\":\"aborted\""));
+  TEST_ASSERT_EQUAL_INT(0, halNative.pwm[CH_A_REV]);
+  sendFrom(3, "{\"cal\":\"a_rev\"}");
+  stepCalibration(3);
+  car.onClientDisconnected(3);
+  TEST_ASSERT_EQUAL_INT(MANUAL, car.mode());
+  TEST_ASSERT_EQUAL_INT(0, halNative.pwm[CH_A_REV]);
+  sendFrom(3, "{\"cal\":\"a_rev\"}");
+  car.setDriveLocked(true);
+  stepCalibration(1);
+  TEST_ASSERT_EQUAL_INT(MANUAL, car.mode());
+  TEST_ASSERT_EQUAL_INT(0, halNative.pwm[CH_A_REV]);
+  sendFrom(3, "{\"cal\":\"a_rev\"}");
+  TEST_ASSERT_EQUAL_STRING("{\"cal\":null,\"error\":\"drive locked\"}", halNative.lastSend);
+  car.setDriveLocked(false);
+  sendFrom(3, "{\"cal\":\"mark\"}");
+  TEST_ASSERT_EQUAL_STRING("{\"cal\":null,\"error\":\"not ramping\"}", halNative.lastSend);
+  // 下限不可超過 max_duty
+  TEST_ASSERT_FALSE(stage("{\"floor_b_right\":300}"));
+  TEST_ASSERT_EQUAL_STRING("floor_b_right: must not exceed max_duty (255)", err);
+}
+
+// 伺服模式沒有設定 Motor B 的 LEDC 通道: 記錄是否有寫入
+static uint32_t motorBWrites = 0;
+static void countMotorB(void*, uint8_t channel, uint32_t) {
+  if (channel == CH_B_LEFT || channel == CH_B_RIGHT) motorBWrites++;
+}
+
+static uint32_t servoDuty(uint32_t us, uint32_t hz) { return (uint32_t)((uint64_t)us * hz * (1u << SERVO_RES) / 1000000); }
+
+void test_servo_steering(void) {
+  // steer_mode / servo_pin / servo_hz 重新開機後生效
+  TEST_ASSERT_TRUE(stage("{\"steer_mode\":1,\"servo_hz\":100}"));
+  loopOnce();
+  TEST_ASSERT_EQUAL_UINT8(STEER_MOTOR, config.active().steerMode);
+  config.flush();
+  config = ConfigStore();
+  config.begin();
+  car = CarControl();
+  car.configure(config.active());
+  motorBWrites = 0;
+  halNative.onPwm = countMotorB;
+  car.begin();
+  TEST_ASSERT_EQUAL_INT(servoDuty(SERVO_CENTER_US, 100), halNative.pwm[CH_SERVO]);
+  car.drive(50, 100);
+  TEST_ASSERT_EQUAL_INT(servoDuty(SERVO_MAX_US, 100), halNative.pwm[CH_SERVO]);
+  TEST_ASSERT_EQUAL_INT(50 * MAX_DUTY / 100, halNative.pwm[CH_A_FWD]);
+  TEST_ASSERT_EQUAL_INT(0, halNative.pwm[CH_B_LEFT] + halNative.pwm[CH_B_RIGHT]);
+  car.drive(50, -50);
+  TEST_ASSERT_EQUAL_INT(servoDuty((SERVO_MIN_US + SERVO_CENTER_US) / 2, 100), halNative.pwm[CH_SERVO]);
+  // 命令超時: 伺服回到中心
+  halNative.nowMs += COMMAND_TIMEOUT + 1;
+  car.tick();
+  TEST_ASSERT_EQUAL_INT(servoDuty(SERVO_CENTER_US, 100), halNative.pwm[CH_SERVO]);
+  car.emergencyStop();
+  TEST_ASSERT_EQUAL_UINT32(0, motorBWrites);
+  halNative.onPwm = nullptr;
+  // 端點與中心即時生效 (停車時立即寫入新的中心); min > max 為反向
+  TEST_ASSERT_TRUE(stage("{\"servo_min_us\":2100,\"servo_center_us\":1550,\"servo_max_us\":900}"));
+  loopOnce();
+  TEST_ASSERT_EQUAL_INT(servoDuty(1550, 100), halNative.pwm[CH_SERVO]);
+  car.drive(0, 100);
+  TEST_ASSERT_EQUAL_INT(servoDuty(900, 100), halNative.pwm[CH_SERVO]);
+  // 轉向不是 Motor B: 不能校正
+  sendFrom(3, "{\"cal\":\"b_left\"}");
+  TEST_ASSERT_EQUAL_STRING("{\"cal\":null,\"error\":\"steering is a servo (steer_mode 1)\"}", halNative.lastSend);
+  TEST_ASSERT_EQUAL_INT(MANUAL, car.mode());
+  // 驗證: 中心在端點之間、只能搭配 MIX_STEER、腳位不可重複
+  TEST_ASSERT_FALSE(stage("{\"servo_center_us\":2200}"));
+  TEST_ASSERT_EQUAL_STRING("servo_center_us: must be between servo_min_us and servo_max_us", err);
+  TEST_ASSERT_FALSE(stage("{\"mix\":1}"));
+  TEST_ASSERT_EQUAL_STRING("steer_mode: servo needs mix 0", err);
+  char json[48];
+  snprintf(json, sizeof(json), "{\"servo_pin\":%d}", motor_stby);
+  TEST_ASSERT_FALSE(stage(json));
+  TEST_ASSERT_EQUAL_STRING("servo_pin: GPIO 4 already used by pin_stby", err);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_defaults_match_compiled_constants);
+  RUN_TEST(test_invalid_batch_is_rejected_whole);
+  RUN_TEST(test_live_fields_apply_at_tick_boundary);
+  RUN_TEST(test_command_timeout_is_configurable);
+  RUN_TEST(test_reboot_fields_wait_for_next_boot);
+  RUN_TEST(test_writes_are_coalesced);
+  RUN_TEST(test_invalid_stored_values_fall_back_to_defaults);
+  RUN_TEST(test_websocket_config_goes_through_handler);
+  RUN_TEST(test_profile_selected_by_mac_or_nvs);
+  RUN_TEST(test_differential_mixing_with_expo);
+  RUN_TEST(test_calibration_stores_per_direction_floor);
+  RUN_TEST(test_calibration_stops_safely);
+  RUN_TEST(test_servo_steering);
+  return UNITY_END();
+}
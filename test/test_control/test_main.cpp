@@ -0,0 +1,272 @@
+// 控制核心 (car_control) 的失效保護測試 (pio test -e native)
+// 時間由 halNative.nowMs 手動推進, 硬體輸出由 host/hal_native.cpp 記錄。
+
+#include <string.h>
+#include <unity.h>
+
+#include "car_control.h"
+#include "gpio_pins.h"
+#include "hal_native.h"
+
+static CarControl car;
+
+static void send(const char* text) { car.handleText(text, strlen(text)); }
+
+static bool motorsOff() {
+  return !halNative.pins[motor_stby] && halNative.pwm[CH_A_FWD] == 0 && halNative.pwm[CH_A_REV] == 0 &&
+         halNative.pwm[CH_B_LEFT] == 0 && halNative.pwm[CH_B_RIGHT] == 0;
+}
+
+void setUp(void) {
+  halNativeReset();
+  halNative.nowMs = 1000;
+  car = CarControl();
+  car.begin();
+}
+
+void tearDown(void) {}
+
+void test_joystick_drives_motors(void) {
+  send("{\"steer\":-40,\"throttle\":100}");
+  TEST_ASSERT_TRUE(halNative.pins[motor_stby]);
+  TEST_ASSERT_EQUAL_INT(MAX_DUTY, halNative.pwm[CH_A_FWD]);
+  TEST_ASSERT_EQUAL_INT(0, halNative.pwm[CH_A_REV]);
+  TEST_ASSERT_EQUAL_INT(40 * MAX_DUTY / 100, halNative.pwm[CH_B_LEFT]);
+  TEST_ASSERT_EQUAL_INT(0, halNative.pwm[CH_B_RIGHT]);
+  TEST_ASSERT_EQUAL_STRING(
+      "{\"motorA\":255,\"motorB\":-102,\"debug\":\"JSTK_Raw:100/-40 | DutyA:255/DutyB:-102 | Mode:MANUAL\"}",
+      halNative.lastBroadcast);
+}
+
+void test_input_is_clamped(void) {
+  send("{\"steer\":500,\"throttle\":-250}");
+  TEST_ASSERT_EQUAL_INT(-MAX_DUTY, car.targetA());
+  TEST_ASSERT_EQUAL_INT(MAX_DUTY, car.targetB());
+  TEST_ASSERT_EQUAL_INT(MAX_DUTY, halNative.pwm[CH_A_REV]);
+  TEST_ASSERT_EQUAL_INT(MAX_DUTY, halNative.pwm[CH_B_RIGHT]);
+}
+
+void test_timeout_stops_after_300ms(void) {
+  send("{\"steer\":0,\"throttle\":60}");
+  halNative.nowMs += COMMAND_TIMEOUT;
+  car.tick();
+  TEST_ASSERT_FALSE(motorsOff()); // 剛好 300 ms 還不算超時
+  halNative.nowMs += 1;
+  car.tick();
+  TEST_ASSERT_TRUE(motorsOff());
+  TEST_ASSERT_EQUAL_STRING("Motors stopped due to command timeout.", halNative.lastLog);
+  TEST_ASSERT_EQUAL_INT(0, car.targetA());
+}
+
+void test_commands_keep_motors_alive(void) {
+  for (int i = 0; i < 20; i++) {
+    send("{\"steer\":10,\"throttle\":60}");
+    halNative.nowMs += COMMAND_TIMEOUT - 50;
+    car.tick();
+    TEST_ASSERT_FALSE(motorsOff());
+  }
+}
+
+void test_timeout_logs_once_when_idle(void) {
+  halNative.nowMs += 10 * COMMAND_TIMEOUT;
+  uint32_t logs = halNative.logs;
+  car.tick();
+  TEST_ASSERT_EQUAL_UINT32(logs, halNative.logs); // 馬達已停止, 不重複記錄
+}
+
+void test_single_char_refreshes_timeout(void) {
+  send("{\"steer\":0,\"throttle\":60}");
+  halNative.nowMs += 200;
+  send("M");
+  halNative.nowMs += 200;
+  car.tick();
+  TEST_ASSERT_FALSE(motorsOff());
+}
+
+void test_emergency_stop(void) {
+  send("{\"steer\":30,\"throttle\":60}");
+  send("S");
+  TEST_ASSERT_TRUE(motorsOff());
+  TEST_ASSERT_EQUAL_STRING("!!! EMERGENCY STOP Triggered !!!", halNative.lastLog);
+  // 急停後新的命令可再次啟動馬達
+  send("{\"steer\":0,\"throttle\":60}");
+  TEST_ASSERT_FALSE(motorsOff());
+}
+
+void test_disconnect_stops_motors(void) {
+  send("{\"steer\":30,\"throttle\":-60}");
+  car.onClientDisconnected();
+  TEST_ASSERT_TRUE(motorsOff());
+}
+
+void test_auto_mode_ignores_joystick(void) {
+  send("A");
+  TEST_ASSERT_EQUAL(AUTO, car.mode());
+  send("{\"steer\":30,\"throttle\":60}");
+  TEST_ASSERT_TRUE(motorsOff());
+  TEST_ASSERT_NOT_NULL(strstr(halNative.lastBroadcast, "Mode:AUTO"));
+}
+
+void test_drive_lock_ignores_joystick(void) {
+  car.setDriveLocked(true);
+  send("{\"steer\":30,\"throttle\":60}");
+  TEST_ASSERT_TRUE(motorsOff());
+  car.setDriveLocked(false);
+  send("{\"steer\":30,\"throttle\":60}");
+  TEST_ASSERT_FALSE(motorsOff());
+}
+
+void test_invalid_json_keeps_state(void) {
+  send("{\"steer\":30,\"throttle\":60}");
+  uint32_t broadcasts = halNative.broadcasts;
+  send("{\"steer\":30,\"throttle\":");
+  TEST_ASSERT_EQUAL_STRING("WS Error: JSON parse failed: IncompleteInput", halNative.lastLog);
+  send("steer=30");
+  TEST_ASSERT_EQUAL_STRING("WS Error: JSON parse failed: InvalidInput", halNative.lastLog);
+  TEST_ASSERT_EQUAL_UINT32(broadcasts, halNative.broadcasts);
+  TEST_ASSERT_EQUAL_INT(60 * MAX_DUTY / 100, car.targetA());
+}
+
+void test_non_integer_fields_default_to_zero(void) {
+  // 與 ArduinoJson 的 `doc["steer"] | 0` 相同
+  send("{\"steer\":\"left\",\"throttle\":12.5,\"extra\":{\"a\":[1,2]}}");
+  TEST_ASSERT_EQUAL_INT(0, car.targetA());
+  TEST_ASSERT_EQUAL_INT(0, car.targetB());
+}
+
+void test_out_of_range_fields_default_to_zero(void) {
+  // 超出 int 範圍時不截斷 (2^32+40 截斷後會變成 40), 與 ArduinoJson 相同回傳預設值
+  send("{\"steer\":4294967336,\"throttle\":-4294967196}");
+  TEST_ASSERT_EQUAL_INT(0, car.targetA());
+  TEST_ASSERT_EQUAL_INT(0, car.targetB());
+  send("{\"steer\":-2147483648,\"throttle\":2147483647}");
+  TEST_ASSERT_EQUAL_INT(MAX_DUTY, car.targetA());
+  TEST_ASSERT_EQUAL_INT(-MAX_DUTY, car.targetB());
+}
+
+void test_only_changed_channels_written(void) {
+  send("{\"steer\":20,\"throttle\":60}");
+  uint32_t writes = halNative.pwmWrites;
+  send("{\"steer\":20,\"throttle\":60}");
+  TEST_ASSERT_EQUAL_UINT32(writes, halNative.pwmWrites);
+  send("{\"steer\":20,\"throttle\":-60}");
+  TEST_ASSERT_EQUAL_UINT32(writes + 2, halNative.pwmWrites); // A fwd -> 0, A rev -> duty
+}
+
+void test_timestamp_is_acknowledged(void) {
+  send("{\"t\":1729150000123,\"steer\":0,\"throttle\":10}");
+  TEST_ASSERT_NOT_NULL(strstr(halNative.lastBroadcast, "\"ack\":1729150000123}"));
+  send("A");
+  send("{\"t\":7,\"steer\":0,\"throttle\":10}");
+  send("{bad");
+  const ControlStats& st = car.stats();
+  TEST_ASSERT_EQUAL_UINT32(4, st.frames);
+  TEST_ASSERT_EQUAL_UINT32(1, st.applied);
+  TEST_ASSERT_EQUAL_UINT32(1, st.ignored);
+  TEST_ASSERT_EQUAL_UINT32(1, st.parseErrors);
+}
+
+void test_ping_replies_to_sender_only(void) {
+  send("{\"steer\":0,\"throttle\":50}");
+  uint32_t lastCommand = car.lastCommandMs();
+  int targetA = car.targetA();
+  uint32_t broadcasts = halNative.broadcasts;
+  halNative.rssi = -61;
+  halNative.nowMs += 200;
+  car.handleText("{\"ping\":1729150000999}", 22, 3);
+  TEST_ASSERT_EQUAL_UINT32(1, halNative.sends);
+  TEST_ASSERT_EQUAL_INT(3, halNative.lastSendClient);
+  TEST_ASSERT_NOT_NULL(strstr(halNative.lastSend, "{\"pong\":1729150000999,\"rssi\":-61,"));
+  TEST_ASSERT_EQUAL_UINT32(broadcasts, halNative.broadcasts);
+  // 不影響馬達與命令超時
+  TEST_ASSERT_EQUAL_INT(targetA, car.targetA());
+  TEST_ASSERT_EQUAL_UINT32(lastCommand, car.lastCommandMs());
+  TEST_ASSERT_EQUAL_UINT32(1, car.stats().pings);
+}
+
+static void sendFrom(int client, const char* text) { car.handleText(text, strlen(text), client); }
+
+void test_subscription_sends_telemetry_at_rate(void) {
+  sendFrom(2, "{\"sub\":4}");
+  TEST_ASSERT_EQUAL_UINT32(1, halNative.sends); // 訂閱時立即送出一次
+  TEST_ASSERT_EQUAL_INT(2, halNative.lastSendClient);
+  TEST_ASSERT_NOT_NULL(strstr(halNative.lastSend, "{\"tele\":{\"ms\":1000,\"mode\":\"MANUAL\""));
+  for (int i = 0; i < 1000; i++) {
+    halNative.nowMs++;
+    car.tick();
+  }
+  TEST_ASSERT_EQUAL_UINT32(5, halNative.sends); // 4 Hz
+  TEST_ASSERT_EQUAL(1, car.subscribers());
+  // 過高的頻率限制在 MAX_TELEMETRY_HZ, 0 取消
+  sendFrom(2, "{\"sub\":1000}");
+  for (int i = 0; i < 1000; i++) {
+    halNative.nowMs++;
+    car.tick();
+  }
+  TEST_ASSERT_EQUAL_UINT32(5 + 1 + MAX_TELEMETRY_HZ, halNative.sends);
+  sendFrom(2, "{\"sub\":0}");
+  TEST_ASSERT_EQUAL(0, car.subscribers());
+}
+
+void test_watcher_disconnect_keeps_driving(void) {
+  sendFrom(1, "{\"steer\":0,\"throttle\":60}");
+  sendFrom(2, "{\"sub\":2}");
+  car.onClientDisconnected(2); // 只看遙測的儀表板
+  TEST_ASSERT_FALSE(motorsOff());
+  // 訂閱後也送過命令的客戶端斷線仍會停車
+  sendFrom(3, "{\"sub\":2}");
+  sendFrom(3, "{\"steer\":0,\"throttle\":40}");
+  car.onClientDisconnected(3);
+  TEST_ASSERT_TRUE(motorsOff());
+}
+
+void test_clock_sync_measures_uplink(void) {
+  // 瀏覽器時鐘 = 車上 millis() + 1739000000000; 上行 5 ms, 下行 3 ms
+  halNative.nowMs = 1000;
+  sendFrom(2, "{\"sync\":1739000000995}");
+  TEST_ASSERT_EQUAL_INT(2, halNative.lastSendClient);
+  TEST_ASSERT_EQUAL_STRING("{\"sync\":1739000000995,\"rx\":1000,\"tx\":1000}", halNative.lastSend);
+  sendFrom(2, "{\"steer\":0,\"throttle\":50,\"t\":1739000000999}"); // 尚未同步: 不計入
+  TEST_ASSERT_EQUAL_UINT32(0, car.uplink().count());
+
+  halNative.nowMs = 2000;
+  sendFrom(2, "{\"sync\":1739000001995,\"echo\":1739000000995,\"t4\":1739000001003}");
+  TEST_ASSERT_NOT_NULL(strstr(halNative.lastSend, "\"off\":-1738999999999.0"));
+  halNative.nowMs = 2100;
+  sendFrom(2, "{\"steer\":0,\"throttle\":50,\"t\":1739000002095}");
+  // 上下行不對稱的一半 (1 ms) 無法分辨, 估計為 4 ms
+  TEST_ASSERT_EQUAL_UINT32(1, car.uplink().count());
+  TEST_ASSERT_EQUAL_UINT16(4, car.uplink().percentile(0.5));
+
+  char json[512];
+  TEST_ASSERT_TRUE(car.latencyJson(json, sizeof(json)) > 0);
+  TEST_ASSERT_NOT_NULL(strstr(json, "{\"clients\":[{\"client\":2,\"samples\":1,"));
+  TEST_ASSERT_NOT_NULL(strstr(json, "\"uplink\":{\"n\":1,"));
+  car.onClientDisconnected(2);
+  car.latencyJson(json, sizeof(json));
+  TEST_ASSERT_NOT_NULL(strstr(json, "{\"clients\":[],"));
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_joystick_drives_motors);
+  RUN_TEST(test_input_is_clamped);
+  RUN_TEST(test_timeout_stops_after_300ms);
+  RUN_TEST(test_commands_keep_motors_alive);
+  RUN_TEST(test_timeout_logs_once_when_idle);
+  RUN_TEST(test_single_char_refreshes_timeout);
+  RUN_TEST(test_emergency_stop);
+  RUN_TEST(test_disconnect_stops_motors);
+  RUN_TEST(test_auto_mode_ignores_joystick);
+  RUN_TEST(test_drive_lock_ignores_joystick);
+  RUN_TEST(test_invalid_json_keeps_state);
+  RUN_TEST(test_non_integer_fields_default_to_zero);
+  RUN_TEST(test_out_of_range_fields_default_to_zero);
+  RUN_TEST(test_only_changed_channels_written);
+  RUN_TEST(test_timestamp_is_acknowledged);
+  RUN_TEST(test_ping_replies_to_sender_only);
+  RUN_TEST(test_subscription_sends_telemetry_at_rate);
+  RUN_TEST(test_watcher_disconnect_keeps_driving);
+  RUN_TEST(test_clock_sync_measures_uplink);
+  return UNITY_END();
+}
@@ -0,0 +1,142 @@
+// SSE 事件分送 (pio test -e native)
+// 每個連線的遙測頻率、狀態的合併與慢連線的 drop-oldest。
+
+#include <string.h>
+#include <unity.h>
+
+#include <string>
+
+#include "event_stream.h"
+
+static EventStream events;
+static uint32_t now;
+
+// 一次取出該連線目前可送的所有事件
+static std::string drain(int sub, size_t room = 1024) {
+  std::string out;
+  char buf[1024];
+  size_t n;
+  while ((n = events.next(sub, buf, room, now)) > 0) out.append(buf, n);
+  return out;
+}
+
+static int count(const std::string& s, const char* what) {
+  int n = 0;
+  for (size_t p = s.find(what); p != std::string::npos; p = s.find(what, p + 1)) n++;
+  return n;
+}
+
+static void publishTele() {
+  char json[64];
+  int len = snprintf(json, sizeof(json), "{\"tele\":{\"ms\":%u}}", now);
+  events.publish(SSE_TELE, json, (size_t)len, now);
+}
+
+// 模擬 loop(): 每 1 ms 有連線到期才組遙測
+static void runUntil(uint32_t end, int sub, std::string* out) {
+  for (; now < end; now++) {
+    if (events.teleDue(now)) publishTele();
+    if (out) *out += drain(sub);
+  }
+}
+
+void setUp(void) {
+  events = EventStream();
+  now = 1000;
+}
+
+void tearDown(void) {}
+
+void test_hello_then_telemetry_at_rate(void) {
+  int sub = events.addSubscriber(5, now);
+  TEST_ASSERT_EQUAL(0, sub);
+  std::string out;
+  runUntil(3000, sub, &out);
+  TEST_ASSERT_EQUAL(0, (int)out.find("retry: 2000\n"));
+  TEST_ASSERT_EQUAL(10, count(out, "event: tele\n"));
+  TEST_ASSERT_NOT_EQUAL(std::string::npos, out.find("event: tele\ndata: {\"tele\":{\"ms\":1000}}\n\n"));
+  // 只有這個連線: 每則遙測只組一次
+  TEST_ASSERT_EQUAL_UINT32(10, events.stats().published[SSE_TELE]);
+}
+
+void test_rates_share_one_serialisation(void) {
+  int fast = events.addSubscriber(10, now);
+  int slow = events.addSubscriber(1, now);
+  std::string a, b;
+  for (; now < 3000; now++) {
+    if (events.teleDue(now)) publishTele();
+    a += drain(fast);
+    b += drain(slow);
+  }
+  TEST_ASSERT_EQUAL(20, count(a, "event: tele"));
+  TEST_ASSERT_EQUAL(2, count(b, "event: tele"));
+  // 慢的連線拿快的連線已經組好的那份, 不另外組
+  TEST_ASSERT_EQUAL_UINT32(20, events.stats().published[SSE_TELE]);
+  TEST_ASSERT_EQUAL_UINT32(0, events.stats().dropped);
+}
+
+void test_status_is_coalesced_per_period(void) {
+  int sub = events.addSubscriber(2, now); // 每 500 ms 最多一則狀態
+  drain(sub);
+  for (int i = 0; i < 5; i++) {
+    char json[32];
+    int len = snprintf(json, sizeof(json), "{\"motorA\":%d}", i * 10);
+    events.publish(SSE_STATUS, json, (size_t)len, now);
+    now += 100;
+  }
+  std::string out = drain(sub);
+  TEST_ASSERT_EQUAL(1, count(out, "event: status"));
+  TEST_ASSERT_NOT_EQUAL(std::string::npos, out.find("{\"motorA\":40}")); // 最新的
+}
+
+void test_slow_connection_drops_oldest(void) {
+  int sub = events.addSubscriber(10, now);
+  drain(sub);
+  // 連線送不出去 (沒有空間): 到期的遙測被新的取代, 不排隊
+  for (; now < 2000; now++) {
+    if (events.teleDue(now)) publishTele();
+    char buf[8];
+    events.next(sub, buf, sizeof(buf), now);
+  }
+  TEST_ASSERT_TRUE(events.stats().dropped >= 8);
+  std::string out = drain(sub);
+  TEST_ASSERT_EQUAL(1, count(out, "event: tele"));
+  TEST_ASSERT_NOT_EQUAL(std::string::npos, out.find("\"ms\":1900"));
+}
+
+void test_logs_are_escaped_and_ring_drops_oldest(void) {
+  int sub = events.addSubscriber(0, now);
+  drain(sub);
+  events.publishLog("say \"hi\"\n\\");
+  std::string out = drain(sub);
+  TEST_ASSERT_EQUAL_STRING("event: log\ndata: {\"log\":\"say \\\"hi\\\"\\u000a\\\\\"}\n\n", out.c_str());
+  for (int i = 0; i < EventStream::LOG_SLOTS + 3; i++) events.publishLog(std::to_string(i).c_str());
+  out = drain(sub);
+  TEST_ASSERT_EQUAL(EventStream::LOG_SLOTS, count(out, "event: log"));
+  TEST_ASSERT_NOT_EQUAL(std::string::npos, out.find("{\"log\":\"3\"}"));
+  TEST_ASSERT_EQUAL_UINT32(3, events.stats().dropped);
+  std::string big(500, 'x');
+  events.publishLog(big.c_str());
+  out = drain(sub);
+  TEST_ASSERT_TRUE(out.size() <= EventStream::LOG_EVENT);
+  TEST_ASSERT_EQUAL(0, (int)out.compare(out.size() - 4, 4, "\"}\n\n"));
+}
+
+void test_subscriber_limit(void) {
+  for (int i = 0; i < EventStream::MAX_SUBS; i++) TEST_ASSERT_EQUAL(i, events.addSubscriber(50, now));
+  TEST_ASSERT_EQUAL(-1, events.addSubscriber(1, now));
+  events.removeSubscriber(2);
+  TEST_ASSERT_EQUAL(2, events.addSubscriber(1, now));
+  TEST_ASSERT_EQUAL(EventStream::MAX_SUBS, events.stats().subscribers);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_hello_then_telemetry_at_rate);
+  RUN_TEST(test_rates_share_one_serialisation);
+  RUN_TEST(test_status_is_coalesced_per_period);
+  RUN_TEST(test_slow_connection_drops_oldest);
+  RUN_TEST(test_logs_are_escaped_and_ring_drops_oldest);
+  RUN_TEST(test_subscriber_limit);
+  return UNITY_END();
+}
@@ -0,0 +1,247 @@
+// Generated by tools/ota_pack.py test-vectors -- do not edit.
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+struct LzssVector { int kind; size_t size; uint8_t windowBits; uint8_t lookaheadBits; const uint8_t* packed; size_t packedLen; };
+
+static const uint8_t LZSS_PACKED_0[98] = {
+  0x80, 0x00, 0x0f, 0x80, 0x0f, 0x40, 0x40, 0x07, 0xc0, 0x07, 0xa0, 0x40, 0x03, 0xe0, 0x03, 0xc2,
+  0x7f, 0xe0, 0x03, 0xe2, 0x7f, 0xe0, 0x03, 0xe2, 0x7f, 0xe0, 0x03, 0xe2, 0x7f, 0xe0, 0x03, 0xe2,
+  0x7f, 0xe0, 0x03, 0xe2, 0x7f, 0xe0, 0x03, 0xe2, 0x7f, 0xe0, 0x03, 0xe2, 0x7f, 0xe0, 0x03, 0xe2,
+  0x7f, 0xe0, 0x03, 0xe2, 0x7f, 0xe0, 0x03, 0xe2, 0x7f, 0xe0, 0x03, 0xe2, 0x7f, 0xe0, 0x03, 0xe2,
+  0x7f, 0xe0, 0x03, 0xe2, 0x7f, 0xe0, 0x03, 0xe2, 0x7f, 0xe0, 0x03, 0xe2, 0x7f, 0xe0, 0x03, 0xe2,
+  0x7f, 0xe0, 0x03, 0xe2, 0x7f, 0xe0, 0x03, 0xe2, 0x7f, 0xe0, 0x03, 0xe2, 0x7f, 0xe0, 0x03, 0xe2,
+  0x6f, 0x60,
+};
+
+static const uint8_t LZSS_PACKED_1[438] = {
+  0xb9, 0xdd, 0x2c, 0xb6, 0x5b, 0x94, 0x82, 0xcb, 0x73, 0xb8, 0x4c, 0xe6, 0x52, 0x0b, 0xa5, 0xa2,
+  0xe5, 0x6f, 0xba, 0x5d, 0x2d, 0x96, 0x59, 0x00, 0x14, 0x2d, 0x92, 0xeb, 0x74, 0xbc, 0x81, 0x93,
+  0x5b, 0x6d, 0xf7, 0x4b, 0x78, 0x10, 0x35, 0xbe, 0xe9, 0x61, 0x02, 0x86, 0x01, 0xc4, 0x06, 0x68,
+  0x02, 0xe9, 0x00, 0xa5, 0x08, 0x65, 0x03, 0xc8, 0x08, 0x25, 0x0b, 0x0a, 0x01, 0x4a, 0x07, 0x43,
+  0x07, 0xc9, 0x05, 0x2b, 0x12, 0xee, 0x04, 0x83, 0x01, 0x88, 0x0c, 0xcb, 0x03, 0x0c, 0x11, 0x2f,
+  0x01, 0xe3, 0x0a, 0x8b, 0x05, 0x08, 0x06, 0x2c, 0x04, 0x25, 0x1b, 0x2a, 0x08, 0xcf, 0x09, 0x8f,
+  0x06, 0x0b, 0x19, 0x8a, 0x00, 0x84, 0x25, 0xea, 0x28, 0xaa, 0x05, 0x70, 0x09, 0x11, 0x04, 0x4b,
+  0x24, 0x2e, 0x1f, 0x0e, 0x18, 0xb1, 0x08, 0xe5, 0x25, 0x95, 0x36, 0xae, 0x0d, 0x8b, 0x23, 0x4b,
+  0x2e, 0xb4, 0x06, 0x2a, 0x10, 0x6e, 0x0a, 0xa9, 0x11, 0xb1, 0x33, 0x09, 0x27, 0xcf, 0x04, 0x4e,
+  0x44, 0x54, 0x4e, 0x0e, 0x1f, 0xf2, 0x16, 0xd1, 0x1f, 0xee, 0x0c, 0xce, 0x2f, 0x90, 0x1b, 0xed,
+  0x1c, 0x8a, 0x0e, 0xa8, 0x10, 0x8a, 0x05, 0x92, 0x16, 0xf4, 0x1e, 0xaf, 0x5b, 0xf2, 0x5f, 0xaa,
+  0x12, 0x6b, 0x49, 0x15, 0x4e, 0x8f, 0x27, 0xf2, 0x3e, 0xdb, 0x2c, 0x2e, 0x10, 0x0a, 0x3b, 0xb3,
+  0x17, 0x94, 0x18, 0x28, 0x01, 0x0d, 0x67, 0x72, 0x05, 0xc9, 0x5f, 0x15, 0x5c, 0xf1, 0x28, 0x54,
+  0x4d, 0x34, 0x39, 0x94, 0x06, 0xab, 0x72, 0xf5, 0x25, 0x54, 0x24, 0x2c, 0x6b, 0xd1, 0x09, 0xe9,
+  0x74, 0x6a, 0x0b, 0xd5, 0x1e, 0xef, 0x18, 0x1a, 0x09, 0x6a, 0x05, 0x4a, 0x73, 0xf2, 0x15, 0x2b,
+  0x02, 0x2b, 0x43, 0x2f, 0x3e, 0xce, 0x16, 0xa9, 0x48, 0x55, 0x4b, 0xd0, 0x0c, 0x2b, 0x20, 0x91,
+  0x6e, 0x90, 0x02, 0x07, 0x05, 0x48, 0x0e, 0x09, 0x4d, 0xb7, 0x4c, 0xf2, 0x73, 0x91, 0x1f, 0x09,
+  0x5d, 0x49, 0x01, 0x29, 0x06, 0x9a, 0x0e, 0xae, 0x0f, 0x6e, 0x47, 0xd7, 0x6b, 0x33, 0x01, 0xca,
+  0x2e, 0xd1, 0x1d, 0xe8, 0x37, 0x6a, 0x1a, 0x76, 0x04, 0x2a, 0x0a, 0xc8, 0x08, 0x8a, 0x54, 0xef,
+  0x2b, 0x50, 0x75, 0x94, 0x68, 0x11, 0x52, 0x09, 0x19, 0x89, 0x18, 0xce, 0x22, 0x4b, 0x0d, 0x92,
+  0x16, 0xcd, 0x65, 0x34, 0x4c, 0xef, 0x33, 0x8f, 0x03, 0x4a, 0x0c, 0x17, 0x10, 0x8b, 0x0a, 0x8a,
+  0x19, 0x51, 0x69, 0x70, 0x0a, 0xfd, 0x37, 0x0e, 0x6e, 0x74, 0x4b, 0xd8, 0x6f, 0x73, 0x03, 0xeb,
+  0x20, 0xce, 0x7f, 0x8f, 0x3d, 0x6e, 0x16, 0x70, 0x07, 0xce, 0x15, 0x49, 0x3b, 0xe9, 0x40, 0xc9,
+  0x6e, 0xb1, 0x24, 0xca, 0x19, 0x55, 0x0d, 0x4a, 0x08, 0xf2, 0x42, 0x6d, 0x1c, 0xae, 0x04, 0x07,
+  0x58, 0xf3, 0x13, 0xaf, 0x1e, 0xcf, 0x3f, 0xaf, 0x64, 0x10, 0x62, 0x3c, 0x40, 0x50, 0x1e, 0x6c,
+  0x01, 0x8c, 0x75, 0xb3, 0x35, 0xb4, 0x1f, 0xa9, 0x03, 0x0e, 0x11, 0xd2, 0x4a, 0x70, 0x12, 0xcb,
+  0x0a, 0xf4, 0x41, 0x74, 0x31, 0x11, 0x19, 0x88, 0x24, 0xab, 0x05, 0x8e, 0x42, 0xfe, 0x39, 0x6f,
+  0x1b, 0xaf, 0x20, 0x2a, 0x26, 0xad,
+};
+
+static const uint8_t LZSS_PACKED_2[1920] = {
+  0x81, 0xc0, 0xe1, 0xb0, 0x88, 0x74, 0x12, 0x1b, 0x07, 0x84, 0x43, 0xe1, 0xb0, 0x68, 0x6c, 0x26,
+  0x0b, 0x00, 0x82, 0x43, 0x21, 0x70, 0x08, 0x1c, 0x22, 0x19, 0x08, 0x82, 0x42, 0xa1, 0x90, 0x18,
+  0x2c, 0x32, 0x1f, 0x05, 0x81, 0x40, 0xa0, 0x70, 0xe8, 0x1c, 0x06, 0x07, 0x0c, 0x82, 0xc3, 0x61,
+  0x90, 0x98, 0x4c, 0x26, 0x1b, 0x0d, 0x87, 0xc3, 0x20, 0x30, 0x00, 0x30, 0x28, 0x1c, 0x02, 0x01,
+  0x07, 0x86, 0xc3, 0xa0, 0x90, 0xc8, 0x34, 0x02, 0x05, 0x00, 0x83, 0x40, 0x61, 0xb0, 0x38, 0x5c,
+  0x1a, 0x15, 0x08, 0x86, 0x41, 0xa0, 0xd0, 0x58, 0x0c, 0x1a, 0x15, 0x0a, 0x87, 0x41, 0xa1, 0xe0,
+  0xc0, 0x50, 0x18, 0x54, 0x1a, 0x09, 0x06, 0x82, 0x42, 0xe0, 0x90, 0xb8, 0x54, 0x22, 0x03, 0x02,
+  0x81, 0xc2, 0xe0, 0x90, 0xd8, 0x44, 0x22, 0x15, 0x0a, 0x81, 0xc1, 0x21, 0xf0, 0xc8, 0x6c, 0x0e,
+  0x11, 0x0d, 0x82, 0x40, 0x60, 0x50, 0x58, 0x6c, 0x0e, 0x1b, 0x09, 0x87, 0xc2, 0xe1, 0x10, 0x48,
+  0x5c, 0x36, 0x17, 0x07, 0x86, 0xc1, 0x60, 0xf0, 0x08, 0x24, 0x12, 0x1d, 0x0b, 0x80, 0xc3, 0xe0,
+  0x50, 0xb8, 0x14, 0x1a, 0x1f, 0x07, 0x85, 0xc1, 0x61, 0x10, 0x48, 0x44, 0x32, 0x05, 0x06, 0x83,
+  0x43, 0xe0, 0x50, 0x78, 0x54, 0x32, 0x0f, 0x03, 0x84, 0x40, 0x20, 0xf0, 0x98, 0x2c, 0x26, 0x15,
+  0x02, 0x83, 0x42, 0x61, 0x30, 0xf8, 0x0c, 0x02, 0x0b, 0x04, 0x80, 0x41, 0xa0, 0xf0, 0x68, 0x24,
+  0x2a, 0x15, 0x06, 0x87, 0xc3, 0x61, 0x50, 0xa8, 0x04, 0x3a, 0x19, 0x00, 0x86, 0x41, 0x61, 0x70,
+  0x28, 0x0c, 0x3a, 0x0b, 0x08, 0x85, 0xc2, 0xe1, 0x50, 0x08, 0x14, 0x22, 0x01, 0x0e, 0x84, 0xc3,
+  0x20, 0xd0, 0x38, 0x44, 0x12, 0x1f, 0x0f, 0x82, 0x40, 0x21, 0x50, 0x78, 0x18, 0x75, 0x14, 0x0a,
+  0x17, 0x0b, 0x80, 0xc0, 0xa1, 0x90, 0x98, 0x1c, 0x1a, 0x19, 0x0d, 0x83, 0x43, 0xa0, 0xd0, 0x88,
+  0x5c, 0x06, 0x01, 0x0e, 0x81, 0xc2, 0xe0, 0x70, 0x68, 0x54, 0x32, 0x1d, 0x08, 0x82, 0x43, 0x61,
+  0x30, 0x38, 0x4c, 0x02, 0x15, 0x01, 0x80, 0x43, 0xe1, 0x50, 0xb8, 0x64, 0x06, 0x09, 0x0c, 0x84,
+  0xc2, 0xe0, 0x70, 0x70, 0x26, 0x28, 0x3c, 0x3a, 0x11, 0x0e, 0x85, 0x43, 0xe1, 0xe1, 0x80, 0x50,
+  0x58, 0x14, 0x1a, 0x0b, 0x00, 0x85, 0xc0, 0xe0, 0xb0, 0x08, 0x04, 0x1a, 0x17, 0x03, 0x86, 0x43,
+  0x60, 0x10, 0x38, 0x34, 0x0c, 0x51, 0x0a, 0x11, 0x0c, 0x82, 0x43, 0xa0, 0x30, 0x68, 0x34, 0x32,
+  0x00, 0x47, 0xc5, 0x02, 0x80, 0xc2, 0x60, 0xb0, 0xa8, 0x4c, 0x36, 0x0f, 0x00, 0x84, 0x03, 0xe1,
+  0x41, 0x61, 0xb0, 0x88, 0x2c, 0x2e, 0x0b, 0x0b, 0x85, 0xc1, 0x21, 0x10, 0xa8, 0x24, 0x1e, 0x0f,
+  0x0c, 0x85, 0x40, 0xa1, 0xf0, 0x48, 0x7c, 0x1a, 0x07, 0x01, 0x86, 0x80, 0x51, 0x40, 0xa1, 0x70,
+  0xc8, 0x54, 0x1e, 0x1f, 0x02, 0x80, 0x41, 0x21, 0x10, 0x08, 0x2c, 0x1a, 0x01, 0x0d, 0x15, 0x82,
+  0x1b, 0x42, 0x81, 0xc0, 0x61, 0x90, 0x78, 0x54, 0x1e, 0x0d, 0x06, 0x87, 0x43, 0x60, 0xd0, 0x38,
+  0x64, 0x0c, 0x6e, 0x0a, 0x11, 0x07, 0x84, 0xc0, 0x60, 0x30, 0x48, 0x0c, 0x1e, 0x15, 0x08, 0x86,
+  0xc1, 0xe1, 0x90, 0x68, 0x14, 0x36, 0x05, 0x0f, 0x0f, 0x02, 0x86, 0xc2, 0xe0, 0x10, 0xf8, 0x74,
+  0x30, 0x3c, 0x0a, 0x19, 0x01, 0x84, 0xc1, 0x21, 0x90, 0xf8, 0x04, 0x02, 0x0a, 0x44, 0x45, 0x03,
+  0x2d, 0x02, 0x80, 0xc2, 0x21, 0x30, 0x48, 0x14, 0x0a, 0x12, 0x17, 0x85, 0x0d, 0x83, 0xc1, 0x61,
+  0x10, 0x08, 0x24, 0x0e, 0x12, 0x6d, 0x05, 0x08, 0x81, 0xc0, 0xa1, 0x50, 0x58, 0x64, 0x1e, 0x0b,
+  0x0f, 0x87, 0x43, 0xa0, 0xb0, 0xc8, 0x74, 0x12, 0x0f, 0x06, 0x84, 0x43, 0xa1, 0x62, 0xc8, 0x50,
+  0x68, 0x14, 0x16, 0x01, 0x0c, 0x0b, 0xa2, 0x85, 0xc1, 0x20, 0x70, 0x18, 0x40, 0x48, 0x14, 0x2a,
+  0x13, 0x0f, 0x84, 0x42, 0x60, 0x30, 0x98, 0x34, 0x16, 0x15, 0x00, 0x84, 0x91, 0x91, 0x42, 0xa0,
+  0xd0, 0xb8, 0x4c, 0x12, 0x01, 0x01, 0x84, 0x40, 0xa0, 0xe8, 0x20, 0x50, 0x68, 0x70, 0xe2, 0x14,
+  0x3a, 0x19, 0x04, 0x81, 0xc3, 0xe0, 0x50, 0x38, 0x24, 0x18, 0x6a, 0x8a, 0x13, 0x00, 0x82, 0x43,
+  0xa1, 0x50, 0x48, 0x41, 0xf0, 0x11, 0x2d, 0x14, 0x32, 0x0f, 0x0d, 0x45, 0x03, 0x82, 0xc3, 0x21,
+  0xb0, 0xc8, 0x6c, 0x0a, 0x05, 0x0e, 0x81, 0x43, 0x21, 0x70, 0xa0, 0xd8, 0x23, 0x5c, 0x23, 0xb6,
+  0x28, 0x6c, 0x3a, 0x00, 0x79, 0x85, 0x05, 0x2e, 0x62, 0x80, 0xc1, 0x60, 0xf0, 0x88, 0x64, 0x16,
+  0x1f, 0x0b, 0x4a, 0xc2, 0x81, 0x40, 0xe0, 0xf0, 0x28, 0x0c, 0x16, 0x13, 0x00, 0x86, 0xc3, 0x21,
+  0xd0, 0x38, 0x4c, 0x36, 0x01, 0x09, 0x82, 0x01, 0xa1, 0x0a, 0x71, 0x41, 0x61, 0xf0, 0xa8, 0x74,
+  0x0e, 0x0e, 0x6b, 0x85, 0x03, 0x80, 0x42, 0x60, 0x30, 0x48, 0x24, 0x26, 0x03, 0x0f, 0x85, 0x43,
+  0x21, 0x70, 0x48, 0x7c, 0x22, 0x09, 0x0e, 0x83, 0x41, 0x60, 0xe1, 0x0c, 0x50, 0xf3, 0x04, 0x28,
+  0x2c, 0x3a, 0x09, 0x05, 0x85, 0x1d, 0xf1, 0x41, 0x20, 0x10, 0xb8, 0x7c, 0x26, 0x01, 0x0c, 0x87,
+  0xc3, 0x60, 0x90, 0x08, 0x2c, 0x2e, 0x0d, 0x00, 0x83, 0x41, 0x60, 0x90, 0x88, 0x14, 0x32, 0x01,
+  0x03, 0x81, 0x02, 0xa1, 0x40, 0x20, 0x50, 0x18, 0x51, 0x16, 0x11, 0x35, 0x14, 0x22, 0x10, 0x9e,
+  0xc5, 0x06, 0x86, 0xc2, 0x20, 0x70, 0xb8, 0x14, 0x32, 0x0c, 0x60, 0x44, 0xac, 0x45, 0x04, 0x85,
+  0x41, 0xe0, 0x8a, 0x4c, 0x50, 0x78, 0x44, 0x06, 0x1f, 0x0e, 0x87, 0xc0, 0x60, 0xd0, 0x48, 0x04,
+  0x26, 0x15, 0x0a, 0x81, 0x43, 0xa1, 0xca, 0x88, 0x42, 0xcc, 0x90, 0xa4, 0xe6, 0x28, 0x3c, 0x32,
+  0x09, 0x06, 0x82, 0xc2, 0x20, 0xcc, 0x04, 0x47, 0x90, 0x4b, 0x34, 0x49, 0x2c, 0x4a, 0x1c, 0x50,
+  0xe8, 0x49, 0x06, 0x14, 0x1a, 0x1f, 0x0b, 0x87, 0xc3, 0xe0, 0x45, 0xe8, 0x42, 0x8c, 0x50, 0x28,
+  0x24, 0x0a, 0x1f, 0x0c, 0x86, 0x1a, 0xe1, 0x18, 0xa1, 0x43, 0xa0, 0xf0, 0x18, 0x24, 0x2e, 0x1e,
+  0x44, 0x45, 0x05, 0x54, 0xc2, 0x87, 0x42, 0xa1, 0xb0, 0x58, 0x64, 0x32, 0x03, 0x07, 0x12, 0x82,
+  0x19, 0x02, 0x80, 0x41, 0xe0, 0xf0, 0xf0, 0x6a, 0x28, 0x44, 0x22, 0x13, 0x0f, 0x81, 0x9a, 0xd2,
+  0x43, 0xe0, 0x26, 0x60, 0x50, 0x78, 0x0c, 0x1e, 0x09, 0x02, 0x80, 0xc2, 0xe1, 0x90, 0x98, 0x00,
+  0xa1, 0x10, 0x88, 0x14, 0x2a, 0x01, 0x0f, 0x85, 0xc0, 0x61, 0x70, 0x36, 0x14, 0x28, 0x74, 0x06,
+  0x09, 0x0e, 0x86, 0x41, 0xe0, 0x00, 0x1c, 0x50, 0x28, 0x5a, 0xbb, 0x14, 0x2a, 0x18, 0x1e, 0xc5,
+  0x05, 0x84, 0x43, 0xdc, 0x30, 0xa1, 0xb0, 0xe8, 0x4c, 0x22, 0x1a, 0x49, 0x47, 0x06, 0x85, 0x05,
+  0xb1, 0x00, 0x91, 0x32, 0x71, 0x13, 0xd1, 0x43, 0xd8, 0x80, 0xa0, 0xf0, 0x88, 0x02, 0xaa, 0x14,
+  0x12, 0x17, 0x01, 0x83, 0xc3, 0xa0, 0x90, 0x38, 0x54, 0x1a, 0x03, 0x0b, 0x87, 0x9b, 0x51, 0x43,
+  0x05, 0x90, 0xa0, 0x10, 0x38, 0x1c, 0x0e, 0x1f, 0x0a, 0x80, 0xc1, 0xc2, 0x50, 0x8f, 0x78, 0xdc,
+  0x30, 0xa1, 0x70, 0x28, 0x6c, 0x22, 0x12, 0x28, 0x05, 0x05, 0x82, 0x41, 0x60, 0xd0, 0xd8, 0x6c,
+  0x36, 0x07, 0x0c, 0x6e, 0x42, 0x83, 0xbb, 0x71, 0x42, 0xa0, 0xd0, 0xc1, 0x08, 0x28, 0x74, 0x16,
+  0x08, 0xfc, 0x45, 0x0b, 0x81, 0xc2, 0x61, 0xd0, 0xe8, 0x04, 0x36, 0x1a, 0xf1, 0x05, 0x05, 0x63,
+  0x23, 0x81, 0xc2, 0x60, 0x70, 0x18, 0x7c, 0x0e, 0x00, 0x37, 0x85, 0x0b, 0x80, 0xc2, 0x20, 0xd0,
+  0xb8, 0x04, 0x3a, 0x0b, 0x05, 0x81, 0xc3, 0xe0, 0x70, 0xb0, 0x94, 0x21, 0x88, 0x28, 0x01, 0x05,
+  0x14, 0x2e, 0x0f, 0x01, 0x85, 0x3c, 0x31, 0xc2, 0x61, 0x30, 0x34, 0xb6, 0x28, 0x2c, 0x2e, 0x1a,
+  0xa4, 0x45, 0x05, 0x83, 0x42, 0x60, 0x90, 0xa8, 0x04, 0x02, 0x1b, 0x0a, 0x83, 0xc1, 0xcb, 0x80,
+  0x9c, 0xc0, 0x98, 0x40, 0xa0, 0x70, 0xf6, 0x4e, 0x28, 0x4c, 0x32, 0x12, 0x36, 0xc5, 0x0a, 0x87,
+  0xc2, 0x21, 0xb0, 0x68, 0x49, 0x1f, 0x14, 0x0a, 0x05, 0x0f, 0x79, 0x02, 0x81, 0xc2, 0xe1, 0xb0,
+  0x68, 0x64, 0x12, 0x1b, 0x07, 0x85, 0xc0, 0x48, 0xa8, 0xa0, 0x30, 0x98, 0x14, 0x3a, 0x09, 0x09,
+  0x83, 0x97, 0x71, 0x11, 0x01, 0x25, 0xf1, 0x42, 0x20, 0xa2, 0x1c, 0x50, 0x88, 0x0c, 0x22, 0x0b,
+  0x0c, 0x84, 0x40, 0x21, 0xf0, 0x28, 0x34, 0x36, 0x15, 0x0f, 0x69, 0xa2, 0x85, 0x97, 0xb1, 0x43,
+  0xe1, 0xf0, 0x98, 0x4c, 0x2e, 0x0c, 0x18, 0x04, 0x66, 0x44, 0xb4, 0x85, 0x02, 0x85, 0xc2, 0x61,
+  0x70, 0xf8, 0x6c, 0x00, 0x7d, 0x8a, 0x01, 0x06, 0x85, 0x00, 0x71, 0x34, 0x71, 0x40, 0x61, 0xf0,
+  0xc0, 0xa8, 0x28, 0x7c, 0x06, 0x01, 0x07, 0x80, 0xba, 0x91, 0x40, 0x60, 0x90, 0x58, 0x4c, 0x2a,
+  0x07, 0x02, 0x80, 0x40, 0x21, 0xd0, 0xd1, 0x3c, 0x22, 0x94, 0x28, 0x14, 0x0a, 0x16, 0xb9, 0x84,
+  0xa9, 0x45, 0x0a, 0x82, 0x19, 0x81, 0x43, 0xa0, 0xb0, 0xf8, 0x24, 0x15, 0x53, 0x8a, 0x1d, 0x0b,
+  0x85, 0x40, 0x20, 0x50, 0xe8, 0x04, 0x25, 0x78, 0x08, 0x2c, 0x0a, 0x01, 0x06, 0x82, 0x43, 0x20,
+  0xf0, 0xc8, 0x6c, 0x22, 0x05, 0x0a, 0x86, 0xc3, 0xe0, 0x70, 0x23, 0x64, 0x22, 0x6a, 0x28, 0x6c,
+  0x1e, 0x0d, 0x0f, 0x86, 0x9a, 0x11, 0x9c, 0x91, 0x42, 0xe0, 0xd0, 0x88, 0x20, 0xf6, 0x14, 0x16,
+  0x0f, 0x07, 0x84, 0x42, 0x61, 0x30, 0x68, 0x33, 0xc7, 0x14, 0x16, 0x01, 0x00, 0x85, 0x9f, 0x21,
+  0xc3, 0xe1, 0xb0, 0xb8, 0x23, 0x98, 0x14, 0x2a, 0x05, 0x0c, 0x85, 0x42, 0x20, 0xb0, 0xe8, 0x34,
+  0x3a, 0x0d, 0x09, 0x83, 0xc2, 0x61, 0x44, 0xb8, 0x50, 0xf8, 0x54, 0x26, 0x04, 0xf6, 0x04, 0xef,
+  0x85, 0x03, 0x87, 0x43, 0x51, 0xf0, 0xa1, 0x50, 0xd8, 0x1c, 0x0e, 0x09, 0x0b, 0x83, 0xc2, 0x60,
+  0x10, 0x88, 0x34, 0x06, 0x01, 0x0c, 0x87, 0x41, 0x60, 0x50, 0x88, 0x08, 0xba, 0x14, 0x22, 0x07,
+  0x00, 0x80, 0x41, 0xe1, 0x6e, 0xec, 0x4c, 0x4c, 0x50, 0x86, 0x98, 0x28, 0x14, 0x3c, 0x53, 0x88,
+  0x37, 0x08, 0x6e, 0x0a, 0x07, 0x00, 0x87, 0x43, 0x0c, 0xf0, 0x8b, 0xe8, 0xa0, 0x50, 0xd8, 0x18,
+  0xda, 0x14, 0x26, 0x1f, 0x09, 0x87, 0x43, 0xe1, 0xf0, 0x88, 0x2a, 0x55, 0x14, 0x16, 0x09, 0x03,
+  0x81, 0xc1, 0x60, 0x70, 0xe8, 0x14, 0x0e, 0x18, 0xc7, 0x45, 0x0e, 0x83, 0xc2, 0x93, 0x48, 0xa0,
+  0x10, 0x18, 0x24, 0x09, 0x7b, 0x8a, 0x0d, 0x0d, 0x80, 0xc3, 0x21, 0x2a, 0xf4, 0x50, 0x58, 0x44,
+  0x12, 0x1e, 0x24, 0xc4, 0x8d, 0x44, 0xdb, 0x85, 0x0e, 0x83, 0xc3, 0xa0, 0x50, 0x78, 0x72, 0xa3,
+  0x14, 0x28, 0xcd, 0x8a, 0x11, 0x06, 0x86, 0x18, 0xe1, 0x02, 0x81, 0x40, 0x20, 0xe6, 0x98, 0x50,
+  0xf8, 0x0c, 0x32, 0x11, 0x0b, 0x81, 0xc1, 0x61, 0xf0, 0x98, 0x14, 0x02, 0x19, 0x08, 0x81, 0xc1,
+  0xd2, 0x28, 0xa0, 0x70, 0x68, 0x3c, 0x02, 0x1a, 0x92, 0x45, 0x07, 0x86, 0xc0, 0x60, 0xf0, 0x98,
+  0x3c, 0x30, 0xce, 0x88, 0x8a, 0x0a, 0x1e, 0x8c, 0x44, 0x61, 0x05, 0x08, 0x82, 0x41, 0xa1, 0xb0,
+  0x94, 0xa8, 0x28, 0x50, 0x55, 0x14, 0x2e, 0x01, 0x0b, 0x86, 0x40, 0xa0, 0xb0, 0x68, 0x1a, 0x6c,
+  0x14, 0x12, 0x1b, 0x04, 0x85, 0x91, 0x41, 0x42, 0x60, 0x50, 0x68, 0x5c, 0x12, 0x1d, 0x03, 0x85,
+  0x8f, 0x81, 0x42, 0x4e, 0x20, 0xe1, 0x90, 0x58, 0x18, 0x28, 0x1c, 0x16, 0x04, 0xc7, 0x85, 0x05,
+  0x82, 0xc2, 0x61, 0xb0, 0xa8, 0x74, 0x22, 0x0a, 0x3d, 0x84, 0xc3, 0x05, 0x0b, 0x29, 0x42, 0x4b,
+  0x62, 0x31, 0xe2, 0x82, 0xc0, 0x61, 0xd0, 0xa8, 0x74, 0x3a, 0x1f, 0x00, 0x86, 0x41, 0x60, 0x30,
+  0x40, 0x96, 0x38, 0x7a, 0xa4, 0x14, 0x02, 0x16, 0x44, 0xc5, 0x0f, 0x21, 0x62, 0x81, 0xc3, 0x86,
+  0x58, 0xa1, 0xb0, 0x18, 0x7b, 0xa6, 0x14, 0x1e, 0x07, 0x07, 0x81, 0xb0, 0x91, 0x41, 0x21, 0x70,
+  0x58, 0x24, 0x12, 0x03, 0x09, 0x83, 0xc1, 0x87, 0x28, 0x8a, 0xe0, 0xa1, 0x10, 0x88, 0x64, 0x36,
+  0x09, 0x03, 0x86, 0xc0, 0x21, 0x50, 0x28, 0x6c, 0x1a, 0x05, 0x04, 0x1b, 0x62, 0x85, 0x40, 0xa0,
+  0x50, 0xc8, 0x24, 0x2a, 0x0d, 0x08, 0x87, 0x40, 0xa1, 0x50, 0x38, 0x53, 0x25, 0x14, 0x32, 0x09,
+  0x01, 0x85, 0x42, 0x20, 0x10, 0x58, 0x74, 0x31, 0x68, 0x8a, 0x1b, 0x0c, 0x80, 0xc3, 0x00, 0xa0,
+  0xa1, 0xd0, 0x38, 0x24, 0x22, 0x19, 0x00, 0x82, 0x40, 0x85, 0x00, 0x9a, 0xc0, 0xa1, 0x50, 0x53,
+  0x82, 0x28, 0x59, 0x8f, 0x14, 0x2e, 0x13, 0x07, 0x1b, 0x82, 0x83, 0xc3, 0x20, 0x10, 0x58, 0x4c,
+  0x21, 0x1f, 0x0a, 0x1b, 0x0b, 0x87, 0x41, 0x20, 0x30, 0x31, 0xe4, 0x28, 0x04, 0x12, 0x15, 0x04,
+  0x86, 0x42, 0x1c, 0xa0, 0xe1, 0x2e, 0xf4, 0x50, 0xf8, 0x00, 0x8c, 0x14, 0x30, 0x51, 0x09, 0xab,
+  0x09, 0xa0, 0x0a, 0x0b, 0x06, 0x80, 0x42, 0x87, 0xc0, 0x9f, 0xd8, 0xa1, 0xcd, 0xa0, 0x44, 0xa0,
+  0x50, 0x38, 0x74, 0x2a, 0x17, 0x08, 0x84, 0xc1, 0x60, 0xb0, 0xf7, 0xaa, 0x28, 0x04, 0x2e, 0x08,
+  0xe6, 0xc4, 0xbc, 0x85, 0x0d, 0x86, 0xc3, 0x21, 0x90, 0x98, 0x54, 0x11, 0x85, 0x0a, 0x11, 0x0b,
+  0x87, 0x42, 0x21, 0x90, 0x28, 0x3c, 0x06, 0x07, 0x07, 0x24, 0x02, 0x84, 0xc0, 0xa1, 0x50, 0xe0,
+  0xee, 0x28, 0x44, 0x00, 0xbc, 0x8a, 0x04, 0x2e, 0xc5, 0x05, 0x80, 0xc3, 0x09, 0x08, 0xa0, 0x30,
+  0x00, 0x86, 0x28, 0x54, 0x04, 0x5f, 0x8a, 0x1f, 0x00, 0x82, 0xc2, 0xe0, 0xd0, 0x28, 0x1c, 0x0e,
+  0x1b, 0x09, 0x83, 0x42, 0xa0, 0xd0, 0x98, 0x5c, 0x26, 0x15, 0x07, 0x81, 0x40, 0x20, 0xb0, 0x48,
+  0x6b, 0x1b, 0x14, 0x2a, 0x0a, 0xe8, 0xc5, 0x09, 0x85, 0x43, 0x55, 0x30, 0xa0, 0x90, 0xa8, 0x28,
+};
+
+static const uint8_t LZSS_PACKED_3[509] = {
+  0xb9, 0xdd, 0x2c, 0xb6, 0x5b, 0x94, 0x82, 0xcb, 0x73, 0xb8, 0x4c, 0xe6, 0x52, 0x0b, 0xa5, 0xa2,
+  0xe5, 0x6f, 0xba, 0x5d, 0x2d, 0x96, 0x59, 0x00, 0x51, 0x6c, 0x97, 0x5b, 0xa5, 0xe4, 0x32, 0xd6,
+  0xdb, 0x7d, 0xd2, 0xde, 0x10, 0x6b, 0x7d, 0xd2, 0xc2, 0x14, 0x60, 0x72, 0x0c, 0xe0, 0x2f, 0x20,
+  0x55, 0x21, 0xa8, 0x7a, 0x08, 0x2a, 0x58, 0xa0, 0x55, 0x0e, 0x8c, 0x7d, 0x22, 0x9b, 0x4b, 0xf0,
+  0x90, 0xc1, 0x90, 0x66, 0xb0, 0xc6, 0x22, 0x7c, 0x1e, 0x65, 0x4b, 0x14, 0x40, 0xc7, 0x04, 0x2a,
+  0xd9, 0xa2, 0x37, 0x93, 0x3c, 0x61, 0x6c, 0xca, 0x02, 0x20, 0x6d, 0x41, 0xf2, 0x41, 0xb1, 0x5d,
+  0x12, 0x3c, 0x45, 0xa2, 0x8a, 0x7c, 0x78, 0x8c, 0x98, 0xbf, 0x65, 0x23, 0xb3, 0x53, 0x01, 0x98,
+  0xdb, 0xa3, 0x65, 0x8d, 0x94, 0xe5, 0x66, 0x0e, 0x18, 0xd2, 0x0f, 0x8a, 0xb2, 0x8d, 0xfb, 0x29,
+  0x29, 0x84, 0x32, 0x31, 0x91, 0x17, 0x2f, 0xf8, 0x28, 0xa0, 0xb5, 0x7d, 0xc3, 0xff, 0xd6, 0xde,
+  0x33, 0xa4, 0x4f, 0x99, 0x9c, 0x6a, 0xa0, 0xb5, 0x2b, 0xa3, 0x7f, 0x5c, 0x94, 0x75, 0x84, 0x25,
+  0x0b, 0x3c, 0x25, 0x68, 0x9f, 0x7a, 0xdb, 0x07, 0x02, 0x54, 0x93, 0xf4, 0xff, 0xa4, 0x75, 0x19,
+  0x20, 0x93, 0x6c, 0x73, 0xdb, 0x84, 0x3e, 0x21, 0x20, 0x74, 0x20, 0x29, 0xa1, 0xa7, 0xcb, 0x54,
+  0xf3, 0x06, 0x01, 0x1a, 0x6f, 0xc4, 0x12, 0x8b, 0xa5, 0x7f, 0xe0, 0x55, 0x12, 0xa8, 0x46, 0xc8,
+  0x90, 0x1a, 0x53, 0xfa, 0x86, 0xb8, 0x1d, 0xc2, 0x3b, 0x1a, 0xda, 0x1a, 0x4c, 0xd6, 0x36, 0xe0,
+  0xd2, 0x8a, 0x8d, 0xfd, 0xa1, 0x1c, 0x27, 0xc8, 0x6d, 0x06, 0x72, 0x5e, 0xf4, 0x03, 0xbb, 0x65,
+  0x81, 0xec, 0x0a, 0x25, 0xd0, 0xaa, 0x84, 0x90, 0x5f, 0x31, 0x42, 0xaa, 0x6c, 0x23, 0x60, 0x55,
+  0x35, 0xc8, 0x85, 0x56, 0xbe, 0x46, 0x21, 0x47, 0x91, 0x14, 0x95, 0x63, 0xfa, 0x4e, 0x50, 0xec,
+  0xd1, 0xf8, 0x10, 0xf0, 0x1a, 0x0a, 0xa0, 0xe1, 0x28, 0x3e, 0x07, 0x40, 0xa9, 0x01, 0xbe, 0x0d,
+  0x67, 0xc7, 0xa8, 0x60, 0x1f, 0x26, 0xd8, 0x1a, 0x78, 0xd1, 0x4e, 0xbc, 0x7b, 0xe0, 0x44, 0x12,
+  0xd5, 0x0b, 0xa0, 0x44, 0x32, 0x70, 0x39, 0x6d, 0xb6, 0xfb, 0xa5, 0xbe, 0xe4, 0x0b, 0x62, 0x8a,
+  0xbb, 0xe0, 0x34, 0xad, 0x3f, 0x06, 0xd8, 0x86, 0x8a, 0xd0, 0x44, 0xa0, 0x52, 0x92, 0xa5, 0x9b,
+  0x80, 0x33, 0x61, 0x72, 0x15, 0x40, 0xb6, 0x37, 0x50, 0x2a, 0x98, 0x60, 0xdf, 0xab, 0xab, 0x02,
+  0xa9, 0xb3, 0xc5, 0x2e, 0x67, 0xe0, 0x74, 0x2c, 0x68, 0x08, 0x83, 0xf5, 0x12, 0x28, 0xf0, 0xc1,
+  0x2a, 0x1a, 0xa3, 0x07, 0xbe, 0xb4, 0x0b, 0x6a, 0x1a, 0x1d, 0x58, 0x46, 0xca, 0xfe, 0x57, 0xf2,
+  0x04, 0x19, 0xb9, 0x89, 0xc3, 0x5c, 0x0d, 0xaa, 0xde, 0x86, 0x4a, 0x23, 0x80, 0xfd, 0x85, 0x20,
+  0x46, 0xa8, 0x35, 0x22, 0x1a, 0x37, 0x94, 0x56, 0xb3, 0xa1, 0xf7, 0x2a, 0xa4, 0x06, 0x61, 0x35,
+  0x02, 0xaa, 0xfa, 0x01, 0x06, 0x35, 0xe0, 0xba, 0x32, 0xbd, 0x94, 0xa6, 0xaa, 0x23, 0xf9, 0x91,
+  0x81, 0x88, 0xe5, 0xf1, 0xf3, 0xb2, 0x24, 0xc7, 0xa9, 0xdf, 0x7b, 0x7b, 0x1e, 0x41, 0x2a, 0x05,
+  0x55, 0x6f, 0x92, 0x4c, 0x1b, 0xaa, 0x9b, 0x16, 0xd3, 0xcf, 0x01, 0x98, 0x58, 0x52, 0x6e, 0xb1,
+  0xf8, 0xf7, 0x63, 0xbf, 0x0c, 0x12, 0x3b, 0xc1, 0xa4, 0x04, 0x44, 0x52, 0x81, 0x6c, 0xaf, 0xe5,
+  0x7a, 0x43, 0x70, 0xa7, 0x8e, 0xa6, 0x58, 0x90, 0x69, 0x94, 0x14, 0x83, 0x62, 0xc8, 0x0d, 0x29,
+  0x2b, 0x85, 0x2a, 0x39, 0x96, 0x6c, 0xb7, 0x7c, 0xc4, 0x8e, 0xcf, 0x41, 0x98,
+};
+
+static const uint8_t LZSS_PACKED_4[486] = {
+  0xb9, 0xdd, 0x2c, 0xb6, 0x5b, 0x94, 0x82, 0xcb, 0x73, 0xb8, 0x4c, 0xe6, 0x52, 0x0b, 0xa5, 0xa2,
+  0xe5, 0x6f, 0xba, 0x5d, 0x2d, 0x96, 0x59, 0x00, 0x0a, 0x2d, 0x92, 0xeb, 0x74, 0xbc, 0x80, 0xcb,
+  0x5b, 0x6d, 0xf7, 0x4b, 0x78, 0x08, 0x35, 0xbe, 0xe9, 0x61, 0x01, 0x46, 0x00, 0xe4, 0x03, 0x38,
+  0x01, 0x79, 0x00, 0x55, 0x04, 0x35, 0x01, 0xe8, 0x04, 0x15, 0x05, 0x8a, 0x00, 0xaa, 0x03, 0xa3,
+  0x03, 0xe9, 0x02, 0x9b, 0x09, 0x7e, 0x02, 0x43, 0x00, 0xc8, 0x06, 0x6b, 0x01, 0x8c, 0x08, 0x9f,
+  0x00, 0xf3, 0x05, 0x4b, 0x02, 0x88, 0x03, 0x1c, 0x02, 0x15, 0x0d, 0x9a, 0x04, 0x6f, 0x04, 0xcf,
+  0x03, 0x0b, 0x0c, 0xca, 0x00, 0x44, 0x12, 0xfa, 0x14, 0x5a, 0x02, 0xbf, 0x04, 0x8f, 0x02, 0x2e,
+  0x12, 0x1e, 0x0f, 0x8e, 0x0c, 0x5f, 0x16, 0x27, 0x12, 0xcf, 0x11, 0x3f, 0x08, 0xff, 0x11, 0xac,
+  0x17, 0x5f, 0x03, 0xb4, 0x03, 0x1a, 0x08, 0x3e, 0x05, 0x59, 0x08, 0xdf, 0x24, 0x37, 0x14, 0x4f,
+  0x09, 0x4c, 0x22, 0x2f, 0x08, 0x8a, 0x27, 0x0e, 0x0f, 0xff, 0x0b, 0x6f, 0x03, 0x3a, 0x08, 0x9f,
+  0x06, 0x67, 0x17, 0xcf, 0x0d, 0xfe, 0x0e, 0x4a, 0x07, 0x58, 0x08, 0x4a, 0x02, 0xcf, 0x01, 0x2b,
+  0x08, 0x9f, 0x0f, 0x5b, 0x2d, 0xff, 0x01, 0x27, 0x09, 0x3f, 0x09, 0xff, 0x09, 0x1d, 0x08, 0xc9,
+  0x13, 0xff, 0x0f, 0x6f, 0x1f, 0x6e, 0x16, 0x1e, 0x08, 0x0a, 0x1d, 0xdf, 0x34, 0xbd, 0x02, 0x8a,
+  0x0c, 0x18, 0x00, 0x8d, 0x33, 0xbf, 0x2e, 0xec, 0x0b, 0xff, 0x1b, 0x1b, 0x01, 0x1b, 0x14, 0x2f,
+  0x27, 0xdf, 0x2e, 0xdf, 0x1c, 0xce, 0x03, 0x5b, 0x39, 0x7f, 0x03, 0x6f, 0x12, 0xaa, 0x12, 0x1c,
+  0x35, 0xef, 0x2b, 0x8b, 0x3a, 0x3a, 0x05, 0xef, 0x08, 0x0b, 0x0e, 0xd9, 0x0c, 0x0f, 0x17, 0x4f,
+  0x02, 0xfa, 0x19, 0x9e, 0x17, 0x49, 0x0a, 0x9b, 0x01, 0x1b, 0x21, 0x9f, 0x1f, 0x6e, 0x0b, 0x59,
+  0x02, 0x8f, 0x17, 0x0b, 0x47, 0xbf, 0x2a, 0x5f, 0x08, 0xfc, 0x01, 0x0f, 0x20, 0x5d, 0x07, 0x09,
+  0x26, 0xdf, 0x15, 0xac, 0x00, 0xdf, 0x39, 0xcf, 0x42, 0x0f, 0x00, 0xf9, 0x26, 0xaf, 0x03, 0x4e,
+  0x07, 0x5e, 0x07, 0xbe, 0x23, 0xef, 0x3b, 0xef, 0x35, 0x9b, 0x00, 0xea, 0x17, 0x6f, 0x48, 0x2a,
+  0x40, 0xcf, 0x0d, 0x3f, 0x2c, 0x47, 0x32, 0x6d, 0x04, 0x4a, 0x2a, 0x7f, 0x15, 0xaf, 0x0c, 0x2f,
+  0x11, 0x5b, 0x09, 0xdb, 0x29, 0x09, 0x0c, 0xc9, 0x0c, 0x6e, 0x11, 0x2b, 0x06, 0xcf, 0x15, 0x5f,
+  0x12, 0x1f, 0x23, 0xef, 0x11, 0x2b, 0x41, 0xae, 0x08, 0xfb, 0x06, 0x0f, 0x0e, 0xf7, 0x2b, 0xcf,
+  0x0c, 0xaf, 0x34, 0xbf, 0x05, 0x7f, 0x05, 0x7f, 0x1b, 0x8f, 0x37, 0x3f, 0x22, 0x9f, 0x25, 0xee,
+  0x37, 0xbf, 0x16, 0x8f, 0x43, 0x0f, 0x3f, 0xce, 0x1e, 0xbe, 0x0b, 0x3f, 0x03, 0xef, 0x0a, 0xa9,
+  0x1d, 0xf9, 0x45, 0xee, 0x2c, 0xaf, 0x12, 0x67, 0x0c, 0xaf, 0x10, 0x0a, 0x4f, 0x6f, 0x04, 0x78,
+  0x21, 0x3d, 0x46, 0x1f, 0x02, 0x06, 0x2c, 0x7f, 0x01, 0xb7, 0x23, 0x3f, 0x0f, 0x6b, 0x1f, 0xdf,
+  0x32, 0x0f, 0x31, 0x1f, 0x12, 0x5d, 0x20, 0x2f, 0x0f, 0x3d, 0x00, 0xcc, 0x3a, 0xdf, 0x0c, 0x7f,
+  0x02, 0x28, 0x47, 0xdf, 0x01, 0x88, 0x08, 0xef, 0x2c, 0x6d, 0x00, 0x5b, 0x05, 0x7f, 0x05, 0x7a,
+  0x20, 0xbf, 0x14, 0x9f, 0x37, 0xaf, 0x43, 0x6f, 0x22, 0x8f, 0x04, 0xaf, 0x14, 0xf9, 0x1c, 0xbf,
+  0x0d, 0xdf, 0x43, 0x9e, 0x08, 0x39,
+};
+
+static const LzssVector LZSS_VECTORS[] = {
+  {0, 1500, 10, 5, LZSS_PACKED_0, sizeof(LZSS_PACKED_0)},
+  {1, 3000, 10, 5, LZSS_PACKED_1, sizeof(LZSS_PACKED_1)},
+  {2, 2000, 10, 5, LZSS_PACKED_2, sizeof(LZSS_PACKED_2)},
+  {1, 3000, 8, 4, LZSS_PACKED_3, sizeof(LZSS_PACKED_3)},
+  {1, 3000, 11, 4, LZSS_PACKED_4, sizeof(LZSS_PACKED_4)},
+};
@@ -0,0 +1,116 @@
+// LZSS 解壓器與 tools/ota_pack.py 的等價測試 (pio test -e native)
+// 向量由 ota_pack.py test-vectors 產生; 原始輸入在這裡以相同的 LCG 重新產生後比對。
+
+#include <string.h>
+#include <unity.h>
+
+#include <string>
+#include <vector>
+
+#include "lzss_decoder.h"
+#include "lzss_vectors.h"
+
+static std::vector<uint8_t> vectorInput(int kind, size_t size) {
+  uint32_t seed = kind + 1;
+  auto next = [&seed]() {
+    seed = (seed * 1103515245u + 12345u) & 0x7fffffffu;
+    return seed >> 16;
+  };
+  std::vector<uint8_t> out;
+  if (kind == 0) {
+    for (size_t i = 0; i < size; i++) out.push_back((uint8_t)((i / 64) % 3));
+  } else if (kind == 1) {
+    static const char* WORDS[] = {"motor ", "duty ", "steer ", "throttle ", "ota ", "esp32 "};
+    while (out.size() < size) {
+      const char* w = WORDS[next() % 6];
+      out.insert(out.end(), w, w + strlen(w));
+    }
+    out.resize(size);
+  } else {
+    for (size_t i = 0; i < size; i++) out.push_back((uint8_t)(next() & 0x0f));
+  }
+  return out;
+}
+
+static bool collect(void* ctx, const uint8_t* data, size_t len) {
+  auto* out = static_cast<std::vector<uint8_t>*>(ctx);
+  out->insert(out->end(), data, data + len);
+  return true;
+}
+
+static std::vector<uint8_t> decode(const LzssVector& v, size_t chunk, bool* ok) {
+  static LzssDecoder decoder;
+  std::vector<uint8_t> out;
+  *ok = decoder.begin(v.windowBits, v.lookaheadBits, v.size, collect, &out);
+  for (size_t i = 0; *ok && i < v.packedLen; i += chunk) {
+    size_t n = v.packedLen - i < chunk ? v.packedLen - i : chunk;
+    *ok = decoder.feed(v.packed + i, n);
+  }
+  *ok = *ok && decoder.flush() && decoder.complete();
+  return out;
+}
+
+void test_vectors_match_packer(void) {
+  static const size_t CHUNKS[] = {1, 3, 64, 1000, 1 << 20};
+  for (const LzssVector& v : LZSS_VECTORS) {
+    std::vector<uint8_t> expected = vectorInput(v.kind, v.size);
+    for (size_t chunk : CHUNKS) {
+      bool ok = false;
+      std::vector<uint8_t> out = decode(v, chunk, &ok);
+      std::string msg = "kind " + std::to_string(v.kind) + " w" + std::to_string(v.windowBits) +
+                        " chunk " + std::to_string(chunk);
+      TEST_ASSERT_TRUE_MESSAGE(ok, msg.c_str());
+      TEST_ASSERT_EQUAL_UINT32_MESSAGE(expected.size(), out.size(), msg.c_str());
+      TEST_ASSERT_EQUAL_MEMORY_MESSAGE(expected.data(), out.data(), expected.size(), msg.c_str());
+    }
+  }
+}
+
+void test_truncated_stream_is_incomplete(void) {
+  LzssVector v = LZSS_VECTORS[1];
+  v.packedLen /= 2;
+  bool ok = true;
+  decode(v, 64, &ok);
+  TEST_ASSERT_FALSE(ok);
+}
+
+void test_trailing_bytes_rejected(void) {
+  const LzssVector& v = LZSS_VECTORS[0];
+  std::vector<uint8_t> padded(v.packed, v.packed + v.packedLen);
+  padded.push_back(0);
+  LzssVector bad = v;
+  bad.packed = padded.data();
+  bad.packedLen = padded.size();
+  bool ok = true;
+  decode(bad, 1 << 20, &ok);
+  TEST_ASSERT_FALSE(ok);
+}
+
+void test_reference_before_start_rejected(void) {
+  // 第一個符號就是距離 1 的 back-reference
+  static const uint8_t stream[] = {0x00, 0x00, 0x00};
+  LzssDecoder decoder;
+  std::vector<uint8_t> out;
+  TEST_ASSERT_TRUE(decoder.begin(10, 5, 16, collect, &out));
+  TEST_ASSERT_FALSE(decoder.feed(stream, sizeof(stream)));
+}
+
+void test_invalid_parameters_rejected(void) {
+  LzssDecoder decoder;
+  std::vector<uint8_t> out;
+  TEST_ASSERT_FALSE(decoder.begin(LzssDecoder::MAX_WINDOW_BITS + 1, 4, 16, collect, &out));
+  TEST_ASSERT_FALSE(decoder.begin(8, 8, 16, collect, &out));
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_vectors_match_packer);
+  RUN_TEST(test_truncated_stream_is_incomplete);
+  RUN_TEST(test_trailing_bytes_rejected);
+  RUN_TEST(test_reference_before_start_rejected);
+  RUN_TEST(test_invalid_parameters_rejected);
+  return UNITY_END();
+}
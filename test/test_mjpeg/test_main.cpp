@@ -0,0 +1,129 @@
+// MJPEG 轉送 (pio test -e native)
+// 上游任意切割的資料要切出完整的 JPEG; 慢的觀看者跳到最新的框, 不排隊。
+
+#include <string.h>
+#include <unity.h>
+
+#include <string>
+
+#include "mjpeg_relay.h"
+
+static MjpegRelay* relay;
+
+// 假 JPEG: SOI + n 個內容位元組 (含 FF 00 填充) + EOI
+static std::string fakeJpeg(char fill, size_t n) {
+  std::string s("\xFF\xD8", 2);
+  for (size_t i = 0; i < n; i++) s += (i % 50 == 7) ? std::string("\xFF\x00", 2) : std::string(1, fill);
+  s.append("\xFF\xD9", 2);
+  return s;
+}
+
+static void feed(const std::string& s, uint32_t nowMs, size_t chunk = 4096) {
+  for (size_t i = 0; i < s.size(); i += chunk) {
+    size_t n = s.size() - i < chunk ? s.size() - i : chunk;
+    relay->feed((const uint8_t*)s.data() + i, n, nowMs);
+  }
+}
+
+static std::string readAll(int viewer, uint32_t nowMs, size_t chunk = 1460) {
+  std::string out;
+  uint8_t buf[2048];
+  for (;;) {
+    size_t n = relay->read(viewer, buf, chunk, nowMs);
+    if (n == 0 || n == MjpegRelay::AGAIN) break;
+    out.append((const char*)buf, n);
+  }
+  return out;
+}
+
+// 從 multipart 輸出中取出第一個框的 JPEG
+static std::string partBody(const std::string& part) {
+  size_t start = part.find("\r\n\r\n");
+  if (start == std::string::npos) return "";
+  return part.substr(start + 4, part.size() - start - 6);
+}
+
+void setUp(void) {
+  relay = new MjpegRelay();
+  relay->begin();
+}
+
+void tearDown(void) {
+  delete relay;
+}
+
+void test_no_frame_yet_is_again(void) {
+  int v = relay->addViewer();
+  uint8_t buf[64];
+  TEST_ASSERT_TRUE(relay->read(v, buf, sizeof(buf), 0) == MjpegRelay::AGAIN);
+  TEST_ASSERT_EQUAL(-1, relay->addViewer(true));
+}
+
+void test_multipart_upstream_is_reframed(void) {
+  std::string jpeg = fakeJpeg('a', 3000);
+  std::string upstream = "--cam\r\nContent-Type: image/jpeg\r\nContent-Length: 3104\r\n\r\n" + jpeg + "\r\n--cam\r\n";
+  int v = relay->addViewer();
+  feed(upstream, 100, 7); // 小區塊: SOI/EOI 跨越邊界
+  std::string part = readAll(v, 130);
+  TEST_ASSERT_EQUAL(0, part.find("--frame\r\nContent-Type: image/jpeg\r\n"));
+  TEST_ASSERT_NOT_EQUAL(std::string::npos, part.find("Content-Length: " + std::to_string(jpeg.size()) + "\r\n"));
+  TEST_ASSERT_NOT_EQUAL(std::string::npos, part.find("X-Frame-Age: 30\r\n"));
+  TEST_ASSERT_TRUE(partBody(part) == jpeg);
+  TEST_ASSERT_EQUAL(2, (int)(part.size() - part.rfind("\r\n")));
+  uint8_t buf[64];
+  TEST_ASSERT_TRUE(relay->read(v, buf, sizeof(buf), 140) == MjpegRelay::AGAIN);
+}
+
+void test_slow_viewer_skips_to_latest(void) {
+  int fast = relay->addViewer();
+  int slow = relay->addViewer();
+  feed(fakeJpeg('1', 2000), 0);
+  readAll(fast, 0);
+  uint8_t buf[100];
+  relay->read(slow, buf, sizeof(buf), 0); // 送到一半
+  feed(fakeJpeg('2', 2000), 10);
+  feed(fakeJpeg('3', 2000), 20);
+  // 框 1 還在送: 框 2 被框 3 取代, 快的觀看者等待
+  TEST_ASSERT_TRUE(relay->read(fast, buf, sizeof(buf), 20) == MjpegRelay::AGAIN);
+  readAll(slow, 20);
+  MjpegStats s = relay->stats();
+  TEST_ASSERT_EQUAL_UINT32(3, s.framesIn);
+  TEST_ASSERT_EQUAL_UINT32(1, s.superseded);
+  std::string part = readAll(fast, 25);
+  TEST_ASSERT_NOT_EQUAL(std::string::npos, part.find("X-Frame-Seq: 2\r\n"));
+  TEST_ASSERT_TRUE(partBody(part) == fakeJpeg('3', 2000));
+}
+
+void test_oversize_frame_is_dropped(void) {
+  int v = relay->addViewer();
+  feed(fakeJpeg('x', MjpegRelay::MAX_FRAME), 0);
+  feed(fakeJpeg('y', 100), 5);
+  MjpegStats s = relay->stats();
+  TEST_ASSERT_EQUAL_UINT32(1, s.oversize);
+  TEST_ASSERT_EQUAL_UINT32(1, s.framesIn);
+  TEST_ASSERT_TRUE(partBody(readAll(v, 5)) == fakeJpeg('y', 100));
+}
+
+void test_single_viewer_gets_one_jpeg(void) {
+  feed(fakeJpeg('s', 500), 0);
+  int v = relay->addViewer(true);
+  TEST_ASSERT_TRUE(v >= 0);
+  size_t len = relay->publishedLen();
+  // 送出中的新框不會改變已鎖定框的長度
+  feed(fakeJpeg('t', 900), 1);
+  TEST_ASSERT_EQUAL(len, relay->publishedLen());
+  std::string body = readAll(v, 2);
+  TEST_ASSERT_TRUE(body == fakeJpeg('s', 500));
+  relay->removeViewer(v);
+  TEST_ASSERT_EQUAL(fakeJpeg('t', 900).size(), relay->publishedLen());
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_no_frame_yet_is_again);
+  RUN_TEST(test_multipart_upstream_is_reframed);
+  RUN_TEST(test_slow_viewer_skips_to_latest);
+  RUN_TEST(test_oversize_frame_is_dropped);
+  RUN_TEST(test_single_viewer_gets_one_jpeg);
+  return UNITY_END();
+}
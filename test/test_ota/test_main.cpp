@@ -0,0 +1,433 @@
+// OTA 管線: SHA-256、串流寫入 (OtaUpdater)、delta 修補 (DeltaPatcher) 與格式分派 (OtaStream)
+// (pio test -e native)。分區由 host/ota_backend_file.cpp 以暫存目錄中的檔案模擬, 與模擬器的 /update 相同。
+
+#include <stdlib.h>
+#include <string.h>
+#include <unity.h>
+
+#include <string>
+#include <vector>
+
+#include "ota_backend.h"
+#include "ota_backend_file.h"
+#include "ota_delta.h"
+#include "ota_stream.h"
+#include "ota_update.h"
+#include "sha256.h"
+
+static std::string stateDir;
+static OtaUpdater updater;
+
+static std::string hexOf(const std::vector<uint8_t>& data) {
+  Sha256 sha;
+  sha.update(data.data(), data.size());
+  uint8_t digest[Sha256::DIGEST_LEN];
+  sha.finish(digest);
+  char hex[Sha256::DIGEST_LEN * 2 + 1];
+  Sha256::toHex(digest, hex);
+  return hex;
+}
+
+static std::vector<uint8_t> digestOf(const std::vector<uint8_t>& data) {
+  std::vector<uint8_t> out(Sha256::DIGEST_LEN);
+  Sha256 sha;
+  sha.update(data.data(), data.size());
+  sha.finish(out.data());
+  return out;
+}
+
+// 與 esp_ota_end 檢查的格式相同: 0xE9 開頭, 結尾附加前面內容的 SHA-256
+static std::vector<uint8_t> makeImage(size_t size, uint32_t seed) {
+  std::vector<uint8_t> image(size - Sha256::DIGEST_LEN);
+  image[0] = 0xE9;
+  for (size_t i = 1; i < image.size(); i++) {
+    seed = seed * 1103515245u + 12345u;
+    image[i] = (uint8_t)(seed >> 16);
+  }
+  std::vector<uint8_t> appended = digestOf(image);
+  image.insert(image.end(), appended.begin(), appended.end());
+  return image;
+}
+
+static bool writeChunks(OtaUpdater& ota, const std::vector<uint8_t>& data, size_t chunk) {
+  for (size_t i = 0; i < data.size(); i += chunk) {
+    size_t n = data.size() - i < chunk ? data.size() - i : chunk;
+    if (!ota.write(data.data() + i, n, 0)) return false;
+  }
+  return true;
+}
+
+static bool streamChunks(OtaStream& stream, const std::vector<uint8_t>& data, size_t chunk) {
+  for (size_t i = 0; i < data.size(); i += chunk) {
+    size_t n = data.size() - i < chunk ? data.size() - i : chunk;
+    if (!stream.write(data.data() + i, n, 0)) return false;
+  }
+  return true;
+}
+
+void setUp(void) {
+  char dir[] = "/tmp/test_ota_XXXXXX";
+  TEST_ASSERT_NOT_NULL(mkdtemp(dir));
+  stateDir = dir;
+  TEST_ASSERT_TRUE(otaFileBackendBoot(dir, nullptr));
+  updater = OtaUpdater();
+}
+
+void tearDown(void) {
+  std::string cmd = "rm -rf " + stateDir;
+  TEST_ASSERT_EQUAL_INT(0, system(cmd.c_str()));
+}
+
+// --- SHA-256 (FIPS 180-4 附錄的測試向量) ---
+
+void test_sha256_known_answers(void) {
+  struct { std::string msg; const char* hex; } cases[] = {
+    {"", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"},
+    {"abc", "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"},
+    {"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+     "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"},
+    {std::string(1000000, 'a'), "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0"},
+  };
+  for (const auto& c : cases) {
+    std::vector<uint8_t> msg(c.msg.begin(), c.msg.end());
+    TEST_ASSERT_EQUAL_STRING(c.hex, hexOf(msg).c_str());
+  }
+}
+
+void test_sha256_incremental_matches_one_shot(void) {
+  // 跨越 64 bytes 區塊與 56 bytes 填充邊界的各種切法
+  std::vector<uint8_t> data = makeImage(300, 7);
+  std::string expected = hexOf(data);
+  static const size_t CHUNKS[] = {1, 55, 56, 63, 64, 65, 299};
+  for (size_t chunk : CHUNKS) {
+    Sha256 sha;
+    for (size_t i = 0; i < data.size(); i += chunk) {
+      sha.update(data.data() + i, data.size() - i < chunk ? data.size() - i : chunk);
+    }
+    uint8_t digest[Sha256::DIGEST_LEN];
+    sha.finish(digest);
+    char hex[Sha256::DIGEST_LEN * 2 + 1];
+    Sha256::toHex(digest, hex);
+    TEST_ASSERT_EQUAL_STRING(expected.c_str(), hex);
+  }
+}
+
+void test_sha256_hex_round_trip(void) {
+  uint8_t digest[Sha256::DIGEST_LEN];
+  const char* upper = "BA7816BF8F01CFEA414140DE5DAE2223B00361A396177A9CB410FF61F20015AD";
+  TEST_ASSERT_TRUE(Sha256::fromHex(upper, digest));
+  char hex[Sha256::DIGEST_LEN * 2 + 1];
+  Sha256::toHex(digest, hex);
+  TEST_ASSERT_EQUAL_STRING("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad", hex);
+  TEST_ASSERT_FALSE(Sha256::fromHex("ba7816bf", digest));
+  TEST_ASSERT_FALSE(Sha256::fromHex("zz7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad", digest));
+  TEST_ASSERT_FALSE(Sha256::fromHex(nullptr, digest));
+}
+
+// --- OtaUpdater ---
+
+void test_image_written_and_committed(void) {
+  std::vector<uint8_t> image = makeImage(5000, 1);
+  TEST_ASSERT_TRUE(updater.begin(image.size(), digestOf(image).data(), 0));
+  TEST_ASSERT_TRUE(writeChunks(updater, image, 1460));
+  TEST_ASSERT_TRUE(updater.finish(100));
+  TEST_ASSERT_EQUAL(OtaState::DONE, updater.state());
+  TEST_ASSERT_EQUAL_UINT32(image.size(), updater.progress().written);
+  // 下次開機為另一個分區
+  TEST_ASSERT_TRUE(otaFileBackendBoot(stateDir.c_str(), nullptr));
+  TEST_ASSERT_EQUAL_STRING("ota_1", otaBackendRunningLabel());
+  size_t size;
+  const uint8_t* running = otaFileBackendImage(&size);
+  TEST_ASSERT_EQUAL_UINT32(image.size(), size);
+  TEST_ASSERT_EQUAL_MEMORY(image.data(), running, size);
+}
+
+void test_truncated_image_rejected(void) {
+  std::vector<uint8_t> image = makeImage(5000, 2);
+  TEST_ASSERT_TRUE(updater.begin(image.size(), digestOf(image).data(), 0));
+  image.resize(4000);
+  TEST_ASSERT_TRUE(writeChunks(updater, image, 1460));
+  TEST_ASSERT_FALSE(updater.finish(100));
+  TEST_ASSERT_EQUAL(OtaState::FAILED, updater.state());
+  TEST_ASSERT_EQUAL_STRING("image truncated", updater.error());
+  TEST_ASSERT_TRUE(otaFileBackendBoot(stateDir.c_str(), nullptr));
+  TEST_ASSERT_EQUAL_STRING("ota_0", otaBackendRunningLabel());
+}
+
+void test_hash_mismatch_rejected(void) {
+  std::vector<uint8_t> image = makeImage(5000, 3);
+  std::vector<uint8_t> expected = digestOf(image);
+  image[2500] ^= 0x01;  // 傳輸途中損壞
+  TEST_ASSERT_TRUE(updater.begin(image.size(), expected.data(), 0));
+  TEST_ASSERT_TRUE(writeChunks(updater, image, 1460));
+  TEST_ASSERT_FALSE(updater.finish(100));
+  TEST_ASSERT_EQUAL_STRING("sha256 mismatch", updater.error());
+  TEST_ASSERT_TRUE(otaFileBackendBoot(stateDir.c_str(), nullptr));
+  TEST_ASSERT_EQUAL_STRING("ota_0", otaBackendRunningLabel());
+}
+
+void test_bad_magic_rejected_by_backend(void) {
+  // 雜湊正確但不是 ESP 影像: 由後端 (esp_ota_end) 拒絕, 不切換開機分區
+  std::vector<uint8_t> image = makeImage(5000, 4);
+  image[0] = 0xE8;
+  TEST_ASSERT_TRUE(updater.begin(image.size(), digestOf(image).data(), 0));
+  TEST_ASSERT_TRUE(writeChunks(updater, image, 1460));
+  TEST_ASSERT_FALSE(updater.finish(100));
+  TEST_ASSERT_EQUAL_STRING("ESP_ERR_OTA_VALIDATE_FAILED", updater.error());
+  TEST_ASSERT_TRUE(otaFileBackendBoot(stateDir.c_str(), nullptr));
+  TEST_ASSERT_EQUAL_STRING("ota_0", otaBackendRunningLabel());
+}
+
+void test_over_length_upload_rejected(void) {
+  std::vector<uint8_t> image = makeImage(5000, 5);
+  TEST_ASSERT_TRUE(updater.begin(4096, digestOf(image).data(), 0));
+  TEST_ASSERT_FALSE(writeChunks(updater, image, 1460));
+  TEST_ASSERT_EQUAL_STRING("image larger than announced size", updater.error());
+  TEST_ASSERT_FALSE(updater.active());
+  // 宣告的長度超過分區: 一開始就拒絕
+  TEST_ASSERT_FALSE(updater.begin(0x200000, digestOf(image).data(), 0));
+  TEST_ASSERT_EQUAL_STRING("ESP_ERR_INVALID_SIZE", updater.error());
+}
+
+// --- OtaStream ---
+
+void test_stream_routes_full_image(void) {
+  OtaStream stream(updater);
+  std::vector<uint8_t> image = makeImage(3000, 6);
+  TEST_ASSERT_TRUE(stream.begin(image.size(), digestOf(image).data(), 0));
+  TEST_ASSERT_TRUE(streamChunks(stream, image, 3));  // 格式判斷跨越多個區塊
+  TEST_ASSERT_TRUE(stream.finish(100));
+  TEST_ASSERT_EQUAL_STRING("image", stream.formatName());
+  TEST_ASSERT_EQUAL_UINT32(image.size(), stream.received());
+}
+
+void test_stream_rejects_unknown_magic(void) {
+  OtaStream stream(updater);
+  std::vector<uint8_t> image = makeImage(3000, 7);
+  image[0] = 0x7F;
+  TEST_ASSERT_TRUE(stream.begin(image.size(), digestOf(image).data(), 0));
+  TEST_ASSERT_FALSE(streamChunks(stream, image, 1460));
+  TEST_ASSERT_FALSE(stream.active());
+  TEST_ASSERT_EQUAL_STRING("unknown update format", updater.error());
+}
+
+void test_stream_image_needs_hash_header(void) {
+  OtaStream stream(updater);
+  std::vector<uint8_t> image = makeImage(3000, 8);
+  TEST_ASSERT_TRUE(stream.begin(image.size(), nullptr, 0));
+  TEST_ASSERT_FALSE(streamChunks(stream, image, 1460));
+  TEST_ASSERT_EQUAL_STRING("missing or malformed X-Image-SHA256 header", updater.error());
+}
+
+void test_stream_too_short_and_busy(void) {
+  OtaStream stream(updater);
+  std::vector<uint8_t> image = makeImage(3000, 9);
+  TEST_ASSERT_TRUE(stream.begin(0, digestOf(image).data(), 0));
+  TEST_ASSERT_FALSE(stream.begin(0, digestOf(image).data(), 0));  // 一次只有一個工作階段
+  TEST_ASSERT_TRUE(stream.write(image.data(), 2, 0));
+  TEST_ASSERT_FALSE(stream.finish(100));
+  TEST_ASSERT_EQUAL_STRING("update body too short", updater.error());
+}
+
+// --- DeltaPatcher ---
+
+// tools/ota_delta.py 的格式: 80 bytes 標頭 + COPY / ADD / INSERT 操作
+struct PatchBuilder {
+  std::vector<uint8_t> bytes;
+
+  PatchBuilder(const std::vector<uint8_t>& base, const std::vector<uint8_t>& target) {
+    bytes = {'E', 'D', 'L', 'T', DeltaPatcher::VERSION, 0, 0, 0};
+    le32((uint32_t)base.size());
+    le32((uint32_t)target.size());
+    bytes.insert(bytes.end(), base.end() - Sha256::DIGEST_LEN, base.end());  // 基底的建置雜湊
+    std::vector<uint8_t> targetSha = digestOf(target);
+    bytes.insert(bytes.end(), targetSha.begin(), targetSha.end());
+  }
+  void le32(uint32_t v) {
+    for (int i = 0; i < 4; i++) bytes.push_back((uint8_t)(v >> (8 * i)));
+  }
+  void varint(uint32_t v) {
+    while (v >= 0x80) {
+      bytes.push_back((uint8_t)(v | 0x80));
+      v >>= 7;
+    }
+    bytes.push_back((uint8_t)v);
+  }
+  void copy(int32_t rel, uint32_t len) {
+    bytes.push_back(0x01);
+    varint((uint32_t)(rel << 1) ^ (uint32_t)(rel >> 31));
+    varint(len);
+  }
+  void add(int32_t rel, const std::vector<uint8_t>& diff) {
+    bytes.push_back(0x02);
+    varint((uint32_t)(rel << 1) ^ (uint32_t)(rel >> 31));
+    varint((uint32_t)diff.size());
+    bytes.insert(bytes.end(), diff.begin(), diff.end());
+  }
+  void insert(const uint8_t* data, size_t len) {
+    bytes.push_back(0x03);
+    varint((uint32_t)len);
+    bytes.insert(bytes.end(), data, data + len);
+  }
+};
+
+static std::vector<uint8_t> baseImage;
+
+// 把基底影像放進 ota_0 作為執行中的影像
+static void bootBase(size_t size = 5000) {
+  baseImage = makeImage(size, 11);
+  std::string path = stateDir + "/base.bin";
+  FILE* f = fopen(path.c_str(), "wb");
+  TEST_ASSERT_NOT_NULL(f);
+  fwrite(baseImage.data(), 1, baseImage.size(), f);
+  fclose(f);
+  TEST_ASSERT_TRUE(otaFileBackendBoot(stateDir.c_str(), path.c_str()));
+  uint8_t sha[Sha256::DIGEST_LEN];
+  TEST_ASSERT_TRUE(otaBackendRunningImage(sha, nullptr));
+}
+
+// 目標: 基底前段不變、中段每個 byte +1、插入新資料、後段平移, 結尾為新的建置雜湊
+static PatchBuilder makePatch(std::vector<uint8_t>* targetOut = nullptr) {
+  const size_t body = baseImage.size() - Sha256::DIGEST_LEN;
+  std::vector<uint8_t> target(baseImage.begin(), baseImage.begin() + 1000);
+  std::vector<uint8_t> diff(500, 1);
+  for (size_t i = 1000; i < 1500; i++) target.push_back((uint8_t)(baseImage[i] + 1));
+  std::vector<uint8_t> fresh = makeImage(232, 12);
+  target.insert(target.end(), fresh.begin(), fresh.begin() + 200);
+  target.insert(target.end(), baseImage.begin() + 2000, baseImage.begin() + body);
+  std::vector<uint8_t> sha = digestOf(target);
+  target.insert(target.end(), sha.begin(), sha.end());
+
+  PatchBuilder patch(baseImage, target);
+  patch.copy(0, 1000);
+  patch.add(0, diff);
+  patch.insert(fresh.data(), 200);
+  patch.copy(500, (uint32_t)(body - 2000));
+  patch.insert(sha.data(), sha.size());
+  if (targetOut) *targetOut = target;
+  return patch;
+}
+
+static bool feedPatch(DeltaPatcher& delta, const std::vector<uint8_t>& patch, size_t chunk) {
+  for (size_t i = 0; i < patch.size(); i += chunk) {
+    size_t n = patch.size() - i < chunk ? patch.size() - i : chunk;
+    if (!delta.feed(patch.data() + i, n, 0)) return false;
+  }
+  return true;
+}
+
+void test_delta_rebuilds_target_for_any_split(void) {
+  bootBase();
+  std::vector<uint8_t> target;
+  PatchBuilder patch = makePatch(&target);
+  // 1 byte 一塊時每個操作碼、varint 與資料都被切開
+  static const size_t CHUNKS[] = {1, 2, 3, 7, 79, 80, 81, 1460, 1 << 20};
+  for (size_t chunk : CHUNKS) {
+    std::string msg = "chunk " + std::to_string(chunk);
+    OtaUpdater ota;
+    DeltaPatcher delta;
+    delta.begin(&ota);
+    TEST_ASSERT_TRUE_MESSAGE(feedPatch(delta, patch.bytes, chunk), msg.c_str());
+    TEST_ASSERT_TRUE_MESSAGE(delta.complete(), msg.c_str());
+    TEST_ASSERT_TRUE_MESSAGE(ota.finish(100), msg.c_str());
+    TEST_ASSERT_EQUAL_MEMORY_MESSAGE(digestOf(target).data(), ota.digest(), Sha256::DIGEST_LEN, msg.c_str());
+    // 下一輪仍以 ota_0 為基底
+    TEST_ASSERT_EQUAL_INT(0, remove((stateDir + "/boot").c_str()));
+    TEST_ASSERT_TRUE(otaFileBackendBoot(stateDir.c_str(), nullptr));
+  }
+}
+
+void test_delta_bad_opcode_rejected(void) {
+  bootBase();
+  PatchBuilder patch = makePatch();
+  patch.bytes[DeltaPatcher::HEADER_LEN] = 0x07;
+  DeltaPatcher delta;
+  delta.begin(&updater);
+  TEST_ASSERT_FALSE(feedPatch(delta, patch.bytes, 1460));
+  TEST_ASSERT_EQUAL_STRING("bad delta opcode", updater.error());
+  TEST_ASSERT_FALSE(updater.active());
+}
+
+void test_delta_copy_beyond_base_rejected(void) {
+  bootBase();
+  std::vector<uint8_t> target;
+  makePatch(&target);
+  PatchBuilder bad(baseImage, target);
+  bad.copy(4900, 200);  // 4900 + 200 > 5000
+  DeltaPatcher delta;
+  delta.begin(&updater);
+  TEST_ASSERT_FALSE(feedPatch(delta, bad.bytes, 1460));
+  TEST_ASSERT_EQUAL_STRING("delta op outside base image", updater.error());
+  // 相對位移使游標變成負值
+  PatchBuilder negative(baseImage, target);
+  negative.copy(-1, 10);
+  delta.begin(&updater);
+  TEST_ASSERT_FALSE(feedPatch(delta, negative.bytes, 1460));
+  TEST_ASSERT_EQUAL_STRING("delta op outside base image", updater.error());
+}
+
+void test_delta_copy_over_limit_rejected(void) {
+  bootBase(DeltaPatcher::MAX_COPY + 1000);
+  std::vector<uint8_t> target(baseImage.begin(), baseImage.begin() + DeltaPatcher::MAX_COPY + 1);
+  PatchBuilder ok(baseImage, target);
+  ok.copy(0, DeltaPatcher::MAX_COPY);
+  ok.copy(0, 1);
+  OtaUpdater ota;
+  DeltaPatcher delta;
+  delta.begin(&ota);
+  TEST_ASSERT_TRUE(feedPatch(delta, ok.bytes, 1460));
+  TEST_ASSERT_TRUE(delta.complete());
+  ota.abort("test done");
+  // 同樣的內容以一個 COPY 表示: 超過上限, 不讀基底就拒絕
+  PatchBuilder bad(baseImage, target);
+  bad.copy(0, DeltaPatcher::MAX_COPY + 1);
+  delta.begin(&updater);
+  TEST_ASSERT_FALSE(feedPatch(delta, bad.bytes, 1460));
+  TEST_ASSERT_EQUAL_STRING("delta COPY too long", updater.error());
+}
+
+void test_delta_base_mismatch_rejected(void) {
+  bootBase();
+  PatchBuilder patch = makePatch();
+  patch.bytes[16] ^= 0xFF;  // 基底雜湊不是執行中的影像
+  DeltaPatcher delta;
+  delta.begin(&updater);
+  TEST_ASSERT_FALSE(feedPatch(delta, patch.bytes, 1460));
+  TEST_ASSERT_EQUAL_STRING("delta base does not match running image", updater.error());
+  TEST_ASSERT_FALSE(updater.active());
+}
+
+void test_delta_truncated_patch_incomplete(void) {
+  bootBase();
+  PatchBuilder patch = makePatch();
+  OtaStream stream(updater);
+  TEST_ASSERT_TRUE(stream.begin(0, nullptr, 0));
+  std::vector<uint8_t> half(patch.bytes.begin(), patch.bytes.begin() + patch.bytes.size() / 2);
+  TEST_ASSERT_TRUE(streamChunks(stream, half, 1460));
+  TEST_ASSERT_EQUAL_STRING("delta", stream.formatName());
+  TEST_ASSERT_FALSE(stream.finish(100));
+  TEST_ASSERT_EQUAL_STRING("delta patch truncated", updater.error());
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_sha256_known_answers);
+  RUN_TEST(test_sha256_incremental_matches_one_shot);
+  RUN_TEST(test_sha256_hex_round_trip);
+  RUN_TEST(test_image_written_and_committed);
+  RUN_TEST(test_truncated_image_rejected);
+  RUN_TEST(test_hash_mismatch_rejected);
+  RUN_TEST(test_bad_magic_rejected_by_backend);
+  RUN_TEST(test_over_length_upload_rejected);
+  RUN_TEST(test_stream_routes_full_image);
+  RUN_TEST(test_stream_rejects_unknown_magic);
+  RUN_TEST(test_stream_image_needs_hash_header);
+  RUN_TEST(test_stream_too_short_and_busy);
+  RUN_TEST(test_delta_rebuilds_target_for_any_split);
+  RUN_TEST(test_delta_bad_opcode_rejected);
+  RUN_TEST(test_delta_copy_beyond_base_rejected);
+  RUN_TEST(test_delta_copy_over_limit_rejected);
+  RUN_TEST(test_delta_base_mismatch_rejected);
+  RUN_TEST(test_delta_truncated_patch_incomplete);
+  return UNITY_END();
+}
@@ -0,0 +1,99 @@
+// 車體動態模擬的數值回歸測試 (pio test -e native)
+// 以 CarControl 實際寫入的 PWM 驅動 VehicleSim; 界限寬鬆, 用來抓控制邏輯或模型的退化。
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#include "car_control.h"
+#include "gpio_pins.h"
+#include "hal_native.h"
+#include "vehicle_sim.h"
+
+static CarControl car;
+
+static MotorOutputs pinOutputs() {
+  MotorOutputs out;
+  out.aFwd = (uint16_t)halNative.pwm[CH_A_FWD];
+  out.aRev = (uint16_t)halNative.pwm[CH_A_REV];
+  out.bLeft = (uint16_t)halNative.pwm[CH_B_LEFT];
+  out.bRight = (uint16_t)halNative.pwm[CH_B_RIGHT];
+  out.standby = halNative.pins[motor_stby];
+  return out;
+}
+
+// 每 50 ms 送一次搖桿命令 (與網頁相同), 持續 driveMs, 之後再模擬 totalMs - driveMs
+static void run(VehicleSim& sim, int steer, int throttle, uint32_t driveMs, uint32_t totalMs) {
+  char frame[64];
+  snprintf(frame, sizeof(frame), "{\"steer\":%d,\"throttle\":%d}", steer, throttle);
+  for (uint32_t ms = 0; ms < totalMs; ms++) {
+    halNative.nowMs = ms;
+    if (ms < driveMs && ms % 50 == 0) car.handleText(frame, strlen(frame));
+    car.tick();
+    sim.step(pinOutputs(), 0.001);
+  }
+}
+
+void setUp(void) {
+  halNativeReset();
+  car = CarControl();
+  car.begin();
+}
+
+void tearDown(void) {}
+
+void test_full_throttle_reaches_plausible_speed(void) {
+  VehicleSim sim(VehicleParams::ackermann());
+  run(sim, 0, 100, 2000, 2000);
+  TEST_ASSERT_TRUE(sim.state().speed > 0.4 && sim.state().speed < 2.0);
+  TEST_ASSERT_TRUE(sim.state().current[0] > 0);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.0, sim.state().heading);
+}
+
+void test_command_timeout_coasts_to_stop(void) {
+  VehicleSim sim(VehicleParams::ackermann());
+  run(sim, 0, 100, 1000, 950 + COMMAND_TIMEOUT);
+  TEST_ASSERT_TRUE(halNative.pins[motor_stby]); // 最後一個命令 (950 ms) 後 300 ms 內仍在驅動
+  double x0 = sim.state().x;
+  halNative.nowMs = 950 + COMMAND_TIMEOUT + 1;
+  car.tick();
+  TEST_ASSERT_FALSE(halNative.pins[motor_stby]);
+  for (int i = 0; i < 1500; i++) sim.step(pinOutputs(), 0.001);
+  TEST_ASSERT_EQUAL_FLOAT(0.0, sim.state().speed);
+  TEST_ASSERT_TRUE(sim.state().x - x0 < 0.5); // 滑行距離
+}
+
+void test_left_steer_turns_counter_clockwise(void) {
+  VehicleSim sim(VehicleParams::ackermann());
+  run(sim, -100, 100, 1000, 1000);
+  TEST_ASSERT_TRUE(sim.state().steerAngle > 0.3);
+  TEST_ASSERT_TRUE(sim.state().heading > 0.5);
+  TEST_ASSERT_TRUE(sim.state().y > 0);
+}
+
+void test_skid_steer_equal_sides_drive_straight(void) {
+  VehicleSim sim(VehicleParams::fourWheelDrive());
+  MotorOutputs out = {200, 0, 0, 200, true}; // 左側 A 前進, 右側 B 前進
+  for (int i = 0; i < 1500; i++) sim.step(out, 0.001);
+  TEST_ASSERT_TRUE(sim.state().speed > 0.3);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.0, sim.state().yawRate);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.0, sim.state().y);
+}
+
+void test_low_duty_does_not_overcome_friction(void) {
+  // fast decay 下低 duty 的平均電流很小: 車子不會動 (MIN_DUTY 存在的原因)
+  VehicleSim sim(VehicleParams::ackermann());
+  run(sim, 0, 15, 1000, 1000);
+  TEST_ASSERT_EQUAL_FLOAT(0.0, sim.state().speed);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_full_throttle_reaches_plausible_speed);
+  RUN_TEST(test_command_timeout_coasts_to_stop);
+  RUN_TEST(test_left_steer_turns_counter_clockwise);
+  RUN_TEST(test_skid_steer_equal_sides_drive_straight);
+  RUN_TEST(test_low_duty_does_not_overcome_friction);
+  return UNITY_END();
+}
@@ -0,0 +1,196 @@
+#!/usr/bin/env python3
+"""REST control API vs. WebSocket benchmark for an esp32c3-car unit or emulator.
+
+Sends the same drive setpoints over POST /api/drive and over the control
+WebSocket and reports per-command latency and throughput:
+
+  REST       time from request to the HTTP response (one TCP connection
+             per request, as the car's AsyncWebServer closes after each
+             response; --keepalive reuses one connection where supported)
+  WebSocket  time from sending {"throttle","steer","t"} to the status
+             broadcast that acknowledges that "t"
+
+Then uploads one mission of --segments segments with a single POST
+/api/mission and compares it with streaming the same number of commands
+over the WebSocket. The car is left stopped (estop) in MANUAL mode:
+
+    api_bench.py --host 192.168.4.1 --count 200 --segments 100
+    api_bench.py --host 127.0.0.1:8080 --json report.json
+"""
+
+import argparse
+import base64
+import http.client
+import json
+import os
+import socket
+import struct
+import sys
+import time
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from fleet_dash import ws_frame, ws_url  # noqa: E402
+
+
+def http_addr(host):
+    name, _, port = host.rpartition(":")
+    return (name, int(port)) if name else (host, 80)
+
+
+class Rest:
+    def __init__(self, host, keepalive):
+        self.addr = http_addr(host)
+        self.keepalive = keepalive
+        self.conn = None
+        self.bytes = 0
+
+    def post(self, path, body):
+        if self.conn is None:
+            self.conn = http.client.HTTPConnection(*self.addr, timeout=5)
+        data = json.dumps(body, separators=(",", ":")).encode() if body is not None else b""
+        headers = {"Content-Type": "application/json"}
+        if not self.keepalive:
+            headers["Connection"] = "close"
+        self.conn.request("POST", path, data, headers)
+        resp = self.conn.getresponse()
+        reply = resp.read()
+        self.bytes += len(data)
+        if not self.keepalive or resp.will_close:
+            self.conn.close()
+            self.conn = None
+        return resp.status, reply
+
+
+class Ws:
+    def __init__(self, host):
+        self.sock = socket.create_connection(ws_url(host), timeout=5)
+        self.sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        key = base64.b64encode(os.urandom(16)).decode()
+        self.sock.sendall(("GET / HTTP/1.1\r\nHost: car\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                           "Sec-WebSocket-Key: %s\r\nSec-WebSocket-Version: 13\r\n\r\n" % key).encode())
+        self.buf = b""
+        while b"\r\n\r\n" not in self.buf:
+            self.buf += self.recv()
+        head, self.buf = self.buf.split(b"\r\n\r\n", 1)
+        if b" 101 " not in head.split(b"\r\n", 1)[0]:
+            sys.exit("WebSocket upgrade failed: %s" % head.split(b"\r\n", 1)[0].decode(errors="replace"))
+        self.bytes = 0
+
+    def recv(self):
+        data = self.sock.recv(65536)
+        if not data:
+            sys.exit("WebSocket closed by the car")
+        return data
+
+    def send(self, obj):
+        frame = ws_frame(json.dumps(obj, separators=(",", ":")))
+        self.bytes += len(frame)
+        self.sock.sendall(frame)
+
+    def texts(self):
+        while True:
+            while len(self.buf) >= 2:
+                op, n, off = self.buf[0] & 0x0F, self.buf[1] & 0x7F, 2
+                if n == 126:
+                    if len(self.buf) < 4:
+                        break
+                    n, off = struct.unpack(">H", self.buf[2:4])[0], 4
+                if len(self.buf) < off + n:
+                    break
+                data, self.buf = self.buf[off:off + n], self.buf[off + n:]
+                if op == 1:
+                    yield data.decode(errors="replace")
+            self.buf += self.recv()
+
+    def wait_ack(self, t):
+        for text in self.texts():
+            if text.startswith("{") and json.loads(text).get("ack") == t:
+                return
+
+    def close(self):
+        self.sock.close()
+
+
+def stats(ms):
+    ms = sorted(ms)
+    return {"n": len(ms), "p50": round(ms[len(ms) // 2], 2), "p95": round(ms[int(len(ms) * 0.95)], 2),
+            "max": round(ms[-1], 2), "mean": round(sum(ms) / len(ms), 2)}
+
+
+def setpoint(i):
+    return {"throttle": 30 + i % 40, "steer": (i * 7) % 81 - 40, "t": i}
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--host", required=True, help="car host[:http port]; WebSocket is port 81 (or http port + 1)")
+    ap.add_argument("--count", type=int, default=200, help="setpoints per transport")
+    ap.add_argument("--segments", type=int, default=100, help="mission segments (max 128)")
+    ap.add_argument("--keepalive", action="store_true", help="reuse one HTTP connection (emulator only)")
+    ap.add_argument("--json", help="write the report here")
+    args = ap.parse_args()
+
+    rest = Rest(args.host, args.keepalive)
+    rest.post("/api/mode", {"mode": "MANUAL"})
+    report = {"host": args.host, "count": args.count, "keepalive": args.keepalive}
+
+    lat = []
+    t0 = time.monotonic()
+    for i in range(args.count):
+        s = time.monotonic()
+        status, reply = rest.post("/api/drive", setpoint(i))
+        if status != 200:
+            sys.exit("POST /api/drive: %d %s" % (status, reply.decode(errors="replace")))
+        lat.append((time.monotonic() - s) * 1000)
+    wall = time.monotonic() - t0
+    report["rest_drive"] = dict(stats(lat), per_s=round(args.count / wall, 1), bytes=rest.bytes)
+
+    ws = Ws(args.host)
+    lat = []
+    t0 = time.monotonic()
+    for i in range(args.count):
+        s = time.monotonic()
+        ws.send(setpoint(i))
+        ws.wait_ack(i)
+        lat.append((time.monotonic() - s) * 1000)
+    wall = time.monotonic() - t0
+    report["ws_drive"] = dict(stats(lat), per_s=round(args.count / wall, 1), bytes=ws.bytes)
+
+    # 同樣數量的命令: 一次 POST 整段任務 vs. WebSocket 逐一送出 (等最後一個 ack)
+    n = min(args.segments, 128)
+    segments = [[50, (i * 13) % 201 - 100, 100] for i in range(n)]
+    rest.bytes = 0
+    s = time.monotonic()
+    status, reply = rest.post("/api/mission", {"segments": segments})
+    if status != 200:
+        sys.exit("POST /api/mission: %d %s" % (status, reply.decode(errors="replace")))
+    report["rest_mission"] = {"segments": n, "requests": 1, "ms": round((time.monotonic() - s) * 1000, 2),
+                              "bytes": rest.bytes}
+    rest.post("/api/mode", {"mode": "MANUAL"})
+    ws.bytes = 0
+    s = time.monotonic()
+    for i, seg in enumerate(segments):
+        ws.send({"throttle": seg[0], "steer": seg[1], "t": 100000 + i})
+    ws.wait_ack(100000 + n - 1)
+    report["ws_commands"] = {"segments": n, "requests": n, "ms": round((time.monotonic() - s) * 1000, 2),
+                             "bytes": ws.bytes}
+
+    rest.post("/api/estop", None)
+    ws.close()
+
+    for key in ("rest_drive", "ws_drive"):
+        r = report[key]
+        print("%-12s n=%d p50=%.2f ms p95=%.2f ms max=%.2f ms  %.1f cmd/s  %d B payload" % (
+            key, r["n"], r["p50"], r["p95"], r["max"], r["per_s"], r["bytes"]))
+    for key in ("rest_mission", "ws_commands"):
+        r = report[key]
+        print("%-12s %d segments in %d request(s): %.2f ms, %d B payload" % (
+            key, r["segments"], r["requests"], r["ms"], r["bytes"]))
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump(report, f, indent=2)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
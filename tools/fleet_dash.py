@@ -0,0 +1,230 @@
+#!/usr/bin/env python3
+"""Fleet dashboard server and telemetry probe for esp32c3-car units.
+
+Serves the same /fleet page the cars carry (read from src/fleet_ui.h) from
+a laptop, with /peers built from --hosts / --list / --mdns instead of the
+car's own mDNS browse, so the whole fleet is visible even when no car is
+reachable by name:
+
+    fleet_dash.py --mdns --port 8000          # then open http://localhost:8000/
+    fleet_dash.py --hosts 127.0.0.1:8080,127.0.0.1:8082
+
+--probe SECONDS skips the page and instead opens one control WebSocket per
+car from a single thread, subscribes to telemetry ({"sub":HZ}) the way the
+page does, and reports per-car message rate, the largest gap between
+telemetry frames and this process's CPU time, to check how a dashboard
+scales with the fleet size:
+
+    fleet_dash.py --hosts 127.0.0.1:8080,127.0.0.1:8082 --probe 20 --hz 2
+"""
+
+import argparse
+import base64
+import http.server
+import json
+import os
+import re
+import selectors
+import socket
+import struct
+import sys
+import time
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from fleet_ota import discover_mdns, read_list  # noqa: E402
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+
+def load_page():
+    src = open(os.path.join(ROOT, "src", "fleet_ui.h"), encoding="utf-8").read()
+    m = re.search(r'R"rawliteral\((.*)\)rawliteral"', src, re.S)
+    if not m:
+        sys.exit("fleet_html not found in src/fleet_ui.h")
+    return m.group(1).encode()
+
+
+def serve(cars, port):
+    page = load_page()
+    peers = json.dumps({"self": "fleet_dash", "peers": [{"name": n, "host": h} for h, n in cars]}).encode()
+
+    class Handler(http.server.BaseHTTPRequestHandler):
+        def do_GET(self):
+            path = self.path.split("?", 1)[0]
+            if path in ("/", "/fleet"):
+                body, kind = page, "text/html; charset=utf-8"
+            elif path == "/peers":
+                body, kind = peers, "application/json"
+            else:
+                self.send_error(404)
+                return
+            self.send_response(200)
+            self.send_header("Content-Type", kind)
+            self.send_header("Content-Length", str(len(body)))
+            self.send_header("Cache-Control", "no-store")
+            self.end_headers()
+            self.wfile.write(body)
+
+        def log_message(self, *args):
+            pass
+
+    httpd = http.server.ThreadingHTTPServer(("", port), Handler)
+    print("fleet dashboard for %d cars at http://localhost:%d/" % (len(cars), port))
+    try:
+        httpd.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+# --- probe: minimal non-blocking WebSocket client (text frames only) ---
+
+def ws_url(host):
+    name, _, port = host.rpartition(":")
+    if not name:
+        return host, 81
+    return name, int(port) + 1
+
+
+def ws_frame(text):
+    payload = text.encode()
+    mask = os.urandom(4)
+    n = len(payload)
+    head = bytes([0x81]) + (bytes([0x80 | n]) if n < 126 else bytes([0x80 | 126]) + struct.pack(">H", n))
+    return head + mask + bytes(b ^ mask[i % 4] for i, b in enumerate(payload))
+
+
+class ProbeCar:
+    def __init__(self, host, name):
+        self.host, self.name = host, name
+        self.buf = b""
+        self.open = False
+        self.error = None
+        self.tele = 0
+        self.other = 0
+        self.first = self.last = None
+        self.max_gap = 0.0
+
+    def on_text(self, text, now):
+        if '"tele"' not in text:
+            self.other += 1
+            return
+        if '"tele":null' in text:
+            self.error = "subscriptions full"
+            return
+        self.tele += 1
+        if self.last is not None:
+            self.max_gap = max(self.max_gap, now - self.last)
+        if self.first is None:
+            self.first = now
+        self.last = now
+
+    def parse(self, now):
+        if not self.open:
+            end = self.buf.find(b"\r\n\r\n")
+            if end < 0:
+                return
+            if b" 101 " not in self.buf[:end].split(b"\r\n", 1)[0]:
+                self.error = self.buf[:end].split(b"\r\n", 1)[0].decode(errors="replace")
+                return
+            self.open = True
+            self.buf = self.buf[end + 4:]
+        while len(self.buf) >= 2:
+            op, n, off = self.buf[0] & 0x0F, self.buf[1] & 0x7F, 2
+            if n == 126:
+                if len(self.buf) < 4:
+                    return
+                n, off = struct.unpack(">H", self.buf[2:4])[0], 4
+            elif n == 127:
+                if len(self.buf) < 10:
+                    return
+                n, off = struct.unpack(">Q", self.buf[2:10])[0], 10
+            if len(self.buf) < off + n:
+                return
+            data, self.buf = self.buf[off:off + n], self.buf[off + n:]
+            if op == 1:
+                self.on_text(data.decode(errors="replace"), now)
+
+
+def probe(cars, seconds, hz):
+    sel = selectors.DefaultSelector()
+    probes = []
+    for host, name in cars:
+        p = ProbeCar(host, name)
+        probes.append(p)
+        addr = ws_url(host)
+        try:
+            s = socket.create_connection(addr, timeout=3)
+        except OSError as e:
+            p.error = str(e)
+            continue
+        key = base64.b64encode(os.urandom(16)).decode()
+        s.sendall(("GET / HTTP/1.1\r\nHost: %s:%d\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                   "Sec-WebSocket-Key: %s\r\nSec-WebSocket-Version: 13\r\n\r\n" % (addr[0], addr[1], key)).encode())
+        s.setblocking(False)
+        sel.register(s, selectors.EVENT_READ, p)
+
+    subscribed = set()
+    cpu0, t0 = time.process_time(), time.monotonic()
+    while time.monotonic() - t0 < seconds:
+        for key, _ in sel.select(timeout=0.2):
+            p = key.data
+            try:
+                data = key.fileobj.recv(65536)
+            except OSError as e:
+                data, p.error = b"", str(e)
+            if not data:
+                p.error = p.error or "closed"
+                sel.unregister(key.fileobj)
+                key.fileobj.close()
+                continue
+            p.buf += data
+            p.parse(time.monotonic())
+            if p.open and p not in subscribed:
+                subscribed.add(p)
+                key.fileobj.sendall(ws_frame(json.dumps({"sub": hz})))
+    wall, cpu = time.monotonic() - t0, time.process_time() - cpu0
+    for key in list(sel.get_map().values()):
+        key.fileobj.close()
+
+    print("%-24s %6s %7s %9s %6s  %s" % ("car", "tele", "rate/s", "max gap", "other", "state"))
+    total = 0
+    for p in probes:
+        span = (p.last - p.first) if p.first is not None and p.last != p.first else 0
+        rate = (p.tele - 1) / span if span else 0
+        total += p.tele
+        print("%-24s %6d %7.2f %7.0f ms %6d  %s" % (p.name[:24], p.tele, rate, p.max_gap * 1000, p.other,
+                                                     p.error or "live"))
+    live = sum(1 for p in probes if p.error is None and p.tele)
+    print("%d/%d cars live, %d telemetry frames in %.1f s, probe cpu %.2f s (%.1f%%)" % (
+        live, len(probes), total, wall, cpu, 100 * cpu / wall))
+    return 0 if live == len(probes) else 1
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--hosts", help="comma separated host[:port] list")
+    ap.add_argument("--list", help="file with one host[:port] [name] per line")
+    ap.add_argument("--mdns", action="store_true", help="discover cars advertising _esp32car._tcp")
+    ap.add_argument("--mdns-wait", type=float, default=3.0)
+    ap.add_argument("--port", type=int, default=8000, help="dashboard HTTP port (default 8000)")
+    ap.add_argument("--probe", type=float, metavar="SECONDS", help="measure telemetry instead of serving the page")
+    ap.add_argument("--hz", type=int, default=2, help="telemetry rate for --probe (the page uses 2)")
+    args = ap.parse_args()
+
+    cars = []
+    if args.hosts:
+        cars += [(h, h) for h in args.hosts.split(",") if h]
+    if args.list:
+        cars += read_list(args.list)
+    if args.mdns:
+        cars += discover_mdns(args.mdns_wait)
+    if not cars:
+        sys.exit("no cars: use --hosts, --list or --mdns")
+
+    if args.probe:
+        sys.exit(probe(cars, args.probe, args.hz))
+    serve(cars, args.port)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,226 @@
+#!/usr/bin/env python3
+"""Parallel OTA updater for a fleet of esp32c3-car units.
+
+Replaces the one-car-at-a-time `upload_port` switching in platformio.ini:
+cars are taken from a list (--hosts / --list) or discovered over mDNS
+(_esp32car._tcp), updated concurrently with at most --jobs uploads in
+flight, and each one is verified after reboot through GET /health
+(build_sha256 must equal the new image's build hash, uptime must restart
+and the boot self-test must no longer be pending).
+
+    fleet_ota.py .pio/build/esp32c3-car/firmware.bin --mdns --jobs 4
+    fleet_ota.py firmware.bin --list fleet.txt --delta-base old/ --compress
+    fleet_ota.py firmware.bin --hosts 127.0.0.1:8081,127.0.0.1:8082
+
+--delta-base points at a directory of previous firmware.bin builds; a car
+whose running build hash matches one of them gets an EDLT patch instead of
+the full image. --compress wraps whatever is sent in an EHSZ container.
+The list file holds one `host[:port] [name]` per line, '#' starts a comment.
+"""
+
+import argparse
+import concurrent.futures
+import glob
+import hashlib
+import json
+import os
+import shutil
+import subprocess
+import sys
+import threading
+import time
+import urllib.request
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import ota_delta  # noqa: E402
+import ota_pack   # noqa: E402
+
+SERVICE = "_esp32car._tcp"
+
+
+def http_json(url, timeout=5):
+    with urllib.request.urlopen(url, timeout=timeout) as res:
+        return json.loads(res.read())
+
+
+def read_list(path):
+    cars = []
+    for line in open(path):
+        line = line.split("#", 1)[0].strip()
+        if line:
+            parts = line.split()
+            cars.append((parts[0], parts[1] if len(parts) > 1 else parts[0]))
+    return cars
+
+
+def discover_mdns(wait):
+    """Browse _esp32car._tcp with python-zeroconf if installed, else avahi-browse."""
+    try:
+        from zeroconf import ServiceBrowser, Zeroconf
+    except ImportError:
+        if not shutil.which("avahi-browse"):
+            sys.exit("mDNS discovery needs python-zeroconf or avahi-browse")
+        out = subprocess.run(["avahi-browse", "-rtp", SERVICE], capture_output=True, text=True,
+                             timeout=wait + 10).stdout
+        cars = {}
+        for line in out.splitlines():
+            f = line.split(";")
+            if f[0] == "=" and f[2] == "IPv4":
+                cars[f[7]] = ("%s:%s" % (f[7], f[8]), f[3])
+        return sorted(cars.values())
+
+    found = {}
+
+    class Listener:
+        def add_service(self, zc, type_, name):
+            info = zc.get_service_info(type_, name)
+            if info and info.parsed_addresses():
+                found[name] = ("%s:%d" % (info.parsed_addresses()[0], info.port), name.split(".")[0])
+
+        def update_service(self, *args):
+            pass
+
+        def remove_service(self, *args):
+            pass
+
+    zc = Zeroconf()
+    ServiceBrowser(zc, SERVICE + ".local.", Listener())
+    time.sleep(wait)
+    zc.close()
+    return sorted(found.values())
+
+
+class Payloads:
+    """Per-base payload cache so N cars on the same build share one diff/pack."""
+
+    def __init__(self, image, base_dir, compress):
+        self.image = image
+        self.compress = compress
+        self.bases = {}
+        if base_dir:
+            for path in glob.glob(os.path.join(base_dir, "**", "*.bin"), recursive=True):
+                data = open(path, "rb").read()
+                self.bases[ota_delta.build_hash(data).hex()] = data
+        self.cache = {}
+        self.lock = threading.Lock()
+
+    def for_car(self, running_hash):
+        key = running_hash if running_hash in self.bases else None
+        with self.lock:
+            if key not in self.cache:
+                body, kind = self.image, "image"
+                if key is not None:
+                    body, kind = ota_delta.make_patch(self.bases[key], self.image), "delta"
+                if self.compress:
+                    body, kind = ota_pack.pack(body, 10, 5), "lzss+" + kind
+                self.cache[key] = (body, kind)
+            return self.cache[key]
+
+
+def update_car(host, name, payloads, target_hash, args):
+    row = {"car": name, "host": host, "kind": "-", "bytes": 0, "upload_s": 0.0, "reboot_s": 0.0,
+           "total_s": 0.0, "result": "?"}
+    t0 = time.time()
+    base = "http://%s" % host
+    try:
+        before = http_json(base + "/health")
+        if before.get("build_sha256") == target_hash and not args.force:
+            row["result"] = "up to date"
+            return row
+        body, kind = payloads.for_car(before.get("build_sha256"))
+        row["kind"], row["bytes"] = kind, len(body)
+        image_sha = hashlib.sha256(body).hexdigest() if kind == "image" else None
+
+        t1 = time.time()
+        result = ota_delta.upload(base + "/update", body, args.user, args.password, image_sha, args.timeout)
+        row["upload_s"] = time.time() - t1
+        if not result.get("ok"):
+            row["result"] = "upload failed: %s" % result.get("error", "?")
+            return row
+
+        # 等待重新開機並確認新版本在執行
+        t2 = time.time()
+        while True:
+            time.sleep(1.0)
+            try:
+                after = http_json(base + "/health", timeout=2)
+                fresh = after.get("uptime_ms", 1e12) < (time.time() - t2 + 5) * 1000
+                # 新影像在自我測試通過 (selftest=passed) 前仍可能回滾
+                if after.get("build_sha256") == target_hash and fresh and after.get("selftest") != "pending":
+                    row["result"] = "ok %s" % after.get("version", "")
+                    if after.get("selftest") == "no_rollback":
+                        row["result"] += " (bootloader without rollback)"
+                    break
+            except OSError:
+                pass
+            if time.time() - t2 > args.boot_timeout:
+                row["result"] = "not healthy after %ds" % args.boot_timeout
+                break
+        row["reboot_s"] = time.time() - t2
+    except OSError as e:
+        row["result"] = "error: %s" % e
+    finally:
+        row["total_s"] = time.time() - t0
+    return row
+
+
+def print_table(rows, wall):
+    cols = ["car", "host", "kind", "bytes", "upload_s", "reboot_s", "total_s", "result"]
+    cells = [[("%.1f" % r[c]) if isinstance(r[c], float) else str(r[c]) for c in cols] for r in rows]
+    widths = [max(len(c), *(len(row[i]) for row in cells)) for i, c in enumerate(cols)]
+    print("  ".join(c.ljust(w) for c, w in zip(cols, widths)).rstrip())
+    for row in cells:
+        print("  ".join(v.ljust(w) for v, w in zip(row, widths)).rstrip())
+    ok = sum(1 for r in rows if r["result"].startswith("ok") or r["result"] == "up to date")
+    print("\n%d/%d cars healthy, wall time %.1fs (sum of per-car totals %.1fs)"
+          % (ok, len(rows), wall, sum(r["total_s"] for r in rows)))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("image", help="new firmware.bin")
+    ap.add_argument("--hosts", help="comma separated host[:port] list")
+    ap.add_argument("--list", help="file with one host[:port] [name] per line")
+    ap.add_argument("--mdns", action="store_true", help="discover cars advertising %s" % SERVICE)
+    ap.add_argument("--mdns-wait", type=float, default=3.0)
+    ap.add_argument("-j", "--jobs", type=int, default=3, help="concurrent uploads (default 3)")
+    ap.add_argument("--delta-base", help="directory of previous firmware.bin builds for delta patches")
+    ap.add_argument("--compress", action="store_true", help="send EHSZ-compressed payloads")
+    ap.add_argument("--force", action="store_true", help="update cars already running the image")
+    ap.add_argument("--user", default="ota")
+    ap.add_argument("--password", default="mysecurepassword")
+    ap.add_argument("--timeout", type=float, default=180, help="upload timeout per car (s)")
+    ap.add_argument("--boot-timeout", type=int, default=60, help="post-update health wait per car (s)")
+    ap.add_argument("--json", help="also write the per-car table as JSON")
+    args = ap.parse_args()
+
+    cars = []
+    if args.hosts:
+        cars += [(h, h) for h in args.hosts.split(",") if h]
+    if args.list:
+        cars += read_list(args.list)
+    if args.mdns:
+        cars += discover_mdns(args.mdns_wait)
+    if not cars:
+        sys.exit("no cars: use --hosts, --list or --mdns")
+
+    image = open(args.image, "rb").read()
+    target_hash = ota_delta.build_hash(image).hex()
+    payloads = Payloads(image, args.delta_base, args.compress)
+    print("updating %d cars to %s with %d parallel jobs" % (len(cars), target_hash[:16], args.jobs))
+
+    t0 = time.time()
+    with concurrent.futures.ThreadPoolExecutor(max_workers=max(1, args.jobs)) as pool:
+        futures = [pool.submit(update_car, host, name, payloads, target_hash, args) for host, name in cars]
+        rows = [f.result() for f in futures]
+    wall = time.time() - t0
+
+    print_table(rows, wall)
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump({"target": target_hash, "jobs": args.jobs, "wall_s": wall, "cars": rows}, f, indent=2)
+    sys.exit(0 if all(r["result"].startswith("ok") or r["result"] == "up to date" for r in rows) else 1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,298 @@
+#!/usr/bin/env python3
+"""Delta OTA patch tool for the esp32c3-car firmware.
+
+Builds a patch that turns the image currently running on a car (the base)
+into a new firmware.bin, in the "EDLT" format decoded by src/ota_delta.cpp.
+The base is identified by its build hash: the SHA-256 esptool appends to
+every image, i.e. the last 32 bytes of firmware.bin, which the car reports
+as build_sha256 on GET /ota/info.
+
+    ota_delta.py diff   base.bin new.bin -o update.edlt
+    ota_delta.py apply  base.bin update.edlt -o check.bin
+    ota_delta.py upload update.edlt --host esp32c3-0c4ea032119c.local
+    ota_delta.py upload new.bin     --host ...   (full image, for comparison)
+    ota_delta.py upload update.ehsz --host ...   (ota_pack.py container)
+
+Matching: old image offsets are indexed by 16-byte seeds; each hit is
+extended exactly and then bsdiff-style approximately (kept while more than
+half the bytes agree). Exact runs become COPY ops, the rest of an aligned
+region becomes ADD ops (byte differences, mostly small pointer shifts) and
+unmatched data becomes INSERT ops. COPY ops are split at MAX_COPY bytes: the
+car runs each COPY inside one network callback and rejects longer ones.
+"""
+
+import argparse
+import base64
+import hashlib
+import json
+import struct
+import sys
+import time
+import urllib.error
+import urllib.request
+
+MAGIC = b"EDLT"
+VERSION = 1
+HEADER = struct.Struct("<4sBBHII32s32s")
+
+OP_COPY, OP_ADD, OP_INSERT = 1, 2, 3
+
+SEED = 16          # bytes hashed per index entry
+SEED_STEP = 4      # index every 4th old offset; every new offset is probed
+MIN_COPY = 12      # shorter exact runs inside a region are folded into ADD
+APPROX_SLACK = 64  # stop approximate extension after this many non-improving bytes
+MAX_COPY = 16384   # DeltaPatcher::MAX_COPY
+
+
+def build_hash(image):
+    """Appended image digest (esptool hash_appended), else SHA-256 of the file."""
+    if len(image) > 32 and hashlib.sha256(image[:-32]).digest() == image[-32:]:
+        return image[-32:]
+    return hashlib.sha256(image).digest()
+
+
+def varint(value):
+    out = bytearray()
+    while True:
+        b = value & 0x7F
+        value >>= 7
+        if value:
+            out.append(b | 0x80)
+        else:
+            out.append(b)
+            return bytes(out)
+
+
+def zigzag(value):
+    return (value << 1) if value >= 0 else ((-value << 1) - 1)
+
+
+def read_varint(buf, pos):
+    value = shift = 0
+    while True:
+        b = buf[pos]
+        pos += 1
+        value |= (b & 0x7F) << shift
+        shift += 7
+        if not b & 0x80:
+            return value, pos
+
+
+def unzigzag(value):
+    return (value >> 1) ^ -(value & 1)
+
+
+def exact_len(old, op, new, np_, limit):
+    n = 0
+    while n < limit:
+        step = min(64, limit - n)
+        if old[op + n:op + n + step] == new[np_ + n:np_ + n + step]:
+            n += step
+            continue
+        while n < limit and old[op + n] == new[np_ + n]:
+            n += 1
+        break
+    return n
+
+
+class PatchWriter:
+    def __init__(self):
+        self.ops = bytearray()
+        self.cursor = 0  # base position after the last COPY/ADD
+
+    def insert(self, data):
+        if data:
+            self.ops += bytes([OP_INSERT]) + varint(len(data)) + data
+
+    def copy(self, offset, length):
+        while length > 0:
+            n = min(length, MAX_COPY)
+            self.ops += bytes([OP_COPY]) + varint(zigzag(offset - self.cursor)) + varint(n)
+            self.cursor = offset + n
+            offset += n
+            length -= n
+
+    def add(self, offset, diff):
+        self.ops += bytes([OP_ADD]) + varint(zigzag(offset - self.cursor)) + varint(len(diff)) + diff
+        self.cursor = offset + len(diff)
+
+    def region(self, old, op, new, np_, length):
+        """Emit an aligned region: long exact runs as COPY, everything else as ADD."""
+        i = 0
+        while i < length:
+            run = exact_len(old, op + i, new, np_ + i, length - i)
+            if run >= MIN_COPY:
+                self.copy(op + i, run)
+                i += run
+                continue
+            # ADD up to the next exact run worth a COPY
+            j = i + max(run, 1)
+            while j < length:
+                run = exact_len(old, op + j, new, np_ + j, length - j)
+                if run >= MIN_COPY:
+                    break
+                j += max(run, 1)
+            self.add(op + i, bytes((new[np_ + k] - old[op + k]) & 0xFF for k in range(i, j)))
+            i = j
+
+
+def make_patch(old, new):
+    index = {}
+    for i in range(0, len(old) - SEED + 1, SEED_STEP):
+        index.setdefault(old[i:i + SEED], i)
+
+    writer = PatchWriter()
+    lit_start = 0
+    j = 0
+    while j <= len(new) - SEED:
+        p = index.get(new[j:j + SEED])
+        if p is None:
+            j += 1
+            continue
+        # extend backwards into the pending literal run
+        while j > lit_start and p > 0 and new[j - 1] == old[p - 1]:
+            j -= 1
+            p -= 1
+        limit = min(len(old) - p, len(new) - j)
+        length = exact_len(old, p, new, j, limit)
+        # bsdiff-style approximate extension: keep the length that maximises 2*matches - len
+        score = best_score = length
+        best_len = length
+        k = length
+        while k < limit and k - best_len < APPROX_SLACK:
+            score += 1 if old[p + k] == new[j + k] else -1
+            k += 1
+            if score >= best_score:
+                best_score, best_len = score, k
+        writer.insert(new[lit_start:j])
+        writer.region(old, p, new, j, best_len)
+        j += best_len
+        lit_start = j
+    writer.insert(new[lit_start:])
+
+    header = HEADER.pack(MAGIC, VERSION, 0, 0, len(old), len(new), build_hash(old),
+                         hashlib.sha256(new).digest())
+    return header + bytes(writer.ops)
+
+
+def apply_patch(old, patch):
+    magic, version, _, _, base_size, target_size, base_hash, target_hash = HEADER.unpack_from(patch)
+    if magic != MAGIC or version != VERSION:
+        raise ValueError("not an EDLT v1 patch")
+    if base_size != len(old) or base_hash != build_hash(old):
+        raise ValueError("patch base does not match %s" % build_hash(old).hex())
+    out = bytearray()
+    pos = HEADER.size
+    cursor = 0
+    while len(out) < target_size:
+        op = patch[pos]
+        pos += 1
+        if op == OP_INSERT:
+            length, pos = read_varint(patch, pos)
+            out += patch[pos:pos + length]
+            pos += length
+            continue
+        rel, pos = read_varint(patch, pos)
+        length, pos = read_varint(patch, pos)
+        cursor += unzigzag(rel)
+        if op == OP_COPY:
+            if length > MAX_COPY:
+                raise ValueError("COPY of %d bytes at %d exceeds %d" % (length, pos, MAX_COPY))
+            out += old[cursor:cursor + length]
+        elif op == OP_ADD:
+            out += bytes((old[cursor + k] + patch[pos + k]) & 0xFF for k in range(length))
+            pos += length
+        else:
+            raise ValueError("bad opcode %d at %d" % (op, pos - 1))
+        cursor += length
+    if pos != len(patch) or hashlib.sha256(out).digest() != target_hash:
+        raise ValueError("patch did not reproduce the target image")
+    return bytes(out)
+
+
+def cmd_diff(args):
+    old = open(args.base, "rb").read()
+    new = open(args.target, "rb").read()
+    t0 = time.time()
+    patch = make_patch(old, new)
+    elapsed = time.time() - t0
+    apply_patch(old, patch)  # self-check before anything is shipped
+    with open(args.output, "wb") as f:
+        f.write(patch)
+    print("base   %s  %8d bytes  build %s" % (args.base, len(old), build_hash(old).hex()))
+    print("target %s  %8d bytes" % (args.target, len(new)))
+    print("patch  %s  %8d bytes  (%.1f%% of full image, %.1fs to generate)"
+          % (args.output, len(patch), 100.0 * len(patch) / len(new), elapsed))
+
+
+def cmd_apply(args):
+    out = apply_patch(open(args.base, "rb").read(), open(args.patch, "rb").read())
+    with open(args.output, "wb") as f:
+        f.write(out)
+    print("wrote %s (%d bytes, sha256 %s)" % (args.output, len(out), hashlib.sha256(out).hexdigest()))
+
+
+def upload(url, body, user, password, image_sha=None, timeout=120):
+    headers = {"Content-Type": "application/octet-stream",
+               "Authorization": "Basic " + base64.b64encode(("%s:%s" % (user, password)).encode()).decode()}
+    if image_sha:
+        headers["X-Image-SHA256"] = image_sha
+    req = urllib.request.Request(url, data=body, headers=headers, method="POST")
+    try:
+        with urllib.request.urlopen(req, timeout=timeout) as res:
+            return json.loads(res.read() or b"{}")
+    except urllib.error.HTTPError as e:
+        return json.loads(e.read() or b"{}") or {"ok": False, "error": "HTTP %d" % e.code}
+
+
+def cmd_upload(args):
+    body = open(args.file, "rb").read()
+    base = "http://%s" % args.host
+    if body[:4] == MAGIC:
+        info = json.loads(urllib.request.urlopen(base + "/ota/info", timeout=10).read())
+        want = HEADER.unpack_from(body)[6].hex()
+        if info.get("build_sha256") != want:
+            sys.exit("car runs %s, patch expects base %s" % (info.get("build_sha256"), want))
+        image_sha = None
+    elif body[:4] == b"EHSZ":
+        image_sha = None  # ota_pack.py container carries its payload hash
+    else:
+        image_sha = hashlib.sha256(body).hexdigest()
+    t0 = time.time()
+    result = upload(base + "/update", body, args.user, args.password, image_sha)
+    elapsed = time.time() - t0
+    print("%s: sent %d bytes in %.2fs (%.1f KiB/s) -> %s"
+          % (args.host, len(body), elapsed, len(body) / 1024.0 / max(elapsed, 1e-6), json.dumps(result)))
+    if not result.get("ok"):
+        sys.exit(1)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = ap.add_subparsers(dest="cmd", required=True)
+
+    p = sub.add_parser("diff", help="create a patch from base.bin to new.bin")
+    p.add_argument("base")
+    p.add_argument("target")
+    p.add_argument("-o", "--output", required=True)
+    p.set_defaults(func=cmd_diff)
+
+    p = sub.add_parser("apply", help="apply a patch on the host (reference decoder)")
+    p.add_argument("base")
+    p.add_argument("patch")
+    p.add_argument("-o", "--output", required=True)
+    p.set_defaults(func=cmd_apply)
+
+    p = sub.add_parser("upload", help="POST a patch or full image to /update and time it")
+    p.add_argument("file")
+    p.add_argument("--host", required=True)
+    p.add_argument("--user", default="ota")
+    p.add_argument("--password", default="mysecurepassword")
+    p.set_defaults(func=cmd_upload)
+
+    args = ap.parse_args()
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()
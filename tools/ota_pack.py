@@ -0,0 +1,250 @@
+#!/usr/bin/env python3
+"""Compressed OTA packer for the esp32c3-car firmware.
+
+Wraps a firmware.bin or an EDLT delta patch (tools/ota_delta.py) in an
+"EHSZ" container holding a heatshrink-format LZSS stream. The car inflates
+it on the fly in src/lzss_decoder.cpp using only a fixed 2^W byte window,
+so there is no extra RAM cost over a plain upload.
+
+    ota_pack.py pack   firmware.bin -o firmware.ehsz [-w 10 -l 5]
+    ota_pack.py unpack firmware.ehsz -o check.bin
+    ota_pack.py test-vectors > test/test_lzss/lzss_vectors.h
+
+Upload the result to /update like any other image, e.g. with
+`ota_delta.py upload firmware.ehsz --host <car>`; the container carries the
+SHA-256 of its payload, so no X-Image-SHA256 header is needed.
+
+If the container would not be smaller than the input (already compressed or
+random data grows by ~1/8 in LZSS literals), `pack` writes the input
+unchanged instead; the car accepts a raw image or EDLT patch as is, and
+`ota_delta.py upload` adds the hash header for a raw image. `--force` always
+writes the container.
+
+Container (little-endian, 44 bytes):
+    "EHSZ" | u8 version | u8 window bits | u8 lookahead bits | u8 0
+    | u32 payload size | payload sha256
+"""
+
+import argparse
+import hashlib
+import struct
+import sys
+import time
+
+MAGIC = b"EHSZ"
+VERSION = 1
+HEADER = struct.Struct("<4sBBBBI32s")
+
+MAX_WINDOW_BITS = 11  # LzssDecoder::MAX_WINDOW_BITS
+MIN_MATCH = 3         # candidates are found through a 3-byte hash
+
+
+class BitWriter:
+    def __init__(self):
+        self.out = bytearray()
+        self.acc = 0
+        self.nbits = 0
+
+    def put(self, value, count):
+        self.acc = (self.acc << count) | value
+        self.nbits += count
+        while self.nbits >= 8:
+            self.nbits -= 8
+            self.out.append((self.acc >> self.nbits) & 0xFF)
+        self.acc &= (1 << self.nbits) - 1
+
+    def finish(self):
+        if self.nbits:
+            self.out.append((self.acc << (8 - self.nbits)) & 0xFF)
+        return bytes(self.out)
+
+
+def compress(data, window_bits=10, lookahead_bits=5, max_chain=32):
+    window = 1 << window_bits
+    max_len = 1 << lookahead_bits
+    n = len(data)
+    head = {}
+    prev = [-1] * n
+    bits = BitWriter()
+
+    def insert(pos):
+        if pos + MIN_MATCH <= n:
+            key = data[pos:pos + MIN_MATCH]
+            prev[pos] = head.get(key, -1)
+            head[key] = pos
+
+    i = 0
+    while i < n:
+        best_len = best_dist = 0
+        if i + MIN_MATCH <= n:
+            cand = head.get(data[i:i + MIN_MATCH], -1)
+            limit = min(max_len, n - i)
+            chain = 0
+            while cand >= 0 and i - cand <= window and chain < max_chain:
+                length = MIN_MATCH
+                while length < limit and data[cand + length] == data[i + length]:
+                    length += 1
+                if length > best_len:
+                    best_len, best_dist = length, i - cand
+                    if length == limit:
+                        break
+                cand = prev[cand]
+                chain += 1
+        if best_len >= MIN_MATCH:
+            bits.put(0, 1)
+            bits.put(best_dist - 1, window_bits)
+            bits.put(best_len - 1, lookahead_bits)
+            for k in range(i, i + best_len):
+                insert(k)
+            i += best_len
+        else:
+            bits.put(1, 1)
+            bits.put(data[i], 8)
+            insert(i)
+            i += 1
+    return bits.finish()
+
+
+def decompress(stream, window_bits, lookahead_bits, size):
+    """Reference decoder, mirrors LzssDecoder."""
+    out = bytearray()
+    pos = 0
+    total_bits = len(stream) * 8
+
+    def take(count):
+        nonlocal pos
+        if pos + count > total_bits:
+            raise ValueError("stream truncated")
+        value = 0
+        for _ in range(count):
+            value = (value << 1) | ((stream[pos >> 3] >> (7 - (pos & 7))) & 1)
+            pos += 1
+        return value
+
+    while len(out) < size:
+        if take(1):
+            out.append(take(8))
+        else:
+            dist = take(window_bits) + 1
+            count = take(lookahead_bits) + 1
+            if dist > len(out) or len(out) + count > size:
+                raise ValueError("bad back-reference")
+            for _ in range(count):
+                out.append(out[-dist])
+    if (pos + 7) // 8 != len(stream):
+        raise ValueError("trailing data")
+    return bytes(out)
+
+
+def pack(payload, window_bits, lookahead_bits):
+    if not 4 <= window_bits <= MAX_WINDOW_BITS or not 3 <= lookahead_bits < window_bits:
+        raise ValueError("window bits must be 4..%d and lookahead 3..window-1" % MAX_WINDOW_BITS)
+    header = HEADER.pack(MAGIC, VERSION, window_bits, lookahead_bits, 0, len(payload),
+                         hashlib.sha256(payload).digest())
+    return header + compress(payload, window_bits, lookahead_bits)
+
+
+def unpack(blob):
+    magic, version, window_bits, lookahead_bits, _, size, digest = HEADER.unpack_from(blob)
+    if magic != MAGIC or version != VERSION:
+        raise ValueError("not an EHSZ v1 container")
+    payload = decompress(blob[HEADER.size:], window_bits, lookahead_bits, size)
+    if hashlib.sha256(payload).digest() != digest:
+        raise ValueError("payload sha256 mismatch")
+    return payload
+
+
+def cmd_pack(args):
+    payload = open(args.input, "rb").read()
+    t0 = time.time()
+    blob = pack(payload, args.window, args.lookahead)
+    elapsed = time.time() - t0
+    if unpack(blob) != payload:
+        sys.exit("internal error: round trip failed")
+    if len(blob) >= len(payload) and not args.force:
+        with open(args.output, "wb") as f:
+            f.write(payload)
+        print("%s: %d bytes, container would be %d bytes (%.1f%%), stored uncompressed"
+              % (args.input, len(payload), len(blob), 100.0 * len(blob) / max(len(payload), 1)))
+        return
+    with open(args.output, "wb") as f:
+        f.write(blob)
+    print("%s: %d -> %d bytes (%.1f%%, w=%d l=%d, %.1fs)"
+          % (args.input, len(payload), len(blob), 100.0 * len(blob) / max(len(payload), 1),
+             args.window, args.lookahead, elapsed))
+
+
+def cmd_unpack(args):
+    payload = unpack(open(args.input, "rb").read())
+    with open(args.output, "wb") as f:
+        f.write(payload)
+    print("wrote %s (%d bytes)" % (args.output, len(payload)))
+
+
+# --- test vectors for test/test_lzss (inputs regenerated by the same LCG in C++) ---
+
+def lcg(seed):
+    while True:
+        seed = (seed * 1103515245 + 12345) & 0x7FFFFFFF
+        yield seed >> 16
+
+
+def vector_input(kind, size):
+    r = lcg(kind + 1)
+    if kind == 0:    # runs
+        return bytes((i // 64) % 3 for i in range(size))
+    if kind == 1:    # words
+        words = [b"motor ", b"duty ", b"steer ", b"throttle ", b"ota ", b"esp32 "]
+        out = bytearray()
+        while len(out) < size:
+            out += words[next(r) % len(words)]
+        return bytes(out[:size])
+    return bytes(next(r) & 0x0F for _ in range(size))  # low-entropy noise
+
+
+VECTORS = [(0, 1500, 10, 5), (1, 3000, 10, 5), (2, 2000, 10, 5), (1, 3000, 8, 4), (1, 3000, 11, 4)]
+
+
+def cmd_test_vectors(_args):
+    print("// Generated by tools/ota_pack.py test-vectors -- do not edit.")
+    print("#pragma once\n#include <stdint.h>\n#include <stddef.h>\n")
+    print("struct LzssVector { int kind; size_t size; uint8_t windowBits; uint8_t lookaheadBits;"
+          " const uint8_t* packed; size_t packedLen; };\n")
+    for idx, (kind, size, w, l) in enumerate(VECTORS):
+        packed = compress(vector_input(kind, size), w, l)
+        print("static const uint8_t LZSS_PACKED_%d[%d] = {" % (idx, len(packed)))
+        for off in range(0, len(packed), 16):
+            print("  " + ", ".join("0x%02x" % b for b in packed[off:off + 16]) + ",")
+        print("};\n")
+    print("static const LzssVector LZSS_VECTORS[] = {")
+    for idx, (kind, size, w, l) in enumerate(VECTORS):
+        print("  {%d, %d, %d, %d, LZSS_PACKED_%d, sizeof(LZSS_PACKED_%d)}," % (kind, size, w, l, idx, idx))
+    print("};")
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = ap.add_subparsers(dest="cmd", required=True)
+
+    p = sub.add_parser("pack", help="compress an image or delta patch into an EHSZ container")
+    p.add_argument("input")
+    p.add_argument("-o", "--output", required=True)
+    p.add_argument("-w", "--window", type=int, default=10, help="window bits (default 10 = 1 KiB)")
+    p.add_argument("-l", "--lookahead", type=int, default=5, help="lookahead bits (default 5)")
+    p.add_argument("--force", action="store_true", help="write the container even if it is not smaller")
+    p.set_defaults(func=cmd_pack)
+
+    p = sub.add_parser("unpack", help="inflate an EHSZ container on the host")
+    p.add_argument("input")
+    p.add_argument("-o", "--output", required=True)
+    p.set_defaults(func=cmd_unpack)
+
+    p = sub.add_parser("test-vectors", help="emit the C header used by test/test_lzss")
+    p.set_defaults(func=cmd_test_vectors)
+
+    args = ap.parse_args()
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()
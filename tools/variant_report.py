@@ -0,0 +1,128 @@
+#!/usr/bin/env python3
+"""Size and control-path performance report for the per-car build variants.
+
+Every [env:car-*] in platformio.ini (plus the generic esp32c3-car image)
+is built with `pio run -e <env>`; the RAM/Flash lines of the PlatformIO
+size summary are collected. The same variant flags (CAR_MIX, CAR_CURVES,
+CAR_FEATURE_* from include/car_variant.h) are then applied to the host
+micro-benchmarks (`pio test -e native -f test_bench`) to show what the
+compiled-in mix and curves cost per command:
+
+    variant_report.py                    # all variants, markdown table
+    variant_report.py -e car-blue -e car-green --json report.json
+    variant_report.py --no-bench         # sizes only
+"""
+
+import argparse
+import configparser
+import json
+import os
+import re
+import shlex
+import subprocess
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+BASE_ENV = "esp32c3-car"
+SIZE_RE = re.compile(r"^(RAM|Flash):.*?used (\d+) bytes from (\d+) bytes", re.M)
+BENCH_RE = re.compile(r"^(?:.*?INFO:)?\s*(\S.*?)\s+([\d.]+) ns/call", re.M)
+
+
+def load_envs():
+    ini = configparser.RawConfigParser(strict=False)
+    ini.read(os.path.join(ROOT, "platformio.ini"))
+    envs = {}
+    for section in ini.sections():
+        if not section.startswith("env:"):
+            continue
+        name = section[4:]
+        if name != BASE_ENV and not name.startswith("car-"):
+            continue
+        flags = shlex.split(ini.get(section, "build_flags", fallback=""))
+        envs[name] = {
+            "flags": [f for f in flags if f.startswith("-DCAR_")],
+            "upload_port": ini.get(section, "upload_port", fallback="").split(";")[0].strip(),
+        }
+    return envs
+
+
+def run(cmd, env=None):
+    try:
+        proc = subprocess.run(cmd, cwd=ROOT, env=env, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    except FileNotFoundError:
+        return 127, "%s: command not found (PlatformIO is required)\n" % cmd[0]
+    return proc.returncode, proc.stdout
+
+
+def build_size(name):
+    code, out = run(["pio", "run", "-e", name])
+    if code != 0:
+        sys.stderr.write(out[-2000:])
+        return None
+    sizes = {}
+    for kind, used, total in SIZE_RE.findall(out):
+        sizes[kind.lower()] = int(used)
+        sizes[kind.lower() + "_total"] = int(total)
+    return sizes
+
+
+def bench(flags):
+    env = dict(os.environ)
+    # PlatformIO appends PLATFORMIO_BUILD_FLAGS to every env, including native tests
+    env["PLATFORMIO_BUILD_FLAGS"] = " ".join(shlex.quote(f) for f in flags)
+    code, out = run(["pio", "test", "-e", "native", "-f", "test_bench", "-v"], env)
+    if code != 0:
+        sys.stderr.write(out[-2000:])
+        return None
+    return {name.strip(): float(ns) for name, ns in BENCH_RE.findall(out)}
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("-e", "--env", action="append", help="variant env (default: all car-* and %s)" % BASE_ENV)
+    ap.add_argument("--no-bench", action="store_true", help="skip the host micro-benchmarks")
+    ap.add_argument("--json", help="also write the report to this file")
+    args = ap.parse_args()
+
+    envs = load_envs()
+    names = args.env or sorted(envs, key=lambda n: (n != BASE_ENV, n))
+    unknown = [n for n in names if n not in envs]
+    if unknown:
+        ap.error("unknown variant env: " + ", ".join(unknown))
+
+    report = {}
+    for name in names:
+        print("building %s ..." % name, file=sys.stderr)
+        entry = dict(envs[name])
+        entry["size"] = build_size(name)
+        entry["bench"] = None if args.no_bench else bench(entry["flags"])
+        report[name] = entry
+
+    base = report.get(BASE_ENV, {}).get("size") or {}
+    benches = sorted({b for e in report.values() for b in (e["bench"] or {})})
+    head = ["variant", "flash", "Δflash", "ram", "Δram"] + ["%s (ns)" % b for b in benches]
+    print("| " + " | ".join(head) + " |")
+    print("|" + "---|" * len(head))
+    for name in names:
+        e = report[name]
+        size = e["size"] or {}
+        row = [name]
+        for kind in ("flash", "ram"):
+            used = size.get(kind)
+            # say so explicitly when the build failed or the toolchain is missing
+            row.append("%d" % used if used is not None else "unmeasured")
+            row.append("%+d" % (used - base[kind]) if used is not None and kind in base else "-")
+        for b in benches:
+            ns = (e["bench"] or {}).get(b)
+            row.append("%.1f" % ns if ns is not None else "unmeasured")
+        print("| " + " | ".join(row) + " |")
+
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump(report, f, indent=2)
+    failed = [n for n in names if report[n]["size"] is None]
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
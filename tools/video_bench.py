@@ -0,0 +1,178 @@
+#!/usr/bin/env python3
+"""Compare the car's MJPEG stream (/stream) with per-frame polling (/frame.jpg).
+
+Both modes read the same relayed camera frames, one after the other, for
+--seconds each:
+
+  stream  one long-lived GET /stream, multipart/x-mixed-replace parts
+  poll    GET /frame.jpg every 1/--poll-fps s on one keep-alive connection,
+          the way the control page used to fetch frames (0 = back to back)
+
+Reported per mode: distinct frames per second, the gap between distinct
+frames (p50/p95/max), frame age (X-Frame-Age from the car plus the time
+until the whole JPEG arrived here, or the request round trip when polling),
+duplicate frames fetched by polling and bytes per second.
+
+    video_bench.py --host 192.168.1.42 --seconds 10
+    video_bench.py --host 127.0.0.1:8080 --mode stream --json bench.json
+
+Against the emulator: emulator --port 8080 --video clip.mjpg --video-fps 15
+"""
+
+import argparse
+import http.client
+import json
+import sys
+import time
+
+
+def percentile(values, q):
+    if not values:
+        return 0.0
+    s = sorted(values)
+    return s[min(len(s) - 1, int(q * (len(s) - 1) + 0.5))]
+
+
+class Result:
+    def __init__(self, mode):
+        self.mode = mode
+        self.frames = 0
+        self.duplicates = 0
+        self.bytes = 0
+        self.gaps = []
+        self.ages = []
+        self.elapsed = 0.0
+        self._last_at = None
+
+    def frame(self, at, age_ms, size):
+        self.frames += 1
+        self.bytes += size
+        self.ages.append(age_ms)
+        if self._last_at is not None:
+            self.gaps.append((at - self._last_at) * 1000)
+        self._last_at = at
+
+    def summary(self):
+        el = self.elapsed or 1
+        return {
+            "mode": self.mode,
+            "frames": self.frames,
+            "fps": round(self.frames / el, 2),
+            "gap_p50_ms": round(percentile(self.gaps, 0.5), 1),
+            "gap_p95_ms": round(percentile(self.gaps, 0.95), 1),
+            "gap_max_ms": round(max(self.gaps), 1) if self.gaps else 0,
+            "age_p50_ms": round(percentile(self.ages, 0.5), 1),
+            "age_p95_ms": round(percentile(self.ages, 0.95), 1),
+            "duplicates": self.duplicates,
+            "kbytes_per_s": round(self.bytes / el / 1024, 1),
+        }
+
+
+def split_host(host):
+    name, _, port = host.partition(":")
+    return name, int(port or 80)
+
+
+def get_json(host, path):
+    conn = http.client.HTTPConnection(*split_host(host), timeout=5)
+    conn.request("GET", path)
+    body = conn.getresponse().read()
+    conn.close()
+    return json.loads(body)
+
+
+def bench_stream(host, seconds):
+    res = Result("stream")
+    conn = http.client.HTTPConnection(*split_host(host), timeout=5)
+    conn.request("GET", "/stream", headers={"Cache-Control": "no-store"})
+    resp = conn.getresponse()
+    if resp.status != 200:
+        sys.exit("GET /stream: HTTP %d %s" % (resp.status, resp.read().decode(errors="replace").strip()))
+    start = time.monotonic()
+    while time.monotonic() - start < seconds:
+        headers = {}
+        line = resp.readline()
+        if not line:
+            break
+        if not line.startswith(b"--"):
+            continue  # trailing CRLF of the previous part
+        header_at = None
+        while True:
+            line = resp.readline().strip()
+            if header_at is None:
+                header_at = time.monotonic()
+            if not line:
+                break
+            key, _, value = line.decode().partition(":")
+            headers[key.strip().lower()] = value.strip()
+        size = int(headers.get("content-length", "0"))
+        jpeg = resp.read(size)
+        now = time.monotonic()
+        res.frame(now, int(headers.get("x-frame-age", "0")) + (now - header_at) * 1000, len(jpeg))
+    res.elapsed = time.monotonic() - start
+    conn.close()
+    return res
+
+
+def bench_poll(host, seconds, fps):
+    res = Result("poll")
+    conn = http.client.HTTPConnection(*split_host(host), timeout=5)
+    last_seq = None
+    start = time.monotonic()
+    due = start
+    while time.monotonic() - start < seconds:
+        if fps > 0:
+            due += 1.0 / fps
+        sent = time.monotonic()
+        conn.request("GET", "/frame.jpg?t=%d" % int(sent * 1000), headers={"Cache-Control": "no-store"})
+        resp = conn.getresponse()
+        jpeg = resp.read()
+        if resp.status != 200:
+            sys.exit("GET /frame.jpg: HTTP %d" % resp.status)
+        now = time.monotonic()
+        seq = resp.getheader("X-Frame-Seq")
+        if seq is not None and seq == last_seq:
+            res.duplicates += 1
+            res.bytes += len(jpeg)
+        else:
+            last_seq = seq
+            res.frame(now, int(resp.getheader("X-Frame-Age", "0")) + (now - sent) * 1000, len(jpeg))
+        if due > now:
+            time.sleep(due - now)
+    res.elapsed = time.monotonic() - start
+    conn.close()
+    return res
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--host", required=True, help="car host[:port]")
+    ap.add_argument("--seconds", type=float, default=10)
+    ap.add_argument("--mode", choices=("both", "stream", "poll"), default="both")
+    ap.add_argument("--poll-fps", type=float, default=10, help="polling rate (the page's old default: 10)")
+    ap.add_argument("--json", help="also write the results as JSON")
+    args = ap.parse_args()
+
+    results = []
+    if args.mode in ("both", "stream"):
+        results.append(bench_stream(args.host, args.seconds).summary())
+    if args.mode in ("both", "poll"):
+        results.append(bench_poll(args.host, args.seconds, args.poll_fps).summary())
+
+    print("%-7s %7s %6s %18s %14s %5s %8s" % ("mode", "frames", "fps", "gap p50/p95/max", "age p50/p95", "dup", "KiB/s"))
+    for r in results:
+        print("%-7s %7d %6.1f %18s %14s %5d %8.1f" % (
+            r["mode"], r["frames"], r["fps"],
+            "%.0f/%.0f/%.0f ms" % (r["gap_p50_ms"], r["gap_p95_ms"], r["gap_max_ms"]),
+            "%.0f/%.0f ms" % (r["age_p50_ms"], r["age_p95_ms"]),
+            r["duplicates"], r["kbytes_per_s"]))
+    info = get_json(args.host, "/video")
+    print("relay   frames_in=%s frames_out=%s superseded=%s oversize=%s" % (
+        info.get("frames_in"), info.get("frames_out"), info.get("superseded"), info.get("oversize")))
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump({"host": args.host, "seconds": args.seconds, "results": results, "relay": info}, f, indent=2)
+
+
+if __name__ == "__main__":
+    main()